@@ -0,0 +1,111 @@
+#ifndef PORT_AGENT_H
+#define PORT_AGENT_H
+
+// Headless stepping API for driving matches from external programs, such as bot training.
+//
+// Built as the 3sx_agent shared library. The game lives in global state, so a process can host a single instance:
+// run several processes side by side to use more cores.
+
+#include <stdbool.h>
+#include <stdint.h>
+
+// Bits of the inputs passed to Agent_Step, the same as the game's own switch words
+#define AGENT_INPUT_UP 0x0001
+#define AGENT_INPUT_DOWN 0x0002
+#define AGENT_INPUT_LEFT 0x0004
+#define AGENT_INPUT_RIGHT 0x0008
+#define AGENT_INPUT_LP 0x0010
+#define AGENT_INPUT_MP 0x0020
+#define AGENT_INPUT_HP 0x0040
+#define AGENT_INPUT_LK 0x0100
+#define AGENT_INPUT_MK 0x0200
+#define AGENT_INPUT_HK 0x0400
+#define AGENT_INPUT_START 0x4000
+
+#define AGENT_CHARACTER_COUNT 20
+#define AGENT_SUPER_ART_COUNT 3
+#define AGENT_STAGE_COUNT 21
+#define AGENT_DIFFICULTY_COUNT 8
+
+typedef struct AgentConfig {
+    /// @brief Character of each player, as numbered by the game (`0` is Gill, `1` Alex...).
+    uint8_t character[2];
+
+    /// @brief Super Art of each player, `0` to `2`.
+    uint8_t super_art[2];
+
+    uint8_t color[2];
+
+    /// @brief Let the game's AI play a player, ignoring its inputs.
+    uint8_t cpu[2];
+
+    /// @brief Level of the AI, `0` to `7` as in the game options.
+    uint8_t difficulty;
+
+    uint8_t stage;
+
+    /// @brief Seeds the game's random number tables. Matches with the same config and inputs play out the same.
+    uint32_t seed;
+} AgentConfig;
+
+/// @brief Box in stage coordinates, `x` and `y` being its lower left corner.
+typedef struct AgentBox {
+    int16_t x;
+    int16_t y;
+    int16_t width;
+    int16_t height;
+} AgentBox;
+
+typedef struct AgentPlayer {
+    int16_t x;
+    int16_t y;
+    int16_t vitality;
+    int16_t stun;
+    int16_t stun_limit;
+    int16_t super_gauge;
+    int16_t super_stock;
+    uint8_t pat_status;
+    uint8_t facing_right;
+    uint8_t wins;
+
+    /// @brief Number of entries of `attack_boxes` that can hit on this frame.
+    uint8_t attack_box_count;
+
+    AgentBox attack_boxes[4];
+} AgentPlayer;
+
+typedef struct AgentObservation {
+    /// @brief Frames stepped since the last reset.
+    uint32_t frame;
+
+    /// @brief Whether the players are in control, `0` during round intros and knockouts.
+    uint8_t battle_active;
+
+    /// @brief Set once the match has been decided. Call Agent_Reset to start another one.
+    uint8_t match_over;
+
+    uint8_t round;
+
+    /// @brief Seconds left in the round, `-1` without a time limit.
+    int8_t timer;
+
+    AgentPlayer player[2];
+} AgentObservation;
+
+/// @brief Boot the game headless. Call once per process, before anything else.
+/// @return `true` on success, `false` if the game resources are missing or the game didn't boot.
+bool Agent_Init();
+
+/// @brief Start a new match and run it up to the first frame where the players are in control.
+/// @return `true` on success, `false` if the config is out of range or the match didn't start.
+bool Agent_Reset(const AgentConfig* config);
+
+/// @brief Run `frames` frames with both players holding the given inputs.
+void Agent_Step(uint16_t p1_input, uint16_t p2_input, int frames);
+
+/// @brief Read the state of the current frame.
+void Agent_Observe(AgentObservation* out);
+
+void Agent_Quit();
+
+#endif
@@ -0,0 +1,23 @@
+#ifndef PORT_BATCH_RUNNER_H
+#define PORT_BATCH_RUNNER_H
+
+#include <stdbool.h>
+#include <stddef.h>
+
+/// @brief Run one job. Called in a child process, which exits afterwards.
+/// @param result Zeroed buffer of `result_size` bytes to write the result to.
+typedef void (*BatchJobFunc)(int job, void* result);
+
+/// @brief Receive the result of a job. Called in the calling process, in the order jobs finish.
+/// @param result Result written by the job, or `NULL` if the child process died before sending it.
+typedef void (*BatchResultFunc)(int job, const void* result, void* user);
+
+/// @brief Run jobs `0` to `job_count - 1`, each in a child forked from the calling process.
+///
+/// Every job starts from a copy-on-write copy of the caller's memory, so the caller can prepare a state once and
+/// have each job start from it. At most `worker_count` children run at the same time.
+/// @return `true` if all jobs were run, `false` if processes can't be forked on this platform.
+bool BatchRunner_Run(int job_count, int worker_count, size_t result_size, BatchJobFunc run_job,
+                     BatchResultFunc on_result, void* user);
+
+#endif
@@ -0,0 +1,83 @@
+#ifndef PORT_OPTIONS_H
+#define PORT_OPTIONS_H
+
+#include <stdbool.h>
+
+typedef struct Options {
+    /// @brief Render audio per simulated frame instead of on the audio device clock.
+    bool frame_locked_audio;
+
+    /// @brief Path of a WAV file to write frame-locked audio to, or `NULL`.
+    const char* audio_dump_path;
+
+    /// @brief Path of a video file to capture the game screen and frame-locked audio to, or `NULL`.
+    const char* capture_path;
+
+    /// @brief Run frames as fast as possible instead of at the game's frame rate.
+    bool fast_forward;
+
+    /// @brief Run without showing a window or using the GPU. Set for batch runs and the agent API.
+    bool headless;
+
+    /// @brief Draw the game screen on the CPU, the same on every machine. Headless runs then render frames too.
+    bool software_render;
+
+    /// @brief Memory budget in MB for pre-decoded SPU samples, `0` to always decode live.
+    int pcm_cache_mb;
+
+    /// @brief Memory budget in MB for files read ahead on the select screens, `0` to disable prefetching.
+    int prefetch_cache_mb;
+
+    /// @brief Directory to stream versus and network matches to as replay files, or `NULL`.
+    const char* record_replay_dir;
+
+    /// @brief Replay file to play from the Replay menu instead of the memory card, or `NULL`.
+    const char* replay_path;
+
+    /// @brief Frame to jump to when replay file playback starts, in seconds.
+    int replay_seek_seconds;
+
+    /// @brief Interval between keyframes in recorded replay files, in seconds.
+    int replay_keyframe_seconds;
+
+    /// @brief Path of a file to log per-frame state hashes of recorded and replayed matches to, or `NULL`.
+    const char* state_hash_log_path;
+
+    /// @brief Path of a file to dump the full simulation state of recorded and replayed matches to, or `NULL`.
+    const char* state_dump_path;
+
+    /// @brief Path of a file listing replay files to run headless, one per line, or `NULL`.
+    const char* batch_list_path;
+
+    /// @brief Number of batch replays or farm matches to run at the same time, `0` for one per CPU core.
+    int batch_jobs;
+
+    /// @brief Path of a file to write the results of batch replays to, or `NULL`.
+    const char* batch_output_path;
+
+    /// @brief Directory to write the image hash of every frame of each batch replay to, or `NULL`. Needs
+    /// `software_render`.
+    const char* batch_frame_hash_dir;
+
+    /// @brief Directory to capture each batch replay to as a video file, or `NULL`. Needs `software_render`.
+    const char* batch_capture_dir;
+
+    /// @brief Path of a file to write the statistics of headless CPU vs CPU matches to, or `NULL`.
+    const char* cpu_farm_path;
+
+    /// @brief Range of CPU difficulties to run farm matches at, `0` to `7`.
+    int farm_difficulty_first;
+    int farm_difficulty_last;
+
+    /// @brief Range of seeds to run farm matches with, one match per seed.
+    int farm_seed_first;
+    int farm_seed_last;
+} Options;
+
+extern Options options;
+
+/// @brief Parse command line arguments into `options`.
+/// @return `true` if the arguments are valid, `false` otherwise.
+bool Options_Parse(int argc, char* argv[]);
+
+#endif
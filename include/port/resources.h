@@ -7,10 +7,15 @@
 /// @param file_path Relative path to a file in resources, or `NULL` for path to the root of resources folder.
 char* Resources_GetPath(const char* file_path);
 
+/// @brief Get path to the file to read the game archive from: a copy in resources, the extracted archive
+/// on the game files, or a disc image.
+/// @return Path to the file, or `NULL` if the game files haven't been located yet.
+char* Resources_GetAFSPath();
+
 bool Resources_CheckIfPresent();
 
-/// @brief Run resource copying flow. Repeated calls of this function progress the flow.
-/// @return `true` if resources have been copied, `false` otherwise.
-bool Resources_RunResourceCopyingFlow();
+/// @brief Run resource locating flow. Repeated calls of this function progress the flow.
+/// @return `true` if resources have been located, `false` otherwise.
+bool Resources_RunResourceLocatingFlow();
 
 #endif
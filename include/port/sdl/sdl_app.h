@@ -14,6 +14,23 @@ bool SDLApp_PollEvents();
 
 void SDLApp_BeginFrame();
 void SDLApp_EndFrame();
+
+/// @brief Finish a frame that was simulated but isn't presented, without audio or frame pacing.
+void SDLApp_SkipFrame();
+
+/// @brief Start a frame of a headless run. Only does anything with the software renderer.
+void SDLApp_BeginHeadlessFrame();
+
+/// @brief Finish a frame of a headless run. Like `SDLApp_SkipFrame`, but can also run frame-locked audio.
+void SDLApp_EndHeadlessFrame(bool with_audio);
+
+/// @brief Start capturing the game canvas and the frame-locked audio to a video file, like `--capture` does.
+/// @return `true` if capture has started.
+bool SDLApp_StartCapture(const char* path);
+
+/// @brief Stop capturing and finish the file.
+void SDLApp_StopCapture();
+
 void SDLApp_Exit();
 
 #endif
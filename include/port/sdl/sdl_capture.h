@@ -0,0 +1,30 @@
+#ifndef SDL_CAPTURE_H
+#define SDL_CAPTURE_H
+
+#include <SDL3/SDL.h>
+
+/// @brief Start capturing the game canvas and the frame-locked audio to a video file.
+///
+/// Frames are encoded on a worker thread with FFV1 and PCM audio, so the file is lossless.
+/// @param path Path of the file to write, its extension picks the container (e.g. `.mkv`).
+/// @param width Width of the captured canvas.
+/// @param height Height of the captured canvas.
+/// @return `true` if the file was opened and capture has started.
+bool SDLCapture_Init(const char* path, int width, int height);
+
+/// @brief Wait for the worker thread and finish the file.
+void SDLCapture_Quit();
+
+/// @brief Queue the current contents of `canvas` and the audio of the last frame for encoding.
+///
+/// Only copies the pixels on the calling thread. The pixels of the software renderer are copied right away, a canvas
+/// drawn by the GPU is read back by the next call to `SDLCapture_BeginFrame`, so it must not be drawn to before then.
+/// Waits if the worker is a whole ring of frames behind.
+void SDLCapture_Frame(SDL_Renderer* renderer, SDL_Texture* canvas);
+
+/// @brief Read back the canvas queued by the last call to `SDLCapture_Frame`, if the GPU draws it.
+///
+/// Call at the start of a frame, before anything is drawn, so that the GPU has finished the canvas by then.
+void SDLCapture_BeginFrame();
+
+#endif
@@ -0,0 +1,21 @@
+#ifndef SDL_DEBUG_TEXT_H
+#define SDL_DEBUG_TEXT_H
+
+#include <SDL3/SDL.h>
+
+void SDLDebugText_Initialize(SDL_Renderer* renderer);
+
+void SDLDebugText_ToggleVisible();
+bool SDLDebugText_IsVisible();
+
+/// @brief Start collecting the characters of a new frame.
+void SDLDebugText_Clear();
+
+/// @brief Add a character at pixel position `x`, `y` of the 512x448 canvas.
+/// @param color Color in PS2 GS format, where `0x80` is full intensity.
+void SDLDebugText_AddChar(int x, int y, int code, unsigned int color);
+
+/// @brief Draw the collected characters onto `target` with a single geometry call.
+void SDLDebugText_Render(SDL_Texture* target);
+
+#endif
@@ -41,7 +41,9 @@ typedef struct SDLGameRenderer_Sprite2 {
 
 extern SDL_Texture* cps3_canvas;
 
+/// @brief Create the game canvas, and set up the software renderer if `options.software_render` is set.
 void SDLGameRenderer_Init(SDL_Renderer* renderer);
+void SDLGameRenderer_Quit();
 void SDLGameRenderer_BeginFrame();
 void SDLGameRenderer_RenderFrame();
 void SDLGameRenderer_EndFrame();
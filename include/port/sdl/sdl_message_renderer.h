@@ -8,7 +8,15 @@ extern SDL_Texture* message_canvas;
 void SDLMessageRenderer_Initialize(SDL_Renderer* renderer);
 void SDLMessageRenderer_BeginFrame();
 
-void SDLMessageRenderer_CreateTexture(int width, int height, void* pixels, int format);
-void SDLMessageRenderer_DrawTexture(int x0, int y0, int x1, int y1, int u0, int v0, int u1, int v1, unsigned int color);
+void SDLMessageRenderer_RenderFrame();
+
+/// @brief Drop the glyphs queued this frame without drawing them.
+void SDLMessageRenderer_DiscardFrame();
+
+void SDLMessageRenderer_ClearGlyphs();
+int SDLMessageRenderer_FindGlyph(unsigned int key);
+int SDLMessageRenderer_AddGlyph(unsigned int key, int width, int height, void* pixels);
+void SDLMessageRenderer_DrawGlyph(int slot, int x0, int y0, int x1, int y1, int u0, int v0, int u1, int v1,
+                                  unsigned int color);
 
 #endif
@@ -0,0 +1,42 @@
+#ifndef SDL_SOFT_RENDERER_H
+#define SDL_SOFT_RENDERER_H
+
+#include "types.h"
+
+#include <SDL3/SDL.h>
+
+typedef struct SDLSoftRenderer_Quad {
+    const SDL_Surface* image; // SDL_PIXELFORMAT_RGBA8888 texture, NULL for a solid quad
+    SDL_Vertex vertices[4];   // Drawn as the triangles 0, 1, 2 and 1, 2, 3
+} SDLSoftRenderer_Quad;
+
+/// @brief Set up a canvas of `width` by `height` pixels.
+/// @param thread_count Number of threads to split each frame between, by bands of rows. They are started with the
+/// first frame.
+void SDLSoftRenderer_Init(int width, int height, int thread_count);
+
+/// @brief Stop the threads and free the canvas.
+void SDLSoftRenderer_Quit();
+
+/// @brief Clear the canvas to `clear_color` and draw `quads` in order over it.
+///
+/// Quads are drawn with nearest sampling, modulated by their vertex colors and alpha blended, like
+/// `SDL_RenderGeometry` with `SDL_BLENDMODE_BLEND`. The result is the same on every machine and with any number
+/// of threads.
+/// @param clear_color Color in `SDL_PIXELFORMAT_RGBA8888`.
+void SDLSoftRenderer_Render(Uint32 clear_color, const SDLSoftRenderer_Quad* quads, int count);
+
+/// @brief Get the pixels of the last rendered frame, in `SDL_PIXELFORMAT_RGBA8888` with a pitch of `width * 4`.
+const Uint32* SDLSoftRenderer_GetPixels();
+
+/// @brief Get the FNV-1a hash of the pixels of the last rendered frame. It only depends on that frame, so it can be
+/// stored as a golden value.
+u64 SDLSoftRenderer_GetFrameHash();
+
+/// @brief Get the FNV-1a hash of the frame hashes of all frames rendered since the last reset.
+u64 SDLSoftRenderer_GetHash();
+
+/// @brief Start hashing frames anew.
+void SDLSoftRenderer_ResetHash();
+
+#endif
@@ -3,6 +3,15 @@
 
 #include "sf33rd/AcrSDK/MiddleWare/PS2/CapSndEng/emlSndDrv.h"
 
+/// Counters for the command ring between the game thread and the audio thread
+typedef struct EmlShimStats {
+    int queue_high_water;
+    int queue_size;
+    int dropped_commands;
+    u32 max_latency_us;
+    u32 avg_latency_us;
+} EmlShimStats;
+
 void emlShimInit();
 void emlShimSysSetVolume(CSE_SYS_PARAM_BANKVOL* param);
 void emlShimSysSetMono(CSE_SYS_PARAM_MONO* param);
@@ -12,5 +21,6 @@ void emlShimSeStop(CSE_REQP* pReqp);
 void emlShimSeKeyOff(CSE_REQP* pReqp);
 void emlShimSeSetLfo(CSE_SYS_PARAM_LFO* param);
 void emlShimSeStopAll();
+void emlShimGetStats(EmlShimStats* stats);
 
 #endif // EMLSHIM_H_
@@ -0,0 +1,48 @@
+#ifndef PORT_SOUND_MIXER_H
+#define PORT_SOUND_MIXER_H
+
+#include "types.h"
+
+#include <stdbool.h>
+
+#define MIXER_SAMPLE_RATE 48000
+#define MIXER_CHANNELS 2
+
+/// @brief Upper bound on the number of frames returned by `Mixer_RenderGameFrame`.
+#define MIXER_MAX_GAME_FRAME_FRAMES 806
+
+typedef enum MixerBus {
+    MIXER_BUS_SE,
+    MIXER_BUS_BGM,
+    MIXER_BUS_COUNT
+} MixerBus;
+
+/// @brief Render interleaved stereo samples of a bus.
+/// @param output Buffer for `num_frames` stereo frames.
+/// @param num_frames Number of frames to render.
+typedef void (*MixerSource)(s16* output, int num_frames);
+
+/// @brief Initialize the mixer.
+/// @param open_device `true` to play the mix through the default audio device, `false` to only mix into memory
+/// with `Mixer_Render`.
+/// @return `true` if the requested output is available.
+bool Mixer_Init(bool open_device);
+void Mixer_Quit();
+
+void Mixer_SetSource(MixerBus bus, MixerSource source);
+void Mixer_SetGain(MixerBus bus, float gain);
+void Mixer_SetPaused(MixerBus bus, bool paused);
+bool Mixer_IsPaused(MixerBus bus);
+
+/// @brief Mix buses into a memory buffer. Only valid when the mixer doesn't output to a device.
+/// @param output Buffer for `num_frames` interleaved stereo frames.
+/// @param num_frames Number of frames to mix.
+void Mixer_Render(s16* output, int num_frames);
+
+/// @brief Mix the share of samples that belongs to one frame of the game (48000 / 59.59949).
+/// The fractional part is carried over to the next call, so the output stays in sync with the game.
+/// @param output Buffer for at least `MIXER_MAX_GAME_FRAME_FRAMES` interleaved stereo frames.
+/// @return Number of frames that have been mixed.
+int Mixer_RenderGameFrame(s16* output);
+
+#endif
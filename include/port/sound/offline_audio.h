@@ -0,0 +1,24 @@
+#ifndef PORT_SOUND_OFFLINE_AUDIO_H
+#define PORT_SOUND_OFFLINE_AUDIO_H
+
+#include "types.h"
+
+/// @brief Start rendering audio in lockstep with the game instead of on an audio device.
+/// @param wav_path Path of a WAV file to write the audio to, or `NULL`.
+void OfflineAudio_Init(const char* wav_path);
+
+/// @brief Finish the WAV file and print the hash of all rendered audio.
+void OfflineAudio_Quit();
+
+/// @brief Render the audio of the frame that has just been simulated.
+void OfflineAudio_RunFrame();
+
+/// @brief Get the FNV-1a hash of all audio rendered so far.
+u64 OfflineAudio_GetHash();
+
+/// @brief Get the audio rendered by the last call to `OfflineAudio_RunFrame`.
+/// @param samples Set to the interleaved samples, `MIXER_CHANNELS` per sample frame.
+/// @return Number of sample frames.
+int OfflineAudio_GetLastFrame(const s16** samples);
+
+#endif
@@ -2,7 +2,8 @@
 #define SPU_H_
 
 #include "common.h"
-#include <SDL3/SDL_mutex.h>
+#include <stdbool.h>
+#include <stddef.h>
 
 struct SPUVConf {
     u32 pitch;
@@ -10,10 +11,21 @@ struct SPUVConf {
     u16 adsr1, adsr2;
 };
 
-extern SDL_Mutex* soundLock;
+struct SPUSampleInfo {
+    u32 addr; // Sound RAM byte address
+    u32 size; // Size in bytes, including the end block
+};
+
+struct SPUStats {
+    u32 render_time_us;
+    u32 rendered_frames;
+    size_t pcm_cache_bytes;
+    size_t pcm_cache_budget;
+};
 
 void SPU_Init(void (*cb)());
 void SPU_Upload(u32 dst, void* src, u32 size);
+void SPU_Render(s16* output, int num_frames);
 void SPU_Tick(s16* output);
 void SPU_VoiceStart(int vnum, u32 start_addr);
 void SPU_VoiceGetConf(int vnum, struct SPUVConf* conf);
@@ -21,5 +33,10 @@ void SPU_VoiceSetConf(int vnum, struct SPUVConf* conf);
 bool SPU_VoiceIsFinished(int vnum);
 void SPU_VoiceKeyOff(int vnum);
 void SPU_VoiceStop(int vnum);
+void SPU_SetPcmCacheBudget(size_t bytes);
+void SPU_CachePcmBank(int bank, const struct SPUSampleInfo* samples, int count);
+void SPU_StepPcmCache();
+void SPU_DropPcmBank(int bank);
+void SPU_GetStats(struct SPUStats* stats);
 
 #endif // SPU_H_
@@ -4,6 +4,8 @@
 #include "structs.h"
 #include "types.h"
 
+void flPS2DebugInit();
+void flPS2DebugStrFlush();
 void flPS2SystemError(s32 error_level, s8* format, ...);
 s32 flPrintL(s32 posi_x, s32 posi_y, const s8* format, ...);
 s32 flPrintColor(u32 col);
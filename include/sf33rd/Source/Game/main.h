@@ -18,6 +18,21 @@ typedef enum TaskID {
 extern MPP mpp_w;
 extern s32 system_init_level;
 
+/// @brief Set up for running the game without a window, for batch runs and the agent API.
+/// Nothing is drawn, and audio is only mixed on frames that ask for it.
+/// @return `true` on success, `false` if SDL or the game resources couldn't be set up.
+bool Headless_Init();
+
+/// @brief Run one frame of a headless run.
+/// @param with_audio Mix the audio of the frame. Screen transitions wait for voices and music to end, so they need
+/// it. Matches run faster without it.
+void Headless_Frame(bool with_audio);
+
+/// @brief Set the switches that both players hold on the following headless frames, in the bits of `p1sw_buff`.
+void Headless_SetInputs(u16 p1_sw, u16 p2_sw);
+
+void Headless_Quit();
+
 void cpInitTask();
 void cpReadyTask(TaskID num, void* func_adrs);
 void cpExitTask(TaskID num);
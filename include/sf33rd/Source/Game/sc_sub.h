@@ -3,6 +3,19 @@
 
 #include "types.h"
 
+typedef struct {
+    s16 fade;
+    s16 fade_kind;
+    u8 fade_prio;
+} FadeData;
+
+typedef struct {
+    u8 atr;
+    u8 page;
+    u8 cx;
+    u8 cy;
+} SAFrame;
+
 void Scrscreen_Init();
 void Sa_frame_Clear();
 void Sa_frame_Clear2(u8 pl);
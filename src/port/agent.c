@@ -0,0 +1,94 @@
+#include "port/agent.h"
+#include "sf33rd/Source/Game/engine/workuser.h"
+#include "sf33rd/Source/Game/main.h"
+#include "sf33rd/Source/Game/system/agent_match.h"
+
+#include <SDL3/SDL.h>
+
+#define BOOT_FRAME_LIMIT (60 * 60)
+#define RESET_FRAME_LIMIT (60 * 60)
+
+static bool is_initialized = false;
+static uint32_t frame;
+
+bool Agent_Init() {
+    s32 i;
+
+    if (is_initialized) {
+        return true;
+    }
+
+    if (!Headless_Init()) {
+        return false;
+    }
+
+    // Boot up to the attract loop, matches are started from there
+    for (i = 0; (i < BOOT_FRAME_LIMIT) && (G_No[0] != 1); i++) {
+        Headless_Frame(true);
+    }
+
+    if (G_No[0] != 1) {
+        SDL_Log("The game didn't boot within %d frames", BOOT_FRAME_LIMIT);
+        Headless_Quit();
+        return false;
+    }
+
+    is_initialized = true;
+    return true;
+}
+
+bool Agent_Reset(const AgentConfig* config) {
+    s32 i;
+
+    if (!is_initialized || (config->character[0] >= AGENT_CHARACTER_COUNT) ||
+        (config->character[1] >= AGENT_CHARACTER_COUNT) || (config->super_art[0] >= AGENT_SUPER_ART_COUNT) ||
+        (config->super_art[1] >= AGENT_SUPER_ART_COUNT) || (config->difficulty >= AGENT_DIFFICULTY_COUNT) ||
+        (config->stage >= AGENT_STAGE_COUNT)) {
+        return false;
+    }
+
+    Headless_SetInputs(0, 0);
+    Agent_Match_Start(config);
+
+    // Screen transitions wait for voices and music to end, so these frames need audio
+    for (i = 0; i < RESET_FRAME_LIMIT; i++) {
+        if (Agent_Match_Update()) {
+            frame = 0;
+            return true;
+        }
+
+        Headless_Frame(true);
+    }
+
+    SDL_Log("The match didn't start within %d frames", RESET_FRAME_LIMIT);
+    return false;
+}
+
+void Agent_Step(uint16_t p1_input, uint16_t p2_input, int frames) {
+    if (frames <= 0) {
+        return;
+    }
+
+    Headless_SetInputs(p1_input, p2_input);
+
+    for (int i = 0; i < frames; i++) {
+        Headless_Frame(false);
+    }
+
+    frame += frames;
+}
+
+void Agent_Observe(AgentObservation* out) {
+    SDL_zerop(out);
+    out->frame = frame;
+    Agent_Match_Observe(out);
+}
+
+void Agent_Quit() {
+    if (!is_initialized) {
+        return;
+    }
+
+    Headless_Quit();
+    is_initialized = false;
+}
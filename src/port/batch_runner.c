@@ -0,0 +1,202 @@
+#include "port/batch_runner.h"
+
+#include <SDL3/SDL.h>
+#include <stdio.h>
+
+#if !defined(_WIN32)
+
+#include <errno.h>
+#include <limits.h>
+#include <poll.h>
+#include <sys/wait.h>
+#include <unistd.h>
+
+// Children write each result with a single write() of at most PIPE_BUF bytes, which is atomic. All of them can
+// then share one pipe without their records interleaving.
+typedef struct BatchRecordHeader {
+    int job;
+} BatchRecordHeader;
+
+typedef struct BatchWorker {
+    pid_t pid;
+    int job;
+} BatchWorker;
+
+typedef struct BatchRun {
+    int read_fd;
+    size_t record_size;
+    unsigned char* record;
+    bool* finished;
+    BatchResultFunc on_result;
+    void* user;
+} BatchRun;
+
+static bool read_record(BatchRun* run) {
+    size_t received = 0;
+
+    while (received < run->record_size) {
+        const ssize_t size = read(run->read_fd, run->record + received, run->record_size - received);
+
+        if (size < 0 && errno == EINTR) {
+            continue;
+        }
+
+        if (size <= 0) {
+            return false;
+        }
+
+        received += size;
+    }
+
+    return true;
+}
+
+/// @brief Hand the results that are waiting in the pipe to the callback.
+/// @param timeout_ms How long to wait for the first result.
+static void receive_results(BatchRun* run, int timeout_ms) {
+    struct pollfd pfd = { .fd = run->read_fd, .events = POLLIN };
+    BatchRecordHeader header;
+
+    while (poll(&pfd, 1, timeout_ms) > 0) {
+        if (!read_record(run)) {
+            return;
+        }
+
+        SDL_memcpy(&header, run->record, sizeof(header));
+        run->finished[header.job] = true;
+        run->on_result(header.job, run->record + sizeof(header), run->user);
+        timeout_ms = 0;
+    }
+}
+
+static void run_child(int write_fd, int job, size_t record_size, size_t result_size, BatchJobFunc run_job) {
+    unsigned char* record = SDL_calloc(1, record_size);
+    const BatchRecordHeader header = { .job = job };
+
+    SDL_memcpy(record, &header, sizeof(header));
+    run_job(job, record + sizeof(header));
+
+    // Writes of at most PIPE_BUF bytes are all or nothing, so one that is interrupted can just be tried again
+    for (;;) {
+        const ssize_t size = write(write_fd, record, record_size);
+
+        if (size == (ssize_t)record_size) {
+            break;
+        }
+
+        if (size < 0 && errno == EINTR) {
+            continue;
+        }
+
+        perror("write");
+        _exit(1);
+    }
+
+    // Skip atexit handlers, they would tear down state that the parent still uses
+    _exit(0);
+}
+
+static void reap_children(BatchRun* run, BatchWorker* workers, int worker_count, int* active) {
+    pid_t pid;
+    int status;
+
+    while ((pid = waitpid(-1, &status, WNOHANG)) > 0) {
+        for (int i = 0; i < worker_count; i++) {
+            if (workers[i].pid != pid) {
+                continue;
+            }
+
+            // A child's result is in the pipe before it exits
+            receive_results(run, 0);
+
+            if (!run->finished[workers[i].job]) {
+                run->finished[workers[i].job] = true;
+                run->on_result(workers[i].job, NULL, run->user);
+            }
+
+            workers[i].pid = 0;
+            *active -= 1;
+            break;
+        }
+    }
+}
+
+bool BatchRunner_Run(int job_count, int worker_count, size_t result_size, BatchJobFunc run_job,
+                     BatchResultFunc on_result, void* user) {
+    BatchWorker* workers;
+    BatchRun run;
+    int fds[2];
+    int next_job = 0;
+    int active = 0;
+
+    run.record_size = sizeof(BatchRecordHeader) + result_size;
+
+    if (run.record_size > PIPE_BUF) {
+        printf("Batch results of %zu bytes don't fit in a single pipe write\n", result_size);
+        return false;
+    }
+
+    if (pipe(fds) != 0) {
+        perror("pipe");
+        return false;
+    }
+
+    run.read_fd = fds[0];
+    run.record = SDL_malloc(run.record_size);
+    run.finished = SDL_calloc(job_count, sizeof(bool));
+    run.on_result = on_result;
+    run.user = user;
+    workers = SDL_calloc(worker_count, sizeof(BatchWorker));
+
+    while ((next_job < job_count) || (active > 0)) {
+        for (int i = 0; (i < worker_count) && (next_job < job_count); i++) {
+            if (workers[i].pid != 0) {
+                continue;
+            }
+
+            // Buffered output would otherwise be written again by the child
+            fflush(stdout);
+            fflush(stderr);
+
+            const pid_t pid = fork();
+
+            if (pid == 0) {
+                close(fds[0]);
+                run_child(fds[1], next_job, run.record_size, result_size, run_job);
+            }
+
+            if (pid < 0) {
+                perror("fork");
+                run.finished[next_job] = true;
+                on_result(next_job, NULL, user);
+                next_job += 1;
+                continue;
+            }
+
+            workers[i].pid = pid;
+            workers[i].job = next_job;
+            active += 1;
+            next_job += 1;
+        }
+
+        receive_results(&run, 100);
+        reap_children(&run, workers, worker_count, &active);
+    }
+
+    close(fds[0]);
+    close(fds[1]);
+    SDL_free(workers);
+    SDL_free(run.finished);
+    SDL_free(run.record);
+    return true;
+}
+
+#else
+
+bool BatchRunner_Run(int job_count, int worker_count, size_t result_size, BatchJobFunc run_job,
+                     BatchResultFunc on_result, void* user) {
+    printf("Batch runs need fork() and aren't supported on Windows\n");
+    return false;
+}
+
+#endif
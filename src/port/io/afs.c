@@ -1,8 +1,13 @@
 #include "port/io/afs.h"
 #include "common.h"
+#include "port/io/mapped_file.h"
 #include <SDL3/SDL.h>
 #include <stdio.h>
 
+#if !defined(_WIN32)
+#include <unistd.h>
+#endif
+
 // Inspired by https://github.com/MaikelChan/AFSLib
 
 #define AFS_MAGIC 0x41465300
@@ -10,8 +15,20 @@
 #define AFS_ATTRIBUTE_ENTRY_SIZE 48
 #define AFS_MAX_NAME_LENGTH 32
 
+#define AFS_INDEX_MAGIC 0x58534641 // "AFSX"
+#define AFS_INDEX_VERSION 1
+
+#define ISO_SECTOR_SIZE 2048
+#define ISO_DESCRIPTOR_SECTOR 16
+#define ISO_RECORD_HEADER_SIZE 33
+
 #define AFS_MAX_READ_REQUESTS 100
 
+#define AFS_PREFETCH_SLOTS 16
+
+// Prefetches are read in chunks so that cancelling one never has to wait for a whole file
+#define AFS_PREFETCH_CHUNK_SECTORS 256
+
 // Uncomment this to enable debug prints
 // #define AFS_DEBUG
 
@@ -23,10 +40,53 @@ typedef struct AFSEntry {
 
 typedef struct AFS {
     char* file_path;
+    MappedFile map;
+
+    // Location of the archive in the file, which is a disc image when `base` isn't 0
+    Uint64 base;
+    Uint64 size;
+
     unsigned int entry_count;
     AFSEntry* entries;
 } AFS;
 
+typedef struct AFSIndexHeader {
+    Uint32 magic;
+    Uint32 version;
+    Uint64 source_size;
+    Sint64 source_time;
+    Uint64 base;
+    Uint64 size;
+    Uint32 entry_count;
+    Uint32 padding;
+} AFSIndexHeader;
+
+typedef enum PrefetchState {
+    PREFETCH_STATE_FREE,
+    PREFETCH_STATE_QUEUED,
+    PREFETCH_STATE_READING,
+    PREFETCH_STATE_DRAINING, // Cancelled, waiting for the chunk in flight before the buffer can be freed
+    PREFETCH_STATE_READY
+} PrefetchState;
+
+typedef struct Prefetch {
+    PrefetchState state;
+    int file_num;
+    unsigned int tags;
+    Uint8* buf;
+    unsigned int sectors;
+    unsigned int sectors_read;
+    unsigned int sectors_reading;
+    AFSHandle handle;
+    Uint64 last_use;
+    bool used;
+
+    // Game read that took over this prefetch while a chunk was in flight
+    AFSHandle adopter;
+    void* adopt_buf;
+    unsigned int adopt_sectors;
+} Prefetch;
+
 typedef struct ReadRequest {
     bool initialized;
     int index;
@@ -34,11 +94,152 @@ typedef struct ReadRequest {
     int sector;
     AFSReadState state;
     SDL_AsyncIO* asyncio;
+
+    // A read finishes once all of its parts have, and ends up in the worst of their states
+    int parts;
+    AFSReadState result;
+
+    Prefetch* prefetch;
+
+    // Set by AFS_CloseAndFree, the request is released along with this buffer when its read finishes
+    bool closing;
+    void* orphan_buf;
 } ReadRequest;
 
+// Reads from a mapped archive are copied on a thread of their own, since a copy
+// from pages that aren't in memory yet waits on the disc like any other read
+typedef struct MapRead {
+    ReadRequest* request;
+    void* buf;
+    Uint64 offset;
+    size_t size;
+} MapRead;
+
+typedef struct MapReader {
+    long pid; // Process the thread was started in, forked children start their own
+    SDL_Thread* thread;
+    SDL_Mutex* mutex;
+    SDL_Condition* queued;
+    SDL_Condition* copied;
+    bool quit;
+
+    // Reads stay queued until they are copied, so a child forked during a copy redoes it
+    MapRead reads[AFS_MAX_READ_REQUESTS];
+    int head;
+    int count;
+
+    ReadRequest* finished[AFS_MAX_READ_REQUESTS];
+    int finished_count;
+} MapReader;
+
 static AFS afs = { 0 };
+static MapReader map_reader = { 0 };
+static SDL_IOStream* init_io = NULL;
 static SDL_AsyncIOQueue* asyncio_queue = NULL;
 static ReadRequest requests[AFS_MAX_READ_REQUESTS] = { { 0 } };
+static bool frame_locked = false;
+
+static Prefetch prefetches[AFS_PREFETCH_SLOTS] = { { 0 } };
+static size_t prefetch_budget = 0;
+static size_t prefetch_used = 0;
+static Uint64 prefetch_clock = 0;
+static AFSPrefetchStats prefetch_stats = { 0 };
+
+static void release_prefetch(Prefetch* prefetch);
+
+static Uint32 get_u32le(const Uint8* src) {
+    return src[0] | (src[1] << 8) | (src[2] << 16) | ((Uint32)src[3] << 24);
+}
+
+static Uint32 get_u32be(const Uint8* src) {
+    return ((Uint32)src[0] << 24) | (src[1] << 16) | (src[2] << 8) | src[3];
+}
+
+/// Read from the file holding the archive, through the mapping when it isn't being read as a stream.
+static bool read_at(Uint64 offset, void* dst, size_t size) {
+    if (init_io == NULL) {
+        if ((offset > afs.map.size) || (size > afs.map.size - offset)) {
+            return false;
+        }
+
+        SDL_memcpy(dst, afs.map.data + offset, size);
+        return true;
+    }
+
+    if (SDL_SeekIO(init_io, offset, SDL_IO_SEEK_SET) != (Sint64)offset) {
+        return false;
+    }
+
+    return SDL_ReadIO(init_io, dst, size) == size;
+}
+
+static bool find_iso_record(Uint32 dir_lba, Uint32 dir_size, const char* name, Uint32* lba, Uint32* size) {
+    const size_t name_length = SDL_strlen(name);
+    Uint8* dir = SDL_malloc(dir_size);
+    bool found = false;
+
+    if ((dir == NULL) || !read_at((Uint64)dir_lba * ISO_SECTOR_SIZE, dir, dir_size)) {
+        SDL_free(dir);
+        return false;
+    }
+
+    for (Uint32 pos = 0; pos < dir_size;) {
+        const Uint8 record_length = dir[pos];
+
+        if (record_length == 0) {
+            // Records don't cross sectors, the rest of this one is padding
+            pos = (pos / ISO_SECTOR_SIZE + 1) * ISO_SECTOR_SIZE;
+            continue;
+        }
+
+        if ((record_length < ISO_RECORD_HEADER_SIZE) || (record_length > dir_size - pos)) {
+            break;
+        }
+
+        const Uint8 id_length = dir[pos + 32];
+        const char* id = (const char*)&dir[pos + ISO_RECORD_HEADER_SIZE];
+
+        // File identifiers carry a version suffix, as in "SF33RD.AFS;1"
+        if ((ISO_RECORD_HEADER_SIZE + id_length <= record_length) && (id_length >= name_length) &&
+            (SDL_strncasecmp(id, name, name_length) == 0) && ((id_length == name_length) || (id[name_length] == ';'))) {
+            *lba = get_u32le(&dir[pos + 2]);
+            *size = get_u32le(&dir[pos + 10]);
+            found = true;
+            break;
+        }
+
+        pos += record_length;
+    }
+
+    SDL_free(dir);
+    return found;
+}
+
+/// Find where the archive starts. Disc images have it in `THIRD/SF33RD.AFS`, plain archives start at 0.
+static bool locate_archive(Uint64 file_size, Uint64* base, Uint64* size) {
+    Uint8 descriptor[ISO_SECTOR_SIZE];
+    Uint32 record_lba;
+    Uint32 record_size;
+
+    *base = 0;
+    *size = file_size;
+
+    if (!read_at(ISO_DESCRIPTOR_SECTOR * ISO_SECTOR_SIZE, descriptor, sizeof(descriptor)) || (descriptor[0] != 1) ||
+        (SDL_memcmp(&descriptor[1], "CD001", 5) != 0)) {
+        return true;
+    }
+
+    const Uint8* root = &descriptor[156];
+
+    if (!find_iso_record(get_u32le(&root[2]), get_u32le(&root[10]), "THIRD", &record_lba, &record_size) ||
+        !find_iso_record(record_lba, record_size, "SF33RD.AFS", &record_lba, &record_size)) {
+        return false;
+    }
+
+    *base = (Uint64)record_lba * ISO_SECTOR_SIZE;
+    *size = record_size;
+    return true;
+}
 
 static bool is_valid_attribute_data(Uint32 attributes_offset, Uint32 attributes_size, Sint64 file_size,
                                     Uint32 entries_end_offset, Uint32 entry_count) {
@@ -65,45 +266,37 @@ static bool is_valid_attribute_data(Uint32 attributes_offset, Uint32 attributes_
     return true;
 }
 
-static void read_string(SDL_IOStream* src, char* dst) {
-    char c;
-
-    do {
-        SDL_ReadIO(src, &c, 1);
-        *dst++ = c;
-    } while (c != '\0');
-}
+static bool parse_toc() {
+    Uint8 header[8];
 
-static bool init_afs(const char* file_path) {
-    afs.file_path = SDL_strdup(file_path);
-    SDL_IOStream* io = SDL_IOFromFile(file_path, "rb");
-
-    if (io == NULL) {
+    if (!read_at(afs.base, header, sizeof(header)) || (get_u32be(header) != AFS_MAGIC)) {
         return false;
     }
 
-    // Check magic
+    afs.entry_count = get_u32le(&header[4]);
 
-    Uint32 magic = 0;
-    SDL_ReadU32BE(io, &magic);
+    // Entries are followed by the location of the attributes, so both come in with a single read
+    const size_t table_size = (size_t)afs.entry_count * 8 + AFS_ATTRIBUTE_HEADER_SIZE;
 
-    if (magic != AFS_MAGIC) {
-        SDL_CloseIO(io);
+    if (table_size > afs.size) {
         return false;
     }
 
-    // Read entries
+    Uint8* table = SDL_malloc(table_size);
+    afs.entries = SDL_calloc(afs.entry_count, sizeof(AFSEntry));
 
-    SDL_ReadU32LE(io, &afs.entry_count);
-    afs.entries = SDL_malloc(sizeof(AFSEntry) * afs.entry_count);
+    if (!read_at(afs.base + sizeof(header), table, table_size)) {
+        SDL_free(table);
+        return false;
+    }
 
     Uint32 entries_start_offset = 0;
     Uint32 entries_end_offset = 0;
 
     for (int i = 0; i < afs.entry_count; i++) {
         AFSEntry* entry = &afs.entries[i];
-        SDL_ReadU32LE(io, &entry->offset);
-        SDL_ReadU32LE(io, &entry->size);
+        entry->offset = get_u32le(&table[i * 8]);
+        entry->size = get_u32le(&table[i * 8 + 4]);
 
         if (entry->offset != 0) {
             if (entries_start_offset == 0) {
@@ -116,41 +309,143 @@ static bool init_afs(const char* file_path) {
 
     // Locate attributes
 
-    Uint32 attributes_offset;
-    Uint32 attributes_size;
+    Uint32 attributes_offset = get_u32le(&table[afs.entry_count * 8]);
+    Uint32 attributes_size = get_u32le(&table[afs.entry_count * 8 + 4]);
     bool has_attributes = false;
 
-    SDL_ReadU32LE(io, &attributes_offset);
-    SDL_ReadU32LE(io, &attributes_size);
+    SDL_free(table);
 
-    if (is_valid_attribute_data(
-            attributes_offset, attributes_size, SDL_GetIOSize(io), entries_end_offset, afs.entry_count)) {
+    if (is_valid_attribute_data(attributes_offset, attributes_size, afs.size, entries_end_offset, afs.entry_count)) {
         has_attributes = true;
-    } else {
-        SDL_SeekIO(io, entries_start_offset - AFS_ATTRIBUTE_HEADER_SIZE, SDL_IO_SEEK_SET);
+    } else if (entries_start_offset >= AFS_ATTRIBUTE_HEADER_SIZE) {
+        Uint8 location[AFS_ATTRIBUTE_HEADER_SIZE];
+
+        if (read_at(afs.base + entries_start_offset - AFS_ATTRIBUTE_HEADER_SIZE, location, sizeof(location))) {
+            attributes_offset = get_u32le(&location[0]);
+            attributes_size = get_u32le(&location[4]);
+            has_attributes = is_valid_attribute_data(
+                attributes_offset, attributes_size, afs.size, entries_end_offset, afs.entry_count);
+        }
+    }
+
+    if (!has_attributes) {
+        return true;
+    }
+
+    const size_t attributes_table_size = (size_t)afs.entry_count * AFS_ATTRIBUTE_ENTRY_SIZE;
+    Uint8* attributes = SDL_malloc(attributes_table_size);
 
-        SDL_ReadU32LE(io, &attributes_offset);
-        SDL_ReadU32LE(io, &attributes_size);
+    if (read_at(afs.base + attributes_offset, attributes, attributes_table_size)) {
+        for (int i = 0; i < afs.entry_count; i++) {
+            AFSEntry* entry = &afs.entries[i];
+            const Uint8* name = &attributes[i * AFS_ATTRIBUTE_ENTRY_SIZE];
 
-        if (is_valid_attribute_data(
-                attributes_offset, attributes_size, SDL_GetIOSize(io), entries_end_offset, afs.entry_count)) {
-            has_attributes = true;
+            if (entry->offset == 0) {
+                continue;
+            }
+
+            for (int j = 0; (j < AFS_MAX_NAME_LENGTH - 1) && (name[j] != '\0'); j++) {
+                entry->name[j] = name[j];
+            }
         }
     }
 
-    for (int i = 0; i < afs.entry_count; i++) {
-        AFSEntry* entry = &afs.entries[i];
+    SDL_free(attributes);
+    return true;
+}
 
-        if ((entry->offset != 0) && has_attributes) {
-            SDL_SeekIO(io, attributes_offset + i * AFS_ATTRIBUTE_ENTRY_SIZE, SDL_IO_SEEK_SET);
-            read_string(io, &entry->name);
-        } else {
-            SDL_memset(&entry->name, 0, sizeof(entry->name));
+// The parsed TOC is cached next to the resources, keyed by the size and modification time of the source file
+
+static bool load_index(const char* index_path, const SDL_PathInfo* source) {
+    size_t length = 0;
+    AFSIndexHeader* header;
+    bool valid;
+
+    if (index_path == NULL) {
+        return false;
+    }
+
+    header = SDL_LoadFile(index_path, &length);
+
+    if (header == NULL) {
+        return false;
+    }
+
+    valid = (length >= sizeof(AFSIndexHeader)) && (header->magic == AFS_INDEX_MAGIC) &&
+            (header->version == AFS_INDEX_VERSION) && (header->source_size == source->size) &&
+            (header->source_time == source->modify_time) &&
+            (length == sizeof(AFSIndexHeader) + (size_t)header->entry_count * sizeof(AFSEntry));
+
+    if (valid) {
+        afs.base = header->base;
+        afs.size = header->size;
+        afs.entry_count = header->entry_count;
+        afs.entries = SDL_malloc(sizeof(AFSEntry) * afs.entry_count);
+        SDL_memcpy(afs.entries, header + 1, sizeof(AFSEntry) * afs.entry_count);
+    }
+
+    SDL_free(header);
+    return valid;
+}
+
+static void save_index(const char* index_path, const SDL_PathInfo* source) {
+    const size_t length = sizeof(AFSIndexHeader) + sizeof(AFSEntry) * afs.entry_count;
+    AFSIndexHeader* header = SDL_calloc(1, length);
+
+    header->magic = AFS_INDEX_MAGIC;
+    header->version = AFS_INDEX_VERSION;
+    header->source_size = source->size;
+    header->source_time = source->modify_time;
+    header->base = afs.base;
+    header->size = afs.size;
+    header->entry_count = afs.entry_count;
+    SDL_memcpy(header + 1, afs.entries, sizeof(AFSEntry) * afs.entry_count);
+
+    if (!SDL_SaveFile(index_path, header, length)) {
+        printf("Failed to save AFS index: %s\n", SDL_GetError());
+    }
+
+    SDL_free(header);
+}
+
+static bool init_afs(const char* file_path, const char* index_path) {
+    SDL_PathInfo info;
+
+    if (!SDL_GetPathInfo(file_path, &info) || (info.type != SDL_PATHTYPE_FILE)) {
+        return false;
+    }
+
+    afs.file_path = SDL_strdup(file_path);
+
+    // Stream I/O is the fallback for when the file can't be mapped
+    if (!MappedFile_Open(&afs.map, file_path)) {
+        printf("Failed to map %s, falling back to stream reads\n", file_path);
+    }
+
+    if (load_index(index_path, &info)) {
+        return true;
+    }
+
+    if (afs.map.data == NULL) {
+        init_io = SDL_IOFromFile(file_path, "rb");
+
+        if (init_io == NULL) {
+            return false;
         }
     }
 
-    SDL_CloseIO(io);
-    return true;
+    const bool success = locate_archive(info.size, &afs.base, &afs.size) && parse_toc();
+
+    if (init_io != NULL) {
+        SDL_CloseIO(init_io);
+        init_io = NULL;
+    }
+
+    if (success && (index_path != NULL)) {
+        save_index(index_path, &info);
+    }
+
+    return success;
 }
 
 static bool init_asyncio(const char* file_path) {
@@ -158,20 +453,65 @@ static bool init_asyncio(const char* file_path) {
     return asyncio_queue != NULL;
 }
 
-bool AFS_Init(const char* file_path) {
-    if (!init_afs(file_path)) {
+bool AFS_Init(const char* file_path, const char* index_path) {
+    if (!init_afs(file_path, index_path)) {
         return false;
     }
 
     return init_asyncio(file_path);
 }
 
+bool AFS_IsValidSource(const char* file_path) {
+    Uint8 header[4];
+    Uint64 base;
+    Uint64 size;
+    bool success = false;
+
+    init_io = SDL_IOFromFile(file_path, "rb");
+
+    if (init_io == NULL) {
+        return false;
+    }
+
+    if (locate_archive(SDL_GetIOSize(init_io), &base, &size) && read_at(base, header, sizeof(header))) {
+        success = get_u32be(header) == AFS_MAGIC;
+    }
+
+    SDL_CloseIO(init_io);
+    init_io = NULL;
+    return success;
+}
+
+static void stop_map_reader();
+
 void AFS_Finish() {
+    for (int i = 0; i < SDL_arraysize(prefetches); i++) {
+        if (prefetches[i].state != PREFETCH_STATE_FREE) {
+            release_prefetch(&prefetches[i]);
+        }
+    }
+
+    stop_map_reader();
+
+    // Destroying the queue waits for the reads in flight, after which closed requests can let go of their buffers
+    SDL_DestroyAsyncIOQueue(asyncio_queue);
+    asyncio_queue = NULL;
+
+    for (int i = 0; i < SDL_arraysize(requests); i++) {
+        if (requests[i].closing) {
+            SDL_free(requests[i].orphan_buf);
+        }
+    }
+
+    MappedFile_Close(&afs.map);
     SDL_free(afs.file_path);
     SDL_free(afs.entries);
     SDL_zero(afs);
     SDL_zeroa(requests);
-    SDL_DestroyAsyncIOQueue(asyncio_queue);
+}
+
+bool AFS_IsMapped() {
+    return afs.map.data != NULL;
 }
 
 unsigned int AFS_GetFileCount() {
@@ -188,9 +528,558 @@ unsigned int AFS_GetSize(int file_num) {
 
 // AFS reading
 
+// Prefetching
+
+static void finish_part(ReadRequest* request, AFSReadState state);
+
+static bool is_prefetch_enabled() {
+    return prefetch_budget > 0;
+}
+
+static Prefetch* find_prefetch(int file_num) {
+    for (int i = 0; i < SDL_arraysize(prefetches); i++) {
+        Prefetch* prefetch = &prefetches[i];
+
+        if ((prefetch->file_num == file_num) && (prefetch->state != PREFETCH_STATE_FREE) &&
+            (prefetch->state != PREFETCH_STATE_DRAINING)) {
+            return prefetch;
+        }
+    }
+
+    return NULL;
+}
+
+static void release_prefetch(Prefetch* prefetch) {
+    if (!prefetch->used) {
+        prefetch_stats.wasted_bytes += (size_t)prefetch->sectors_read * 2048;
+    }
+
+    if (prefetch->buf != NULL) {
+        SDL_free(prefetch->buf);
+        prefetch_used -= (size_t)prefetch->sectors * 2048;
+    }
+
+    if (prefetch->state == PREFETCH_STATE_READING || prefetch->state == PREFETCH_STATE_DRAINING) {
+        AFS_Close(prefetch->handle);
+    }
+
+    SDL_zerop(prefetch);
+    prefetch->handle = AFS_NONE;
+    prefetch->adopter = AFS_NONE;
+}
+
+static void prefetch_chunk_done(Prefetch* prefetch, AFSReadState state) {
+    const bool ok = (state == AFS_READ_STATE_FINISHED);
+
+    if (ok) {
+        prefetch->sectors_read += prefetch->sectors_reading;
+        prefetch_stats.read_bytes += (size_t)prefetch->sectors_reading * 2048;
+    }
+
+    prefetch->sectors_reading = 0;
+
+    if (prefetch->adopter != AFS_NONE) {
+        ReadRequest* adopter = &requests[prefetch->adopter];
+
+        if (ok) {
+            SDL_memcpy(prefetch->adopt_buf, prefetch->buf, (size_t)prefetch->adopt_sectors * 2048);
+        }
+
+        prefetch->adopter = AFS_NONE;
+        prefetch->used = true;
+        finish_part(adopter, state);
+        release_prefetch(prefetch);
+        return;
+    }
+
+    if (!ok || (prefetch->state == PREFETCH_STATE_DRAINING)) {
+        release_prefetch(prefetch);
+        return;
+    }
+
+    if (prefetch->sectors_read >= prefetch->sectors) {
+        AFS_Close(prefetch->handle);
+        prefetch->handle = AFS_NONE;
+        prefetch->state = PREFETCH_STATE_READY;
+    }
+}
+
+static void finish_part(ReadRequest* request, AFSReadState state) {
+    if ((state != AFS_READ_STATE_FINISHED) && (request->result != AFS_READ_STATE_ERROR)) {
+        request->result = state;
+    }
+
+    request->parts -= 1;
+
+    if (request->parts > 0) {
+        return;
+    }
+
+    request->state = request->result;
+
+    if (request->prefetch != NULL) {
+        prefetch_chunk_done(request->prefetch, request->state);
+    }
+}
+
+// Reading from the mapping
+
+static long current_pid() {
+#if defined(_WIN32)
+    return 0;
+#else
+    return getpid();
+#endif
+}
+
+/// The last file can end in a partial sector, its padding is zero filled.
+static void copy_from_map(const MapRead* read) {
+    const size_t available = (read->offset < afs.map.size) ? SDL_min(read->size, afs.map.size - read->offset) : 0;
+
+    SDL_memcpy(read->buf, afs.map.data + read->offset, available);
+    SDL_memset((Uint8*)read->buf + available, 0, read->size - available);
+}
+
+static int SDLCALL run_map_reader(void* data) {
+    SDL_LockMutex(map_reader.mutex);
+
+    while (!map_reader.quit) {
+        if (map_reader.count == 0) {
+            SDL_WaitCondition(map_reader.queued, map_reader.mutex);
+            continue;
+        }
+
+        const MapRead read = map_reader.reads[map_reader.head];
+
+        SDL_UnlockMutex(map_reader.mutex);
+        copy_from_map(&read);
+        SDL_LockMutex(map_reader.mutex);
+
+        map_reader.head = (map_reader.head + 1) % SDL_arraysize(map_reader.reads);
+        map_reader.count -= 1;
+        map_reader.finished[map_reader.finished_count++] = read.request;
+        SDL_SignalCondition(map_reader.copied);
+    }
+
+    SDL_UnlockMutex(map_reader.mutex);
+    return 0;
+}
+
+/// Start the copy thread of this process. A forked child inherits the queue but not the thread, and the locks
+/// may have been held by it, so the child makes new ones and copies the reads that were queued over again.
+static bool start_map_reader() {
+    const long pid = current_pid();
+
+    if ((map_reader.thread != NULL) && (map_reader.pid == pid)) {
+        return true;
+    }
+
+    map_reader.pid = pid;
+    map_reader.quit = false;
+    map_reader.mutex = SDL_CreateMutex();
+    map_reader.queued = SDL_CreateCondition();
+    map_reader.copied = SDL_CreateCondition();
+    map_reader.thread = SDL_CreateThread(run_map_reader, "afs_map", NULL);
+
+    if (map_reader.thread == NULL) {
+        printf("Failed to start the AFS read thread: %s\n", SDL_GetError());
+        SDL_DestroyCondition(map_reader.copied);
+        SDL_DestroyCondition(map_reader.queued);
+        SDL_DestroyMutex(map_reader.mutex);
+        return false;
+    }
+
+    return true;
+}
+
+static void stop_map_reader() {
+    if ((map_reader.thread != NULL) && (map_reader.pid == current_pid())) {
+        SDL_LockMutex(map_reader.mutex);
+        map_reader.quit = true;
+        SDL_SignalCondition(map_reader.queued);
+        SDL_UnlockMutex(map_reader.mutex);
+        SDL_WaitThread(map_reader.thread, NULL);
+
+        SDL_DestroyCondition(map_reader.copied);
+        SDL_DestroyCondition(map_reader.queued);
+        SDL_DestroyMutex(map_reader.mutex);
+    }
+
+    SDL_zero(map_reader);
+}
+
+static void queue_map_read(ReadRequest* request, int sectors, void* buf, Uint64 offset) {
+    const MapRead read = { .request = request, .buf = buf, .offset = offset, .size = (size_t)sectors * 2048 };
+    bool queued = false;
+
+    request->state = AFS_READ_STATE_READING;
+    request->sector += sectors;
+
+    if (start_map_reader()) {
+        SDL_LockMutex(map_reader.mutex);
+
+        // Every queued read ends up in the list of finished ones, which only empties when they are collected
+        if (map_reader.count + map_reader.finished_count < SDL_arraysize(map_reader.reads)) {
+            map_reader.reads[(map_reader.head + map_reader.count) % SDL_arraysize(map_reader.reads)] = read;
+            map_reader.count += 1;
+            SDL_SignalCondition(map_reader.queued);
+            queued = true;
+        }
+
+        SDL_UnlockMutex(map_reader.mutex);
+    }
+
+    // Copy right away when the thread can't take the read
+    if (!queued) {
+        copy_from_map(&read);
+        finish_part(request, AFS_READ_STATE_FINISHED);
+    }
+}
+
+static bool issue_read(ReadRequest* request, int sectors, void* buf) {
+    const Uint64 offset = afs.base + afs.entries[request->file_num].offset + request->sector * 2048;
+
+    if (afs.map.data != NULL) {
+        queue_map_read(request, sectors, buf, offset);
+        return true;
+    }
+
+    request->state = AFS_READ_STATE_READING;
+    request->asyncio = SDL_AsyncIOFromFile(afs.file_path, "r");
+
+    if (request->asyncio == NULL) {
+        printf("SDL_AsyncIOFromFile error: %s\n", SDL_GetError());
+        request->state = AFS_READ_STATE_ERROR;
+        return false;
+    }
+
+    const bool success = SDL_ReadAsyncIO(request->asyncio, buf, offset, sectors * 2048, asyncio_queue, request);
+
+    if (!success) {
+        printf("SDL_ReadAsyncIO error: %s\n", SDL_GetError());
+        request->state = AFS_READ_STATE_ERROR;
+        return false;
+    }
+
+    request->sector += sectors;
+    return true;
+}
+
+static bool start_prefetch(Prefetch* prefetch) {
+    const size_t size = (size_t)prefetch->sectors * 2048;
+
+    // Make room by evicting the staged files that were used least recently
+    while (prefetch_used + size > prefetch_budget) {
+        Prefetch* victim = NULL;
+
+        for (int i = 0; i < SDL_arraysize(prefetches); i++) {
+            Prefetch* candidate = &prefetches[i];
+
+            if ((candidate->state == PREFETCH_STATE_READY) &&
+                ((victim == NULL) || (candidate->last_use < victim->last_use))) {
+                victim = candidate;
+            }
+        }
+
+        if (victim == NULL) {
+            release_prefetch(prefetch);
+            return false;
+        }
+
+        release_prefetch(victim);
+    }
+
+    prefetch->handle = AFS_Open(prefetch->file_num);
+
+    if (prefetch->handle == AFS_NONE) {
+        release_prefetch(prefetch);
+        return false;
+    }
+
+    prefetch->buf = SDL_malloc(size);
+
+    if (prefetch->buf == NULL) {
+        // The handle is only closed by release_prefetch once the file is being read
+        AFS_Close(prefetch->handle);
+        release_prefetch(prefetch);
+        return false;
+    }
+
+    prefetch_used += size;
+    prefetch->state = PREFETCH_STATE_READING;
+    requests[prefetch->handle].prefetch = prefetch;
+    return true;
+}
+
+static void run_prefetch() {
+    Prefetch* next = NULL;
+
+    if (!is_prefetch_enabled()) {
+        return;
+    }
+
+    // Stay off the disc while the game is waiting on it
+    for (int i = 0; i < SDL_arraysize(requests); i++) {
+        const ReadRequest* request = &requests[i];
+
+        if (request->initialized && (request->prefetch == NULL) && (request->state == AFS_READ_STATE_READING)) {
+            return;
+        }
+    }
+
+    // Keep a single chunk in flight, finishing the file that was started before beginning the oldest queued one
+    for (int i = 0; i < SDL_arraysize(prefetches); i++) {
+        Prefetch* prefetch = &prefetches[i];
+
+        if (prefetch->sectors_reading > 0) {
+            return;
+        }
+
+        if (prefetch->state == PREFETCH_STATE_READING) {
+            next = prefetch;
+        }
+    }
+
+    if (next == NULL) {
+        for (int i = 0; i < SDL_arraysize(prefetches); i++) {
+            Prefetch* prefetch = &prefetches[i];
+
+            if ((prefetch->state == PREFETCH_STATE_QUEUED) &&
+                ((next == NULL) || (prefetch->last_use < next->last_use))) {
+                next = prefetch;
+            }
+        }
+
+        if ((next == NULL) || !start_prefetch(next)) {
+            return;
+        }
+    }
+
+    ReadRequest* request = &requests[next->handle];
+    const unsigned int sectors = SDL_min(next->sectors - next->sectors_read, AFS_PREFETCH_CHUNK_SECTORS);
+
+    request->parts = 1;
+    request->result = AFS_READ_STATE_FINISHED;
+    next->sectors_reading = sectors;
+
+    if (!issue_read(request, sectors, next->buf + (size_t)next->sectors_read * 2048)) {
+        next->sectors_reading = 0;
+        release_prefetch(next);
+    }
+}
+
+/// Serve a read of the start of a file from a prefetch of it, if there is one.
+static bool read_from_prefetch(AFSHandle handle, int sectors, void* buf) {
+    ReadRequest* request = &requests[handle];
+    Prefetch* prefetch = find_prefetch(request->file_num);
+
+    if ((prefetch == NULL) || (sectors <= 0) || (sectors > prefetch->sectors)) {
+        return false;
+    }
+
+    switch (prefetch->state) {
+    case PREFETCH_STATE_QUEUED:
+        // Not started yet, so the game's own read gets there first
+        release_prefetch(prefetch);
+        return false;
+
+    case PREFETCH_STATE_READY:
+        SDL_memcpy(buf, prefetch->buf, (size_t)sectors * 2048);
+        prefetch->used = true;
+        prefetch->last_use = ++prefetch_clock;
+        request->sector += sectors;
+        request->state = AFS_READ_STATE_FINISHED;
+        prefetch_stats.hits += 1;
+        return true;
+
+    case PREFETCH_STATE_READING:
+        break;
+
+    default:
+        return false;
+    }
+
+    if (prefetch->adopter != AFS_NONE) {
+        return false;
+    }
+
+    const unsigned int covered = prefetch->sectors_read + prefetch->sectors_reading;
+
+    request->parts = 0;
+    request->result = AFS_READ_STATE_FINISHED;
+    request->state = AFS_READ_STATE_READING;
+    prefetch_stats.partial_hits += 1;
+
+    if (prefetch->sectors_reading > 0) {
+        // Let the chunk in flight finish into the game's buffer
+        prefetch->adopter = handle;
+        prefetch->adopt_buf = buf;
+        prefetch->adopt_sectors = SDL_min(sectors, covered);
+        request->parts += 1;
+    } else {
+        SDL_memcpy(buf, prefetch->buf, (size_t)SDL_min(sectors, covered) * 2048);
+        prefetch->used = true;
+        release_prefetch(prefetch);
+    }
+
+    request->sector = SDL_min(sectors, covered);
+
+    if (sectors > covered) {
+        request->parts += 1;
+
+        if (!issue_read(request, sectors - covered, (Uint8*)buf + (size_t)covered * 2048)) {
+            request->parts -= 1;
+            request->result = AFS_READ_STATE_ERROR;
+        }
+    }
+
+    if (request->parts == 0) {
+        request->state = request->result;
+    } else {
+        request->state = AFS_READ_STATE_READING;
+    }
+
+    return true;
+}
+
+/// Detach a game read that is being stopped from the prefetch it took over.
+static void detach_adopter(AFSHandle handle) {
+    for (int i = 0; i < SDL_arraysize(prefetches); i++) {
+        Prefetch* prefetch = &prefetches[i];
+
+        if ((prefetch->state != PREFETCH_STATE_FREE) && (prefetch->adopter == handle)) {
+            ReadRequest* request = &requests[handle];
+
+            prefetch->adopter = AFS_NONE;
+            prefetch->state = PREFETCH_STATE_DRAINING;
+
+            // The chunk in flight no longer counts towards the read
+            if (--request->parts == 0) {
+                request->state = AFS_READ_STATE_IDLE;
+            }
+        }
+    }
+}
+
+void AFS_SetPrefetchBudget(size_t bytes) {
+    prefetch_budget = bytes;
+}
+
+void AFS_Prefetch(int file_num, int tag) {
+    Prefetch* prefetch;
+
+    if (!is_prefetch_enabled() || (file_num < 0) || (file_num >= afs.entry_count)) {
+        return;
+    }
+
+    const unsigned int sectors = (afs.entries[file_num].size + 2048 - 1) / 2048;
+
+    if ((sectors == 0) || ((size_t)sectors * 2048 > prefetch_budget)) {
+        return;
+    }
+
+    prefetch = find_prefetch(file_num);
+
+    if (prefetch != NULL) {
+        prefetch->tags |= 1U << tag;
+        return;
+    }
+
+    for (int i = 0; i < SDL_arraysize(prefetches); i++) {
+        prefetch = &prefetches[i];
+
+        if (prefetch->state != PREFETCH_STATE_FREE) {
+            continue;
+        }
+
+        prefetch->state = PREFETCH_STATE_QUEUED;
+        prefetch->file_num = file_num;
+        prefetch->tags = 1U << tag;
+        prefetch->sectors = sectors;
+        prefetch->handle = AFS_NONE;
+        prefetch->adopter = AFS_NONE;
+        prefetch->last_use = ++prefetch_clock;
+        return;
+    }
+}
+
+void AFS_CancelPrefetch(int tag) {
+    for (int i = 0; i < SDL_arraysize(prefetches); i++) {
+        Prefetch* prefetch = &prefetches[i];
+
+        if ((prefetch->state == PREFETCH_STATE_FREE) || !(prefetch->tags & (1U << tag))) {
+            continue;
+        }
+
+        prefetch->tags &= ~(1U << tag);
+
+        // Files that finished staging stay around until they are evicted
+        if ((prefetch->tags != 0) || (prefetch->adopter != AFS_NONE) || (prefetch->state == PREFETCH_STATE_READY)) {
+            continue;
+        }
+
+        prefetch_stats.cancelled += 1;
+
+        if (prefetch->sectors_reading > 0) {
+            prefetch->state = PREFETCH_STATE_DRAINING;
+        } else {
+            release_prefetch(prefetch);
+        }
+    }
+}
+
+void AFS_GetPrefetchStats(AFSPrefetchStats* stats) {
+    *stats = prefetch_stats;
+    stats->staged_bytes = prefetch_used;
+}
+
+static void complete_read(ReadRequest* request, AFSReadState state) {
+    finish_part(request, state);
+
+    if (request->closing && (request->state != AFS_READ_STATE_READING)) {
+        SDL_free(request->orphan_buf);
+        SDL_zerop(request);
+    }
+}
+
+/// Finish the reads the copy thread is done with.
+/// @param wait Wait for one to be done if there are none yet.
+/// @return `false` if there were none and none are queued.
+static bool collect_map_reads(bool wait) {
+    ReadRequest* finished[AFS_MAX_READ_REQUESTS];
+    int count;
+
+    if ((map_reader.thread == NULL) || !start_map_reader()) {
+        return false;
+    }
+
+    SDL_LockMutex(map_reader.mutex);
+    const bool queued = map_reader.count > 0;
+
+    if (wait && (map_reader.finished_count == 0) && queued) {
+        SDL_WaitCondition(map_reader.copied, map_reader.mutex);
+    }
+
+    count = map_reader.finished_count;
+    SDL_memcpy(finished, map_reader.finished, count * sizeof(ReadRequest*));
+    map_reader.finished_count = 0;
+    SDL_UnlockMutex(map_reader.mutex);
+
+    for (int i = 0; i < count; i++) {
+        complete_read(finished[i], AFS_READ_STATE_FINISHED);
+    }
+
+    return (count > 0) || queued;
+}
+
 static void process_asyncio_outcome(const SDL_AsyncIOOutcome* outcome) {
     ReadRequest* request = (ReadRequest*)outcome->userdata;
 
+    if (request == NULL) {
+        // Closing of a file handle that was used for a finished read
+        return;
+    }
+
 #if defined(AFS_DEBUG)
     printf("📂 %d: request complete (type = %d, result = %d, offset = 0x%llX, requested = 0x%llX, transferred = "
            "0x%llX)\n",
@@ -204,17 +1093,24 @@ static void process_asyncio_outcome(const SDL_AsyncIOOutcome* outcome) {
 
     switch (outcome->type) {
     case SDL_ASYNCIO_TASK_READ:
+        // Every read opens its own file handle, so release it as soon as the read is done.
+        // If AFS_Stop got here first, the handle is already being closed.
+        if (request->asyncio == outcome->asyncio) {
+            SDL_CloseAsyncIO(outcome->asyncio, false, asyncio_queue, NULL);
+            request->asyncio = NULL;
+        }
+
         switch (outcome->result) {
         case SDL_ASYNCIO_COMPLETE:
-            request->state = AFS_READ_STATE_FINISHED;
+            complete_read(request, AFS_READ_STATE_FINISHED);
             break;
 
         case SDL_ASYNCIO_CANCELED:
-            request->state = AFS_READ_STATE_IDLE;
+            complete_read(request, AFS_READ_STATE_IDLE);
             break;
 
         case SDL_ASYNCIO_FAILURE:
-            request->state = AFS_READ_STATE_ERROR;
+            complete_read(request, AFS_READ_STATE_ERROR);
             break;
         }
 
@@ -236,12 +1132,47 @@ static void process_asyncio_outcome(const SDL_AsyncIOOutcome* outcome) {
     request->asyncio = NULL;
 }
 
+static void wait_for_request(AFSHandle handle) {
+    SDL_AsyncIOOutcome outcome;
+
+    while (requests[handle].state == AFS_READ_STATE_READING) {
+        if (afs.map.data != NULL) {
+            if (!collect_map_reads(true)) {
+                break;
+            }
+
+            continue;
+        }
+
+        if (!SDL_WaitAsyncIOResult(asyncio_queue, &outcome, -1)) {
+            break;
+        }
+
+        process_asyncio_outcome(&outcome);
+    }
+}
+
 void AFS_RunServer() {
     SDL_AsyncIOOutcome outcome;
 
+    if (frame_locked) {
+        // Finish every read that has been issued since the previous call, so that
+        // loads take the same number of frames regardless of disk speed
+        for (int i = 0; i < SDL_arraysize(requests); i++) {
+            wait_for_request(i);
+        }
+    }
+
     while (SDL_GetAsyncIOResult(asyncio_queue, &outcome)) {
         process_asyncio_outcome(&outcome);
     }
+
+    collect_map_reads(false);
+    run_prefetch();
+}
+
+void AFS_SetFrameLocked(bool enabled) {
+    frame_locked = enabled;
 }
 
 AFSHandle AFS_Open(int file_num) {
@@ -276,26 +1207,18 @@ void AFS_Read(AFSHandle handle, int sectors, void* buf) {
 #endif
 
     ReadRequest* request = &requests[handle];
-    const Uint64 offset = afs.entries[request->file_num].offset + request->sector * 2048;
-
-    request->state = AFS_READ_STATE_READING;
-    request->asyncio = SDL_AsyncIOFromFile(afs.file_path, "r");
 
-    if (request->asyncio == NULL) {
-        printf("SDL_AsyncIOFromFile error: %s\n", SDL_GetError());
-        request->state = AFS_READ_STATE_ERROR;
+    if ((request->sector == 0) && read_from_prefetch(handle, sectors, buf)) {
         return;
     }
 
-    const bool success = SDL_ReadAsyncIO(request->asyncio, buf, offset, sectors * 2048, asyncio_queue, request);
-
-    if (!success) {
-        printf("SDL_ReadAsyncIO error: %s\n", SDL_GetError());
-        request->state = AFS_READ_STATE_ERROR;
-        return;
+    if (is_prefetch_enabled()) {
+        prefetch_stats.misses += 1;
     }
 
-    request->sector += sectors;
+    request->parts = 1;
+    request->result = AFS_READ_STATE_FINISHED;
+    issue_read(request, sectors, buf);
 }
 
 void AFS_ReadSync(AFSHandle handle, int sectors, void* buf) {
@@ -304,18 +1227,15 @@ void AFS_ReadSync(AFSHandle handle, int sectors, void* buf) {
 #endif
 
     AFS_Read(handle, sectors, buf);
+    wait_for_request(handle);
+}
 
-    SDL_AsyncIOOutcome outcome;
-
-    while (SDL_WaitAsyncIOResult(asyncio_queue, &outcome, -1)) {
-        process_asyncio_outcome(&outcome);
-
-        ReadRequest* request = (ReadRequest*)outcome.userdata;
+void AFS_Seek(AFSHandle handle, int sector) {
+#if defined(AFS_DEBUG)
+    printf("📂 %d: seek (sector = %d)\n", handle, sector);
+#endif
 
-        if (request->index == handle) {
-            break;
-        }
-    }
+    requests[handle].sector = sector;
 }
 
 void AFS_Stop(AFSHandle handle) {
@@ -325,6 +1245,8 @@ void AFS_Stop(AFSHandle handle) {
 
     ReadRequest* request = &requests[handle];
 
+    detach_adopter(handle);
+
     if (request->asyncio != NULL) {
         SDL_CloseAsyncIO(request->asyncio, false, asyncio_queue, request);
         request->asyncio = NULL;
@@ -337,10 +1259,35 @@ void AFS_Close(AFSHandle handle) {
 #endif
 
     ReadRequest* request = &requests[handle];
+
+    // Reads can't be canceled, so make sure nothing gets written to the caller's buffer after this returns
+    wait_for_request(handle);
+
     AFS_Stop(handle);
     SDL_zerop(request);
 }
 
+void AFS_CloseAndFree(AFSHandle handle, void* buf) {
+#if defined(AFS_DEBUG)
+    printf("📂 %d: close and free\n", handle);
+#endif
+
+    ReadRequest* request = &requests[handle];
+
+    // Staged data is only copied into the buffer for as long as the request holds on to the prefetch
+    detach_adopter(handle);
+
+    if (request->state != AFS_READ_STATE_READING) {
+        SDL_free(buf);
+        SDL_zerop(request);
+        return;
+    }
+
+    // The read outcome closes the file handle and releases the request
+    request->closing = true;
+    request->orphan_buf = buf;
+}
+
 AFSReadState AFS_GetState(AFSHandle handle) {
     ReadRequest* request = &requests[handle];
 
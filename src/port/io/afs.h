@@ -2,6 +2,7 @@
 #define PORT_IO_AFS_H
 
 #include <stdbool.h>
+#include <stddef.h>
 
 typedef enum AFSReadState {
     AFS_READ_STATE_IDLE,
@@ -14,18 +15,70 @@ typedef int AFSHandle;
 
 #define AFS_NONE -1
 
-bool AFS_Init(const char* file_path);
+typedef struct AFSPrefetchStats {
+    /// @brief Reads served entirely from staged data.
+    unsigned int hits;
+
+    /// @brief Reads that took over a prefetch that was still in progress.
+    unsigned int partial_hits;
+
+    /// @brief Reads that had to go to the disc.
+    unsigned int misses;
+
+    /// @brief Prefetches dropped before they finished.
+    unsigned int cancelled;
+
+    size_t read_bytes;
+    size_t wasted_bytes;
+    size_t staged_bytes;
+} AFSPrefetchStats;
+
+/// @brief Open the game archive.
+/// @param file_path Path to `SF33RD.AFS`, or to an ISO9660 image of the game disc that contains it.
+/// @param index_path Path to cache the parsed table of contents at, or `NULL` to always parse it.
+bool AFS_Init(const char* file_path, const char* index_path);
+
+/// @brief Check whether a file is an AFS archive, or a disc image with the game archive on it.
+bool AFS_IsValidSource(const char* file_path);
+
 void AFS_Finish();
+
+/// @brief Check whether the archive is read through a memory mapping. Only then can processes forked after
+/// `AFS_Init` read from it, since stream reads go through SDL's I/O threads, which aren't copied to the child.
+/// Mapped reads start a copy thread of their own in each process.
+bool AFS_IsMapped();
+
 unsigned int AFS_GetFileCount();
 unsigned int AFS_GetSize(int file_num);
 
 void AFS_RunServer();
+
+/// @brief Make `AFS_RunServer` wait for all pending reads instead of only collecting finished ones.
+void AFS_SetFrameLocked(bool enabled);
+
 AFSHandle AFS_Open(int file_num);
 void AFS_Read(AFSHandle handle, int sectors, void* buf);
 void AFS_ReadSync(AFSHandle handle, int sectors, void* buf);
+void AFS_Seek(AFSHandle handle, int sector);
 void AFS_Stop(AFSHandle handle);
 void AFS_Close(AFSHandle handle);
+
+/// @brief Close a handle without waiting for the read in flight on it, if any.
+/// @param buf Heap buffer the read goes to. It is freed with `SDL_free` once nothing writes to it anymore.
+void AFS_CloseAndFree(AFSHandle handle, void* buf);
 AFSReadState AFS_GetState(AFSHandle handle);
 unsigned int AFS_GetSectorCount(AFSHandle handle);
 
+/// @brief Set how much memory files read ahead of time may take up, `0` to disable prefetching.
+void AFS_SetPrefetchBudget(size_t bytes);
+
+/// @brief Read a file in the background so that a later `AFS_Read` of it can be served from memory.
+/// @param tag Group (0-31) the prefetch belongs to, for `AFS_CancelPrefetch`.
+void AFS_Prefetch(int file_num, int tag);
+
+/// @brief Drop the prefetches of a group that haven't finished. Finished ones are kept until evicted.
+void AFS_CancelPrefetch(int tag);
+
+void AFS_GetPrefetchStats(AFSPrefetchStats* stats);
+
 #endif
@@ -0,0 +1,110 @@
+#include "port/io/mapped_file.h"
+
+#include <SDL3/SDL.h>
+
+#if defined(_WIN32)
+#include <windows.h>
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+#if defined(_WIN32)
+
+bool MappedFile_Open(MappedFile* file, const char* path) {
+    SDL_zerop(file);
+
+    wchar_t* wide_path = (wchar_t*)SDL_iconv_string("UTF-16LE", "UTF-8", path, SDL_strlen(path) + 1);
+
+    if (wide_path == NULL) {
+        return false;
+    }
+
+    const HANDLE handle =
+        CreateFileW(wide_path, GENERIC_READ, FILE_SHARE_READ, NULL, OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, NULL);
+    SDL_free(wide_path);
+
+    if (handle == INVALID_HANDLE_VALUE) {
+        return false;
+    }
+
+    LARGE_INTEGER size;
+    HANDLE mapping = NULL;
+    const void* data = NULL;
+
+    if (GetFileSizeEx(handle, &size) && (size.QuadPart > 0) && ((Uint64)size.QuadPart <= SIZE_MAX)) {
+        mapping = CreateFileMappingW(handle, NULL, PAGE_READONLY, 0, 0, NULL);
+    }
+
+    // The mapping keeps the file open on its own
+    CloseHandle(handle);
+
+    if (mapping == NULL) {
+        return false;
+    }
+
+    data = MapViewOfFile(mapping, FILE_MAP_READ, 0, 0, 0);
+
+    if (data == NULL) {
+        CloseHandle(mapping);
+        return false;
+    }
+
+    file->data = data;
+    file->size = (size_t)size.QuadPart;
+    file->mapping = mapping;
+    return true;
+}
+
+void MappedFile_Close(MappedFile* file) {
+    if (file->data != NULL) {
+        UnmapViewOfFile(file->data);
+        CloseHandle(file->mapping);
+    }
+
+    SDL_zerop(file);
+}
+
+#else
+
+bool MappedFile_Open(MappedFile* file, const char* path) {
+    struct stat st;
+
+    SDL_zerop(file);
+
+    const int fd = open(path, O_RDONLY);
+
+    if (fd < 0) {
+        return false;
+    }
+
+    if ((fstat(fd, &st) != 0) || (st.st_size <= 0) || ((Uint64)st.st_size > SIZE_MAX)) {
+        close(fd);
+        return false;
+    }
+
+    void* data = mmap(NULL, (size_t)st.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+
+    // The mapping keeps the file open on its own
+    close(fd);
+
+    if (data == MAP_FAILED) {
+        return false;
+    }
+
+    file->data = data;
+    file->size = (size_t)st.st_size;
+    return true;
+}
+
+void MappedFile_Close(MappedFile* file) {
+    if (file->data != NULL) {
+        munmap((void*)file->data, file->size);
+    }
+
+    SDL_zerop(file);
+}
+
+#endif
@@ -0,0 +1,20 @@
+#ifndef PORT_IO_MAPPED_FILE_H
+#define PORT_IO_MAPPED_FILE_H
+
+#include <stdbool.h>
+#include <stddef.h>
+
+/// @brief Read-only view of a whole file, paged in by the OS on access.
+typedef struct MappedFile {
+    const unsigned char* data;
+    size_t size;
+    void* mapping;
+} MappedFile;
+
+/// @brief Map a file into memory.
+/// @return `true` on success. On failure `file` is left zeroed.
+bool MappedFile_Open(MappedFile* file, const char* path);
+
+void MappedFile_Close(MappedFile* file);
+
+#endif
@@ -0,0 +1,380 @@
+#include "port/io/replay_file.h"
+#include "zlib.h"
+
+#include <SDL3/SDL.h>
+#include <stdio.h>
+
+// A replay file is a header followed by chunks, all little endian:
+//
+//   header  magic, version, state layout, info size, info
+//   INPT    player, input words (appended whenever the game's input buffer fills up or a keyframe is taken)
+//   KEYF    frame, input positions, state size, deflated state
+//   INDX    frame count, keyframe count, (frame, file offset) of every keyframe. Written last, on close.
+//
+// Recording only ever appends, so a file that was cut short is valid up to its last complete chunk.
+
+#define REPLAY_MAGIC 0x52585333 // "3SXR"
+#define REPLAY_VERSION 1
+#define REPLAY_HEADER_SIZE 16
+#define REPLAY_CHUNK_HEADER_SIZE 8
+#define REPLAY_KEYFRAME_HEADER_SIZE (4 + REPLAY_PLAYERS * 8 + 4)
+
+#define REPLAY_TAG(a, b, c, d) ((Uint32)(a) | ((Uint32)(b) << 8) | ((Uint32)(c) << 16) | ((Uint32)(d) << 24))
+#define REPLAY_TAG_INPUTS REPLAY_TAG('I', 'N', 'P', 'T')
+#define REPLAY_TAG_KEYFRAME REPLAY_TAG('K', 'E', 'Y', 'F')
+#define REPLAY_TAG_INDEX REPLAY_TAG('I', 'N', 'D', 'X')
+
+typedef struct ReplayKeyframe {
+    Uint32 frame;
+    Uint64 offset; // Offset of the chunk in the file
+} ReplayKeyframe;
+
+typedef struct ReplayInputs {
+    Uint16* words;
+    size_t count;
+    size_t capacity;
+} ReplayInputs;
+
+struct ReplayWriter {
+    SDL_IOStream* io;
+    ReplayKeyframe* keyframes;
+    Uint32 keyframe_count;
+    Uint32 keyframe_capacity;
+    Uint8* deflate_buf;
+    size_t deflate_capacity;
+};
+
+struct ReplayReader {
+    Uint8* data;
+    size_t size;
+    Uint32 state_layout;
+    const Uint8* info;
+    size_t info_size;
+    ReplayInputs inputs[REPLAY_PLAYERS];
+    ReplayKeyframe* keyframes;
+    Uint32 keyframe_count;
+    Uint32 keyframe_capacity;
+    Uint32 frame_count;
+};
+
+static Uint16 get_u16le(const Uint8* src) {
+    return src[0] | (src[1] << 8);
+}
+
+static Uint32 get_u32le(const Uint8* src) {
+    return src[0] | (src[1] << 8) | (src[2] << 16) | ((Uint32)src[3] << 24);
+}
+
+static Uint64 get_u64le(const Uint8* src) {
+    return get_u32le(src) | ((Uint64)get_u32le(src + 4) << 32);
+}
+
+static void push_keyframe(ReplayKeyframe** keyframes, Uint32* count, Uint32* capacity, Uint32 frame, Uint64 offset) {
+    if (*count == *capacity) {
+        *capacity = (*capacity == 0) ? 64 : (*capacity * 2);
+        *keyframes = SDL_realloc(*keyframes, sizeof(ReplayKeyframe) * *capacity);
+    }
+
+    (*keyframes)[*count].frame = frame;
+    (*keyframes)[*count].offset = offset;
+    *count += 1;
+}
+
+static void write_chunk_header(SDL_IOStream* io, Uint32 tag, Uint32 size) {
+    SDL_WriteU32LE(io, tag);
+    SDL_WriteU32LE(io, size);
+}
+
+ReplayWriter* ReplayWriter_Create(const char* path, const void* info, size_t info_size, Uint32 state_layout) {
+    SDL_IOStream* io = SDL_IOFromFile(path, "wb");
+    ReplayWriter* writer;
+
+    if (io == NULL) {
+        printf("Failed to create replay file %s: %s\n", path, SDL_GetError());
+        return NULL;
+    }
+
+    SDL_WriteU32LE(io, REPLAY_MAGIC);
+    SDL_WriteU32LE(io, REPLAY_VERSION);
+    SDL_WriteU32LE(io, state_layout);
+    SDL_WriteU32LE(io, (Uint32)info_size);
+    SDL_WriteIO(io, info, info_size);
+    SDL_FlushIO(io);
+
+    writer = SDL_calloc(1, sizeof(ReplayWriter));
+    writer->io = io;
+    return writer;
+}
+
+void ReplayWriter_WriteInputs(ReplayWriter* writer, int player, const Uint16* words, size_t count) {
+    if (count == 0) {
+        return;
+    }
+
+    write_chunk_header(writer->io, REPLAY_TAG_INPUTS, 4 + (Uint32)count * 2);
+    SDL_WriteU32LE(writer->io, player);
+
+    for (size_t i = 0; i < count; i++) {
+        SDL_WriteU16LE(writer->io, words[i]);
+    }
+}
+
+void ReplayWriter_WriteKeyframe(ReplayWriter* writer, Uint32 frame, const ReplayInputPos inputs[REPLAY_PLAYERS],
+                                const void* state, size_t state_size) {
+    // Worst case growth of deflate, as documented in zlib.h
+    const size_t bound = state_size + state_size / 1000 + 12;
+    uLongf deflated_size;
+
+    if (writer->deflate_capacity < bound) {
+        SDL_free(writer->deflate_buf);
+        writer->deflate_buf = SDL_malloc(bound);
+        writer->deflate_capacity = bound;
+    }
+
+    deflated_size = bound;
+
+    if (compress2(writer->deflate_buf, &deflated_size, state, state_size, Z_BEST_SPEED) != Z_OK) {
+        printf("Failed to compress replay keyframe at frame %u\n", frame);
+        return;
+    }
+
+    push_keyframe(&writer->keyframes, &writer->keyframe_count, &writer->keyframe_capacity, frame, SDL_TellIO(writer->io));
+    write_chunk_header(writer->io, REPLAY_TAG_KEYFRAME, REPLAY_KEYFRAME_HEADER_SIZE + (Uint32)deflated_size);
+    SDL_WriteU32LE(writer->io, frame);
+
+    for (int i = 0; i < REPLAY_PLAYERS; i++) {
+        SDL_WriteU32LE(writer->io, inputs[i].position);
+        SDL_WriteU16LE(writer->io, inputs[i].timer);
+        SDL_WriteU16LE(writer->io, inputs[i].value);
+    }
+
+    SDL_WriteU32LE(writer->io, (Uint32)state_size);
+    SDL_WriteIO(writer->io, writer->deflate_buf, deflated_size);
+    SDL_FlushIO(writer->io);
+}
+
+void ReplayWriter_Close(ReplayWriter* writer, Uint32 frames) {
+    write_chunk_header(writer->io, REPLAY_TAG_INDEX, 8 + writer->keyframe_count * 12);
+    SDL_WriteU32LE(writer->io, frames);
+    SDL_WriteU32LE(writer->io, writer->keyframe_count);
+
+    for (Uint32 i = 0; i < writer->keyframe_count; i++) {
+        SDL_WriteU32LE(writer->io, writer->keyframes[i].frame);
+        SDL_WriteU64LE(writer->io, writer->keyframes[i].offset);
+    }
+
+    if (!SDL_CloseIO(writer->io)) {
+        printf("Failed to finish replay file: %s\n", SDL_GetError());
+    }
+
+    SDL_free(writer->keyframes);
+    SDL_free(writer->deflate_buf);
+    SDL_free(writer);
+}
+
+static void append_inputs(ReplayInputs* inputs, const Uint8* src, size_t count) {
+    if (inputs->count + count > inputs->capacity) {
+        inputs->capacity = SDL_max(inputs->capacity * 2, inputs->count + count);
+        inputs->words = SDL_realloc(inputs->words, sizeof(Uint16) * inputs->capacity);
+    }
+
+    for (size_t i = 0; i < count; i++) {
+        inputs->words[inputs->count + i] = get_u16le(&src[i * 2]);
+    }
+
+    inputs->count += count;
+}
+
+static void read_index(ReplayReader* reader, const Uint8* payload, Uint32 size) {
+    Uint32 count;
+
+    if (size < 8) {
+        return;
+    }
+
+    count = get_u32le(&payload[4]);
+
+    if (size != 8 + (Uint64)count * 12) {
+        return;
+    }
+
+    reader->frame_count = get_u32le(payload);
+    reader->keyframe_count = 0;
+
+    for (Uint32 i = 0; i < count; i++) {
+        const Uint8* entry = &payload[8 + i * 12];
+        push_keyframe(&reader->keyframes,
+                      &reader->keyframe_count,
+                      &reader->keyframe_capacity,
+                      get_u32le(entry),
+                      get_u64le(entry + 4));
+    }
+}
+
+static void read_chunks(ReplayReader* reader) {
+    size_t pos = REPLAY_HEADER_SIZE + reader->info_size;
+    bool has_index = false;
+
+    while (pos + REPLAY_CHUNK_HEADER_SIZE <= reader->size) {
+        const Uint32 tag = get_u32le(&reader->data[pos]);
+        const Uint32 size = get_u32le(&reader->data[pos + 4]);
+        const Uint8* payload = &reader->data[pos + REPLAY_CHUNK_HEADER_SIZE];
+
+        // The recording was cut short in the middle of this chunk
+        if (size > reader->size - pos - REPLAY_CHUNK_HEADER_SIZE) {
+            break;
+        }
+
+        switch (tag) {
+        case REPLAY_TAG_INPUTS:
+            if ((size >= 4) && (get_u32le(payload) < REPLAY_PLAYERS)) {
+                append_inputs(&reader->inputs[get_u32le(payload)], payload + 4, (size - 4) / 2);
+            }
+
+            break;
+
+        case REPLAY_TAG_KEYFRAME:
+            // The index lists the same keyframes, so these are only needed when it is missing
+            if (!has_index && (size >= REPLAY_KEYFRAME_HEADER_SIZE)) {
+                push_keyframe(&reader->keyframes,
+                              &reader->keyframe_count,
+                              &reader->keyframe_capacity,
+                              get_u32le(payload),
+                              pos);
+            }
+
+            break;
+
+        case REPLAY_TAG_INDEX:
+            read_index(reader, payload, size);
+            has_index = (reader->frame_count > 0);
+            break;
+
+        default:
+            // Unknown chunks are skipped, so newer files stay readable
+            break;
+        }
+
+        pos += REPLAY_CHUNK_HEADER_SIZE + size;
+    }
+}
+
+ReplayReader* ReplayReader_Open(const char* path) {
+    ReplayReader* reader = SDL_calloc(1, sizeof(ReplayReader));
+
+    reader->data = SDL_LoadFile(path, &reader->size);
+
+    if (reader->data == NULL) {
+        printf("Failed to load replay file %s: %s\n", path, SDL_GetError());
+        ReplayReader_Close(reader);
+        return NULL;
+    }
+
+    if ((reader->size < REPLAY_HEADER_SIZE) || (get_u32le(reader->data) != REPLAY_MAGIC) ||
+        (get_u32le(&reader->data[4]) != REPLAY_VERSION)) {
+        printf("%s is not a replay file this version can play\n", path);
+        ReplayReader_Close(reader);
+        return NULL;
+    }
+
+    reader->state_layout = get_u32le(&reader->data[8]);
+    reader->info_size = get_u32le(&reader->data[12]);
+    reader->info = &reader->data[REPLAY_HEADER_SIZE];
+
+    if (reader->info_size > reader->size - REPLAY_HEADER_SIZE) {
+        printf("Replay file %s is truncated\n", path);
+        ReplayReader_Close(reader);
+        return NULL;
+    }
+
+    read_chunks(reader);
+    return reader;
+}
+
+void ReplayReader_Close(ReplayReader* reader) {
+    if (reader == NULL) {
+        return;
+    }
+
+    for (int i = 0; i < REPLAY_PLAYERS; i++) {
+        SDL_free(reader->inputs[i].words);
+    }
+
+    SDL_free(reader->keyframes);
+    SDL_free(reader->data);
+    SDL_free(reader);
+}
+
+const void* ReplayReader_GetInfo(const ReplayReader* reader, size_t* size) {
+    *size = reader->info_size;
+    return reader->info;
+}
+
+Uint32 ReplayReader_GetStateLayout(const ReplayReader* reader) {
+    return reader->state_layout;
+}
+
+size_t ReplayReader_GetInputs(const ReplayReader* reader, int player, const Uint16** words) {
+    *words = reader->inputs[player].words;
+    return reader->inputs[player].count;
+}
+
+Uint32 ReplayReader_GetFrameCount(const ReplayReader* reader) {
+    return reader->frame_count;
+}
+
+int ReplayReader_FindKeyframe(const ReplayReader* reader, Uint32 frame) {
+    int found = -1;
+
+    // Keyframes are in recording order
+    for (Uint32 i = 0; i < reader->keyframe_count; i++) {
+        if (reader->keyframes[i].frame > frame) {
+            break;
+        }
+
+        found = i;
+    }
+
+    return found;
+}
+
+Uint32 ReplayReader_GetKeyframeFrame(const ReplayReader* reader, int index) {
+    return reader->keyframes[index].frame;
+}
+
+bool ReplayReader_LoadKeyframe(const ReplayReader* reader, int index, Uint32* frame,
+                               ReplayInputPos inputs[REPLAY_PLAYERS], void* state, size_t state_size) {
+    const Uint64 offset = reader->keyframes[index].offset;
+    const Uint8* payload;
+    Uint32 size;
+    uLongf inflated_size = state_size;
+
+    if (offset + REPLAY_CHUNK_HEADER_SIZE > reader->size) {
+        return false;
+    }
+
+    size = get_u32le(&reader->data[offset + 4]);
+    payload = &reader->data[offset + REPLAY_CHUNK_HEADER_SIZE];
+
+    if ((get_u32le(&reader->data[offset]) != REPLAY_TAG_KEYFRAME) || (size < REPLAY_KEYFRAME_HEADER_SIZE) ||
+        (size > reader->size - offset - REPLAY_CHUNK_HEADER_SIZE) ||
+        (get_u32le(&payload[REPLAY_KEYFRAME_HEADER_SIZE - 4]) != state_size)) {
+        return false;
+    }
+
+    if ((uncompress(state, &inflated_size, &payload[REPLAY_KEYFRAME_HEADER_SIZE], size - REPLAY_KEYFRAME_HEADER_SIZE) !=
+         Z_OK) ||
+        (inflated_size != state_size)) {
+        return false;
+    }
+
+    *frame = get_u32le(payload);
+
+    for (int i = 0; i < REPLAY_PLAYERS; i++) {
+        inputs[i].position = get_u32le(&payload[4 + i * 8]);
+        inputs[i].timer = get_u16le(&payload[8 + i * 8]);
+        inputs[i].value = get_u16le(&payload[10 + i * 8]);
+    }
+
+    return true;
+}
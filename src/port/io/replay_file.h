@@ -0,0 +1,69 @@
+#ifndef PORT_IO_REPLAY_FILE_H
+#define PORT_IO_REPLAY_FILE_H
+
+#include <SDL3/SDL.h>
+
+#include <stdbool.h>
+#include <stddef.h>
+
+#define REPLAY_PLAYERS 2
+
+/// @brief Where each player's input stream stood when a keyframe was taken.
+typedef struct ReplayInputPos {
+    /// @brief Number of input words recorded before the keyframe.
+    Uint32 position;
+
+    /// @brief Frames spent so far in the run that hasn't been written yet, `0` if there is none.
+    Uint16 timer;
+
+    /// @brief Input of the run that hasn't been written yet.
+    Uint16 value;
+} ReplayInputPos;
+
+typedef struct ReplayWriter ReplayWriter;
+typedef struct ReplayReader ReplayReader;
+
+/// @brief Create a replay file and write its header.
+/// @param info Match setup, stored as is.
+/// @param state_layout Identifies the layout of keyframe state, see `ReplayReader_GetStateLayout`.
+ReplayWriter* ReplayWriter_Create(const char* path, const void* info, size_t info_size, Uint32 state_layout);
+
+/// @brief Append recorded input words of one player.
+void ReplayWriter_WriteInputs(ReplayWriter* writer, int player, const Uint16* words, size_t count);
+
+/// @brief Append a keyframe and flush the file, so that a recording cut short is still playable up to here.
+void ReplayWriter_WriteKeyframe(ReplayWriter* writer, Uint32 frame, const ReplayInputPos inputs[REPLAY_PLAYERS],
+                                const void* state, size_t state_size);
+
+/// @brief Write the keyframe index and close the file.
+/// @param frames Length of the recording in frames.
+void ReplayWriter_Close(ReplayWriter* writer, Uint32 frames);
+
+/// @brief Load a replay file. Files without an index (recordings that were cut short) are accepted.
+ReplayReader* ReplayReader_Open(const char* path);
+
+void ReplayReader_Close(ReplayReader* reader);
+
+const void* ReplayReader_GetInfo(const ReplayReader* reader, size_t* size);
+Uint32 ReplayReader_GetStateLayout(const ReplayReader* reader);
+
+/// @brief Get all input words of a player.
+/// @return Number of words.
+size_t ReplayReader_GetInputs(const ReplayReader* reader, int player, const Uint16** words);
+
+/// @brief Get the length of the recording in frames, `0` if the file has no index.
+Uint32 ReplayReader_GetFrameCount(const ReplayReader* reader);
+
+/// @brief Find the last keyframe at or before a frame.
+/// @return Keyframe index, or `-1` if there is none.
+int ReplayReader_FindKeyframe(const ReplayReader* reader, Uint32 frame);
+
+/// @brief Get the frame a keyframe was taken at.
+Uint32 ReplayReader_GetKeyframeFrame(const ReplayReader* reader, int index);
+
+/// @brief Decompress a keyframe.
+/// @param state Buffer of `state_size` bytes, which must match the size the keyframe was written with.
+bool ReplayReader_LoadKeyframe(const ReplayReader* reader, int index, Uint32* frame,
+                               ReplayInputPos inputs[REPLAY_PLAYERS], void* state, size_t state_size);
+
+#endif
@@ -0,0 +1,159 @@
+#include "port/options.h"
+
+#include <errno.h>
+#include <limits.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+Options options = { .prefetch_cache_mb = 32, .replay_keyframe_seconds = 5, .farm_difficulty_last = 7 };
+
+static void print_usage(const char* program) {
+    printf("Usage: %s [options]\n", program);
+    printf("  --frame-locked-audio     Render audio per frame, without an audio device\n");
+    printf("  --audio-dump <file.wav>  Write frame-locked audio to a WAV file\n");
+    printf("  --capture <file.mkv>     Capture the game screen and audio losslessly to a video file\n");
+    printf("  --fast-forward           Don't limit the frame rate\n");
+    printf("  --software-render        Draw the game screen on the CPU, also in batch runs, to hash every frame\n");
+    printf("  --pcm-cache <MB>         Pre-decode sound effect banks, using up to MB of memory\n");
+    printf("  --prefetch-cache <MB>    Read ahead the hovered character and stage, using up to MB (default 32)\n");
+    printf("  --record-replays <dir>   Stream versus and network matches to replay files in dir\n");
+    printf("  --replay <file>          Play a replay file from the Replay menu\n");
+    printf("  --replay-seek <seconds>  Start replay file playback at this time\n");
+    printf("  --replay-keyframe <s>    Seconds between keyframes in recorded replays (default 5)\n");
+    printf("  --state-hash-log <file>  Log state hashes of recorded and replayed matches for desync checks\n");
+    printf("  --state-dump <file>      Dump the full state of recorded and replayed matches every frame\n");
+    printf("  --batch <list>           Run the replay files listed in a file headless and exit\n");
+    printf("  --batch-jobs <N>         Replays or farm matches to run at once (default: one per CPU core)\n");
+    printf("  --batch-output <file>    Write the results of batch replays to a file\n");
+    printf("  --batch-frames <dir>     With --software-render, write the image hash of every batch frame to dir\n");
+    printf("  --batch-capture <dir>    With --software-render, capture every batch replay to a video file in dir\n");
+    printf("  --cpu-farm <file>        Run CPU vs CPU matches of every pairing headless, write statistics and exit\n");
+    printf("  --farm-difficulty <A-B>  Difficulties to run farm matches at (default 0-7)\n");
+    printf("  --farm-seeds <A-B>       Seeds to run farm matches with, one match each (default 0-0)\n");
+}
+
+/// @brief Parse `A-B`, or `A` for a range of one, of whole decimal numbers between `min` and `max`.
+static bool parse_range(const char* value, int min, int max, int* first, int* last) {
+    const char* start = value;
+    char* end;
+
+    errno = 0;
+    const long first_number = strtol(start, &end, 10);
+    long last_number = first_number;
+
+    if ((end == start) || (errno == ERANGE)) {
+        return false;
+    }
+
+    if (*end == '-') {
+        start = end + 1;
+        last_number = strtol(start, &end, 10);
+
+        if ((end == start) || (errno == ERANGE)) {
+            return false;
+        }
+    }
+
+    if ((*end != '\0') || (first_number < min) || (last_number > max) || (first_number > last_number)) {
+        return false;
+    }
+
+    *first = (int)first_number;
+    *last = (int)last_number;
+    return true;
+}
+
+/// @brief Parse a whole decimal number between `min` and `max`.
+static bool parse_int(const char* value, int min, int max, int* result) {
+    char* end;
+
+    errno = 0;
+    const long number = strtol(value, &end, 10);
+
+    if ((end == value) || (*end != '\0') || (errno == ERANGE) || (number < min) || (number > max)) {
+        return false;
+    }
+
+    *result = (int)number;
+    return true;
+}
+
+bool Options_Parse(int argc, char* argv[]) {
+    for (int i = 1; i < argc; i++) {
+        const char* arg = argv[i];
+        const bool has_value = (i + 1) < argc;
+
+        if (strcmp(arg, "--frame-locked-audio") == 0) {
+            options.frame_locked_audio = true;
+        } else if ((strcmp(arg, "--audio-dump") == 0) && has_value) {
+            options.audio_dump_path = argv[++i];
+            options.frame_locked_audio = true;
+        } else if ((strcmp(arg, "--capture") == 0) && has_value) {
+            options.capture_path = argv[++i];
+            options.frame_locked_audio = true;
+        } else if (strcmp(arg, "--fast-forward") == 0) {
+            options.fast_forward = true;
+        } else if (strcmp(arg, "--software-render") == 0) {
+            options.software_render = true;
+        } else if ((strcmp(arg, "--pcm-cache") == 0) && has_value) {
+            if (!parse_int(argv[++i], 0, 1024 * 1024, &options.pcm_cache_mb)) {
+                print_usage(argv[0]);
+                return false;
+            }
+        } else if ((strcmp(arg, "--prefetch-cache") == 0) && has_value) {
+            if (!parse_int(argv[++i], 0, 1024 * 1024, &options.prefetch_cache_mb)) {
+                print_usage(argv[0]);
+                return false;
+            }
+        } else if ((strcmp(arg, "--record-replays") == 0) && has_value) {
+            options.record_replay_dir = argv[++i];
+        } else if ((strcmp(arg, "--replay") == 0) && has_value) {
+            options.replay_path = argv[++i];
+        } else if ((strcmp(arg, "--replay-seek") == 0) && has_value) {
+            if (!parse_int(argv[++i], 0, INT_MAX / 60, &options.replay_seek_seconds)) {
+                print_usage(argv[0]);
+                return false;
+            }
+        } else if ((strcmp(arg, "--replay-keyframe") == 0) && has_value) {
+            if (!parse_int(argv[++i], 1, INT_MAX / 60, &options.replay_keyframe_seconds)) {
+                print_usage(argv[0]);
+                return false;
+            }
+        } else if ((strcmp(arg, "--state-hash-log") == 0) && has_value) {
+            options.state_hash_log_path = argv[++i];
+        } else if ((strcmp(arg, "--state-dump") == 0) && has_value) {
+            options.state_dump_path = argv[++i];
+        } else if ((strcmp(arg, "--batch") == 0) && has_value) {
+            options.batch_list_path = argv[++i];
+        } else if ((strcmp(arg, "--batch-jobs") == 0) && has_value) {
+            if (!parse_int(argv[++i], 0, 1024, &options.batch_jobs)) {
+                print_usage(argv[0]);
+                return false;
+            }
+        } else if ((strcmp(arg, "--batch-output") == 0) && has_value) {
+            options.batch_output_path = argv[++i];
+        } else if ((strcmp(arg, "--batch-frames") == 0) && has_value) {
+            options.batch_frame_hash_dir = argv[++i];
+        } else if ((strcmp(arg, "--batch-capture") == 0) && has_value) {
+            options.batch_capture_dir = argv[++i];
+        } else if ((strcmp(arg, "--cpu-farm") == 0) && has_value) {
+            options.cpu_farm_path = argv[++i];
+        } else if ((strcmp(arg, "--farm-difficulty") == 0) && has_value) {
+            if (!parse_range(argv[++i], 0, INT_MAX, &options.farm_difficulty_first, &options.farm_difficulty_last)) {
+                print_usage(argv[0]);
+                return false;
+            }
+        } else if ((strcmp(arg, "--farm-seeds") == 0) && has_value) {
+            if (!parse_range(argv[++i], 0, INT_MAX, &options.farm_seed_first, &options.farm_seed_last)) {
+                print_usage(argv[0]);
+                return false;
+            }
+        } else {
+            print_usage(argv[0]);
+            return false;
+        }
+    }
+
+    return true;
+}
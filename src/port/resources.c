@@ -1,11 +1,15 @@
 #include "port/resources.h"
+#include "port/io/afs.h"
 #include "port/sdl/sdl_app.h"
 
 #include <SDL3/SDL.h>
 
-typedef enum FlowState { INIT, DIALOG_OPENED, COPY_ERROR, COPY_SUCCESS } ResourceCopyingFlowState;
+// Remembers where the game files were found, so that they can be read in place
+#define SOURCE_FILE "source.txt"
 
-static ResourceCopyingFlowState flow_state = INIT;
+typedef enum FlowState { INIT, DIALOG_OPENED, LOCATE_ERROR, LOCATE_SUCCESS } ResourceLocatingFlowState;
+
+static ResourceLocatingFlowState flow_state = INIT;
 
 static bool file_exists(const char* path) {
     SDL_PathInfo path_info;
@@ -26,25 +30,69 @@ static void create_resources_directory() {
     SDL_free(path);
 }
 
-static bool copy_file(const char* rom_path, const char* src_name, const char* dst_name) {
-    char* src_path = NULL;
-    char* dst_path = Resources_GetPath(dst_name);
-    SDL_asprintf(&src_path, "%s/%s", rom_path, src_name);
+static char* load_source_path() {
+    char* path = Resources_GetPath(SOURCE_FILE);
+    char* source = SDL_LoadFile(path, NULL);
+    SDL_free(path);
+    return source;
+}
 
-    create_resources_directory();
-    const bool success = SDL_CopyFile(src_path, dst_path);
+/// @brief Find the game archive in a folder, either as an extracted file or inside a disc image.
+/// @return Path to the file to read the archive from, or `NULL` if there is none.
+static char* find_source(const char* rom_path) {
+    char* source = NULL;
+    char** images;
+    int count = 0;
+
+    SDL_asprintf(&source, "%s/%s", rom_path, "THIRD/SF33RD.AFS");
+
+    if (file_exists(source)) {
+        return source;
+    }
+
+    SDL_free(source);
+    source = NULL;
+    images = SDL_GlobDirectory(rom_path, "*.iso", SDL_GLOB_CASEINSENSITIVE, &count);
+
+    for (int i = 0; (images != NULL) && (i < count); i++) {
+        SDL_asprintf(&source, "%s/%s", rom_path, images[i]);
+
+        if (AFS_IsValidSource(source)) {
+            break;
+        }
+
+        SDL_free(source);
+        source = NULL;
+    }
+
+    SDL_free(images);
+    return source;
+}
+
+static bool save_source_path(const char* source) {
+    char* path = Resources_GetPath(SOURCE_FILE);
 
-    SDL_free(src_path);
-    SDL_free(dst_path);
+    create_resources_directory();
+    const bool success = SDL_SaveFile(path, source, SDL_strlen(source) + 1);
 
+    SDL_free(path);
     return success;
 }
 
 static void open_folder_dialog_callback(void* userdata, const char* const* filelist, int filter) {
-    const char* rom_path = filelist[0];
-    bool success = true;
-    success &= copy_file(rom_path, "THIRD/SF33RD.AFS", "SF33RD.AFS");
-    flow_state = success ? COPY_SUCCESS : COPY_ERROR;
+    char* source = NULL;
+    bool success = false;
+
+    if ((filelist != NULL) && (filelist[0] != NULL)) {
+        source = find_source(filelist[0]);
+    }
+
+    if (source != NULL) {
+        success = save_source_path(source);
+        SDL_free(source);
+    }
+
+    flow_state = success ? LOCATE_SUCCESS : LOCATE_ERROR;
 }
 
 char* Resources_GetPath(const char* file_path) {
@@ -61,12 +109,32 @@ char* Resources_GetPath(const char* file_path) {
     return full_path;
 }
 
+char* Resources_GetAFSPath() {
+    char* source;
+
+    // Archives copied by earlier versions take precedence
+    if (check_if_file_present("SF33RD.AFS")) {
+        return Resources_GetPath("SF33RD.AFS");
+    }
+
+    source = load_source_path();
+
+    if ((source != NULL) && !file_exists(source)) {
+        SDL_free(source);
+        source = NULL;
+    }
+
+    return source;
+}
+
 bool Resources_CheckIfPresent() {
-    const bool afs_present = check_if_file_present("SF33RD.AFS");
+    char* afs_path = Resources_GetAFSPath();
+    const bool afs_present = afs_path != NULL;
+    SDL_free(afs_path);
     return afs_present;
 }
 
-bool Resources_RunResourceCopyingFlow() {
+bool Resources_RunResourceLocatingFlow() {
     switch (flow_state) {
     case INIT:
         SDL_ShowSimpleMessageBox(SDL_MESSAGEBOX_INFORMATION,
@@ -82,21 +150,22 @@ bool Resources_RunResourceCopyingFlow() {
         // Wait for the callback to be called
         break;
 
-    case COPY_ERROR:
+    case LOCATE_ERROR:
         SDL_ShowSimpleMessageBox(SDL_MESSAGEBOX_ERROR,
                                  "Invalid directory",
-                                 "The directory you provided doesn't contain the required files",
+                                 "The directory you provided doesn't contain the game files or a disc image of "
+                                 "the game",
                                  window);
         flow_state = DIALOG_OPENED;
         SDL_ShowOpenFolderDialog(open_folder_dialog_callback, NULL, window, NULL, false);
         break;
 
-    case COPY_SUCCESS:
-        char* resources_path = Resources_GetPath(NULL);
+    case LOCATE_SUCCESS:
+        char* source = load_source_path();
         char* message = NULL;
-        SDL_asprintf(&message, "You can find them at:\n%s", resources_path);
-        SDL_ShowSimpleMessageBox(SDL_MESSAGEBOX_INFORMATION, "Resources copied successfully", message, window);
-        SDL_free(resources_path);
+        SDL_asprintf(&message, "3SX will read them from:\n%s", source);
+        SDL_ShowSimpleMessageBox(SDL_MESSAGEBOX_INFORMATION, "Resources found", message, window);
+        SDL_free(source);
         SDL_free(message);
         flow_state = INIT;
         return true;
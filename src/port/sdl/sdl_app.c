@@ -1,11 +1,19 @@
 #include "port/sdl/sdl_app.h"
 #include "common.h"
+#include "port/options.h"
 #include "port/sound/adx.h"
+#include "port/sound/emlShim.h"
+#include "port/sound/mixer.h"
+#include "port/sound/offline_audio.h"
+#include "port/sound/spu.h"
+#include "port/sdl/sdl_capture.h"
+#include "port/sdl/sdl_debug_text.h"
 #include "port/sdl/sdl_game_renderer.h"
 #include "port/sdl/sdl_message_renderer.h"
 #include "port/sdl/sdl_pad.h"
 #include "sf33rd/AcrSDK/ps2/foundaps2.h"
 #include "sf33rd/Source/Game/main.h"
+#include "sf33rd/Source/Game/system/replay_stream.h"
 
 #include <SDL3/SDL.h>
 
@@ -33,6 +41,9 @@ static bool should_save_screenshot = false;
 static Uint64 last_mouse_motion_time = 0;
 static const int mouse_hide_delay_ms = 2000; // 2 seconds
 
+// F5 and F6 jump this far back and forward in replay file playback
+static const int replay_seek_frames = 10 * 60;
+
 static void create_screen_texture() {
     if (screen_texture != NULL) {
         SDL_DestroyTexture(screen_texture);
@@ -50,7 +61,22 @@ int SDLApp_Init() {
     SDL_SetHint(SDL_HINT_VIDEO_WAYLAND_PREFER_LIBDECOR, "1");
     SDL_SetHint(SDL_HINT_NO_SIGNAL_HANDLERS, "1");
 
-    if (!SDL_Init(SDL_INIT_VIDEO | SDL_INIT_AUDIO | SDL_INIT_GAMEPAD)) {
+    SDL_InitFlags init_flags = SDL_INIT_VIDEO | SDL_INIT_GAMEPAD;
+    SDL_WindowFlags window_flags = SDL_WINDOW_RESIZABLE | SDL_WINDOW_HIGH_PIXEL_DENSITY;
+
+    // Nothing is presented, and forked processes can't share a GPU context
+    if (options.headless) {
+        SDL_SetHint(SDL_HINT_VIDEO_DRIVER, "offscreen");
+        SDL_SetHint(SDL_HINT_RENDER_DRIVER, "software");
+        window_flags |= SDL_WINDOW_HIDDEN;
+        init_flags &= ~SDL_INIT_GAMEPAD;
+    }
+
+    if (!options.frame_locked_audio) {
+        init_flags |= SDL_INIT_AUDIO;
+    }
+
+    if (!SDL_Init(init_flags)) {
         SDL_Log("Couldn't initialize SDL: %s", SDL_GetError());
         return 1;
     }
@@ -58,7 +84,7 @@ int SDLApp_Init() {
     if (!SDL_CreateWindowAndRenderer(app_name,
                                      window_default_width,
                                      window_default_height,
-                                     SDL_WINDOW_RESIZABLE | SDL_WINDOW_HIGH_PIXEL_DENSITY,
+                                     window_flags,
                                      &window,
                                      &renderer)) {
         SDL_Log("Couldn't create window/renderer: %s", SDL_GetError());
@@ -70,6 +96,9 @@ int SDLApp_Init() {
     // Initialize message renderer
     SDLMessageRenderer_Initialize(renderer);
 
+    // Initialize debug text overlay
+    SDLDebugText_Initialize(renderer);
+
     // Initialize game renderer
     SDLGameRenderer_Init(renderer);
 
@@ -79,10 +108,61 @@ int SDLApp_Init() {
     // Initialize pads
     SDLPad_Init();
 
+    // Initialize audio output
+    if (options.frame_locked_audio) {
+        Mixer_Init(false);
+        OfflineAudio_Init(options.audio_dump_path);
+    } else {
+        Mixer_Init(true);
+    }
+
+    SPU_SetPcmCacheBudget((size_t)options.pcm_cache_mb * 1024 * 1024);
+
+    if (options.capture_path != NULL) {
+        SDLApp_StartCapture(options.capture_path);
+    }
+
     return 0;
 }
 
+#if defined(DEBUG)
+static void print_sound_stats() {
+    EmlShimStats stats;
+    struct SPUStats spu_stats;
+
+    SPU_GetStats(&spu_stats);
+
+    if (spu_stats.rendered_frames > 0) {
+        // CPU time per second of audio, to compare runs with and without the PCM cache
+        SDL_Log("SPU: %.3f ms per second of audio, PCM cache %zu KB of %zu KB",
+                (spu_stats.render_time_us / 1000.0) / ((double)spu_stats.rendered_frames / MIXER_SAMPLE_RATE),
+                spu_stats.pcm_cache_bytes / 1024,
+                spu_stats.pcm_cache_budget / 1024);
+    }
+
+    emlShimGetStats(&stats);
+    SDL_Log("Sound commands: queue high-water %d/%d, %d dropped, latency avg %u us, max %u us",
+            stats.queue_high_water,
+            stats.queue_size,
+            stats.dropped_commands,
+            stats.avg_latency_us,
+            stats.max_latency_us);
+}
+#endif
+
 void SDLApp_Quit() {
+#if defined(DEBUG)
+    print_sound_stats();
+#endif
+
+    SDLCapture_Quit();
+
+    if (options.frame_locked_audio) {
+        OfflineAudio_Quit();
+    }
+
+    Mixer_Quit();
+    SDLGameRenderer_Quit();
     SDL_DestroyRenderer(renderer);
     SDL_DestroyWindow(window);
     SDL_Quit();
@@ -94,6 +174,28 @@ static void set_screenshot_flag_if_needed(SDL_KeyboardEvent* event) {
     }
 }
 
+static void handle_debug_text_toggle(SDL_KeyboardEvent* event) {
+    if ((event->key == SDLK_F3) && event->down && !event->repeat) {
+        SDLDebugText_ToggleVisible();
+    }
+}
+
+static void handle_replay_seek(SDL_KeyboardEvent* event) {
+    if (!event->down) {
+        return;
+    }
+
+    switch (event->key) {
+    case SDLK_F5:
+        Seek_Replay_Stream(-replay_seek_frames);
+        break;
+
+    case SDLK_F6:
+        Seek_Replay_Stream(replay_seek_frames);
+        break;
+    }
+}
+
 static void handle_fullscreen_toggle(SDL_KeyboardEvent* event) {
     const bool is_alt_enter = (event->key == SDLK_RETURN) && (event->mod & SDL_KMOD_ALT);
     const bool is_f11 = (event->key == SDLK_F11);
@@ -149,6 +251,8 @@ bool SDLApp_PollEvents() {
         case SDL_EVENT_KEY_UP:
             set_screenshot_flag_if_needed(&event.key);
             handle_fullscreen_toggle(&event.key);
+            handle_debug_text_toggle(&event.key);
+            handle_replay_seek(&event.key);
             SDLPad_HandleKeyboardEvent(&event.key);
             break;
 
@@ -170,6 +274,9 @@ bool SDLApp_PollEvents() {
 }
 
 void SDLApp_BeginFrame() {
+    // The last frame's canvas is read back before anything of this one is drawn
+    SDLCapture_BeginFrame();
+
     // Clear window
     SDL_SetRenderDrawColor(renderer, 0, 0, 0, SDL_ALPHA_OPAQUE);
     SDL_SetRenderTarget(renderer, NULL);
@@ -235,14 +342,22 @@ void SDLApp_EndFrame() {
     // Run sound processing
     ADX_ProcessTracks();
 
+    if (options.frame_locked_audio) {
+        OfflineAudio_RunFrame();
+    }
+
     // Render
 
     SDLGameRenderer_RenderFrame();
+    SDLMessageRenderer_RenderFrame();
+    SDLDebugText_Render(message_canvas);
 
     if (should_save_screenshot) {
         save_texture(cps3_canvas, "screenshot_cps3.bmp");
     }
 
+    SDLCapture_Frame(renderer, cps3_canvas);
+
     SDL_SetRenderTarget(renderer, screen_texture);
 
     // Render window background
@@ -286,7 +401,9 @@ void SDLApp_EndFrame() {
         frame_deadline = now + target_frame_time_ns;
     }
 
-    if (now < frame_deadline) {
+    if (options.fast_forward) {
+        frame_deadline = now;
+    } else if (now < frame_deadline) {
         Uint64 sleep_time = frame_deadline - now;
         SDL_DelayNS(sleep_time);
         now = SDL_GetTicksNS();
@@ -305,6 +422,41 @@ void SDLApp_EndFrame() {
     update_fps();
 }
 
+void SDLApp_SkipFrame() {
+    SDLMessageRenderer_DiscardFrame();
+    SDLGameRenderer_EndFrame();
+}
+
+void SDLApp_BeginHeadlessFrame() {
+    if (options.software_render) {
+        SDLGameRenderer_BeginFrame();
+    }
+}
+
+void SDLApp_EndHeadlessFrame(bool with_audio) {
+    // Screen transitions wait for voices and streams to finish, so they need sound to run
+    if (with_audio) {
+        ADX_ProcessTracks();
+        OfflineAudio_RunFrame();
+    }
+
+    // The software renderer doesn't need the GPU, so frames can be drawn, hashed and captured
+    if (options.software_render) {
+        SDLGameRenderer_RenderFrame();
+        SDLCapture_Frame(renderer, cps3_canvas);
+    }
+
+    SDLApp_SkipFrame();
+}
+
+bool SDLApp_StartCapture(const char* path) {
+    return SDLCapture_Init(path, cps3_canvas->w, cps3_canvas->h);
+}
+
+void SDLApp_StopCapture() {
+    SDLCapture_Quit();
+}
+
 void SDLApp_Exit() {
     SDL_Event quit_event;
     quit_event.type = SDL_EVENT_QUIT;
@@ -0,0 +1,597 @@
+/**
+ * @file sdl_capture.c
+ * Video capture of the game canvas
+ *
+ * Each presented frame, the canvas is copied into a surface that goes into a ring of slots together with the
+ * audio mixed for that frame. A worker thread takes the slots in order, converts the pixels and encodes them, so the
+ * main thread only pays for the copy. When the worker falls a whole ring behind, the main thread waits for it
+ * rather than dropping frames, so the file always has every frame in order.
+ *
+ * With the software renderer, the copy is a memcpy of its pixels into a surface the slot keeps. Otherwise the
+ * canvas has to be read back from the GPU, and reading it right after it was drawn would wait for the GPU to finish
+ * the frame. The readback is deferred to the start of the next frame instead: the canvas isn't redrawn before then,
+ * and the GPU finishes drawing it while the frame is presented and paced, so only the transfer is left. Debug builds
+ * log how long the copies took.
+ */
+
+#include "port/sdl/sdl_capture.h"
+#include "port/options.h"
+#include "port/sdl/sdl_soft_renderer.h"
+#include "port/sound/mixer.h"
+#include "port/sound/offline_audio.h"
+
+#include <SDL3/SDL.h>
+
+#include <libavcodec/avcodec.h>
+#include <libavformat/avformat.h>
+#include <libavutil/avutil.h>
+#include <libavutil/channel_layout.h>
+
+#include <stdio.h>
+
+#define RING_SLOTS 8
+#define FNV_OFFSET_BASIS 0xCBF29CE484222325ULL
+#define FNV_PRIME 0x100000001B3ULL
+
+// 59.59949 frames per second, the same rate the frame pacing in sdl_app.c targets
+static const AVRational frame_time_base = { 100000, 5959949 };
+
+typedef struct CaptureSlot {
+    SDL_Surface* surface;     // Copied canvas, NULL if the readback failed
+    SDL_Surface* soft_pixels; // Kept between frames for the pixels of the software renderer
+    int num_audio_frames;
+    s16 audio[MIXER_MAX_GAME_FRAME_FRAMES * MIXER_CHANNELS];
+} CaptureSlot;
+
+typedef struct CaptureStream {
+    AVCodecContext* context;
+    AVStream* stream;
+    AVFrame* frame;
+    int64_t next_pts;
+} CaptureStream;
+
+static bool is_capturing = false;
+static int width;
+static int height;
+static AVFormatContext* format = NULL;
+static AVPacket* packet = NULL;
+static CaptureStream video = { 0 };
+static CaptureStream audio = { 0 };
+
+// Only touched by the worker thread while it runs
+static bool has_failed = false;
+static Uint64 captured_frames = 0;
+
+#if defined(DEBUG)
+static u64 hash = FNV_OFFSET_BASIS;
+
+// Only touched by the main thread
+static Uint64 copy_ticks = 0;
+static Uint64 max_copy_ticks = 0;
+#endif
+
+static CaptureSlot ring[RING_SLOTS];
+static int ring_head = 0;  // Slot the worker encodes next
+static int ring_count = 0; // Number of slots waiting for the worker
+
+// Slot whose canvas is read back at the start of the next frame, NULL if there is none
+static CaptureSlot* pending_slot = NULL;
+static SDL_Renderer* pending_renderer = NULL;
+static SDL_Texture* pending_canvas = NULL;
+static bool is_stopping = false;
+static SDL_Mutex* ring_mutex = NULL;
+static SDL_Condition* slot_filled = NULL;
+static SDL_Condition* slot_freed = NULL;
+static SDL_Thread* worker = NULL;
+
+static void print_av_error(int errnum) {
+    char errbuf[AV_ERROR_MAX_STRING_SIZE] = { 0 };
+    av_strerror(errnum, errbuf, sizeof(errbuf));
+    fprintf(stderr, "FFmpeg error: %s\n", errbuf);
+}
+
+static AVCodecContext* alloc_encoder(enum AVCodecID id) {
+    const AVCodec* codec = avcodec_find_encoder(id);
+
+    if (codec == NULL) {
+        SDL_Log("The %s encoder isn't available, rebuild the dependencies with build-deps.sh", avcodec_get_name(id));
+        return NULL;
+    }
+
+    return avcodec_alloc_context3(codec);
+}
+
+/// @brief Open the encoder of `cs`, once its context has been set up, and add its stream to the file.
+static bool open_stream(CaptureStream* cs) {
+    int ret;
+
+    if (format->oformat->flags & AVFMT_GLOBALHEADER) {
+        cs->context->flags |= AV_CODEC_FLAG_GLOBAL_HEADER;
+    }
+
+    ret = avcodec_open2(cs->context, cs->context->codec, NULL);
+
+    if (ret < 0) {
+        print_av_error(ret);
+        return false;
+    }
+
+    cs->stream = avformat_new_stream(format, NULL);
+    cs->frame = av_frame_alloc();
+
+    if ((cs->stream == NULL) || (cs->frame == NULL)) {
+        return false;
+    }
+
+    cs->stream->time_base = cs->context->time_base;
+    ret = avcodec_parameters_from_context(cs->stream->codecpar, cs->context);
+
+    if (ret < 0) {
+        print_av_error(ret);
+        return false;
+    }
+
+    return true;
+}
+
+static bool open_video() {
+    AVFrame* frame;
+    int ret;
+
+    video.context = alloc_encoder(AV_CODEC_ID_FFV1);
+
+    if (video.context == NULL) {
+        return false;
+    }
+
+    video.context->width = width;
+    video.context->height = height;
+    video.context->pix_fmt = AV_PIX_FMT_0RGB32;
+    video.context->time_base = frame_time_base;
+    video.context->framerate = av_inv_q(frame_time_base);
+
+    if (!open_stream(&video)) {
+        return false;
+    }
+
+    frame = video.frame;
+    frame->format = video.context->pix_fmt;
+    frame->width = width;
+    frame->height = height;
+    ret = av_frame_get_buffer(frame, 0);
+
+    if (ret < 0) {
+        print_av_error(ret);
+        return false;
+    }
+
+    // Stands in for frames whose readback failed until a good one arrives
+    SDL_memset(frame->data[0], 0, frame->linesize[0] * height);
+    return true;
+}
+
+static bool open_audio() {
+    const AVChannelLayout ch_layout = AV_CHANNEL_LAYOUT_STEREO;
+    AVFrame* frame;
+    int ret;
+
+    audio.context = alloc_encoder(AV_CODEC_ID_PCM_S16LE);
+
+    if (audio.context == NULL) {
+        return false;
+    }
+
+    audio.context->sample_fmt = AV_SAMPLE_FMT_S16;
+    audio.context->sample_rate = MIXER_SAMPLE_RATE;
+    audio.context->time_base = (AVRational) { 1, MIXER_SAMPLE_RATE };
+    av_channel_layout_copy(&audio.context->ch_layout, &ch_layout);
+
+    if (!open_stream(&audio)) {
+        return false;
+    }
+
+    // PCM takes frames of any size, so each one holds the samples of one game frame
+    frame = audio.frame;
+    frame->format = audio.context->sample_fmt;
+    frame->sample_rate = MIXER_SAMPLE_RATE;
+    frame->nb_samples = MIXER_MAX_GAME_FRAME_FRAMES;
+    av_channel_layout_copy(&frame->ch_layout, &ch_layout);
+    ret = av_frame_get_buffer(frame, 0);
+
+    if (ret < 0) {
+        print_av_error(ret);
+        return false;
+    }
+
+    return true;
+}
+
+/// @brief Encode `frame`, or flush the encoder if it's `NULL`, and write the packets that come out to the file.
+static bool encode(CaptureStream* cs, AVFrame* frame) {
+    int ret = avcodec_send_frame(cs->context, frame);
+
+    while (ret >= 0) {
+        ret = avcodec_receive_packet(cs->context, packet);
+
+        if ((ret == AVERROR(EAGAIN)) || (ret == AVERROR_EOF)) {
+            return true;
+        }
+
+        if (ret < 0) {
+            break;
+        }
+
+        av_packet_rescale_ts(packet, cs->context->time_base, cs->stream->time_base);
+        packet->stream_index = cs->stream->index;
+        ret = av_interleaved_write_frame(format, packet);
+    }
+
+    print_av_error(ret);
+    return false;
+}
+
+#if defined(DEBUG)
+/// @brief Hash the red, green and blue of every pixel, so that the result doesn't depend on the host.
+static void hash_pixels(const AVFrame* frame) {
+    for (int y = 0; y < height; y++) {
+        const Uint32* row = (const Uint32*)(frame->data[0] + y * frame->linesize[0]);
+
+        for (int x = 0; x < width; x++) {
+            hash = (hash ^ ((row[x] >> 16) & 0xFF)) * FNV_PRIME;
+            hash = (hash ^ ((row[x] >> 8) & 0xFF)) * FNV_PRIME;
+            hash = (hash ^ (row[x] & 0xFF)) * FNV_PRIME;
+        }
+    }
+}
+#endif
+
+static bool encode_slot(const CaptureSlot* slot) {
+    AVFrame* frame = video.frame;
+    int ret;
+
+    ret = av_frame_make_writable(frame);
+
+    if (ret < 0) {
+        print_av_error(ret);
+        return false;
+    }
+
+    // AV_PIX_FMT_0RGB32 is a native-endian 0x00RRGGBB word, the same as SDL_PIXELFORMAT_XRGB8888
+    if ((slot->surface == NULL) || (slot->surface->w != width) || (slot->surface->h != height) ||
+        !SDL_ConvertPixels(width,
+                           height,
+                           slot->surface->format,
+                           slot->surface->pixels,
+                           slot->surface->pitch,
+                           SDL_PIXELFORMAT_XRGB8888,
+                           frame->data[0],
+                           frame->linesize[0])) {
+        SDL_Log("Couldn't read back captured frame %" SDL_PRIu64 ", repeating the previous one", captured_frames);
+    }
+
+#if defined(DEBUG)
+    hash_pixels(frame);
+#endif
+    frame->pts = video.next_pts++;
+
+    if (!encode(&video, frame)) {
+        return false;
+    }
+
+    if (slot->num_audio_frames == 0) {
+        return true;
+    }
+
+    frame = audio.frame;
+    ret = av_frame_make_writable(frame);
+
+    if (ret < 0) {
+        print_av_error(ret);
+        return false;
+    }
+
+    frame->nb_samples = slot->num_audio_frames;
+    frame->pts = audio.next_pts;
+    audio.next_pts += slot->num_audio_frames;
+    SDL_memcpy(frame->data[0], slot->audio, slot->num_audio_frames * MIXER_CHANNELS * sizeof(s16));
+    return encode(&audio, frame);
+}
+
+static int SDLCALL run_worker(void* data) {
+    CaptureSlot* slot;
+
+    while (true) {
+        SDL_LockMutex(ring_mutex);
+
+        while ((ring_count == 0) && !is_stopping) {
+            SDL_WaitCondition(slot_filled, ring_mutex);
+        }
+
+        if (ring_count == 0) {
+            SDL_UnlockMutex(ring_mutex);
+            break;
+        }
+
+        slot = &ring[ring_head];
+        SDL_UnlockMutex(ring_mutex);
+
+        // Keep taking slots after an error, so that the game never waits on a worker that has given up
+        if (!has_failed) {
+            has_failed = !encode_slot(slot);
+
+            if (has_failed) {
+                SDL_Log("Capture failed after %" SDL_PRIu64 " frames, the rest of the game isn't captured",
+                        captured_frames);
+            } else {
+                captured_frames += 1;
+            }
+        }
+
+        if (slot->surface != slot->soft_pixels) {
+            SDL_DestroySurface(slot->surface);
+        }
+
+        slot->surface = NULL;
+
+        SDL_LockMutex(ring_mutex);
+        ring_head = (ring_head + 1) % RING_SLOTS;
+        ring_count -= 1;
+        SDL_SignalCondition(slot_freed);
+        SDL_UnlockMutex(ring_mutex);
+    }
+
+    return 0;
+}
+
+static void close_stream(CaptureStream* cs) {
+    av_frame_free(&cs->frame);
+    avcodec_free_context(&cs->context);
+    cs->stream = NULL;
+    cs->next_pts = 0;
+}
+
+static void close_file() {
+    close_stream(&video);
+    close_stream(&audio);
+    av_packet_free(&packet);
+
+    if (format != NULL) {
+        if (!(format->oformat->flags & AVFMT_NOFILE)) {
+            avio_closep(&format->pb);
+        }
+
+        avformat_free_context(format);
+        format = NULL;
+    }
+}
+
+static void destroy_soft_pixels() {
+    for (int i = 0; i < RING_SLOTS; i++) {
+        SDL_DestroySurface(ring[i].soft_pixels);
+        ring[i].soft_pixels = NULL;
+    }
+}
+
+/// @brief Hand the slot after the last filled one over to the worker.
+static void fill_slot() {
+    SDL_LockMutex(ring_mutex);
+    ring_count += 1;
+    SDL_SignalCondition(slot_filled);
+    SDL_UnlockMutex(ring_mutex);
+}
+
+/// @brief Copy the pixels of the software renderer into `slot`.
+/// @return `false` if the canvas is drawn by the GPU instead.
+static bool copy_soft_pixels(CaptureSlot* slot) {
+    const Uint32* soft_pixels = SDLSoftRenderer_GetPixels();
+
+    if ((slot->soft_pixels == NULL) || (soft_pixels == NULL)) {
+        return false;
+    }
+
+    SDL_ConvertPixels(width,
+                      height,
+                      SDL_PIXELFORMAT_RGBA8888,
+                      soft_pixels,
+                      width * sizeof(Uint32),
+                      SDL_PIXELFORMAT_RGBA8888,
+                      slot->soft_pixels->pixels,
+                      slot->soft_pixels->pitch);
+    slot->surface = slot->soft_pixels;
+    return true;
+}
+
+/// @brief Read back the canvas of the pending slot from the GPU and hand the slot over to the worker.
+static void read_back_pending() {
+    SDL_Texture* previous_target;
+
+    if (pending_slot == NULL) {
+        return;
+    }
+
+#if defined(DEBUG)
+    const Uint64 copy_start = SDL_GetPerformanceCounter();
+#endif
+
+    previous_target = SDL_GetRenderTarget(pending_renderer);
+    SDL_SetRenderTarget(pending_renderer, pending_canvas);
+    pending_slot->surface = SDL_RenderReadPixels(pending_renderer, NULL);
+    SDL_SetRenderTarget(pending_renderer, previous_target);
+
+#if defined(DEBUG)
+    const Uint64 ticks = SDL_GetPerformanceCounter() - copy_start;
+    copy_ticks += ticks;
+    max_copy_ticks = SDL_max(max_copy_ticks, ticks);
+#endif
+
+    pending_slot = NULL;
+    fill_slot();
+}
+
+bool SDLCapture_Init(const char* path, int canvas_width, int canvas_height) {
+    int ret;
+
+    width = canvas_width;
+    height = canvas_height;
+    has_failed = false;
+    captured_frames = 0;
+#if defined(DEBUG)
+    hash = FNV_OFFSET_BASIS;
+    copy_ticks = 0;
+    max_copy_ticks = 0;
+#endif
+
+    ret = avformat_alloc_output_context2(&format, NULL, NULL, path);
+
+    if (ret < 0) {
+        SDL_Log("Couldn't pick a container for %s", path);
+        print_av_error(ret);
+        return false;
+    }
+
+    packet = av_packet_alloc();
+
+    if ((packet == NULL) || !open_video() || !open_audio()) {
+        close_file();
+        return false;
+    }
+
+    if (!(format->oformat->flags & AVFMT_NOFILE)) {
+        ret = avio_open(&format->pb, path, AVIO_FLAG_WRITE);
+
+        if (ret < 0) {
+            SDL_Log("Couldn't open %s for writing", path);
+            print_av_error(ret);
+            close_file();
+            return false;
+        }
+    }
+
+    ret = avformat_write_header(format, NULL);
+
+    if (ret < 0) {
+        print_av_error(ret);
+        close_file();
+        return false;
+    }
+
+    if (options.software_render) {
+        for (int i = 0; i < RING_SLOTS; i++) {
+            ring[i].soft_pixels = SDL_CreateSurface(width, height, SDL_PIXELFORMAT_RGBA8888);
+        }
+    }
+
+    ring_head = 0;
+    ring_count = 0;
+    pending_slot = NULL;
+    is_stopping = false;
+    ring_mutex = SDL_CreateMutex();
+    slot_filled = SDL_CreateCondition();
+    slot_freed = SDL_CreateCondition();
+    worker = SDL_CreateThread(run_worker, "capture", NULL);
+
+    if (worker == NULL) {
+        SDL_Log("Couldn't start the capture thread: %s", SDL_GetError());
+        destroy_soft_pixels();
+        SDL_DestroyCondition(slot_freed);
+        SDL_DestroyCondition(slot_filled);
+        SDL_DestroyMutex(ring_mutex);
+        close_file();
+        return false;
+    }
+
+    is_capturing = true;
+    return true;
+}
+
+void SDLCapture_Quit() {
+    int ret;
+
+    if (!is_capturing) {
+        return;
+    }
+
+    read_back_pending();
+
+    SDL_LockMutex(ring_mutex);
+    is_stopping = true;
+    SDL_SignalCondition(slot_filled);
+    SDL_UnlockMutex(ring_mutex);
+    SDL_WaitThread(worker, NULL);
+    worker = NULL;
+
+    if (!has_failed && encode(&video, NULL) && encode(&audio, NULL)) {
+        ret = av_write_trailer(format);
+
+        if (ret < 0) {
+            print_av_error(ret);
+        }
+    }
+
+    close_file();
+    destroy_soft_pixels();
+    SDL_DestroyCondition(slot_freed);
+    SDL_DestroyCondition(slot_filled);
+    SDL_DestroyMutex(ring_mutex);
+    is_capturing = false;
+
+#if defined(DEBUG)
+    if (captured_frames > 0) {
+        SDL_Log("Capture: %" SDL_PRIu64 " frames, hash %016" SDL_PRIX64 ", copy avg %.3f ms, max %.3f ms",
+                captured_frames,
+                hash,
+                (double)copy_ticks * 1000 / SDL_GetPerformanceFrequency() / captured_frames,
+                (double)max_copy_ticks * 1000 / SDL_GetPerformanceFrequency());
+    }
+#endif
+}
+
+void SDLCapture_Frame(SDL_Renderer* renderer, SDL_Texture* canvas) {
+    CaptureSlot* slot;
+    const s16* samples;
+
+    if (!is_capturing) {
+        return;
+    }
+
+    // In case no frame was begun since the last one
+    read_back_pending();
+
+    // The slot after the last filled one stays ours until it's handed over, the worker only reads up to it
+    SDL_LockMutex(ring_mutex);
+
+    while (ring_count == RING_SLOTS) {
+        SDL_WaitCondition(slot_freed, ring_mutex);
+    }
+
+    slot = &ring[(ring_head + ring_count) % RING_SLOTS];
+    SDL_UnlockMutex(ring_mutex);
+
+    slot->num_audio_frames = OfflineAudio_GetLastFrame(&samples);
+    SDL_memcpy(slot->audio, samples, slot->num_audio_frames * MIXER_CHANNELS * sizeof(s16));
+
+#if defined(DEBUG)
+    const Uint64 copy_start = SDL_GetPerformanceCounter();
+    const bool is_copied = copy_soft_pixels(slot);
+    const Uint64 ticks = SDL_GetPerformanceCounter() - copy_start;
+    copy_ticks += ticks;
+    max_copy_ticks = SDL_max(max_copy_ticks, ticks);
+#else
+    const bool is_copied = copy_soft_pixels(slot);
+#endif
+
+    if (is_copied) {
+        fill_slot();
+        return;
+    }
+
+    pending_slot = slot;
+    pending_renderer = renderer;
+    pending_canvas = canvas;
+}
+
+void SDLCapture_BeginFrame() {
+    if (is_capturing) {
+        read_back_pending();
+    }
+}
@@ -0,0 +1,114 @@
+#include "port/sdl/sdl_debug_text.h"
+
+#include <SDL3/SDL.h>
+
+#define MAX_CHARS 0x12C0
+#define FIRST_CHAR 0x20
+#define LAST_CHAR 0x7E
+#define CHAR_SIZE SDL_DEBUG_TEXT_FONT_CHARACTER_SIZE
+#define ATLAS_COLUMNS 16
+#define ATLAS_ROWS ((LAST_CHAR - FIRST_CHAR + ATLAS_COLUMNS) / ATLAS_COLUMNS)
+#define ATLAS_WIDTH (ATLAS_COLUMNS * CHAR_SIZE)
+#define ATLAS_HEIGHT (ATLAS_ROWS * CHAR_SIZE)
+
+static SDL_Renderer* _renderer = NULL;
+static SDL_Texture* font_atlas = NULL;
+static SDL_Vertex vertices[MAX_CHARS * 4];
+static int indices[MAX_CHARS * 6];
+static int num_chars = 0;
+static bool visible = false;
+
+void SDLDebugText_Initialize(SDL_Renderer* renderer) {
+    _renderer = renderer;
+
+    // Bake SDL's built-in 8x8 font into an atlas once
+    font_atlas =
+        SDL_CreateTexture(renderer, SDL_PIXELFORMAT_RGBA8888, SDL_TEXTUREACCESS_TARGET, ATLAS_WIDTH, ATLAS_HEIGHT);
+    SDL_SetTextureScaleMode(font_atlas, SDL_SCALEMODE_NEAREST);
+    SDL_SetTextureBlendMode(font_atlas, SDL_BLENDMODE_BLEND);
+
+    SDL_SetRenderTarget(renderer, font_atlas);
+    SDL_SetRenderDrawColor(renderer, 0, 0, 0, SDL_ALPHA_TRANSPARENT);
+    SDL_RenderClear(renderer);
+    SDL_SetRenderDrawColor(renderer, 255, 255, 255, SDL_ALPHA_OPAQUE);
+
+    for (int code = FIRST_CHAR; code <= LAST_CHAR; code++) {
+        const int index = code - FIRST_CHAR;
+        const char str[2] = { (char)code, '\0' };
+
+        SDL_RenderDebugText(renderer, (index % ATLAS_COLUMNS) * CHAR_SIZE, (index / ATLAS_COLUMNS) * CHAR_SIZE, str);
+    }
+
+    SDL_SetRenderTarget(renderer, NULL);
+
+    for (int i = 0; i < MAX_CHARS; i++) {
+        int* quad = &indices[i * 6];
+        const int first = i * 4;
+
+        quad[0] = first;
+        quad[1] = first + 1;
+        quad[2] = first + 2;
+        quad[3] = first + 2;
+        quad[4] = first + 1;
+        quad[5] = first + 3;
+    }
+}
+
+void SDLDebugText_ToggleVisible() {
+    visible = !visible;
+}
+
+bool SDLDebugText_IsVisible() {
+    return visible;
+}
+
+void SDLDebugText_Clear() {
+    num_chars = 0;
+}
+
+static float scale_color_value(unsigned int value) {
+    value *= 2;
+
+    if (value > 0xFF) {
+        value = 0xFF;
+    }
+
+    return value / 255.0f;
+}
+
+void SDLDebugText_AddChar(int x, int y, int code, unsigned int color) {
+    if ((num_chars >= MAX_CHARS) || (code < FIRST_CHAR) || (code > LAST_CHAR)) {
+        return;
+    }
+
+    const int index = code - FIRST_CHAR;
+    const float u0 = (float)((index % ATLAS_COLUMNS) * CHAR_SIZE) / ATLAS_WIDTH;
+    const float v0 = (float)((index / ATLAS_COLUMNS) * CHAR_SIZE) / ATLAS_HEIGHT;
+    const float u1 = u0 + (float)CHAR_SIZE / ATLAS_WIDTH;
+    const float v1 = v0 + (float)CHAR_SIZE / ATLAS_HEIGHT;
+    const float x0 = x;
+    const float y0 = y;
+    const float x1 = x0 + CHAR_SIZE;
+    const float y1 = y0 + CHAR_SIZE;
+    const SDL_FColor vertex_color = { .r = scale_color_value((color >> 16) & 0xFF),
+                                      .g = scale_color_value((color >> 8) & 0xFF),
+                                      .b = scale_color_value(color & 0xFF),
+                                      .a = scale_color_value(color >> 24) };
+    SDL_Vertex* quad = &vertices[num_chars * 4];
+
+    quad[0] = (SDL_Vertex) { .position = { x0, y0 }, .color = vertex_color, .tex_coord = { u0, v0 } };
+    quad[1] = (SDL_Vertex) { .position = { x1, y0 }, .color = vertex_color, .tex_coord = { u1, v0 } };
+    quad[2] = (SDL_Vertex) { .position = { x0, y1 }, .color = vertex_color, .tex_coord = { u0, v1 } };
+    quad[3] = (SDL_Vertex) { .position = { x1, y1 }, .color = vertex_color, .tex_coord = { u1, v1 } };
+
+    num_chars += 1;
+}
+
+void SDLDebugText_Render(SDL_Texture* target) {
+    if (!visible || (num_chars == 0)) {
+        return;
+    }
+
+    SDL_SetRenderTarget(_renderer, target);
+    SDL_RenderGeometry(_renderer, font_atlas, vertices, num_chars * 4, indices, num_chars * 6);
+}
@@ -1,5 +1,7 @@
 #include "port/sdl/sdl_game_renderer.h"
 #include "common.h"
+#include "port/options.h"
+#include "port/sdl/sdl_soft_renderer.h"
 #include "sf33rd/AcrSDK/ps2/flps2etc.h"
 #include "sf33rd/AcrSDK/ps2/flps2render.h"
 #include "sf33rd/AcrSDK/ps2/foundaps2.h"
@@ -15,6 +17,7 @@
 
 typedef struct RenderTask {
     SDL_Texture* texture;
+    SDL_Surface* image; // Texture of the software renderer
     SDL_Vertex vertices[4];
     float z;
     int index;
@@ -29,6 +32,7 @@ static SDL_Renderer* _renderer = NULL;
 static SDL_Surface* surfaces[FL_TEXTURE_MAX] = { NULL };
 static SDL_Palette* palettes[FL_PALETTE_MAX] = { NULL };
 static SDL_Texture* textures[FL_PALETTE_MAX] = { NULL };
+static SDL_Surface* images[FL_PALETTE_MAX] = { NULL };
 static int texture_count = 0;
 static SDL_Texture* texture_cache[FL_TEXTURE_MAX][FL_PALETTE_MAX + 1] = { { NULL } };
 static SDL_Texture* textures_to_destroy[1024] = { NULL };
@@ -36,6 +40,15 @@ static int textures_to_destroy_count = 0;
 static RenderTask render_tasks[RENDER_TASK_MAX] = { 0 };
 static int render_task_count = 0;
 
+// Software rendering
+
+static bool is_software = false;
+static Uint32 soft_clear_color = 0;
+static SDL_Surface* image_cache[FL_TEXTURE_MAX][FL_PALETTE_MAX + 1] = { { NULL } };
+static SDL_Surface* images_to_destroy[1024] = { NULL };
+static int images_to_destroy_count = 0;
+static SDLSoftRenderer_Quad soft_quads[RENDER_TASK_MAX];
+
 // Debugging
 
 static bool draw_rect_borders = false;
@@ -97,8 +110,9 @@ static void save_texture(const SDL_Surface* surface, const SDL_Palette* palette)
 
 // Textures
 
-static void push_texture(SDL_Texture* texture) {
+static void push_texture(SDL_Texture* texture, SDL_Surface* image) {
     textures[texture_count] = texture;
+    images[texture_count] = image;
     texture_count += 1;
 }
 
@@ -110,14 +124,28 @@ static SDL_Texture* get_texture() {
     return textures[texture_count - 1];
 }
 
+static SDL_Surface* get_image() {
+    if (texture_count == 0) {
+        fatal_error("No textures to get");
+    }
+
+    return images[texture_count - 1];
+}
+
 static void push_texture_to_destroy(SDL_Texture* texture) {
     textures_to_destroy[textures_to_destroy_count] = texture;
     textures_to_destroy_count += 1;
 }
 
+static void push_image_to_destroy(SDL_Surface* image) {
+    images_to_destroy[images_to_destroy_count] = image;
+    images_to_destroy_count += 1;
+}
+
 static void destroy_textures() {
     for (int i = 0; i < texture_count; i++) {
         textures[i] = NULL;
+        images[i] = NULL;
     }
 
     texture_count = 0;
@@ -127,6 +155,12 @@ static void destroy_textures() {
     }
 
     textures_to_destroy_count = 0;
+
+    for (int i = 0; i < images_to_destroy_count; i++) {
+        SDL_DestroySurface(images_to_destroy[i]);
+    }
+
+    images_to_destroy_count = 0;
 }
 
 static void push_render_task(RenderTask* task) {
@@ -216,6 +250,20 @@ void SDLGameRenderer_Init(SDL_Renderer* renderer) {
     cps3_canvas =
         SDL_CreateTexture(renderer, SDL_PIXELFORMAT_RGBA8888, SDL_TEXTUREACCESS_TARGET, cps3_width, cps3_height);
     SDL_SetTextureScaleMode(cps3_canvas, SDL_SCALEMODE_NEAREST);
+
+    is_software = options.software_render;
+
+    if (is_software) {
+        // Batch runs already fill every core with processes
+        const bool is_batch = (options.batch_list_path != NULL) || (options.cpu_farm_path != NULL);
+        SDLSoftRenderer_Init(cps3_width, cps3_height, is_batch ? 1 : SDL_GetNumLogicalCPUCores());
+    }
+}
+
+void SDLGameRenderer_Quit() {
+    if (is_software) {
+        SDLSoftRenderer_Quit();
+    }
 }
 
 void SDLGameRenderer_BeginFrame() {
@@ -225,6 +273,16 @@ void SDLGameRenderer_BeginFrame() {
     const Uint8 b = flPs2State.FrameClearColor & 0xFF;
     const Uint8 a = flPs2State.FrameClearColor >> 24;
 
+    if (is_software) {
+        if (a != SDL_ALPHA_TRANSPARENT) {
+            soft_clear_color = ((Uint32)r << 24) | (g << 16) | (b << 8) | a;
+        } else {
+            soft_clear_color = SDL_ALPHA_OPAQUE;
+        }
+
+        return;
+    }
+
     if (a != SDL_ALPHA_TRANSPARENT) {
         SDL_SetRenderDrawColor(_renderer, r, g, b, a);
     } else {
@@ -235,10 +293,30 @@ void SDLGameRenderer_BeginFrame() {
     SDL_RenderClear(_renderer);
 }
 
+static void render_software() {
+    for (int i = 0; i < render_task_count; i++) {
+        soft_quads[i].image = render_tasks[i].image;
+        SDL_memcpy(soft_quads[i].vertices, render_tasks[i].vertices, sizeof(soft_quads[i].vertices));
+    }
+
+    SDLSoftRenderer_Render(soft_clear_color, soft_quads, render_task_count);
+
+    // Headless runs only need the hash
+    if (!options.headless) {
+        SDL_UpdateTexture(cps3_canvas, NULL, SDLSoftRenderer_GetPixels(), cps3_width * sizeof(Uint32));
+    }
+}
+
 void SDLGameRenderer_RenderFrame() {
-    SDL_SetRenderTarget(_renderer, cps3_canvas);
     qsort(render_tasks, render_task_count, sizeof(RenderTask), compare_render_tasks);
 
+    if (is_software) {
+        render_software();
+        return;
+    }
+
+    SDL_SetRenderTarget(_renderer, cps3_canvas);
+
     for (int i = 0; i < render_task_count; i++) {
         const RenderTask* task = &render_tasks[i];
         const int indices[] = { 0, 1, 2, 1, 2, 3 };
@@ -341,6 +419,17 @@ void SDLGameRenderer_DestroyTexture(unsigned int texture_handle) {
         *texture_p = NULL;
     }
 
+    for (int i = 0; i < FL_PALETTE_MAX + 1; i++) {
+        SDL_Surface** image_p = &image_cache[texture_index][i];
+
+        if (*image_p == NULL) {
+            continue;
+        }
+
+        push_image_to_destroy(*image_p);
+        *image_p = NULL;
+    }
+
     SDL_DestroySurface(surfaces[texture_index]);
     surfaces[texture_index] = NULL;
 }
@@ -411,6 +500,17 @@ void SDLGameRenderer_DestroyPalette(unsigned int palette_handle) {
         *texture_p = NULL;
     }
 
+    for (int i = 0; i < FL_TEXTURE_MAX; i++) {
+        SDL_Surface** image_p = &image_cache[i][palette_handle];
+
+        if (*image_p == NULL) {
+            continue;
+        }
+
+        push_image_to_destroy(*image_p);
+        *image_p = NULL;
+    }
+
     SDL_DestroyPalette(palettes[palette_index]);
     palettes[palette_index] = NULL;
 }
@@ -429,6 +529,19 @@ void SDLGameRenderer_SetTexture(unsigned int th) {
         SDL_SetSurfacePalette(surface, palette);
     }
 
+    // The software renderer samples 32-bit copies, cached the same way as the textures
+    if (is_software) {
+        SDL_Surface* image = image_cache[texture_handle - 1][palette_handle];
+
+        if (image == NULL) {
+            image = SDL_ConvertSurface(surface, SDL_PIXELFORMAT_RGBA8888);
+            image_cache[texture_handle - 1][palette_handle] = image;
+        }
+
+        push_texture(NULL, image);
+        return;
+    }
+
     SDL_Texture* texture = NULL;
     const SDL_Texture* cached_texture = texture_cache[texture_handle - 1][palette_handle];
 
@@ -441,13 +554,14 @@ void SDLGameRenderer_SetTexture(unsigned int th) {
         texture_cache[texture_handle - 1][palette_handle] = texture;
     }
 
-    push_texture(texture);
+    push_texture(texture, NULL);
 }
 
 static void draw_quad(const SDLGameRenderer_Vertex* vertices, bool textured) {
     RenderTask task;
     task.index = render_task_count;
     task.texture = textured ? get_texture() : NULL;
+    task.image = textured ? get_image() : NULL;
     task.z = flPS2ConvScreenFZ(vertices[0].coord.z);
 
     SDL_zeroa(task.vertices);
@@ -2,15 +2,40 @@
 
 #include <SDL3/SDL.h>
 
+#define ATLAS_SIZE 1024
+#define GLYPH_CELL_SIZE 32
+#define GLYPH_CELLS_PER_ROW (ATLAS_SIZE / GLYPH_CELL_SIZE)
+#define GLYPH_SLOT_COUNT (GLYPH_CELLS_PER_ROW * GLYPH_CELLS_PER_ROW)
+#define GLYPH_BUCKET_COUNT 1024
+#define BATCH_MAX_QUADS 1024
+
+typedef struct GlyphSlot {
+    unsigned int key;
+    int next; // Next slot in the same hash bucket, or -1
+    Uint64 last_use;
+} GlyphSlot;
+
 SDL_Texture* message_canvas = NULL;
 
 static const int canvas_width = 512;
 static const int canvas_height = 448;
 
 static SDL_Renderer* _renderer = NULL;
-static SDL_Texture* knjsub_texture = NULL;
 static SDL_Palette* knjsub_palette = NULL;
 
+// Glyphs are uploaded once into an atlas and evicted least recently used first
+static SDL_Texture* glyph_atlas = NULL;
+static GlyphSlot glyph_slots[GLYPH_SLOT_COUNT];
+static int glyph_buckets[GLYPH_BUCKET_COUNT];
+static int glyph_slots_used = 0;
+static Uint64 glyph_clock = 0;
+
+// All glyph quads of a frame are drawn with one geometry call
+static SDL_Vertex batch_vertices[BATCH_MAX_QUADS * 4];
+static int batch_indices[BATCH_MAX_QUADS * 6];
+static int batch_quads = 0;
+static Uint64 batch_start_clock = 0;
+
 static const SDL_Color knjsub_palette_colors[4] = {
     { .r = 255, .g = 255, .b = 255, .a = 0 },
     { .r = 255, .g = 255, .b = 255, .a = 0 },
@@ -29,6 +54,26 @@ void SDLMessageRenderer_Initialize(SDL_Renderer* renderer) {
     // Initialize knjsub palette
     knjsub_palette = SDL_CreatePalette(4);
     SDL_SetPaletteColors(knjsub_palette, knjsub_palette_colors, 0, 4);
+
+    // Initialize glyph atlas
+    glyph_atlas =
+        SDL_CreateTexture(renderer, SDL_PIXELFORMAT_RGBA8888, SDL_TEXTUREACCESS_STATIC, ATLAS_SIZE, ATLAS_SIZE);
+    SDL_SetTextureScaleMode(glyph_atlas, SDL_SCALEMODE_NEAREST);
+    SDL_SetTextureBlendMode(glyph_atlas, SDL_BLENDMODE_BLEND);
+
+    for (int i = 0; i < BATCH_MAX_QUADS; i++) {
+        int* indices = &batch_indices[i * 6];
+        const int first = i * 4;
+
+        indices[0] = first;
+        indices[1] = first + 1;
+        indices[2] = first + 2;
+        indices[3] = first + 2;
+        indices[4] = first + 1;
+        indices[5] = first + 3;
+    }
+
+    SDLMessageRenderer_ClearGlyphs();
 }
 
 void SDLMessageRenderer_BeginFrame() {
@@ -38,18 +83,105 @@ void SDLMessageRenderer_BeginFrame() {
     SDL_RenderClear(_renderer);
 }
 
-void SDLMessageRenderer_CreateTexture(int width, int height, void* pixels, int format) {
-    if (knjsub_texture != NULL) {
-        SDL_DestroyTexture(knjsub_texture);
+static void flush_batch() {
+    if (batch_quads == 0) {
+        return;
+    }
+
+    SDL_SetRenderTarget(_renderer, message_canvas);
+    SDL_RenderGeometry(_renderer, glyph_atlas, batch_vertices, batch_quads * 4, batch_indices, batch_quads * 6);
+    batch_quads = 0;
+    batch_start_clock = glyph_clock + 1;
+}
+
+void SDLMessageRenderer_RenderFrame() {
+    flush_batch();
+}
+
+void SDLMessageRenderer_DiscardFrame() {
+    batch_quads = 0;
+    batch_start_clock = glyph_clock + 1;
+}
+
+static int hash_glyph_key(unsigned int key) {
+    key ^= key >> 16;
+    key *= 0x45D9F3B;
+    key ^= key >> 16;
+    return key % GLYPH_BUCKET_COUNT;
+}
+
+static void unlink_glyph_slot(int slot) {
+    int* link = &glyph_buckets[hash_glyph_key(glyph_slots[slot].key)];
+
+    while (*link != slot) {
+        link = &glyph_slots[*link].next;
+    }
+
+    *link = glyph_slots[slot].next;
+}
+
+void SDLMessageRenderer_ClearGlyphs() {
+    flush_batch();
+
+    for (int i = 0; i < GLYPH_BUCKET_COUNT; i++) {
+        glyph_buckets[i] = -1;
+    }
+
+    glyph_slots_used = 0;
+}
+
+int SDLMessageRenderer_FindGlyph(unsigned int key) {
+    for (int slot = glyph_buckets[hash_glyph_key(key)]; slot >= 0; slot = glyph_slots[slot].next) {
+        if (glyph_slots[slot].key == key) {
+            glyph_slots[slot].last_use = ++glyph_clock;
+            return slot;
+        }
+    }
+
+    return -1;
+}
+
+int SDLMessageRenderer_AddGlyph(unsigned int key, int width, int height, void* pixels) {
+    int slot;
+
+    if (glyph_slots_used < GLYPH_SLOT_COUNT) {
+        slot = glyph_slots_used;
+        glyph_slots_used += 1;
+    } else {
+        slot = 0;
+
+        for (int i = 1; i < GLYPH_SLOT_COUNT; i++) {
+            if (glyph_slots[i].last_use < glyph_slots[slot].last_use) {
+                slot = i;
+            }
+        }
+
+        // The batch still samples the old glyph
+        if (glyph_slots[slot].last_use >= batch_start_clock) {
+            flush_batch();
+        }
+
+        unlink_glyph_slot(slot);
     }
 
     SDL_Surface* surface = SDL_CreateSurfaceFrom(width, height, SDL_PIXELFORMAT_INDEX4LSB, pixels, width / 2);
     SDL_SetSurfacePalette(surface, knjsub_palette);
-    knjsub_texture = SDL_CreateTextureFromSurface(_renderer, surface);
+    SDL_Surface* converted = SDL_ConvertSurface(surface, SDL_PIXELFORMAT_RGBA8888);
     SDL_DestroySurface(surface);
 
-    SDL_SetTextureScaleMode(knjsub_texture, SDL_SCALEMODE_NEAREST);
-    SDL_SetTextureBlendMode(knjsub_texture, SDL_BLENDMODE_BLEND);
+    const SDL_Rect rect = { .x = (slot % GLYPH_CELLS_PER_ROW) * GLYPH_CELL_SIZE,
+                            .y = (slot / GLYPH_CELLS_PER_ROW) * GLYPH_CELL_SIZE,
+                            .w = SDL_min(width, GLYPH_CELL_SIZE),
+                            .h = SDL_min(height, GLYPH_CELL_SIZE) };
+    SDL_UpdateTexture(glyph_atlas, &rect, converted->pixels, converted->pitch);
+    SDL_DestroySurface(converted);
+
+    glyph_slots[slot].key = key;
+    glyph_slots[slot].last_use = ++glyph_clock;
+    glyph_slots[slot].next = glyph_buckets[hash_glyph_key(key)];
+    glyph_buckets[hash_glyph_key(key)] = slot;
+
+    return slot;
 }
 
 static int adjust_coordinate(int coordinate, bool is_x, bool is_uv) {
@@ -63,7 +195,7 @@ static int adjust_coordinate(int coordinate, bool is_x, bool is_uv) {
     return coordinate;
 }
 
-static Uint8 scale_color_value(Uint8 value) {
+static float scale_color_value(Uint8 value) {
     int temp = value;
     temp *= 2;
 
@@ -71,11 +203,18 @@ static Uint8 scale_color_value(Uint8 value) {
         temp = 0xFF;
     }
 
-    return (Uint8)temp;
+    return temp / 255.0f;
 }
 
-void SDLMessageRenderer_DrawTexture(int x0, int y0, int x1, int y1, int u0, int v0, int u1, int v1,
-                                    unsigned int color) {
+void SDLMessageRenderer_DrawGlyph(int slot, int x0, int y0, int x1, int y1, int u0, int v0, int u1, int v1,
+                                  unsigned int color) {
+    const float cell_x = (slot % GLYPH_CELLS_PER_ROW) * GLYPH_CELL_SIZE;
+    const float cell_y = (slot / GLYPH_CELLS_PER_ROW) * GLYPH_CELL_SIZE;
+
+    if (batch_quads == BATCH_MAX_QUADS) {
+        flush_batch();
+    }
+
     x0 = adjust_coordinate(x0, true, false);
     y0 = adjust_coordinate(y0, false, false);
     x1 = adjust_coordinate(x1, true, false);
@@ -86,26 +225,20 @@ void SDLMessageRenderer_DrawTexture(int x0, int y0, int x1, int y1, int u0, int
     u1 = adjust_coordinate(u1, true, true);
     v1 = adjust_coordinate(v1, false, true);
 
-    SDL_FRect src_rect;
-    src_rect.x = u0;
-    src_rect.y = v0;
-    src_rect.w = u1 - u0;
-    src_rect.h = v1 - v0;
-
-    SDL_FRect dst_rect;
-    dst_rect.x = x0;
-    dst_rect.y = y0;
-    dst_rect.w = x1 - x0;
-    dst_rect.h = y1 - y0;
-
-    const Uint8 r = scale_color_value(color & 0xFF);
-    const Uint8 g = scale_color_value((color >> 8) & 0xFF);
-    const Uint8 b = scale_color_value((color >> 16) & 0xFF);
-    const Uint8 a = scale_color_value(color >> 24);
-
-    SDL_SetTextureColorMod(knjsub_texture, r, g, b);
-    SDL_SetTextureAlphaMod(knjsub_texture, a);
-
-    SDL_SetRenderTarget(_renderer, message_canvas);
-    SDL_RenderTexture(_renderer, knjsub_texture, &src_rect, &dst_rect);
+    const SDL_FColor vertex_color = { .r = scale_color_value(color & 0xFF),
+                                      .g = scale_color_value((color >> 8) & 0xFF),
+                                      .b = scale_color_value((color >> 16) & 0xFF),
+                                      .a = scale_color_value(color >> 24) };
+    const float tu0 = (cell_x + u0) / ATLAS_SIZE;
+    const float tv0 = (cell_y + v0) / ATLAS_SIZE;
+    const float tu1 = (cell_x + u1) / ATLAS_SIZE;
+    const float tv1 = (cell_y + v1) / ATLAS_SIZE;
+    SDL_Vertex* vertices = &batch_vertices[batch_quads * 4];
+
+    vertices[0] = (SDL_Vertex) { .position = { x0, y0 }, .color = vertex_color, .tex_coord = { tu0, tv0 } };
+    vertices[1] = (SDL_Vertex) { .position = { x1, y0 }, .color = vertex_color, .tex_coord = { tu1, tv0 } };
+    vertices[2] = (SDL_Vertex) { .position = { x0, y1 }, .color = vertex_color, .tex_coord = { tu0, tv1 } };
+    vertices[3] = (SDL_Vertex) { .position = { x1, y1 }, .color = vertex_color, .tex_coord = { tu1, tv1 } };
+
+    batch_quads += 1;
 }
@@ -0,0 +1,578 @@
+/**
+ * @file sdl_soft_renderer.c
+ * CPU rasterizer for the game canvas
+ *
+ * Quads are split into two triangles, the same way the game renderer hands them to SDL_RenderGeometry. Only the
+ * conversion of the vertices uses floats: positions are snapped to 1/16 pixel, and from there coverage, texture
+ * coordinates, colors and blending are all integer math. Pixels are covered by their centers with a top-left fill
+ * rule, so the two halves of a quad never both draw the pixels of their shared edge.
+ *
+ * Each thread owns a band of rows, and draws every triangle that crosses it in order. A pixel is only ever touched
+ * by one thread, so frames are the same whatever the number of threads, on any machine. The threads are started
+ * with the first frame and then wait for the next one.
+ */
+
+#include "port/sdl/sdl_soft_renderer.h"
+
+#include <SDL3/SDL.h>
+
+#include <stdio.h>
+
+#if !defined(_WIN32)
+#include <unistd.h>
+#endif
+
+#define SUBPIXEL_BITS 4
+#define SUBPIXEL_ONE (1 << SUBPIXEL_BITS)
+#define ATTR_BITS 16
+#define THREAD_MAX 8
+#define FNV_OFFSET_BASIS 0xCBF29CE484222325ULL
+#define FNV_PRIME 0x100000001B3ULL
+
+// Keeps every product of the setup within 64 bits
+static const float position_limit = 4096;
+
+typedef enum Attribute {
+    ATTR_U,
+    ATTR_V,
+    ATTR_R,
+    ATTR_G,
+    ATTR_B,
+    ATTR_A,
+    ATTR_COUNT,
+} Attribute;
+
+typedef struct FixedVertex {
+    Sint64 x;
+    Sint64 y;
+    Sint64 attr[ATTR_COUNT]; // With ATTR_BITS fractional bits, texture coordinates in texels
+} FixedVertex;
+
+typedef struct Triangle {
+    const Uint32* texels; // NULL for a solid triangle
+    int texel_pitch;      // In pixels
+    int texture_width;
+    int texture_height;
+
+    // Pixels the triangle can cover, clipped to the canvas
+    int x_begin;
+    int x_end;
+    int y_begin;
+    int y_end;
+
+    // Edge i is the one opposite vertex i. Its function is the weight of that vertex, scaled by the area.
+    Sint64 area;
+    Sint64 edge_origin[3]; // At the center of pixel 0, 0
+    Sint64 edge_step_x[3];
+    Sint64 edge_step_y[3];
+    Sint64 edge_min[3]; // 0 for top and left edges, whose pixels the triangle draws, 1 otherwise
+
+    Sint64 attr[ATTR_COUNT][3];
+    Sint64 attr_step_x[ATTR_COUNT];
+    int attr_count;   // ATTR_COUNT when the vertex colors differ, ATTR_R when they are flat
+    int flat_rgba[4]; // Color of the whole triangle when the vertex colors are the same
+    bool is_white;    // The color doesn't change the texels
+} Triangle;
+
+typedef struct Band {
+    int y_begin;
+    int y_end;
+} Band;
+
+typedef struct Pool {
+    long pid; // Process the threads were started in, forked children start their own
+    SDL_Thread* threads[THREAD_MAX];
+    SDL_Mutex* mutex;
+    SDL_Condition* started;
+    SDL_Condition* finished;
+    Uint64 frame; // Number of frames handed to the threads
+    int pending;  // Bands of the current frame that are still being drawn
+    bool quit;
+} Pool;
+
+static int canvas_width;
+static int canvas_height;
+static Uint32* pixels = NULL;
+static int band_count = 1;
+static Band bands[THREAD_MAX];
+
+static Triangle* triangles = NULL;
+static int triangle_count = 0;
+static int triangle_capacity = 0;
+static Uint32 frame_clear_color;
+
+static Pool pool = { 0 };
+static bool pool_failed = false;
+
+static u64 frame_hash = FNV_OFFSET_BASIS;
+static u64 hash = FNV_OFFSET_BASIS;
+
+/// @brief Round `a * b / 255`, exactly.
+static int mul_div_255(int a, int b) {
+    const int t = a * b + 128;
+    return (t + (t >> 8)) >> 8;
+}
+
+static int clamp_int(int value, int min, int max) {
+    return (value < min) ? min : ((value > max) ? max : value);
+}
+
+static Sint64 round_to_fixed(float value, float scale) {
+    return (Sint64)SDL_lroundf(value * scale);
+}
+
+static void convert_vertex(const SDL_Vertex* vertex, const SDL_Surface* image, FixedVertex* out) {
+    const float x = SDL_clamp(vertex->position.x, -position_limit, position_limit);
+    const float y = SDL_clamp(vertex->position.y, -position_limit, position_limit);
+
+    out->x = round_to_fixed(x, SUBPIXEL_ONE);
+    out->y = round_to_fixed(y, SUBPIXEL_ONE);
+
+    if (image != NULL) {
+        out->attr[ATTR_U] = round_to_fixed(vertex->tex_coord.x * image->w, 1 << ATTR_BITS);
+        out->attr[ATTR_V] = round_to_fixed(vertex->tex_coord.y * image->h, 1 << ATTR_BITS);
+    } else {
+        out->attr[ATTR_U] = 0;
+        out->attr[ATTR_V] = 0;
+    }
+
+    // Vertex colors come from 8-bit channels, so this gets the original values back
+    out->attr[ATTR_R] = round_to_fixed(vertex->color.r, 255) << ATTR_BITS;
+    out->attr[ATTR_G] = round_to_fixed(vertex->color.g, 255) << ATTR_BITS;
+    out->attr[ATTR_B] = round_to_fixed(vertex->color.b, 255) << ATTR_BITS;
+    out->attr[ATTR_A] = round_to_fixed(vertex->color.a, 255) << ATTR_BITS;
+}
+
+static bool has_flat_color(const FixedVertex* v0, const FixedVertex* v1, const FixedVertex* v2) {
+    for (int i = ATTR_R; i <= ATTR_A; i++) {
+        if ((v0->attr[i] != v1->attr[i]) || (v0->attr[i] != v2->attr[i])) {
+            return false;
+        }
+    }
+
+    return true;
+}
+
+/// @return `false` if the triangle has no area or is off the canvas.
+static bool setup_triangle(const FixedVertex* v0, const FixedVertex* v1, const FixedVertex* v2,
+                           const SDL_Surface* image, Triangle* tri) {
+    const FixedVertex* v[3] = { v0, v1, v2 };
+    Sint64 area = (v1->x - v0->x) * (v2->y - v0->y) - (v1->y - v0->y) * (v2->x - v0->x);
+    Sint64 min_x;
+    Sint64 max_x;
+    Sint64 min_y;
+    Sint64 max_y;
+
+    if (area == 0) {
+        return false;
+    }
+
+    // Make the vertices go clockwise on screen, so that every edge function is positive inside
+    if (area < 0) {
+        v[1] = v2;
+        v[2] = v1;
+        area = -area;
+    }
+
+    min_x = SDL_min(SDL_min(v0->x, v1->x), v2->x);
+    max_x = SDL_max(SDL_max(v0->x, v1->x), v2->x);
+    min_y = SDL_min(SDL_min(v0->y, v1->y), v2->y);
+    max_y = SDL_max(SDL_max(v0->y, v1->y), v2->y);
+
+    tri->x_begin = SDL_max(0, (int)(min_x >> SUBPIXEL_BITS));
+    tri->x_end = SDL_min(canvas_width, (int)(max_x >> SUBPIXEL_BITS) + 1);
+    tri->y_begin = SDL_max(0, (int)(min_y >> SUBPIXEL_BITS));
+    tri->y_end = SDL_min(canvas_height, (int)(max_y >> SUBPIXEL_BITS) + 1);
+
+    if ((tri->x_begin >= tri->x_end) || (tri->y_begin >= tri->y_end)) {
+        return false;
+    }
+
+    tri->area = area;
+
+    for (int i = 0; i < 3; i++) {
+        const FixedVertex* start = v[(i + 1) % 3];
+        const FixedVertex* end = v[(i + 2) % 3];
+        const Sint64 dx = end->x - start->x;
+        const Sint64 dy = end->y - start->y;
+        const Sint64 half = SUBPIXEL_ONE / 2;
+
+        tri->edge_origin[i] = dx * (half - start->y) - dy * (half - start->x);
+        tri->edge_step_x[i] = -dy * SUBPIXEL_ONE;
+        tri->edge_step_y[i] = dx * SUBPIXEL_ONE;
+        tri->edge_min[i] = ((dy < 0) || ((dy == 0) && (dx > 0))) ? 0 : 1;
+    }
+
+    tri->attr_count = has_flat_color(v0, v1, v2) ? ATTR_R : ATTR_COUNT;
+
+    for (int i = 0; i < tri->attr_count; i++) {
+        tri->attr_step_x[i] = 0;
+
+        for (int j = 0; j < 3; j++) {
+            tri->attr[i][j] = v[j]->attr[i];
+            tri->attr_step_x[i] += tri->edge_step_x[j] * v[j]->attr[i];
+        }
+
+        tri->attr_step_x[i] /= area;
+    }
+
+    for (int i = 0; i < 4; i++) {
+        tri->flat_rgba[i] = (int)(v0->attr[ATTR_R + i] >> ATTR_BITS);
+    }
+
+    tri->is_white = (tri->attr_count == ATTR_R) && (tri->flat_rgba[0] == 255) && (tri->flat_rgba[1] == 255) &&
+                    (tri->flat_rgba[2] == 255) && (tri->flat_rgba[3] == 255);
+
+    if (image != NULL) {
+        tri->texels = image->pixels;
+        tri->texel_pitch = image->pitch / 4;
+        tri->texture_width = image->w;
+        tri->texture_height = image->h;
+    } else {
+        tri->texels = NULL;
+    }
+
+    return true;
+}
+
+static void add_quad(const SDLSoftRenderer_Quad* quad) {
+    FixedVertex v[4];
+
+    if ((quad->image != NULL) && (quad->image->format != SDL_PIXELFORMAT_RGBA8888)) {
+        return;
+    }
+
+    if (triangle_count + 2 > triangle_capacity) {
+        const int capacity = SDL_max(64, triangle_capacity * 2);
+        Triangle* grown = SDL_realloc(triangles, capacity * sizeof(Triangle));
+
+        if (grown == NULL) {
+            return;
+        }
+
+        triangles = grown;
+        triangle_capacity = capacity;
+    }
+
+    for (int i = 0; i < 4; i++) {
+        convert_vertex(&quad->vertices[i], quad->image, &v[i]);
+    }
+
+    if (setup_triangle(&v[0], &v[1], &v[2], quad->image, &triangles[triangle_count])) {
+        triangle_count += 1;
+    }
+
+    if (setup_triangle(&v[1], &v[2], &v[3], quad->image, &triangles[triangle_count])) {
+        triangle_count += 1;
+    }
+}
+
+static void blend_pixel(Uint32* dst, int r, int g, int b, int a) {
+    const Uint32 d = *dst;
+    const int inv_a = 255 - a;
+
+    if (a == 0) {
+        return;
+    }
+
+    if (a == 255) {
+        *dst = ((Uint32)r << 24) | ((Uint32)g << 16) | ((Uint32)b << 8) | 0xFF;
+        return;
+    }
+
+    r = mul_div_255(r, a) + mul_div_255((d >> 24) & 0xFF, inv_a);
+    g = mul_div_255(g, a) + mul_div_255((d >> 16) & 0xFF, inv_a);
+    b = mul_div_255(b, a) + mul_div_255((d >> 8) & 0xFF, inv_a);
+    a = a + mul_div_255(d & 0xFF, inv_a);
+    *dst = ((Uint32)r << 24) | ((Uint32)g << 16) | ((Uint32)b << 8) | (Uint32)a;
+}
+
+static void draw_triangle(const Triangle* tri, const Band* band) {
+    const int y_begin = SDL_max(tri->y_begin, band->y_begin);
+    const int y_end = SDL_min(tri->y_end, band->y_end);
+    Sint64 w[3];
+    Sint64 attr[ATTR_COUNT];
+    int rgba[4];
+    int u;
+    int v;
+    Uint32 texel;
+    bool is_inside;
+    bool has_entered;
+
+    for (int y = y_begin; y < y_end; y++) {
+        Uint32* row = &pixels[y * canvas_width];
+
+        for (int i = 0; i < 3; i++) {
+            w[i] = tri->edge_origin[i] + tri->edge_step_x[i] * tri->x_begin + tri->edge_step_y[i] * y;
+        }
+
+        has_entered = false;
+
+        for (int x = tri->x_begin; x < tri->x_end; x++) {
+            is_inside = (w[0] >= tri->edge_min[0]) && (w[1] >= tri->edge_min[1]) && (w[2] >= tri->edge_min[2]);
+
+            if (!is_inside) {
+                // Triangles are convex, so the row is done once it has been left
+                if (has_entered) {
+                    break;
+                }
+
+                for (int i = 0; i < 3; i++) {
+                    w[i] += tri->edge_step_x[i];
+                }
+
+                continue;
+            }
+
+            // Interpolate exactly at the first pixel of the row, then step across it
+            if (!has_entered) {
+                for (int i = 0; i < tri->attr_count; i++) {
+                    attr[i] = (w[0] * tri->attr[i][0] + w[1] * tri->attr[i][1] + w[2] * tri->attr[i][2]) / tri->area;
+                }
+
+                has_entered = true;
+            }
+
+            if (tri->attr_count == ATTR_COUNT) {
+                for (int i = 0; i < 4; i++) {
+                    rgba[i] = clamp_int((int)(attr[ATTR_R + i] >> ATTR_BITS), 0, 255);
+                }
+            } else {
+                for (int i = 0; i < 4; i++) {
+                    rgba[i] = tri->flat_rgba[i];
+                }
+            }
+
+            if (tri->texels != NULL) {
+                u = clamp_int((int)(attr[ATTR_U] >> ATTR_BITS), 0, tri->texture_width - 1);
+                v = clamp_int((int)(attr[ATTR_V] >> ATTR_BITS), 0, tri->texture_height - 1);
+                texel = tri->texels[v * tri->texel_pitch + u];
+
+                if (tri->is_white) {
+                    rgba[0] = texel >> 24;
+                    rgba[1] = (texel >> 16) & 0xFF;
+                    rgba[2] = (texel >> 8) & 0xFF;
+                    rgba[3] = texel & 0xFF;
+                } else {
+                    rgba[0] = mul_div_255(texel >> 24, rgba[0]);
+                    rgba[1] = mul_div_255((texel >> 16) & 0xFF, rgba[1]);
+                    rgba[2] = mul_div_255((texel >> 8) & 0xFF, rgba[2]);
+                    rgba[3] = mul_div_255(texel & 0xFF, rgba[3]);
+                }
+            }
+
+            blend_pixel(&row[x], rgba[0], rgba[1], rgba[2], rgba[3]);
+
+            for (int i = 0; i < tri->attr_count; i++) {
+                attr[i] += tri->attr_step_x[i];
+            }
+
+            for (int i = 0; i < 3; i++) {
+                w[i] += tri->edge_step_x[i];
+            }
+        }
+    }
+}
+
+static void draw_band(const Band* band) {
+    for (int y = band->y_begin; y < band->y_end; y++) {
+        Uint32* row = &pixels[y * canvas_width];
+
+        for (int x = 0; x < canvas_width; x++) {
+            row[x] = frame_clear_color;
+        }
+    }
+
+    for (int i = 0; i < triangle_count; i++) {
+        draw_triangle(&triangles[i], band);
+    }
+}
+
+static u64 hash_byte(u64 value, Uint32 byte) {
+    return (value ^ byte) * FNV_PRIME;
+}
+
+/// @brief Hash the channels of every pixel one by one, so that the result doesn't depend on the host. The hash of
+/// all frames is chained over the hash of each.
+static void hash_frame() {
+    frame_hash = FNV_OFFSET_BASIS;
+
+    for (int i = 0; i < canvas_width * canvas_height; i++) {
+        const Uint32 pixel = pixels[i];
+
+        frame_hash = hash_byte(frame_hash, pixel >> 24);
+        frame_hash = hash_byte(frame_hash, (pixel >> 16) & 0xFF);
+        frame_hash = hash_byte(frame_hash, (pixel >> 8) & 0xFF);
+        frame_hash = hash_byte(frame_hash, pixel & 0xFF);
+    }
+
+    for (int i = 0; i < 64; i += 8) {
+        hash = hash_byte(hash, (Uint32)(frame_hash >> i) & 0xFF);
+    }
+}
+
+static long current_pid() {
+#if defined(_WIN32)
+    return 0;
+#else
+    return getpid();
+#endif
+}
+
+static int SDLCALL run_band_thread(void* data) {
+    const Band* band = data;
+    Uint64 frame = 0;
+
+    SDL_LockMutex(pool.mutex);
+
+    while (!pool.quit) {
+        if (pool.frame == frame) {
+            SDL_WaitCondition(pool.started, pool.mutex);
+            continue;
+        }
+
+        frame = pool.frame;
+        SDL_UnlockMutex(pool.mutex);
+        draw_band(band);
+        SDL_LockMutex(pool.mutex);
+
+        pool.pending -= 1;
+
+        if (pool.pending == 0) {
+            SDL_SignalCondition(pool.finished);
+        }
+    }
+
+    SDL_UnlockMutex(pool.mutex);
+    return 0;
+}
+
+static void stop_pool() {
+    if ((pool.mutex != NULL) && (pool.pid == current_pid())) {
+        SDL_LockMutex(pool.mutex);
+        pool.quit = true;
+        SDL_BroadcastCondition(pool.started);
+        SDL_UnlockMutex(pool.mutex);
+
+        for (int i = 0; i < THREAD_MAX; i++) {
+            if (pool.threads[i] != NULL) {
+                SDL_WaitThread(pool.threads[i], NULL);
+            }
+        }
+
+        SDL_DestroyCondition(pool.finished);
+        SDL_DestroyCondition(pool.started);
+        SDL_DestroyMutex(pool.mutex);
+    }
+
+    SDL_zero(pool);
+}
+
+/// Start a thread for every band but the first, which the caller draws. A forked child inherits the pool but not
+/// the threads, and the lock may have been held by one of them, so the child makes a new pool.
+static bool start_pool() {
+    const long pid = current_pid();
+
+    if ((pool.mutex != NULL) && (pool.pid == pid)) {
+        return true;
+    }
+
+    if (pool_failed) {
+        return false;
+    }
+
+    SDL_zero(pool);
+    pool.pid = pid;
+    pool.mutex = SDL_CreateMutex();
+    pool.started = SDL_CreateCondition();
+    pool.finished = SDL_CreateCondition();
+
+    for (int i = 1; i < band_count; i++) {
+        pool.threads[i] = SDL_CreateThread(run_band_thread, "soft_render", &bands[i]);
+
+        if (pool.threads[i] == NULL) {
+            printf("Failed to start the software renderer threads: %s\n", SDL_GetError());
+            stop_pool();
+            pool_failed = true;
+            return false;
+        }
+    }
+
+    return true;
+}
+
+void SDLSoftRenderer_Init(int width, int height, int thread_count) {
+    const int rows = (height + SDL_clamp(thread_count, 1, THREAD_MAX) - 1) / SDL_clamp(thread_count, 1, THREAD_MAX);
+
+    canvas_width = width;
+    canvas_height = height;
+    pixels = SDL_calloc(width * height, sizeof(Uint32));
+    band_count = 0;
+
+    for (int y = 0; y < height; y += rows) {
+        bands[band_count].y_begin = y;
+        bands[band_count].y_end = SDL_min(y + rows, height);
+        band_count += 1;
+    }
+
+    SDLSoftRenderer_ResetHash();
+}
+
+void SDLSoftRenderer_Quit() {
+    stop_pool();
+    pool_failed = false;
+    SDL_free(triangles);
+    triangles = NULL;
+    triangle_capacity = 0;
+    SDL_free(pixels);
+    pixels = NULL;
+}
+
+void SDLSoftRenderer_Render(Uint32 clear_color, const SDLSoftRenderer_Quad* quads, int count) {
+    frame_clear_color = clear_color;
+    triangle_count = 0;
+
+    for (int i = 0; i < count; i++) {
+        add_quad(&quads[i]);
+    }
+
+    if ((band_count > 1) && start_pool()) {
+        SDL_LockMutex(pool.mutex);
+        pool.frame += 1;
+        pool.pending = band_count - 1;
+        SDL_BroadcastCondition(pool.started);
+        SDL_UnlockMutex(pool.mutex);
+
+        draw_band(&bands[0]);
+
+        SDL_LockMutex(pool.mutex);
+
+        while (pool.pending > 0) {
+            SDL_WaitCondition(pool.finished, pool.mutex);
+        }
+
+        SDL_UnlockMutex(pool.mutex);
+    } else {
+        for (int i = 0; i < band_count; i++) {
+            draw_band(&bands[i]);
+        }
+    }
+
+    hash_frame();
+}
+
+const Uint32* SDLSoftRenderer_GetPixels() {
+    return pixels;
+}
+
+u64 SDLSoftRenderer_GetFrameHash() {
+    return frame_hash;
+}
+
+u64 SDLSoftRenderer_GetHash() {
+    return hash;
+}
+
+void SDLSoftRenderer_ResetHash() {
+    hash = FNV_OFFSET_BASIS;
+}
@@ -1,7 +1,7 @@
 #include "port/sound/adx.h"
 #include "common.h"
 #include "port/io/afs.h"
-#include "sf33rd/Source/Game/io/gd3rd.h"
+#include "port/sound/mixer.h"
 
 #include <SDL3/SDL.h>
 
@@ -16,13 +16,20 @@
 #include <stdio.h>
 #include <stdlib.h>
 
-#define SAMPLE_RATE 48000
-#define N_CHANNELS 2
+#define SAMPLE_RATE MIXER_SAMPLE_RATE
+#define N_CHANNELS MIXER_CHANNELS
 #define BYTES_PER_SAMPLE 2
+#define BYTES_PER_FRAME (N_CHANNELS * BYTES_PER_SAMPLE)
 #define MIN_QUEUED_DATA_MS 400
 #define MIN_QUEUED_DATA (int)((float)SAMPLE_RATE * MIN_QUEUED_DATA_MS / 1000 * N_CHANNELS * BYTES_PER_SAMPLE)
 #define TRACKS_MAX 10
 
+// Streamed tracks are read from AFS in chunks of CHUNK_SECTORS sectors into a ring of RING_CHUNKS chunks
+#define SECTOR_SIZE 2048
+#define CHUNK_SECTORS 4
+#define CHUNK_SIZE (CHUNK_SECTORS * SECTOR_SIZE)
+#define RING_CHUNKS 4
+
 #define MIN(a, b) ((a) < (b) ? (a) : (b))
 #define MAX(a, b) ((a) > (b) ? (a) : (b))
 
@@ -38,21 +45,47 @@ typedef struct ADXLoopInfo {
     bool looping_enabled;
     int start_sample;
     int end_sample;
-    uint8_t* data;
-    int data_size;
-    int position;
+    int start_block_sample; // First sample of the block that contains start_sample
+    int start_byte;         // Offset of the block that contains start_sample
+    int end_byte;           // Offset right after the block that contains the last looped sample
 } ADXLoopInfo;
 
+typedef struct ADXChunk {
+    int index; // Number of the chunk within the file
+    int begin; // Offset of the first byte to decode within the chunk
+    int end;   // Offset right after the last byte to decode within the chunk
+    bool loop; // Decoding continues from the loop start after this chunk
+} ADXChunk;
+
+typedef struct ADXStream {
+    AFSHandle handle;
+    int num_chunks;
+    int num_sectors;
+    int next_chunk;
+    int next_begin;
+    bool reading;
+    int head;     // Ring slot that is being decoded
+    int count;    // Number of ring slots with data ready for decoding
+    int consumed; // Number of bytes consumed from the head slot
+    ADXChunk chunks[RING_CHUNKS];
+    uint8_t (*ring)[CHUNK_SIZE]; // RING_CHUNKS slots, on the heap so that a read in flight can outlive the track
+} ADXStream;
+
 typedef struct ADXTrack {
     int size;
-    uint8_t* data;
-    bool should_free_data_after_use;
+    const uint8_t* data; // Track data for tracks played from memory, NULL for tracks streamed from AFS
     int used_bytes;
+    bool header_parsed;
+    bool looping_allowed;
+    bool loop_pending;
     int processed_samples;
+    int skip_samples;
     ADXLoopInfo loop_info;
+    ADXStream stream;
     ADXDecoderPipeline pipeline;
 } ADXTrack;
 
+// Queue of decoded samples that the mixer plays on the BGM bus
 static SDL_AudioStream* stream = NULL;
 static ADXTrack tracks[TRACKS_MAX] = { 0 };
 static int num_tracks = 0;
@@ -101,138 +134,290 @@ static void pipeline_destroy(ADXDecoderPipeline* pipeline) {
     av_parser_close(pipeline->parser_context);
 }
 
-static void* load_file(int file_id, int* size) {
-    // FIXME: Remove dependency on GD3rd.h
-    const unsigned int file_size = fsGetFileSize(file_id);
-    *size = file_size;
-    const size_t buff_size = (file_size + 2048 - 1) & ~(2048 - 1); // AFS reads data in 2048-byte chunks
-    void* buff = malloc(buff_size);
-
-    AFSHandle handle = AFS_Open(file_id);
-    AFS_ReadSync(handle, fsCalSectorSize(file_size), buff);
-    AFS_Close(handle);
-
-    return buff;
-}
-
 static void print_av_error(int errnum) {
     char errbuf[AV_ERROR_MAX_STRING_SIZE] = { 0 };
     av_strerror(errnum, errbuf, sizeof(errbuf));
     fprintf(stderr, "FFmpeg error: %s\n", errbuf);
 }
 
-static bool track_reached_eof(ADXTrack* track) {
-    return (track->size - track->used_bytes) <= 0;
+static void loop_info_init(ADXLoopInfo* info, const uint8_t* data, int size) {
+    const uint8_t version = data[0x12];
+
+    switch (version) {
+    case 3:
+        const Uint16 loop_enabled_16 = AV_RB16(data + 0x16);
+
+        if (loop_enabled_16 == 1) {
+            info->looping_enabled = true;
+            info->start_sample = AV_RB32(data + 0x1C);
+            info->end_sample = AV_RB32(data + 0x24);
+        }
+
+        break;
+
+    case 4:
+        const Uint32 loop_enabled_32 = AV_RB32(data + 0x24);
+
+        if (loop_enabled_32 == 1) {
+            info->looping_enabled = true;
+            info->start_sample = AV_RB32(data + 0x28);
+            info->end_sample = AV_RB32(data + 0x30);
+        }
+
+        break;
+
+    default:
+        fatal_error("Unhandled ADX version: %d", version);
+        break;
+    }
+
+    if (info->looping_enabled) {
+        // Blocks of all channels are interleaved right after the header
+        const int data_offset = AV_RB16(data + 0x02) + 4;
+        const int block_size = data[0x05] * data[0x07];
+        const int samples_per_block = (data[0x05] - 2) * 8 / data[0x06];
+        const int start_block = info->start_sample / samples_per_block;
+        const int end_block = (info->end_sample + samples_per_block - 1) / samples_per_block;
+
+        info->start_block_sample = start_block * samples_per_block;
+        info->start_byte = data_offset + start_block * block_size;
+        info->end_byte = MIN(data_offset + end_block * block_size, size);
+    }
 }
 
-static bool track_loop_filled(ADXTrack* track) {
-    if (track->loop_info.looping_enabled) {
-        return track->processed_samples >= track->loop_info.end_sample;
-    } else {
-        return false;
+static void track_parse_header(ADXTrack* track, const uint8_t* data) {
+    if (track->looping_allowed) {
+        loop_info_init(&track->loop_info, data, track->size);
     }
+
+    track->header_parsed = true;
 }
 
-static bool track_needs_decoding(ADXTrack* track) {
-    if (track->loop_info.looping_enabled) {
-        return !track_loop_filled(track);
-    } else {
-        return !track_reached_eof(track);
+static void track_restart_loop(ADXTrack* track) {
+    const ADXLoopInfo* loop_info = &track->loop_info;
+
+    // Decoding resumes at the start of the block, so drop the samples that precede the loop start
+    track->processed_samples = loop_info->start_block_sample;
+    track->skip_samples = loop_info->start_sample - loop_info->start_block_sample;
+    track->loop_pending = false;
+}
+
+// Streaming
+
+static void chunk_apply_loop(ADXTrack* track, ADXChunk* chunk) {
+    ADXStream* stream = &track->stream;
+    const ADXLoopInfo* loop_info = &track->loop_info;
+    const int chunk_offset = chunk->index * CHUNK_SIZE;
+
+    if (!loop_info->looping_enabled || (loop_info->end_byte > chunk_offset + chunk->end)) {
+        return;
     }
+
+    chunk->end = loop_info->end_byte - chunk_offset;
+    chunk->loop = true;
+    stream->next_chunk = loop_info->start_byte / CHUNK_SIZE;
+    stream->next_begin = loop_info->start_byte % CHUNK_SIZE;
 }
 
-static bool track_exhausted(ADXTrack* track) {
-    if (track->loop_info.looping_enabled) {
-        return false; // Track is never exhausted, because it can be looped infinitely
-    } else {
-        return track_reached_eof(track);
+static void stream_init(ADXTrack* track, int file_id) {
+    ADXStream* stream = &track->stream;
+
+    stream->handle = AFS_Open(file_id);
+    stream->ring = SDL_malloc(RING_CHUNKS * CHUNK_SIZE);
+    stream->num_chunks = (track->size + CHUNK_SIZE - 1) / CHUNK_SIZE;
+    stream->num_sectors = (track->size + SECTOR_SIZE - 1) / SECTOR_SIZE;
+
+    if (stream->handle == AFS_NONE) {
+        fprintf(stderr, "ADX: couldn't open file %d for streaming\n", file_id);
+        stream->next_chunk = stream->num_chunks;
     }
 }
 
-static int track_add_samples_to_loop(ADXTrack* track, uint8_t* buf, int num_samples) {
-    ADXLoopInfo* loop_info = &track->loop_info;
+static void stream_read_next_chunk(ADXTrack* track) {
+    ADXStream* stream = &track->stream;
+    const int slot = (stream->head + stream->count) % RING_CHUNKS;
+    ADXChunk* chunk = &stream->chunks[slot];
+    const int first_sector = stream->next_chunk * CHUNK_SECTORS;
+
+    chunk->index = stream->next_chunk;
+    chunk->begin = stream->next_begin;
+    chunk->end = MIN(CHUNK_SIZE, track->size - chunk->index * CHUNK_SIZE);
+    chunk->loop = false;
 
-    if (!loop_info->looping_enabled) {
-        return 0; // No need to add samples if looping is not enabled
+    stream->next_chunk += 1;
+    stream->next_begin = 0;
+
+    if (track->header_parsed) {
+        chunk_apply_loop(track, chunk);
     }
 
-    const int buf_sample_start = MAX(loop_info->start_sample - track->processed_samples, 0);
-    const int buf_sample_end = MIN(loop_info->end_sample - track->processed_samples, num_samples);
+    AFS_Seek(stream->handle, first_sector);
+    AFS_Read(stream->handle, MIN(CHUNK_SECTORS, stream->num_sectors - first_sector), stream->ring[slot]);
+    stream->reading = true;
+}
+
+static void stream_update(ADXTrack* track) {
+    ADXStream* stream = &track->stream;
 
-    if (buf_sample_end > buf_sample_start) {
-        const int buf_start = buf_sample_start * N_CHANNELS * BYTES_PER_SAMPLE;
-        const int buf_end = buf_sample_end * N_CHANNELS * BYTES_PER_SAMPLE;
-        const int buf_len = buf_end - buf_start;
-        memcpy(loop_info->data + loop_info->position, buf + buf_sample_start, buf_len);
-        loop_info->position += buf_len;
+    if (stream->reading) {
+        const AFSReadState state = AFS_GetState(stream->handle);
+
+        if (state == AFS_READ_STATE_READING) {
+            return;
+        }
 
-        if (loop_info->position == loop_info->data_size) {
-            loop_info->position = 0;
+        stream->reading = false;
+
+        if (state == AFS_READ_STATE_FINISHED) {
+            const int slot = (stream->head + stream->count) % RING_CHUNKS;
+            stream->count += 1;
+
+            if (!track->header_parsed) {
+                // The header lives in the first chunk, so loop points can only be applied once it arrives
+                track_parse_header(track, stream->ring[slot]);
+                chunk_apply_loop(track, &stream->chunks[slot]);
+            }
+        } else {
+            fprintf(stderr, "ADX: streaming read failed (state = %d)\n", state);
+            stream->next_chunk = stream->num_chunks;
         }
     }
 
-    const int overflow = MAX(track->processed_samples + num_samples - loop_info->end_sample, 0);
-    track->processed_samples += num_samples;
-    return overflow;
+    if ((stream->count < RING_CHUNKS) && (stream->next_chunk < stream->num_chunks)) {
+        stream_read_next_chunk(track);
+    }
 }
 
-static void loop_info_init(ADXLoopInfo* info, const uint8_t* data) {
-    const uint8_t version = data[0x12];
+static void stream_pop_chunk(ADXTrack* track) {
+    ADXStream* stream = &track->stream;
 
-    switch (version) {
-    case 3:
-        const Uint16 loop_enabled_16 = AV_RB16(data + 0x16);
+    if (stream->chunks[stream->head].loop) {
+        track->loop_pending = true;
+    }
 
-        if (loop_enabled_16 == 1) {
-            info->looping_enabled = true;
-            info->start_sample = AV_RB32(data + 0x1C);
-            info->end_sample = AV_RB32(data + 0x24);
+    stream->head = (stream->head + 1) % RING_CHUNKS;
+    stream->count -= 1;
+    stream->consumed = 0;
+}
+
+static void stream_destroy(ADXStream* stream) {
+    // Stopping music mustn't wait for the disc, so AFS frees the ring once the read in flight is done with it
+    if (stream->handle != AFS_NONE) {
+        AFS_CloseAndFree(stream->handle, stream->ring);
+    } else {
+        SDL_free(stream->ring);
+    }
+}
+
+// Track data access
+
+static bool track_is_streamed(ADXTrack* track) {
+    return track->data == NULL;
+}
+
+/// @brief Get the next run of ADX data that is ready for decoding.
+/// @return Number of bytes available at `*data`. `0` if no data is available at the moment.
+static int track_peek(ADXTrack* track, const uint8_t** data) {
+    if (track_is_streamed(track)) {
+        ADXStream* stream = &track->stream;
+
+        while (stream->count > 0) {
+            const ADXChunk* chunk = &stream->chunks[stream->head];
+            const int available = chunk->end - chunk->begin - stream->consumed;
+
+            if (available > 0) {
+                *data = stream->ring[stream->head] + chunk->begin + stream->consumed;
+                return available;
+            }
+
+            stream_pop_chunk(track);
         }
 
-        break;
+        return 0;
+    }
 
-    case 4:
-        const Uint32 loop_enabled_32 = AV_RB32(data + 0x24);
+    const ADXLoopInfo* loop_info = &track->loop_info;
+    const int end = loop_info->looping_enabled ? loop_info->end_byte : track->size;
+    *data = track->data + track->used_bytes;
+    return end - track->used_bytes;
+}
 
-        if (loop_enabled_32 == 1) {
-            info->looping_enabled = true;
-            info->start_sample = AV_RB32(data + 0x28);
-            info->end_sample = AV_RB32(data + 0x30);
+static void track_consume(ADXTrack* track, int size) {
+    if (track_is_streamed(track)) {
+        ADXStream* stream = &track->stream;
+        const ADXChunk* chunk = &stream->chunks[stream->head];
+        stream->consumed += size;
+
+        if (stream->consumed >= chunk->end - chunk->begin) {
+            stream_pop_chunk(track);
         }
 
-        break;
+        return;
+    }
 
-    default:
-        fatal_error("Unhandled ADX version: %d", version);
-        break;
+    const ADXLoopInfo* loop_info = &track->loop_info;
+    track->used_bytes += size;
+
+    if (loop_info->looping_enabled && (track->used_bytes >= loop_info->end_byte)) {
+        track->used_bytes = loop_info->start_byte;
+        track->loop_pending = true;
     }
+}
 
-    if (info->looping_enabled) {
-        info->data_size = (info->end_sample - info->start_sample) * BYTES_PER_SAMPLE * N_CHANNELS;
-        info->data = malloc(info->data_size);
-        info->position = 0;
+static bool track_exhausted(ADXTrack* track) {
+    if (track->loop_info.looping_enabled) {
+        return false; // Track is never exhausted, because it can be looped infinitely
+    }
+
+    if (track_is_streamed(track)) {
+        const ADXStream* stream = &track->stream;
+        return !stream->reading && (stream->count == 0) && (stream->next_chunk >= stream->num_chunks);
     }
+
+    return (track->size - track->used_bytes) <= 0;
 }
 
-static void loop_info_destroy(ADXLoopInfo* info) {
-    if (info->looping_enabled) {
-        free(info->data);
+static void track_queue_samples(ADXTrack* track, const uint8_t* buf, int num_samples) {
+    const ADXLoopInfo* loop_info = &track->loop_info;
+    const int first_sample = MIN(track->skip_samples, num_samples);
+    int end_sample = num_samples;
+
+    if (loop_info->looping_enabled) {
+        // Samples past the loop end are decoded as part of the last block, but never played
+        end_sample = MIN(end_sample, loop_info->end_sample - track->processed_samples);
     }
 
-    SDL_zerop(info);
+    track->skip_samples -= first_sample;
+    track->processed_samples += num_samples;
+
+    if (end_sample > first_sample) {
+        const int size = (end_sample - first_sample) * BYTES_PER_FRAME;
+        SDL_PutAudioStreamData(stream, buf + first_sample * BYTES_PER_FRAME, size);
+    }
 }
 
 static void process_track(ADXTrack* track) {
     ADXDecoderPipeline* pipeline = &track->pipeline;
 
+    if (track_is_streamed(track)) {
+        stream_update(track);
+    }
+
     // Decode samples and queue them for playback
-    while (stream_needs_data() && track_needs_decoding(track)) {
+    while (stream_needs_data()) {
+        const uint8_t* data = NULL;
+        const int available = track_peek(track, &data);
+
+        if (available <= 0) {
+            break;
+        }
+
         int ret = av_parser_parse2(pipeline->parser_context,
                                    pipeline->context,
                                    &pipeline->packet->data,
                                    &pipeline->packet->size,
-                                   track->data + track->used_bytes,
-                                   track->size - track->used_bytes,
+                                   data,
+                                   available,
                                    AV_NOPTS_VALUE,
                                    AV_NOPTS_VALUE,
                                    0);
@@ -242,7 +427,7 @@ static void process_track(ADXTrack* track) {
             break;
         }
 
-        track->used_bytes += ret;
+        track_consume(track, ret);
 
         if (pipeline->packet->size > 0) {
             // Send parsed packet to decoder
@@ -277,29 +462,21 @@ static void process_track(ADXTrack* track) {
                 const int samples_converted = swr_convert(
                     pipeline->swr, &out_buf, out_samples, (const uint8_t**)pipeline->frame->data, out_samples);
 
-                const int overflow = track_add_samples_to_loop(track, out_buf, samples_converted);
-                const int samples_to_queue = samples_converted - overflow;
-
-                const int out_size =
-                    av_samples_get_buffer_size(&out_linesize, out_channels, samples_to_queue, AV_SAMPLE_FMT_S16, 1);
-
-                SDL_PutAudioStreamData(stream, out_buf, out_size);
+                track_queue_samples(track, out_buf, samples_converted);
                 av_freep(&out_buf);
             }
         }
-    }
 
-    // Queue looped samples (if needed)
-    while (track_loop_filled(track) && stream_needs_data()) {
-        const int available_data = track->loop_info.data_size - track->loop_info.position;
-        const int data_to_queue = MIN(stream_data_needed(), available_data);
-        SDL_PutAudioStreamData(stream, track->loop_info.data + track->loop_info.position, data_to_queue);
-        track->loop_info.position += data_to_queue;
-
-        if (track->loop_info.position == track->loop_info.data_size) {
-            track->loop_info.position = 0;
+        if (track->loop_pending) {
+            // Restart only after the last block of the loop has been decoded
+            track_restart_loop(track);
         }
     }
+
+    if (track_is_streamed(track)) {
+        // Refill the ring slots freed up by decoding
+        stream_update(track);
+    }
 }
 
 static void track_init(ADXTrack* track, int file_id, void* buf, size_t buf_size, bool looping_allowed) {
@@ -307,20 +484,20 @@ static void track_init(ADXTrack* track, int file_id, void* buf, size_t buf_size,
         fatal_error("One of file_id or buf must be valid.");
     }
 
+    track->used_bytes = 0;
+    track->looping_allowed = looping_allowed;
+    track->stream.handle = AFS_NONE;
+    pipeline_init(&track->pipeline);
+
     if (file_id != -1) {
-        track->data = load_file(file_id, &track->size);
-        track->should_free_data_after_use = true;
+        // Data is streamed from AFS, so playback can start without waiting for the whole file
+        track->data = NULL;
+        track->size = AFS_GetSize(file_id);
+        stream_init(track, file_id);
     } else {
         track->data = buf;
         track->size = buf_size;
-        track->should_free_data_after_use = false;
-    }
-
-    track->used_bytes = 0;
-    pipeline_init(&track->pipeline);
-
-    if (looping_allowed) {
-        loop_info_init(&track->loop_info, track->data);
+        track_parse_header(track, track->data);
     }
 
     process_track(track); // Feed first batch of data to the stream
@@ -328,12 +505,7 @@ static void track_init(ADXTrack* track, int file_id, void* buf, size_t buf_size,
 
 static void track_destroy(ADXTrack* track) {
     pipeline_destroy(&track->pipeline);
-    loop_info_destroy(&track->loop_info);
-
-    if (track->should_free_data_after_use) {
-        free(track->data);
-    }
-
+    stream_destroy(&track->stream);
     SDL_zerop(track);
 }
 
@@ -369,13 +541,26 @@ void ADX_ProcessTracks() {
     }
 }
 
+static void mixer_source(s16* output, int num_frames) {
+    const int size = num_frames * BYTES_PER_FRAME;
+    const int received = SDL_max(SDL_GetAudioStreamData(stream, output, size), 0);
+
+    // Fill the gap with silence if decoding can't keep up
+    SDL_memset((u8*)output + received, 0, size - received);
+}
+
 void ADX_Init() {
+    // Input and output formats match, so the stream is only used as a thread-safe FIFO
     const SDL_AudioSpec spec = { .format = SDL_AUDIO_S16, .channels = N_CHANNELS, .freq = SAMPLE_RATE };
-    stream = SDL_OpenAudioDeviceStream(SDL_AUDIO_DEVICE_DEFAULT_PLAYBACK, &spec, NULL, NULL);
+    stream = SDL_CreateAudioStream(&spec, &spec);
+
+    Mixer_SetPaused(MIXER_BUS_BGM, true);
+    Mixer_SetSource(MIXER_BUS_BGM, mixer_source);
 }
 
 void ADX_Exit() {
     ADX_Stop();
+    Mixer_SetSource(MIXER_BUS_BGM, NULL);
     SDL_DestroyAudioStream(stream);
 }
 
@@ -394,15 +579,11 @@ void ADX_Stop() {
 }
 
 int ADX_IsPaused() {
-    return SDL_AudioStreamDevicePaused(stream);
+    return Mixer_IsPaused(MIXER_BUS_BGM);
 }
 
 void ADX_Pause(int pause) {
-    if (pause) {
-        SDL_PauseAudioStreamDevice(stream);
-    } else {
-        SDL_ResumeAudioStreamDevice(stream);
-    }
+    Mixer_SetPaused(MIXER_BUS_BGM, pause);
 }
 
 void ADX_StartMem(void* buf, size_t size) {
@@ -439,7 +620,7 @@ void ADX_StartAfs(int file_id) {
 void ADX_SetOutVol(int volume) {
     // Convert volume (dB * 10) to linear gain
     const float gain = powf(10.0f, volume / 200.0f);
-    SDL_SetAudioStreamGain(stream, gain);
+    Mixer_SetGain(MIXER_BUS_BGM, gain);
 }
 
 void ADX_SetMono(bool mono) {
@@ -451,7 +632,7 @@ ADXState ADX_GetState() {
         return ADX_STATE_STOP;
     }
 
-    if (stream_is_empty()) {
+    if (stream_is_empty() && (num_tracks == 0)) {
         return ADX_STATE_PLAYEND;
     } else {
         if (ADX_IsPaused()) {
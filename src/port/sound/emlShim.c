@@ -2,8 +2,10 @@
 
 #include "common.h"
 #include "port/sound/list.h"
+#include "port/sound/mixer.h"
 #include "port/sound/spu.h"
 #include "sf33rd/AcrSDK/MiddleWare/PS2/CapSndEng/emlSndDrv.h"
+#include <SDL3/SDL.h>
 #include <stdio.h>
 #include <string.h>
 
@@ -54,8 +56,44 @@ struct VWork {
     struct list_head list;
 };
 
-static short masterVolume;
-static short assignedBankVolume[16];
+// Voice control runs on the audio thread. The game thread only pushes commands into a
+// single-producer/single-consumer ring, which is drained at the start of every mixer block.
+
+#define COMMAND_RING_SIZE 256 // Must be a power of two
+
+typedef enum CommandType {
+    COMMAND_START_SOUND,
+    COMMAND_KEY_OFF,
+    COMMAND_STOP,
+    COMMAND_STOP_ALL,
+    COMMAND_SET_BANK_VOLUME,
+    COMMAND_SET_LFO,
+} CommandType;
+
+typedef struct Command {
+    CommandType type;
+    Uint64 enqueue_time;
+
+    union {
+        CSE_SYS_PARAM_SNDSTART start;
+        CSE_REQP reqp;
+        CSE_SYS_PARAM_BANKVOL bankvol;
+        CSE_SYS_PARAM_LFO lfo;
+    } param;
+} Command;
+
+static Command commandRing[COMMAND_RING_SIZE];
+static SDL_AtomicU32 commandHead; // Written by the game thread only
+static SDL_AtomicU32 commandTail; // Written by the audio thread only
+
+// Producer side counters
+static int queueHighWater;
+static int droppedCommands;
+
+// Consumer side counters, read from the game thread
+static SDL_AtomicU32 maxLatencyUs;
+static SDL_AtomicU32 avgLatencyUs;
+
 static short bankVolume[16];
 
 static struct VWork vpool[48];
@@ -191,20 +229,21 @@ static void workTick() {
     gcVoices();
 }
 
+static void applyCommands();
+
+static void renderSE(s16* output, int num_frames) {
+    applyCommands();
+    SPU_Render(output, num_frames);
+}
+
 void emlShimInit() {
     memset(vpool, 0, sizeof(vpool));
 
     list_init(&active_voices);
     list_init(&free_voices);
 
-    SPU_Init(workTick);
-
-    SDL_LockMutex(soundLock);
-
-    masterVolume = 0x3fff;
     for (int i = 0; i < 16; i++) {
         bankVolume[i] = 0x3fff;
-        assignedBankVolume[i] = 0x3fff;
     }
 
     for (int i = 0; i < 48; i++) {
@@ -213,15 +252,17 @@ void emlShimInit() {
         list_insert(&free_voices, &vpool[i].list);
     }
 
-    SDL_UnlockMutex(soundLock);
+    SDL_SetAtomicU32(&commandHead, 0);
+    SDL_SetAtomicU32(&commandTail, 0);
+
+    SPU_Init(workTick);
+    Mixer_SetSource(MIXER_BUS_SE, renderSE);
 }
 
 static int gcVoices() {
     struct VWork *i, *n;
     int numFreed = 0;
 
-    SDL_LockMutex(soundLock);
-
     list_for_each_safe (i, n, &active_voices, list) {
         if (SPU_VoiceIsFinished(i->voice_num)) {
             list_remove(&i->list);
@@ -230,8 +271,6 @@ static int gcVoices() {
         }
     }
 
-    SDL_UnlockMutex(soundLock);
-
     return numFreed;
 }
 
@@ -447,19 +486,16 @@ static int doSeDrop(CSE_REQP* reqp) {
     return ret;
 }
 
-void emlShimStartSound(CSE_SYS_PARAM_SNDSTART* param) {
+static void doStartSound(CSE_SYS_PARAM_SNDSTART* param) {
     struct VWork* voice;
 
-    SDL_LockMutex(soundLock);
     if (!doSeDrop(&param->reqp)) {
-        SDL_UnlockMutex(soundLock);
         return;
     }
 
     voice = allocVoice();
     if (!voice) {
         printf("no free voices!\n");
-        SDL_UnlockMutex(soundLock);
         return;
     }
 
@@ -492,74 +528,46 @@ void emlShimStartSound(CSE_SYS_PARAM_SNDSTART* param) {
     UpdateVolPanPitch(voice);
 
     SPU_VoiceStart(voice->voice_num, param->phdp.s_addr >> 1);
-
-    SDL_UnlockMutex(soundLock);
 }
 
-void emlShimSeKeyOff(CSE_REQP* pReqp) {
+static void doSeKeyOff(CSE_REQP* pReqp) {
     u32 cond = makeConditions(pReqp);
     struct VWork* i;
 
-    SDL_LockMutex(soundLock);
-
     list_for_each (i, &active_voices, list) {
         if (checkConditions(&i->id, pReqp, cond)) {
             SPU_VoiceKeyOff(i->voice_num);
         }
     }
-
-    SDL_UnlockMutex(soundLock);
 }
 
-void emlShimSeStop(CSE_REQP* pReqp) {
+static void doSeStop(CSE_REQP* pReqp) {
     u32 cond = makeConditions(pReqp);
     struct VWork* i;
 
-    SDL_LockMutex(soundLock);
-
     list_for_each (i, &active_voices, list) {
         if (checkConditions(&i->id, pReqp, cond)) {
             SPU_VoiceStop(i->voice_num);
         }
     }
-
-    SDL_UnlockMutex(soundLock);
 }
 
-void emlShimSeStopAll() {
+static void doSeStopAll() {
     struct VWork* i;
 
-    SDL_LockMutex(soundLock);
-
     list_for_each (i, &active_voices, list) {
         SPU_VoiceStop(i->voice_num);
     }
-
-    SDL_UnlockMutex(soundLock);
 }
 
-void emlShimSysSetVolume(CSE_SYS_PARAM_BANKVOL* param) {
-    SDL_LockMutex(soundLock);
-
-    if (param->bank == 0xff) {
-        masterVolume = param->vol ? (param->vol * 0x3fff) / 0x7f : 0;
-    } else {
-        assignedBankVolume[param->bank] = param->vol ? (param->vol * 0x3fff) / 0x7f : 0;
-    }
-
-    for (int i = 0; i < 16; i++) {
-        bankVolume[i] = (masterVolume * assignedBankVolume[i]) / 0x3fff;
-    }
-
-    SDL_UnlockMutex(soundLock);
+static void doSysSetBankVolume(CSE_SYS_PARAM_BANKVOL* param) {
+    bankVolume[param->bank] = param->vol ? (param->vol * 0x3fff) / 0x7f : 0;
 }
 
-void emlShimSeSetLfo(CSE_SYS_PARAM_LFO* param) {
+static void doSeSetLfo(CSE_SYS_PARAM_LFO* param) {
     u32 cond = makeConditions(&param->reqp);
     struct VWork* i;
 
-    SDL_LockMutex(soundLock);
-
     list_for_each (i, &active_voices, list) {
         if (checkConditions(&i->id, &param->reqp, cond)) {
             i->lfo_pitch.state = 0;
@@ -571,8 +579,154 @@ void emlShimSeSetLfo(CSE_SYS_PARAM_LFO* param) {
             i->lfo_vol.depth = param->amd_depth;
         }
     }
+}
+
+static void applyCommand(Command* command) {
+    switch (command->type) {
+    case COMMAND_START_SOUND:
+        doStartSound(&command->param.start);
+        break;
+    case COMMAND_KEY_OFF:
+        doSeKeyOff(&command->param.reqp);
+        break;
+    case COMMAND_STOP:
+        doSeStop(&command->param.reqp);
+        break;
+    case COMMAND_STOP_ALL:
+        doSeStopAll();
+        break;
+    case COMMAND_SET_BANK_VOLUME:
+        doSysSetBankVolume(&command->param.bankvol);
+        break;
+    case COMMAND_SET_LFO:
+        doSeSetLfo(&command->param.lfo);
+        break;
+    }
+}
+
+static void applyCommands() {
+    const u32 head = SDL_GetAtomicU32(&commandHead);
+    u32 tail = SDL_GetAtomicU32(&commandTail);
+    u32 maxLatency, avgLatency;
+    Uint64 now;
+
+    if (tail == head) {
+        return;
+    }
+
+    now = SDL_GetTicksNS();
+    maxLatency = SDL_GetAtomicU32(&maxLatencyUs);
+    avgLatency = SDL_GetAtomicU32(&avgLatencyUs);
+
+    while (tail != head) {
+        Command* command = &commandRing[tail & (COMMAND_RING_SIZE - 1)];
+        const u32 latency = (u32)((now - command->enqueue_time) / 1000);
+
+        applyCommand(command);
+
+        maxLatency = SDL_max(maxLatency, latency);
+
+        // Exponential moving average with a weight of 1/16
+        avgLatency = (u32)((s32)avgLatency + ((s32)latency - (s32)avgLatency) / 16);
+
+        tail += 1;
+    }
+
+    SDL_SetAtomicU32(&maxLatencyUs, maxLatency);
+    SDL_SetAtomicU32(&avgLatencyUs, avgLatency);
+    SDL_SetAtomicU32(&commandTail, tail);
+}
+
+static Command* reserveCommand(CommandType type) {
+    const u32 head = SDL_GetAtomicU32(&commandHead);
+    const u32 tail = SDL_GetAtomicU32(&commandTail);
+    const int used = head - tail;
+    Command* command;
+
+    if (used >= COMMAND_RING_SIZE) {
+        droppedCommands += 1;
+        return NULL;
+    }
+
+    queueHighWater = SDL_max(queueHighWater, used + 1);
+
+    command = &commandRing[head & (COMMAND_RING_SIZE - 1)];
+    command->type = type;
+    return command;
+}
+
+static void publishCommand(Command* command) {
+    command->enqueue_time = SDL_GetTicksNS();
+    SDL_SetAtomicU32(&commandHead, SDL_GetAtomicU32(&commandHead) + 1);
+}
+
+void emlShimStartSound(CSE_SYS_PARAM_SNDSTART* param) {
+    Command* command = reserveCommand(COMMAND_START_SOUND);
+
+    if (command) {
+        command->param.start = *param;
+        publishCommand(command);
+    }
+}
+
+void emlShimSeKeyOff(CSE_REQP* pReqp) {
+    Command* command = reserveCommand(COMMAND_KEY_OFF);
+
+    if (command) {
+        command->param.reqp = *pReqp;
+        publishCommand(command);
+    }
+}
+
+void emlShimSeStop(CSE_REQP* pReqp) {
+    Command* command = reserveCommand(COMMAND_STOP);
+
+    if (command) {
+        command->param.reqp = *pReqp;
+        publishCommand(command);
+    }
+}
+
+void emlShimSeStopAll() {
+    Command* command = reserveCommand(COMMAND_STOP_ALL);
+
+    if (command) {
+        publishCommand(command);
+    }
+}
+
+void emlShimSysSetVolume(CSE_SYS_PARAM_BANKVOL* param) {
+    Command* command;
+
+    if (param->bank == 0xff) {
+        // Master volume is the gain of the whole SE bus
+        Mixer_SetGain(MIXER_BUS_SE, param->vol / 127.0f);
+        return;
+    }
+
+    command = reserveCommand(COMMAND_SET_BANK_VOLUME);
+
+    if (command) {
+        command->param.bankvol = *param;
+        publishCommand(command);
+    }
+}
+
+void emlShimSeSetLfo(CSE_SYS_PARAM_LFO* param) {
+    Command* command = reserveCommand(COMMAND_SET_LFO);
+
+    if (command) {
+        command->param.lfo = *param;
+        publishCommand(command);
+    }
+}
 
-    SDL_UnlockMutex(soundLock);
+void emlShimGetStats(EmlShimStats* stats) {
+    stats->queue_high_water = queueHighWater;
+    stats->queue_size = COMMAND_RING_SIZE;
+    stats->dropped_commands = droppedCommands;
+    stats->max_latency_us = SDL_GetAtomicU32(&maxLatencyUs);
+    stats->avg_latency_us = SDL_GetAtomicU32(&avgLatencyUs);
 }
 
 void emlShimSysSetMono(CSE_SYS_PARAM_MONO* param) {
@@ -0,0 +1,155 @@
+#include "port/sound/mixer.h"
+#include "common.h"
+
+#include <SDL3/SDL.h>
+
+#define BLOCK_FRAMES 256
+#define BLOCK_SAMPLES (BLOCK_FRAMES * MIXER_CHANNELS)
+
+// The game runs at 59.59949 fps
+#define GAME_FPS_NUM 5959949
+#define GAME_FPS_DEN 100000
+
+typedef struct MixerBusState {
+    MixerSource source;
+    float gain;
+    bool paused;
+} MixerBusState;
+
+static SDL_AudioStream* device_stream = NULL;
+static MixerBusState buses[MIXER_BUS_COUNT] = { 0 };
+static Uint64 game_frame_carry = 0;
+
+static void lock() {
+    // The device callback runs with the stream locked
+    if (device_stream != NULL) {
+        SDL_LockAudioStream(device_stream);
+    }
+}
+
+static void unlock() {
+    if (device_stream != NULL) {
+        SDL_UnlockAudioStream(device_stream);
+    }
+}
+
+static void mix_block(s16* output, int num_frames) {
+    static s16 bus_buf[BLOCK_SAMPLES];
+    float acc[BLOCK_SAMPLES];
+    const int num_samples = num_frames * MIXER_CHANNELS;
+
+    SDL_memset(acc, 0, num_samples * sizeof(float));
+
+    for (int i = 0; i < MIXER_BUS_COUNT; i++) {
+        const MixerBusState* bus = &buses[i];
+
+        if ((bus->source == NULL) || bus->paused) {
+            continue;
+        }
+
+        bus->source(bus_buf, num_frames);
+
+        for (int j = 0; j < num_samples; j++) {
+            acc[j] += bus_buf[j] * bus->gain;
+        }
+    }
+
+    for (int i = 0; i < num_samples; i++) {
+        output[i] = SDL_clamp(acc[i], INT16_MIN, INT16_MAX);
+    }
+}
+
+static void mix(s16* output, int num_frames) {
+    while (num_frames > 0) {
+        const int block_frames = SDL_min(num_frames, BLOCK_FRAMES);
+        mix_block(output, block_frames);
+        output += block_frames * MIXER_CHANNELS;
+        num_frames -= block_frames;
+    }
+}
+
+static void device_callback(void* userdata, SDL_AudioStream* stream, int additional_amount, int total_amount) {
+    static s16 outbuf[BLOCK_SAMPLES];
+    int num_frames = additional_amount / (MIXER_CHANNELS * sizeof(s16));
+
+    while (num_frames > 0) {
+        const int block_frames = SDL_min(num_frames, BLOCK_FRAMES);
+        mix_block(outbuf, block_frames);
+        SDL_PutAudioStreamData(stream, outbuf, block_frames * MIXER_CHANNELS * sizeof(s16));
+        num_frames -= block_frames;
+    }
+}
+
+bool Mixer_Init(bool open_device) {
+    game_frame_carry = 0;
+
+    for (int i = 0; i < MIXER_BUS_COUNT; i++) {
+        buses[i].source = NULL;
+        buses[i].gain = 1.0f;
+        buses[i].paused = false;
+    }
+
+    if (!open_device) {
+        return true;
+    }
+
+    const SDL_AudioSpec spec = { .format = SDL_AUDIO_S16, .channels = MIXER_CHANNELS, .freq = MIXER_SAMPLE_RATE };
+    device_stream = SDL_OpenAudioDeviceStream(SDL_AUDIO_DEVICE_DEFAULT_PLAYBACK, &spec, device_callback, NULL);
+
+    if (device_stream == NULL) {
+        SDL_Log("Couldn't create SDL audio stream: %s", SDL_GetError());
+        return false;
+    }
+
+    SDL_ResumeAudioStreamDevice(device_stream);
+    return true;
+}
+
+void Mixer_Quit() {
+    if (device_stream != NULL) {
+        SDL_DestroyAudioStream(device_stream);
+        device_stream = NULL;
+    }
+
+    SDL_zeroa(buses);
+}
+
+void Mixer_SetSource(MixerBus bus, MixerSource source) {
+    lock();
+    buses[bus].source = source;
+    unlock();
+}
+
+void Mixer_SetGain(MixerBus bus, float gain) {
+    lock();
+    buses[bus].gain = gain;
+    unlock();
+}
+
+void Mixer_SetPaused(MixerBus bus, bool paused) {
+    lock();
+    buses[bus].paused = paused;
+    unlock();
+}
+
+bool Mixer_IsPaused(MixerBus bus) {
+    return buses[bus].paused;
+}
+
+void Mixer_Render(s16* output, int num_frames) {
+    if (device_stream != NULL) {
+        fatal_error("Mixer_Render can't be used while the mixer outputs to a device.");
+    }
+
+    mix(output, num_frames);
+}
+
+int Mixer_RenderGameFrame(s16* output) {
+    // Exact integer arithmetic, so that runs produce identical output on every machine
+    game_frame_carry += (Uint64)MIXER_SAMPLE_RATE * GAME_FPS_DEN;
+    const int num_frames = game_frame_carry / GAME_FPS_NUM;
+    game_frame_carry %= GAME_FPS_NUM;
+
+    Mixer_Render(output, num_frames);
+    return num_frames;
+}
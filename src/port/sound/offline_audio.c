@@ -0,0 +1,105 @@
+#include "port/sound/offline_audio.h"
+#include "port/sound/mixer.h"
+
+#include <SDL3/SDL.h>
+
+#include <inttypes.h>
+#include <stdio.h>
+
+#define WAV_HEADER_SIZE 44
+#define FNV_OFFSET_BASIS 0xCBF29CE484222325ULL
+#define FNV_PRIME 0x100000001B3ULL
+
+static SDL_IOStream* wav = NULL;
+static Uint32 wav_data_size = 0;
+static u64 hash = FNV_OFFSET_BASIS;
+static Uint64 rendered_frames = 0;
+static s16 last_samples[MIXER_MAX_GAME_FRAME_FRAMES * MIXER_CHANNELS];
+static int last_num_frames = 0;
+
+static void write_wav_header() {
+    const int block_align = MIXER_CHANNELS * sizeof(s16);
+
+    SDL_SeekIO(wav, 0, SDL_IO_SEEK_SET);
+    SDL_WriteU32BE(wav, 0x52494646); // "RIFF"
+    SDL_WriteU32LE(wav, WAV_HEADER_SIZE - 8 + wav_data_size);
+    SDL_WriteU32BE(wav, 0x57415645); // "WAVE"
+    SDL_WriteU32BE(wav, 0x666D7420); // "fmt "
+    SDL_WriteU32LE(wav, 16);
+    SDL_WriteU16LE(wav, 1); // PCM
+    SDL_WriteU16LE(wav, MIXER_CHANNELS);
+    SDL_WriteU32LE(wav, MIXER_SAMPLE_RATE);
+    SDL_WriteU32LE(wav, MIXER_SAMPLE_RATE * block_align);
+    SDL_WriteU16LE(wav, block_align);
+    SDL_WriteU16LE(wav, 16);
+    SDL_WriteU32BE(wav, 0x64617461); // "data"
+    SDL_WriteU32LE(wav, wav_data_size);
+}
+
+static void hash_samples(const s16* samples, int count) {
+    // Hash little-endian bytes, so that the result doesn't depend on the host
+    for (int i = 0; i < count; i++) {
+        const u16 sample = samples[i];
+
+        hash = (hash ^ (sample & 0xFF)) * FNV_PRIME;
+        hash = (hash ^ (sample >> 8)) * FNV_PRIME;
+    }
+}
+
+void OfflineAudio_Init(const char* wav_path) {
+    hash = FNV_OFFSET_BASIS;
+    rendered_frames = 0;
+    wav_data_size = 0;
+
+    if (wav_path == NULL) {
+        return;
+    }
+
+    wav = SDL_IOFromFile(wav_path, "wb");
+
+    if (wav == NULL) {
+        SDL_Log("Couldn't open %s for writing: %s", wav_path, SDL_GetError());
+        return;
+    }
+
+    // Sizes are filled in when the file is closed
+    write_wav_header();
+}
+
+void OfflineAudio_Quit() {
+    if (wav != NULL) {
+        write_wav_header();
+        SDL_CloseIO(wav);
+        wav = NULL;
+    }
+
+    printf("Offline audio: %" PRIu64 " frames, hash %016" PRIX64 "\n", rendered_frames, hash);
+}
+
+void OfflineAudio_RunFrame() {
+    const int num_frames = Mixer_RenderGameFrame(last_samples);
+    const int num_samples = num_frames * MIXER_CHANNELS;
+
+    last_num_frames = num_frames;
+    hash_samples(last_samples, num_samples);
+    rendered_frames += num_frames;
+
+    if (wav == NULL) {
+        return;
+    }
+
+    for (int i = 0; i < num_samples; i++) {
+        SDL_WriteS16LE(wav, last_samples[i]);
+    }
+
+    wav_data_size += num_samples * sizeof(s16);
+}
+
+u64 OfflineAudio_GetHash() {
+    return hash;
+}
+
+int OfflineAudio_GetLastFrame(const s16** samples) {
+    *samples = last_samples;
+    return last_num_frames;
+}
@@ -4,6 +4,7 @@
 #include <SDL3/SDL.h>
 #include <stdbool.h>
 #include <stdio.h>
+#include <stdlib.h>
 #include <string.h>
 
 #define min(a, b) (((a) < (b)) ? (a) : (b))
@@ -11,6 +12,11 @@
 #define clamp(val, min, max) (((val) > (max)) ? (max) : (((val) < (min)) ? (min) : (val)))
 
 #define VOICE_COUNT 48
+#define RAM_WORDS ((2 * 1024 * 1024) >> 1)
+#define BANK_COUNT 16
+
+#define ADPCM_BLOCK_WORDS 8
+#define ADPCM_BLOCK_SAMPLES 28
 
 #include "interp_table.inc"
 
@@ -31,6 +37,24 @@ struct AdsrParamCache {
     bool infinite;
 };
 
+// Samples of an uploaded bank decoded to PCM ahead of time.
+// A cached sample covers every block before the one carrying the end flag. The end block and
+// anything after a loop jump are decoded live, so flag handling stays in one place.
+struct PcmSample {
+    u32 ssa;        // Start address in ram words
+    u32 num_blocks; // Blocks decoded into pcm
+    s16* pcm;
+};
+
+struct PcmBank {
+    struct PcmBank* next_retired;
+    u32 retire_epoch;
+    size_t bytes;
+    u32 begin, end; // Range of start addresses, in ram words
+    int num_samples;
+    struct PcmSample samples[];
+};
+
 struct SPU_Voice {
     bool run;
     bool noise;
@@ -55,18 +79,46 @@ struct SPU_Voice {
 
     s16 decodeBuf[0x40];
     u32 decRPos, decWPos, decLeft;
-};
 
-SDL_Mutex* soundLock;
+    int pcmBankIndex;
+    struct PcmBank* pcmBank;
+    struct PcmSample* pcmSample;
+    u32 pcmPos;
+};
 
 static void (*timer_cb)();
-static SDL_AudioStream* stream;
 static struct SPU_Voice voices[VOICE_COUNT];
-static u16 ram[(2 * 1024 * 1024) >> 1];
+static u16 ram[RAM_WORDS];
 static s16 adpcm_coefs[5][2] = {
     { 0, 0 }, { 60, 0 }, { 115, -52 }, { 98, -55 }, { 122, -60 },
 };
 
+// Banks are published by the game thread and picked up by the audio thread at key-on.
+// The audio thread bumps pcmEpoch after every block, once voices playing from a bank that
+// is no longer published have gone back to live decoding.
+static struct PcmBank* pcmBanks[BANK_COUNT];
+static SDL_AtomicU32 pcmEpoch;
+static struct PcmBank* retiredBanks;
+static size_t pcmCacheBudget;
+static size_t pcmCacheUsed;
+
+// Decoding a whole bank takes several milliseconds, so banks are decoded a slice per frame
+// by SPU_StepPcmCache and only published once they are complete.
+#define PCM_BUILD_BLOCKS_PER_STEP 2048
+
+struct PcmBuild {
+    struct PcmBank* cache;
+    int sample;  // Sample being decoded
+    u32 block;   // Next block of that sample
+    s16 hist[2]; // Decoder history at that block
+};
+
+static struct PcmBuild pcmBuilds[BANK_COUNT];
+
+static Uint64 renderTimeNs;
+static SDL_AtomicU32 renderTimeUs;
+static SDL_AtomicU32 renderedFrames;
+
 static s16 SPU_ApplyVolume(s16 sample, s32 volume) {
     return (sample * volume) >> 15;
 }
@@ -156,41 +208,91 @@ static void SPU_VoiceRunADSR(struct SPU_Voice* v) {
     }
 }
 
-static void SPU_VoiceDecode(struct SPU_Voice* v) {
-    u32 data;
-    u16 header, filter, shift;
-
-    if (v->decLeft >= 16) {
-        return;
-    }
-
-    data = ram[v->nax];
-    header = ram[v->nax & ~0x7];
-    shift = header & 0xf;
-    filter = (header >> 4) & 7;
+static void SPU_DecodeWord(u16 data, u16 header, s16* hist, s16* output) {
+    u16 shift = header & 0xf;
+    u16 filter = (header >> 4) & 7;
 
     for (int i = 0; i < 4; i++) {
         s32 sample = (s16)((data & 0xF) << 12);
         sample >>= shift;
 
         // TODO do the right thing for invalid shift/filter values
-        sample += (adpcm_coefs[filter][0] * v->decodeHist[0]) >> 6;
-        sample += (adpcm_coefs[filter][1] * v->decodeHist[1]) >> 6;
+        sample += (adpcm_coefs[filter][0] * hist[0]) >> 6;
+        sample += (adpcm_coefs[filter][1] * hist[1]) >> 6;
 
         // We do get overflow here otherwise, should we?
         sample = clamp(sample, INT16_MIN, INT16_MAX);
 
-        v->decodeHist[1] = v->decodeHist[0];
-        v->decodeHist[0] = (s16)sample;
+        hist[1] = hist[0];
+        hist[0] = (s16)sample;
+        output[i] = sample;
 
-        v->decodeBuf[v->decWPos] = sample;
-        v->decodeBuf[v->decWPos | 0x20] = sample;
+        data >>= 4;
+    }
+}
+
+static void SPU_VoicePushSamples(struct SPU_Voice* v, const s16* samples) {
+    for (int i = 0; i < 4; i++) {
+        v->decodeBuf[v->decWPos] = samples[i];
+        v->decodeBuf[v->decWPos | 0x20] = samples[i];
 
         v->decWPos = (v->decWPos + 1) & 0x1f;
         v->decLeft++;
+    }
+}
 
-        data >>= 4;
+// Continue from the cached sample's current position with live decoding
+static void SPU_VoiceLeaveCache(struct SPU_Voice* v) {
+    const struct PcmSample* s = v->pcmSample;
+    const u32 block = v->pcmPos / ADPCM_BLOCK_SAMPLES;
+    const u32 offset = v->pcmPos % ADPCM_BLOCK_SAMPLES;
+
+    v->lsa = s->ssa;
+
+    for (u32 i = 0; i <= block; i++) {
+        const u32 addr = (s->ssa + i * ADPCM_BLOCK_WORDS) & 0xfffff;
+
+        if (ram[addr] & 0x400) {
+            v->lsa = addr;
+        }
+    }
+
+    v->nax = (s->ssa + block * ADPCM_BLOCK_WORDS + 1 + offset / 4) & 0xfffff;
+
+    if (v->pcmPos >= 2) {
+        v->decodeHist[0] = s->pcm[v->pcmPos - 1];
+        v->decodeHist[1] = s->pcm[v->pcmPos - 2];
+    }
+
+    v->pcmBank = NULL;
+    v->pcmSample = NULL;
+}
+
+static void SPU_VoiceDecodeCached(struct SPU_Voice* v) {
+    SPU_VoicePushSamples(v, &v->pcmSample->pcm[v->pcmPos]);
+    v->pcmPos += 4;
+
+    if (v->pcmPos == v->pcmSample->num_blocks * ADPCM_BLOCK_SAMPLES) {
+        SPU_VoiceLeaveCache(v);
     }
+}
+
+static void SPU_VoiceDecode(struct SPU_Voice* v) {
+    s16 samples[4];
+    u16 header;
+
+    if (v->decLeft >= 16) {
+        return;
+    }
+
+    if (v->pcmSample) {
+        SPU_VoiceDecodeCached(v);
+        return;
+    }
+
+    header = ram[v->nax & ~0x7];
+    SPU_DecodeWord(ram[v->nax], header, v->decodeHist, samples);
+    SPU_VoicePushSamples(v, samples);
 
     v->nax = (v->nax + 1) & 0xfffff;
 
@@ -289,6 +391,241 @@ void SPU_VoiceSetConf(int vnum, struct SPUVConf* conf) {
     v->adsr2 = conf->adsr2;
 }
 
+static int SPU_ComparePcmSamples(const void* a, const void* b) {
+    const struct PcmSample* sa = a;
+    const struct PcmSample* sb = b;
+
+    return (sa->ssa > sb->ssa) - (sa->ssa < sb->ssa);
+}
+
+static struct PcmSample* SPU_FindCachedSample(u32 addr, struct PcmBank** out_bank, int* out_index) {
+    for (int i = 0; i < BANK_COUNT; i++) {
+        struct PcmBank* bank = SDL_GetAtomicPointer((void**)&pcmBanks[i]);
+        struct PcmSample key = { .ssa = addr };
+        struct PcmSample* sample;
+
+        if ((bank == NULL) || (addr < bank->begin) || (addr > bank->end)) {
+            continue;
+        }
+
+        sample = bsearch(&key, bank->samples, bank->num_samples, sizeof(struct PcmSample), SPU_ComparePcmSamples);
+
+        if (sample != NULL) {
+            *out_bank = bank;
+            *out_index = i;
+            return sample;
+        }
+    }
+
+    return NULL;
+}
+
+// Runs on the audio thread before every block
+static void SPU_SyncPcmCache() {
+    for (int i = 0; i < VOICE_COUNT; i++) {
+        struct SPU_Voice* v = &voices[i];
+
+        if (v->pcmSample && (SDL_GetAtomicPointer((void**)&pcmBanks[v->pcmBankIndex]) != v->pcmBank)) {
+            SPU_VoiceLeaveCache(v);
+        }
+    }
+
+    SDL_SetAtomicU32(&pcmEpoch, SDL_GetAtomicU32(&pcmEpoch) + 1);
+}
+
+// Frees dropped banks once no voice can be reading from them anymore
+static void SPU_ReclaimPcmBanks() {
+    const u32 epoch = SDL_GetAtomicU32(&pcmEpoch);
+    struct PcmBank** link = &retiredBanks;
+
+    while (*link) {
+        struct PcmBank* bank = *link;
+
+        // One block to make voices leave the bank, one more for key-ons that raced with the drop
+        if ((u32)(epoch - bank->retire_epoch) >= 2) {
+            *link = bank->next_retired;
+            pcmCacheUsed -= bank->bytes;
+            SDL_free(bank);
+        } else {
+            link = &bank->next_retired;
+        }
+    }
+}
+
+// Number of blocks before the end block, or 0 if the sample can't be cached
+static u32 SPU_MeasureSample(u32 ssa, u32 size) {
+    const u32 max_blocks = size / (ADPCM_BLOCK_WORDS * 2);
+
+    for (u32 i = 0; i < max_blocks; i++) {
+        const u32 addr = ssa + i * ADPCM_BLOCK_WORDS;
+
+        if (addr + ADPCM_BLOCK_WORDS > RAM_WORDS) {
+            break;
+        }
+
+        if (ram[addr] & 0x100) {
+            return i;
+        }
+    }
+
+    return 0;
+}
+
+void SPU_SetPcmCacheBudget(size_t bytes) {
+    pcmCacheBudget = bytes;
+}
+
+void SPU_CachePcmBank(int bank, const struct SPUSampleInfo* samples, int count) {
+    struct PcmSample* entries;
+    struct PcmBank* cache;
+    size_t pcm_bytes = 0;
+    int num_entries = 0;
+    s16* pcm;
+
+    SPU_DropPcmBank(bank);
+    SPU_ReclaimPcmBanks();
+
+    if ((pcmCacheBudget == 0) || (count <= 0)) {
+        return;
+    }
+
+    entries = SDL_malloc(count * sizeof(struct PcmSample));
+
+    for (int i = 0; i < count; i++) {
+        const u32 ssa = samples[i].addr >> 1;
+
+        if ((samples[i].addr & 0xf) || (ssa >= RAM_WORDS)) {
+            continue;
+        }
+
+        entries[num_entries].ssa = ssa;
+        entries[num_entries].num_blocks = SPU_MeasureSample(ssa, samples[i].size);
+
+        if (entries[num_entries].num_blocks > 0) {
+            num_entries += 1;
+        }
+    }
+
+    qsort(entries, num_entries, sizeof(struct PcmSample), SPU_ComparePcmSamples);
+
+    // Several programs can share a sample, and whatever doesn't fit the budget is decoded live
+    for (int i = 0; i < num_entries; i++) {
+        const size_t bytes = entries[i].num_blocks * ADPCM_BLOCK_SAMPLES * sizeof(s16);
+
+        if ((i > 0) && (entries[i].ssa == entries[i - 1].ssa)) {
+            entries[i].num_blocks = 0;
+        } else if (pcmCacheUsed + pcm_bytes + bytes > pcmCacheBudget) {
+            entries[i].num_blocks = 0;
+        } else {
+            pcm_bytes += bytes;
+        }
+    }
+
+    if (pcm_bytes == 0) {
+        SDL_free(entries);
+        return;
+    }
+
+    cache = SDL_malloc(sizeof(struct PcmBank) + num_entries * sizeof(struct PcmSample) + pcm_bytes);
+    cache->next_retired = NULL;
+    cache->retire_epoch = 0;
+    cache->bytes = pcm_bytes;
+    cache->num_samples = 0;
+    pcm = (s16*)&cache->samples[num_entries];
+
+    for (int i = 0; i < num_entries; i++) {
+        struct PcmSample* sample = &cache->samples[cache->num_samples];
+
+        if (entries[i].num_blocks == 0) {
+            continue;
+        }
+
+        *sample = entries[i];
+        sample->pcm = pcm;
+        pcm += sample->num_blocks * ADPCM_BLOCK_SAMPLES;
+        cache->num_samples += 1;
+    }
+
+    cache->begin = cache->samples[0].ssa;
+    cache->end = cache->samples[cache->num_samples - 1].ssa;
+
+    SDL_free(entries);
+
+    // The budget is taken right away so that banks queued behind this one see it
+    pcmCacheUsed += cache->bytes;
+    SDL_zero(pcmBuilds[bank]);
+    pcmBuilds[bank].cache = cache;
+}
+
+void SPU_StepPcmCache() {
+    int blocks_left = PCM_BUILD_BLOCKS_PER_STEP;
+
+    for (int bank = 0; (bank < BANK_COUNT) && (blocks_left > 0); bank++) {
+        struct PcmBuild* build = &pcmBuilds[bank];
+        struct PcmBank* cache = build->cache;
+
+        if (cache == NULL) {
+            continue;
+        }
+
+        while ((build->sample < cache->num_samples) && (blocks_left > 0)) {
+            const struct PcmSample* sample = &cache->samples[build->sample];
+            const u32 end = min(sample->num_blocks, build->block + blocks_left);
+
+            for (; build->block < end; build->block++) {
+                const u16* data = &ram[sample->ssa + build->block * ADPCM_BLOCK_WORDS];
+                s16* pcm = sample->pcm + build->block * ADPCM_BLOCK_SAMPLES;
+
+                for (int word = 1; word < ADPCM_BLOCK_WORDS; word++) {
+                    SPU_DecodeWord(data[word], data[0], build->hist, pcm);
+                    pcm += 4;
+                }
+
+                blocks_left -= 1;
+            }
+
+            if (build->block == sample->num_blocks) {
+                build->sample += 1;
+                build->block = 0;
+                build->hist[0] = 0;
+                build->hist[1] = 0;
+            }
+        }
+
+        if (build->sample == cache->num_samples) {
+            build->cache = NULL;
+            SDL_SetAtomicPointer((void**)&pcmBanks[bank], cache);
+        }
+    }
+}
+
+void SPU_DropPcmBank(int bank) {
+    struct PcmBank* cache = SDL_GetAtomicPointer((void**)&pcmBanks[bank]);
+
+    // A bank that is still being decoded was never published, so nothing can be reading from it
+    if (pcmBuilds[bank].cache != NULL) {
+        pcmCacheUsed -= pcmBuilds[bank].cache->bytes;
+        SDL_free(pcmBuilds[bank].cache);
+        SDL_zero(pcmBuilds[bank]);
+    }
+
+    if (cache == NULL) {
+        return;
+    }
+
+    SDL_SetAtomicPointer((void**)&pcmBanks[bank], NULL);
+    cache->retire_epoch = SDL_GetAtomicU32(&pcmEpoch);
+    cache->next_retired = retiredBanks;
+    retiredBanks = cache;
+}
+
+void SPU_GetStats(struct SPUStats* stats) {
+    stats->render_time_us = SDL_GetAtomicU32(&renderTimeUs);
+    stats->rendered_frames = SDL_GetAtomicU32(&renderedFrames);
+    stats->pcm_cache_bytes = pcmCacheUsed;
+    stats->pcm_cache_budget = pcmCacheBudget;
+}
+
 void SPU_VoiceStart(int vnum, u32 start_addr) {
     struct SPU_Voice* v = &voices[vnum];
     u16 header;
@@ -303,78 +640,66 @@ void SPU_VoiceStart(int vnum, u32 start_addr) {
     v->adsr_phase = ADSR_PHASE_ATTACK;
     SPU_VoiceCacheADSR(v);
 
+    // Start from a clean decoder so that cached and live decoding produce the same output
+    v->decodeHist[0] = 0;
+    v->decodeHist[1] = 0;
+    v->counter = 0;
+    v->decRPos = 0;
+    v->decWPos = 0;
+    v->decLeft = 0;
+
     header = ram[v->nax & ~0x7];
     if ((header >> 10) & 1) {
         v->lsa = v->nax;
     }
 
     v->nax = (v->nax + 1) & 0xfffff;
-}
 
-void SPU_SDL_CB(void* user, SDL_AudioStream* stream, int additional_amount, int total_amount) {
-    u32 samples_per_channel = (additional_amount / sizeof(s16)) >> 1;
-    static s16 outbuf[4096] = {};
+    v->pcmBank = NULL;
+    v->pcmSample = SPU_FindCachedSample(start_addr, &v->pcmBank, &v->pcmBankIndex);
+    v->pcmPos = 0;
+}
 
+void SPU_Render(s16* output, int num_frames) {
     // We need to run the eml callbaack at 250hz
     // 48000 / 250 = 192
     static int cb_timer = 192;
+    const Uint64 start_time = SDL_GetTicksNS();
 
-    // TODO consider redesigning this whole system, emlshim and spu should probably run
-    // on the same thread, no locks would be needed in the SDL audio callback path
-    SDL_LockMutex(soundLock);
-
-    while (samples_per_channel) {
-        u32 batch_count = min(samples_per_channel, 4096);
-        s16* p = outbuf;
-        for (int i = 0; i < batch_count; i++) {
-            SPU_Tick(p);
-            p += 2;
-
-            cb_timer--;
-            if (!cb_timer) {
-                timer_cb();
-                cb_timer = 192;
-            }
-        }
+    SPU_SyncPcmCache();
+
+    for (int i = 0; i < num_frames; i++) {
+        SPU_Tick(output);
+        output += 2;
 
-        SDL_PutAudioStreamData(stream, outbuf, (batch_count * sizeof(s16)) << 1);
-        samples_per_channel -= batch_count;
+        cb_timer--;
+        if (!cb_timer) {
+            timer_cb();
+            cb_timer = 192;
+        }
     }
 
-    SDL_UnlockMutex(soundLock);
+    renderTimeNs += SDL_GetTicksNS() - start_time;
+    SDL_SetAtomicU32(&renderTimeUs, (u32)(renderTimeNs / 1000));
+    SDL_SetAtomicU32(&renderedFrames, SDL_GetAtomicU32(&renderedFrames) + num_frames);
 }
 
 static void nullcb() {}
 
 void SPU_Init(void (*cb)()) {
-    SDL_AudioSpec spec;
-
     timer_cb = cb;
     if (!cb) {
         timer_cb = nullcb;
     }
 
     memset(voices, 0, sizeof(voices));
-    soundLock = SDL_CreateMutex();
-
-    spec.channels = 2;
-    spec.format = SDL_AUDIO_S16;
-    spec.freq = 48000;
-
-    stream = SDL_OpenAudioDeviceStream(SDL_AUDIO_DEVICE_DEFAULT_PLAYBACK, &spec, SPU_SDL_CB, NULL);
-    if (!stream) {
-        SDL_Log("Couldn't create SDL audio stream: %s", SDL_GetError());
-    }
-
-    SDL_ResumeAudioStreamDevice(stream);
 }
 
 void SPU_Upload(u32 dst, void* src, u32 size) {
-    SDL_LockMutex(soundLock);
-
+    // Like the SPU2 DMA on hardware this isn't synchronised with voice playback.
+    // A voice reading a region that's being replaced plays garbage at worst,
+    // nax is masked so it never leaves sound RAM.
     memcpy(&ram[dst >> 1], src, size);
-
-    SDL_UnlockMutex(soundLock);
 }
 
 void SPU_Tick(s16* output) {
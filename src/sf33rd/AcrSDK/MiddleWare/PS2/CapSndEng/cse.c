@@ -2,15 +2,47 @@
 #include "common.h"
 #include "port/sound/spu.h"
 #include "sf33rd/AcrSDK/MiddleWare/PS2/CapSndEng/emlMemMap.h"
+#include "sf33rd/AcrSDK/MiddleWare/PS2/CapSndEng/emlRefPhd.h"
 #include "sf33rd/AcrSDK/MiddleWare/PS2/CapSndEng/emlRpcQueue.h"
 #include "sf33rd/AcrSDK/MiddleWare/PS2/CapSndEng/emlSndDrv.h"
 #include "sf33rd/AcrSDK/MiddleWare/PS2/CapSndEng/emlTSB.h"
 
 #include <assert.h>
+#include <stdarg.h>
 #include <stdio.h>
+#include <stdlib.h>
 
 static CSE_SYSWORK cseSysWork __attribute__((aligned(16)));
 
+// Banks whose BD or PHD changed since the SPU PCM cache was last built for them
+static u32 spuCacheDirty;
+
+static void cacheSpuBank(u32 bank) {
+    _ps2_head_chunk* pHEAD = mlMemMapGetPhdAddr(bank);
+    _ps2_vagi_param* pVPRM;
+    struct SPUSampleInfo* samples;
+    s32 num;
+
+    if ((pHEAD == NULL) || (cseSysWork.SpuBankId[bank] == -1)) {
+        return;
+    }
+
+    num = GetVagiParam(&pVPRM, pHEAD);
+    if (num <= 0) {
+        return;
+    }
+
+    samples = malloc(num * sizeof(struct SPUSampleInfo));
+
+    for (s32 i = 0; i < num; i++) {
+        samples[i].addr = mlMemMapGetBankAddr(bank) + pVPRM[i].vagOffset;
+        samples[i].size = pVPRM[i].vagSize;
+    }
+
+    SPU_CachePcmBank(bank, samples, num);
+    free(samples);
+}
+
 s32 cseInitSndDrv() {
     u32 i;
 
@@ -28,6 +60,16 @@ s32 cseInitSndDrv() {
 
 s32 cseExecServer() {
     if (cseSysWork.InitializeFlag == 1) {
+        for (u32 bank = 0; spuCacheDirty != 0; bank++) {
+            if (spuCacheDirty & (1 << bank)) {
+                spuCacheDirty &= ~(1 << bank);
+                cacheSpuBank(bank);
+            }
+        }
+
+        // Banks are decoded a slice per frame so that loading one doesn't hold up the frame
+        SPU_StepPcmCache();
+
         mlTsbExecServer();
         cseSysWork.Counter++;
         return 0;
@@ -72,7 +114,9 @@ s32 cseSendBd2SpuWithId(void* ee_addr, u32 size, u32 bank, u32 id) {
         param.s_addr = mlMemMapGetBankAddr(bank);
         param.size = size;
 
+        SPU_DropPcmBank(bank);
         SPU_Upload(param.s_addr, ee_addr, size);
+        spuCacheDirty |= 1 << bank;
     }
 
     return 0;
@@ -83,6 +127,10 @@ u32 cseGetIdStoredBd(u32 bank) {
 }
 
 s32 cseMemMapSetPhdAddr(u32 bank, void* addr) {
+    if ((bank < SPUBANKID_MAX) && (mlMemMapGetPhdAddr(bank) != addr)) {
+        spuCacheDirty |= 1 << bank;
+    }
+
     return mlMemMapSetPhdAddr(bank, addr);
 }
 
@@ -62,6 +62,28 @@ s32 GetNumSplit(_ps2_head_chunk* pHEAD, u8 prog) {
     return pPPRM->nSplit;
 }
 
+s32 GetVagiParam(_ps2_vagi_param** ppVPRM, _ps2_head_chunk* pHEAD) {
+    _ps2_vagi_chunk* pVAGI;
+    u32 num;
+
+    if (IsSafeHeadChunk(pHEAD) != 1) {
+        return -1;
+    }
+
+    pVAGI = (_ps2_vagi_chunk*)((uintptr_t)&pHEAD->tag + (u32)pHEAD->vagiChunkOffset);
+    if (IsSafeVagiChunk(pVAGI) != 1) {
+        return -4;
+    }
+
+    num = pVAGI->maxVagInfoNum + 1;
+    if (num > (pVAGI->chunkSize - sizeof(_ps2_vagi_chunk)) / sizeof(_ps2_vagi_param)) {
+        num = (pVAGI->chunkSize - sizeof(_ps2_vagi_chunk)) / sizeof(_ps2_vagi_param);
+    }
+
+    *ppVPRM = pVAGI->vagiParam;
+    return num;
+}
+
 s32 GetPhdParam(CSE_PHDPADDR* pHDPA, _ps2_head_chunk* pHEAD, u8 prog, u8 note, u8 index) {
     _ps2_prog_chunk* pPROG;
     _ps2_smpl_chunk* pSMPL;
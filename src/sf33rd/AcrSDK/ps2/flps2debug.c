@@ -9,11 +9,38 @@
 #include "sf33rd/AcrSDK/ps2/foundaps2.h"
 #include "structs.h"
 
+#include "port/sdl/sdl_debug_text.h"
+
 #include <stdarg.h>
 #include <stdio.h>
 #include <string.h>
 
-// FIXME: reimplement using SDL apis
+#define DEBUG_STR_MAX 0x12C0
+
+void flPS2DebugInit() {
+    flDebugStrHan = flPS2GetSystemMemoryHandle(DEBUG_STR_MAX * sizeof(RenderBuffer), 1);
+    flDebugStrCtr = 0;
+    flPrintColor(0xFFFFFFFF);
+}
+
+// Hands this frame's characters to the debug text overlay
+void flPS2DebugStrFlush() {
+    RenderBuffer* buff_ptr;
+    u32 i;
+
+    SDLDebugText_Clear();
+
+    if (SDLDebugText_IsVisible()) {
+        buff_ptr = flPS2GetSystemBuffAdrs(flDebugStrHan);
+
+        for (i = 0; i < flDebugStrCtr; i++, buff_ptr++) {
+            SDLDebugText_AddChar(buff_ptr->x, buff_ptr->y, buff_ptr->code, buff_ptr->col);
+        }
+    }
+
+    flDebugStrCtr = 0;
+}
+
 s32 flPrintL(s32 posi_x, s32 posi_y, const s8* format, ...) {
     s8 code;
     s8 str[512];
@@ -30,8 +57,8 @@ s32 flPrintL(s32 posi_x, s32 posi_y, const s8* format, ...) {
     vsprintf(str, format, args);
     len = strlen(str);
 
-    if (flDebugStrCtr + len >= 0x12C0) {
-        len = 0x12C0 - flDebugStrCtr;
+    if (flDebugStrCtr + len >= DEBUG_STR_MAX) {
+        len = DEBUG_STR_MAX - flDebugStrCtr;
     }
 
     for (i = 0; i < len; i++) {
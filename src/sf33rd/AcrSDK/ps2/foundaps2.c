@@ -39,6 +39,7 @@ s32 flInitialize() {
     }
 
     flPS2SystemTmpBuffInit();
+    flPS2DebugInit();
     flPS2InitRenderBuff();
     flPADInitialize();
 
@@ -65,6 +66,7 @@ static s32 system_work_init() {
 
 s32 flFlip(u32 flag) {
     flPS2SystemTmpBuffFlush();
+    flPS2DebugStrFlush();
     cseExecServer(); // FIXME: This shouldn't be called from multiple places
     return 1;
 }
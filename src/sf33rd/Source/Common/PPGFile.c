@@ -12,6 +12,11 @@
 
 #include <SDL3/SDL.h>
 
+#if defined(__SSE2__) || defined(_M_X64)
+#include <emmintrin.h>
+#define PPG_SSE2
+#endif
+
 #define MAGIC_TO_INT(str) ((str[0] << 0x18) | (str[1] << 0x10) | (str[2] << 0x8) | (str[3]))
 #define REVERT_U32(val)                                                                                                \
     (((val & 0xFF) << 0x18) | ((val & 0xFF00) << 8) | ((val >> 8) & 0xFF00) | ((val >> 0x18) & 0xFF))
@@ -673,11 +678,65 @@ error_handler:
     while (1) {}
 }
 
-void ppgChangeDataEndian(u8* adrs, s32 size, s32 dendL, s32 col4, s32 depth, s32 excdot) {
-    s32 i;
-    u32* c4;
-    u16* c2;
+static void ppgRevertU32(u32* c4, s32 num) {
+    s32 i = 0;
+
+#if defined(PPG_SSE2)
+    __m128i v;
 
+    for (; i + 4 <= num; i += 4) {
+        v = _mm_loadu_si128((__m128i*)&c4[i]);
+        v = _mm_or_si128(_mm_slli_epi16(v, 8), _mm_srli_epi16(v, 8));
+        v = _mm_shufflelo_epi16(v, _MM_SHUFFLE(2, 3, 0, 1));
+        v = _mm_shufflehi_epi16(v, _MM_SHUFFLE(2, 3, 0, 1));
+        _mm_storeu_si128((__m128i*)&c4[i], v);
+    }
+#endif
+
+    for (; i < num; i++) {
+        c4[i] = REVERT_U32(c4[i]);
+    }
+}
+
+static void ppgRevertU16(u16* c2, s32 num) {
+    s32 i = 0;
+
+#if defined(PPG_SSE2)
+    __m128i v;
+
+    for (; i + 8 <= num; i += 8) {
+        v = _mm_loadu_si128((__m128i*)&c2[i]);
+        v = _mm_or_si128(_mm_slli_epi16(v, 8), _mm_srli_epi16(v, 8));
+        _mm_storeu_si128((__m128i*)&c2[i], v);
+    }
+#endif
+
+    for (; i < num; i++) {
+        c2[i] = REVERT_U16(c2[i]);
+    }
+}
+
+static void ppgRevertU8(u8* adrs, s32 num) {
+    s32 i = 0;
+
+#if defined(PPG_SSE2)
+    const __m128i lo_mask = _mm_set1_epi8(0xF);
+    const __m128i hi_mask = _mm_set1_epi8((s8)0xF0);
+    __m128i v;
+
+    for (; i + 16 <= num; i += 16) {
+        v = _mm_loadu_si128((__m128i*)&adrs[i]);
+        v = _mm_or_si128(_mm_and_si128(_mm_slli_epi16(v, 4), hi_mask), _mm_and_si128(_mm_srli_epi16(v, 4), lo_mask));
+        _mm_storeu_si128((__m128i*)&adrs[i], v);
+    }
+#endif
+
+    for (; i < num; i++) {
+        adrs[i] = REVERT_U8(adrs[i]);
+    }
+}
+
+void ppgChangeDataEndian(u8* adrs, s32 size, s32 dendL, s32 col4, s32 depth, s32 excdot) {
     if (depth == 1) {
         return;
     }
@@ -685,17 +744,9 @@ void ppgChangeDataEndian(u8* adrs, s32 size, s32 dendL, s32 col4, s32 depth, s32
     if (depth != 0) {
         if (dendL == 0) {
             if (col4 != 0) {
-                c4 = (u32*)adrs;
-
-                for (i = 0; i < size / 4; i++) {
-                    c4[i] = REVERT_U32(c4[i]);
-                }
+                ppgRevertU32((u32*)adrs, size / 4);
             } else {
-                c2 = (u16*)adrs;
-
-                for (i = 0; i < size / 2; i++) {
-                    c2[i] = REVERT_U16(c2[i]);
-                }
+                ppgRevertU16((u16*)adrs, size / 2);
             }
         }
 
@@ -703,9 +754,7 @@ void ppgChangeDataEndian(u8* adrs, s32 size, s32 dendL, s32 col4, s32 depth, s32
     }
 
     if (excdot != 0) {
-        for (i = 0; i < size; i++) {
-            adrs[i] = REVERT_U8(adrs[i]);
-        }
+        ppgRevertU8(adrs, size);
     }
 }
 
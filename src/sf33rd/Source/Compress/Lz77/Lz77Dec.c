@@ -1,6 +1,41 @@
 #include "sf33rd/Source/Compress/Lz77/Lz77Dec.h"
 #include "common.h"
 
+#include <string.h>
+
+/// @brief Copy `num` bytes forward, one at a time as far as the result is concerned.
+static void copy_forward(u8* dst, const u8* src, s32 num) {
+    s32 j;
+
+    if ((dst + num <= src) || (src + num <= dst)) {
+        memcpy(dst, src, num);
+        return;
+    }
+
+    for (j = 0; j < num; j++) {
+        *dst++ = *src++;
+    }
+}
+
+/// @brief Copy `num` bytes from `offset` bytes back in the output. When the two overlap, the `offset` bytes before
+/// `dst` are repeated.
+static void copy_match(u8* dst, s32 offset, s32 num) {
+    s32 chunk;
+
+    if (offset == 1) {
+        memset(dst, dst[-1], num);
+        return;
+    }
+
+    // Each chunk reads only bytes that are already written
+    while (num > 0) {
+        chunk = (num < offset) ? num : offset;
+        memcpy(dst, dst - offset, chunk);
+        dst += chunk;
+        num -= chunk;
+    }
+}
+
 s32 decLZ77withSizeCheck(u8* src, u8* dst, s32 size) {
     s32 j;
     s32 loop;
@@ -42,9 +77,8 @@ s32 decLZ77withSizeCheck(u8* src, u8* dst, s32 size) {
                         dic++;
                     }
                 } else {
-                    for (j = 0; j < loop; j++) {
-                        *dst++ = *dic++;
-                    }
+                    copy_match(dst, offset, loop);
+                    dst += loop;
                 }
 
                 size -= loop;
@@ -57,9 +91,9 @@ s32 decLZ77withSizeCheck(u8* src, u8* dst, s32 size) {
                         loop = 0x100;
                     }
 
-                    for (j = 0; j < loop; j++) {
-                        *dst++ = *src++;
-                    }
+                    copy_forward(dst, src, loop);
+                    dst += loop;
+                    src += loop;
 
                     size -= loop;
                     break;
@@ -72,9 +106,9 @@ s32 decLZ77withSizeCheck(u8* src, u8* dst, s32 size) {
                         loop = 0x10000;
                     }
 
-                    for (j = 0; j < loop; j++) {
-                        *dst++ = *src++;
-                    }
+                    copy_forward(dst, src, loop);
+                    dst += loop;
+                    src += loop;
 
                     size -= loop;
                     break;
@@ -87,9 +121,8 @@ s32 decLZ77withSizeCheck(u8* src, u8* dst, s32 size) {
                         loop = 0x100;
                     }
 
-                    for (j = 0; j < loop; j++) {
-                        *dst++ = num;
-                    }
+                    memset(dst, num, loop);
+                    dst += loop;
 
                     size -= loop;
                     break;
@@ -103,9 +136,8 @@ s32 decLZ77withSizeCheck(u8* src, u8* dst, s32 size) {
                         loop = 0x10000;
                     }
 
-                    for (j = 0; j < loop; j++) {
-                        *dst++ = num;
-                    }
+                    memset(dst, num, loop);
+                    dst += loop;
 
                     size -= loop;
                     break;
@@ -160,11 +192,8 @@ s32 decLZ77withSizeCheck(u8* src, u8* dst, s32 size) {
                 offset = 0x800;
             }
 
-            dic = dst - offset;
-
-            for (j = 0; j < loop; j++) {
-                *dst++ = *dic++;
-            }
+            copy_match(dst, offset, loop);
+            dst += loop;
 
             size -= loop;
         }
@@ -1,3 +1,4 @@
+#include "sf33rd/Source/Compress/zlibApp.h"
 #include "common.h"
 #include "sf33rd/Source/Common/MemMan.h"
 #include "structs.h"
@@ -12,6 +13,10 @@ typedef struct {
     struct z_stream_s info;
     s32 state;
     _MEMMAN_OBJ mobj;
+
+    /// Whether `info` holds an inflate context. It is kept from one call to the next and reset before each stream,
+    /// so its window is only allocated once.
+    bool ready;
 } ZLIB;
 
 ZLIB zlib;
@@ -29,6 +34,7 @@ void zlib_Initialize(void* tempAdrs, s32 tempSize) {
     zlib.info.zalloc = zlib_Malloc;
     zlib.info.zfree = zlib_Free;
     zlib.info.opaque = NULL;
+    zlib.ready = false;
 }
 
 void* zlib_Malloc(void* opaque, u32 items, u32 size) {
@@ -40,15 +46,27 @@ void zlib_Free(void* opaque, void* adrs) {
 }
 
 ssize_t zlib_Decompress(void* srcBuff, s32 srcSize, void* dstBuff, s32 dstSize) {
+    zlib.state = 0;
+
+    if (zlib.ready) {
+        if (inflateReset(&zlib.info) != 0) {
+            return 0;
+        }
+    } else {
+        zlib.info.next_in = NULL;
+        zlib.info.avail_in = 0;
+
+        if (inflateInit_(&zlib.info, ZLIB_VERSION, sizeof(z_stream)) != 0) {
+            return 0;
+        }
+
+        zlib.ready = true;
+    }
+
     zlib.info.next_in = srcBuff;
     zlib.info.avail_in = srcSize;
     zlib.info.next_out = dstBuff;
     zlib.info.avail_out = dstSize;
-    zlib.state = 0;
-
-    if (inflateInit_(&zlib.info, ZLIB_VERSION, sizeof(z_stream)) != 0) {
-        return 0;
-    }
 
     while (1) {
         zlib.state = inflate(&zlib.info, 0);
@@ -64,9 +82,5 @@ ssize_t zlib_Decompress(void* srcBuff, s32 srcSize, void* dstBuff, s32 dstSize)
         }
     }
 
-    if (inflateEnd(&zlib.info) != 0) {
-        return 0;
-    }
-
     return zlib.info.total_out;
 }
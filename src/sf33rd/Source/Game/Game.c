@@ -116,7 +116,7 @@ void Game_Task(struct _TASK* task_ptr) {
 
     for (ix = 0; ix < ff; ix++) {
         if (ix == ff - 1) {
-            No_Trans = 0;
+            No_Trans = Force_No_Trans;
 
             if (Turbo != 0 && (Process_Counter > 1) && (Turbo_Timer != 5)) {
                 Play_Game = 0;
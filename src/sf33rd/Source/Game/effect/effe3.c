@@ -6,6 +6,7 @@
 #include "sf33rd/Source/Game/effect/effe3.h"
 #include "common.h"
 #include "sf33rd/Source/Game/effect/effect.h"
+#include "sf33rd/Source/Game/engine/cmd_main.h"
 #include "sf33rd/Source/Game/engine/plcnt.h"
 #include "sf33rd/Source/Game/engine/plmain.h"
 #include "sf33rd/Source/Game/engine/spgauge.h"
@@ -145,7 +146,7 @@ void effect_E3_move(WORK_Other* ewk) {
         }
 
         if (ewk->wu.direction == 0) {
-            mwk->cp->waza_flag[7] = 2;
+            waza_flag_set(mwk->wu.id, 7, 2);
 
             switch (Training[0].contents[0][0][2]) {
             case 0:
@@ -15,6 +15,11 @@
 
 #include <SDL3/SDL.h>
 
+// Effects live in the slots of frw. Every slot starts with a WORK, and the effect code casts it to its own struct.
+// Free slots are kept as a stack in frwque, with frwctr entries. Slots in use are in one of 8 lists, linked through
+// WORK.before and WORK.behind, and each list is updated in order by move_effect_work. Free slots are never visited.
+// frw_live has a bit for each slot in use, so that they can also be found in slot order without walking the lists.
+
 s16 frwctr;
 s16 frwctr_min;
 s16 head_ix[8];
@@ -22,6 +27,7 @@ s16 tail_ix[8];
 s16 exec_tm[8];
 uintptr_t frw[EFFECT_MAX][448];
 s16 frwque[EFFECT_MAX];
+u64 frw_live[EFFECT_MAX / 64];
 
 void move_effect_work(s16 index) {
     WORK* c_addr;
@@ -84,6 +90,7 @@ void effect_work_init() {
     s16 i;
 
     SDL_zeroa(frw);
+    SDL_zeroa(frw_live);
 
     for (i = 0; i < EFFECT_MAX; i++) {
         frwctr = (EFFECT_MAX - 1) - i;
@@ -163,6 +170,7 @@ s16 pull_effect_work(s16 index) {
 
     tadr->timing = exec_tm[index];
     tadr->listix = index;
+    frw_live[qix / 64] |= 1ULL << (qix % 64);
 
     if (frwctr_min > frwctr) {
         frwctr_min = frwctr;
@@ -171,6 +179,33 @@ s16 pull_effect_work(s16 index) {
     return qix;
 }
 
+/// @brief Finds the next slot of `frw` that is in use, in the order of the slots rather than of the lists.
+/// @param ix Slot to start from.
+/// @return Index of the first slot from `ix` on that is in use, or `-1` if there is none.
+s16 next_effect_work(s16 ix) {
+    s16 word = ix / 64;
+    u64 bits;
+
+    if (ix >= EFFECT_MAX) {
+        return -1;
+    }
+
+    bits = frw_live[word] & (~0ULL << (ix % 64));
+
+    while (bits == 0) {
+        if (++word == (EFFECT_MAX / 64)) {
+            return -1;
+        }
+
+        bits = frw_live[word];
+    }
+
+    // Index of the lowest set bit
+    bits &= ~bits + 1;
+    return (word * 64) + (((u32)bits != 0) ? SDL_MostSignificantBitIndex32((u32)bits)
+                                           : (SDL_MostSignificantBitIndex32((u32)(bits >> 32)) + 32));
+}
+
 /// @brief Searches for an effect.
 /// @param index Index of the list to perform search in.
 /// @param flag Set to `true` to search from the tail, `false` to search from the head.
@@ -251,6 +286,7 @@ void push_effect_work(WORK* wkhd) {
     }
 
     SDL_zeroa(frw[qix]);
+    frw_live[qix / 64] &= ~(1ULL << (qix % 64));
 
     c_addr->before = c_addr->behind = -1;
     frwque[frwctr++] = qix;
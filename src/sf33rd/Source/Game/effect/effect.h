@@ -13,6 +13,7 @@ extern s16 tail_ix[8];
 extern s16 frwctr_min;
 extern s16 frwctr;
 extern s16 frwque[EFFECT_MAX];
+extern u64 frw_live[EFFECT_MAX / 64];
 
 void move_effect_work(s16 index);
 void disp_effect_work();
@@ -21,6 +22,7 @@ void effect_work_quick_init();
 void effect_work_kill_mod_plcol();
 void push_effect_work(WORK* wkhd);
 s16 pull_effect_work(s16 index);
+s16 next_effect_work(s16 ix);
 void effect_work_list_init(s16 lix, s16 iid);
 s16 search_effect_index(s16 index, s16 flag, s16 tid);
 void effect_work_kill(s16 index, s16 kill_id);
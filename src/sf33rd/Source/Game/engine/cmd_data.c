@@ -12,6 +12,7 @@
 WORK_CP wcp[2];
 T_PL_LVR t_pl_lvr[2];
 WAZA_WORK waza_work[2][56];
+u8 waza_live[2][56];
 
 // sbss
 
@@ -20,6 +21,7 @@ s16* cmd_tbl_ptr;
 u16 sw_work;
 T_PL_LVR* chk_pl;
 s16 waza_type[2];
+s16 waza_live_num[2];
 WAZA_WORK* waza_ptr;
 PLW* cmd_pl;
 
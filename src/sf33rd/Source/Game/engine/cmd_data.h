@@ -10,6 +10,10 @@ extern WORK_CP wcp[2];
 extern T_PL_LVR t_pl_lvr[2];
 extern WAZA_WORK waza_work[2][56];
 
+/// Numbers of the moves of each player whose `waza_flag` isn't `-1`, in ascending order
+extern u8 waza_live[2][56];
+extern s16 waza_live_num[2];
+
 extern s16 cmd_id;
 extern s16* cmd_tbl_ptr;
 extern u16 sw_work;
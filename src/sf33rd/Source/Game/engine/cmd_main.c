@@ -95,10 +95,19 @@ void cmd_init(PLW* pl) {
 }
 
 void cmd_move() {
+    WORK_CP* cp;
+    WAZA_WORK* work;
+    const u8* live;
+    s16 live_num;
+    s16 i;
     s16 j;
     intptr_t* adrs;
 
     cmd_id = cmd_pl->wu.id;
+    cp = &wcp[cmd_id];
+    work = waza_work[cmd_id];
+    live = waza_live[cmd_id];
+    live_num = waza_live_num[cmd_id];
 
     if (cmd_sel[cmd_id]) {
         adrs = pl_CMD[cmd_pl->player_number];
@@ -106,18 +115,24 @@ void cmd_move() {
         adrs = pl_cmd[cmd_pl->player_number];
     }
 
-    for (j = 0; j < 56; j++) {
-        if (wcp[cmd_id].waza_flag[j] != -1) {
-            waza_type[cmd_id] = j;
-            cmd_tbl_ptr = (s16*)adrs[j];
-            waza_ptr = &waza_work[cmd_id][j];
+    // Only the moves listed by make_waza_live can be checked. check_20 does nothing, so moves that wait on it are
+    // only pointed at, which leaves the same globals behind.
+    for (i = 0; i < live_num; i++) {
+        j = live[i];
+        waza_type[cmd_id] = j;
+        cmd_tbl_ptr = (s16*)adrs[j];
+        waza_ptr = &work[j];
+
+        if (waza_ptr->w_type != 21) {
             chk_move_jp[waza_ptr->w_type]();
         }
     }
 
-    for (j = 0; j < 56; j++) {
-        if ((wcp[cmd_id].waza_flag[j] != -1) && (wcp[cmd_id].waza_flag[j] != 0)) {
-            waza_ptr = &waza_work[cmd_id][j];
+    for (i = 0; i < live_num; i++) {
+        j = live[i];
+
+        if (cp->waza_flag[j] != 0) {
+            waza_ptr = &work[j];
             command_ok_move(j);
         }
     }
@@ -1778,9 +1793,27 @@ void waza_flag_clear_only_1(s16 pl_id, s16 wznum) {
     waza_compel_init(pl_id, wznum, adrs);
 }
 
+/// @brief List the moves of a player that `cmd_move` checks.
+///
+/// Only `waza_compel_all_init` and `waza_flag_set` give a move a `waza_flag` of `-1`. Whatever else sets one that may
+/// be `-1` goes through `waza_compel_init` or `waza_flag_set`, which list the move again. The checks never set it to `-1`, since
+/// none of the `reset` values are, and the parry checks only write to the first 16 moves, which every character has.
+static void make_waza_live(s16 pl_id) {
+    s16 i;
+
+    waza_live_num[pl_id] = 0;
+
+    for (i = 0; i < 56; i++) {
+        if (wcp[pl_id].waza_flag[i] != -1) {
+            waza_live[pl_id][waza_live_num[pl_id]++] = i;
+        }
+    }
+}
+
 void waza_compel_init(s16 pl_id, s16 num, intptr_t* adrs) {
     WAZA_WORK* w_ptr;
     s16* ptr;
+    s16 was_dead = wcp[pl_id].waza_flag[num] == -1;
 
     ptr = (s16*)adrs[num];
     ptr += 12;
@@ -1797,6 +1830,20 @@ void waza_compel_init(s16 pl_id, s16 num, intptr_t* adrs) {
     w_ptr->shot_ok = 0;
     w_ptr->free3 = 0;
     wcp[pl_id].waza_flag[num] = 0;
+
+    if (was_dead) {
+        make_waza_live(pl_id);
+    }
+}
+
+void waza_flag_set(s16 pl_id, s16 wznum, s16 flag) {
+    s16 was_dead = wcp[pl_id].waza_flag[wznum] == -1;
+
+    wcp[pl_id].waza_flag[wznum] = flag;
+
+    if (was_dead != (flag == -1)) {
+        make_waza_live(pl_id);
+    }
 }
 
 void waza_compel_all_init(PLW* pl) {
@@ -1871,6 +1918,8 @@ void waza_compel_all_init(PLW* pl) {
     for (i = pl_cmd_num[pl->player_number][6]; i < 56; i++) {
         wcp[cmd_id].waza_flag[i] = -1;
     }
+
+    make_waza_live(cmd_id);
 }
 
 void waza_compel_all_init2(PLW* pl) {
@@ -46,6 +46,10 @@ void dash_flag_clear(s16 pl_id);
 void hi_jump_flag_clear(s16 pl_id);
 void waza_flag_clear_only_1(s16 pl_id, s16 wznum);
 void waza_compel_init(s16 pl_id, s16 num, intptr_t* adrs);
+
+/// @brief Set the `waza_flag` of move `wznum`, and list it for `cmd_move` again if it was `-1`.
+void waza_flag_set(s16 pl_id, s16 wznum, s16 flag);
+
 void waza_compel_all_init(PLW* pl);
 void waza_compel_all_init2(PLW* pl);
 u16 processed_lvbt(u16 lv_data);
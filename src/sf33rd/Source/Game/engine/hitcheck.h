@@ -29,6 +29,8 @@ extern const u8 dm_oiuchi_catch[32];
 extern HS hs[32];
 
 extern WORK* q_hit_push[32];
+extern s16 mkm_wk[32];
+extern s16 hpq_in;
 extern s8 ca_check_flag;
 
 void make_red_blocking_time(s16 id, s16 ix, s16 num);
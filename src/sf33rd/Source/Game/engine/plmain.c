@@ -410,27 +410,27 @@ void look_after_timers(PLW* wk) {
 
     if (Debug_w[9]) {
         if (wk->sa->nmsa_g_ix != 0) {
-            wk->cp->waza_flag[wk->sa->nmsa_g_ix] = 9;
+            waza_flag_set(wk->wu.id, wk->sa->nmsa_g_ix, 9);
         }
 
         if (wk->sa->exsa_g_ix != 0) {
-            wk->cp->waza_flag[wk->sa->exsa_g_ix] = 9;
+            waza_flag_set(wk->wu.id, wk->sa->exsa_g_ix, 9);
         }
 
         if (wk->sa->exs2_g_ix != 0) {
-            wk->cp->waza_flag[wk->sa->exs2_g_ix] = 9;
+            waza_flag_set(wk->wu.id, wk->sa->exs2_g_ix, 9);
         }
 
         if (wk->sa->nmsa_a_ix != 0) {
-            wk->cp->waza_flag[wk->sa->nmsa_a_ix] = 9;
+            waza_flag_set(wk->wu.id, wk->sa->nmsa_a_ix, 9);
         }
 
         if (wk->sa->exsa_a_ix != 0) {
-            wk->cp->waza_flag[wk->sa->exsa_a_ix] = 9;
+            waza_flag_set(wk->wu.id, wk->sa->exsa_a_ix, 9);
         }
 
         if (wk->sa->exs2_a_ix != 0) {
-            wk->cp->waza_flag[wk->sa->exs2_a_ix] = 9;
+            waza_flag_set(wk->wu.id, wk->sa->exs2_a_ix, 9);
         }
     }
 }
@@ -27,6 +27,14 @@ typedef struct {
 
 typedef void (*LDREQ_Process_Func)(REQ*);
 
+// Frames a select cursor has to rest on a choice before its files are read ahead
+#define PREFETCH_DWELL 8
+
+typedef struct {
+    s16 ix;
+    s16 timer;
+} PREFETCH_HINT;
+
 const u8 lpr_wrdata[3] = { 0x03, 0xC0, 0x3C };
 const u8 lpc_seldat[2] = { 10, 11 };
 const u8 lpt_seldat[4] = { 3, 4, 5, 0 };
@@ -38,6 +46,9 @@ u8 ldreq_result[294];
 
 static AFSHandle afs_handle = AFS_NONE;
 
+// Player 1 cursor, player 2 cursor, CPU opponent and its stage
+static PREFETCH_HINT prefetch_hint[4] = { { -1, 0 }, { -1, 0 }, { -1, 0 }, { -1, 0 } };
+
 // forward decls
 s32 Push_LDREQ_Queue(REQ* ldreq);
 void Push_LDREQ_Queue_Metamor();
@@ -45,6 +56,9 @@ void q_ldreq_error(REQ* curr);
 void disp_ldreq_status();
 void Push_LDREQ_Queue_Union(s16 ix);
 s32 Check_LDREQ_Queue_Union(s16 ix);
+void Prefetch_LDREQ_Union(s16 slot, s16 ix);
+void Consume_LDREQ_Prefetch(s16 ix);
+s32 ldreq_file_number(const LDREQ_TBL* tbl);
 
 const LDREQ_Process_Func ldreq_process[6];
 s8* ldreq_process_name[];
@@ -243,6 +257,7 @@ void Push_LDREQ_Queue_Player(s16 id, s16 ix) {
     kara = ldreq_ix[ix][0];
     made = kara + ldreq_ix[ix][1];
     plt_req[id] = ix;
+    Consume_LDREQ_Prefetch(ix);
 
     for (i = kara; i < made; i++) {
         ldreq.type = ldreq_tbl[i].type;
@@ -276,6 +291,7 @@ void Push_LDREQ_Queue_Union(s16 ix) {
 
     kara = ldreq_ix[ix][0];
     made = kara + ldreq_ix[ix][1];
+    Consume_LDREQ_Prefetch(ix);
 
     for (i = kara; i < made; i++) {
         ldreq.type = ldreq_tbl[i].type;
@@ -319,6 +335,77 @@ void Push_LDREQ_Queue_Direct(s16 ix, s16 id) {
     Push_LDREQ_Queue(&ldreq);
 }
 
+s32 ldreq_file_number(const LDREQ_TBL* tbl) {
+    u16 fnum;
+
+    switch (tbl->type) {
+    case 1:
+        return texgrpdat[tbl->ix].apfn;
+
+    case 2:
+    case 3:
+    case 4:
+    case 5:
+        fnum = get_color_file_number(tbl->ix);
+        return (fnum == 0xFFFF) ? -1 : fnum;
+
+    default:
+        return -1;
+    }
+}
+
+void Prefetch_LDREQ_Player(s16 id, s16 ix) {
+    Prefetch_LDREQ_Union(id, ix);
+}
+
+void Prefetch_LDREQ_BG(s16 ix) {
+    Prefetch_LDREQ_Union(3, ix + 20);
+}
+
+void Prefetch_LDREQ_Union(s16 slot, s16 ix) {
+    PREFETCH_HINT* hint = &prefetch_hint[slot];
+    s16 i;
+    s16 kara;
+    s16 made;
+
+    if (ix < 0 || ix >= (s16)(sizeof(ldreq_ix) / sizeof(ldreq_ix[0]))) {
+        ix = -1;
+    }
+
+    if (hint->ix != ix) {
+        AFS_CancelPrefetch(slot);
+        hint->ix = ix;
+        hint->timer = 0;
+    }
+
+    if (ix < 0 || hint->timer > PREFETCH_DWELL) {
+        return;
+    }
+
+    if (++hint->timer <= PREFETCH_DWELL) {
+        return;
+    }
+
+    kara = ldreq_ix[ix][0];
+    made = kara + ldreq_ix[ix][1];
+
+    for (i = kara; i < made; i++) {
+        AFS_Prefetch(ldreq_file_number(&ldreq_tbl[i]), slot);
+    }
+}
+
+void Consume_LDREQ_Prefetch(s16 ix) {
+    s16 i;
+
+    // The files stay staged for the load that was just queued, the hint is only forgotten
+    for (i = 0; i < 4; i++) {
+        if (prefetch_hint[i].ix == ix) {
+            prefetch_hint[i].ix = -1;
+            prefetch_hint[i].timer = 0;
+        }
+    }
+}
+
 s32 Push_LDREQ_Queue(REQ* ldreq) {
     s16 i;
     u8 masknum;
@@ -387,6 +474,7 @@ void Check_LDREQ_Queue() {
 }
 
 void disp_ldreq_status() {
+    AFSPrefetchStats stats;
     s16 i;
 
     flPrintColor(0xFFFFFF8F);
@@ -398,6 +486,9 @@ void disp_ldreq_status() {
         }
 
         flPrintL(2, i + 18, "%4d", system_timer);
+
+        AFS_GetPrefetchStats(&stats);
+        flPrintL(2, i + 19, "PF %d/%d/%d", stats.hits, stats.partial_hits, stats.misses);
     }
 }
 
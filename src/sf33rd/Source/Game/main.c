@@ -23,7 +23,12 @@
 #include "sf33rd/Source/Game/rendering/texcash.h"
 #include "sf33rd/Source/Game/sound/sound3rd.h"
 #include "sf33rd/Source/Game/stage/bg.h"
+#include "sf33rd/Source/Game/system/cpu_farm.h"
 #include "sf33rd/Source/Game/system/ramcnt.h"
+#include "sf33rd/Source/Game/system/replay_batch.h"
+#include "sf33rd/Source/Game/system/replay_stream.h"
+#include "sf33rd/Source/Game/system/state_dump.h"
+#include "sf33rd/Source/Game/system/state_hash.h"
 #include "sf33rd/Source/Game/system/sys_sub.h"
 #include "sf33rd/Source/Game/system/sys_sub2.h"
 #include "sf33rd/Source/Game/system/work_sys.h"
@@ -37,6 +42,7 @@
 #endif
 
 #include "port/io/afs.h"
+#include "port/options.h"
 #include "port/resources.h"
 
 #include <SDL3/SDL.h>
@@ -58,12 +64,16 @@ MPP mpp_w;
 static bool is_game_initialized = false;
 static bool are_resources_checked = false;
 static bool is_running_resource_flow = false;
+static u16 headless_sw[2];
 
 // forward decls
 static void game_init();
 static void game_step_0();
 static void game_step_1();
+
+#if !defined(AGENT_LIBRARY)
 static void init_windows_console();
+#endif
 
 void distributeScratchPadAddress();
 void appCopyKeyData();
@@ -90,7 +100,7 @@ static bool run_resource_flow() {
         is_running_resource_flow = true;
     }
 
-    are_resources_checked = Resources_RunResourceCopyingFlow();
+    are_resources_checked = Resources_RunResourceLocatingFlow();
 
     if (are_resources_checked) {
         // Cleanup
@@ -101,9 +111,33 @@ static bool run_resource_flow() {
 }
 
 static void afs_init() {
-    char* file_path = Resources_GetPath("SF33RD.AFS");
-    AFS_Init(file_path);
+    char* file_path = Resources_GetAFSPath();
+    char* index_path = Resources_GetPath("SF33RD.idx");
+    AFS_Init(file_path, index_path);
+    AFS_SetFrameLocked(options.frame_locked_audio);
+    AFS_SetPrefetchBudget((size_t)options.prefetch_cache_mb * 1024 * 1024);
     SDL_free(file_path);
+    SDL_free(index_path);
+}
+
+static void afs_finish() {
+    AFSPrefetchStats stats;
+    unsigned int reads;
+
+    AFS_GetPrefetchStats(&stats);
+    reads = stats.hits + stats.partial_hits + stats.misses;
+
+    if (reads > 0) {
+        SDL_Log("AFS prefetch: %u of %u reads served (%u in full), %u cancelled, %zu KB read ahead, %zu KB unused",
+                stats.hits + stats.partial_hits,
+                reads,
+                stats.hits,
+                stats.cancelled,
+                stats.read_bytes / 1024,
+                stats.wasted_bytes / 1024);
+    }
+
+    AFS_Finish();
 }
 
 static void step_0() {
@@ -131,10 +165,102 @@ static void step_1() {
     game_step_1();
 }
 
-int main() {
+/// @brief Runs the frames that a replay seek skips over without presenting them.
+static void run_hidden_frames() {
+    while (is_game_initialized && Is_Replay_Seeking()) {
+        step_0();
+        SDLApp_SkipFrame();
+        step_1();
+    }
+}
+
+bool Headless_Init() {
+    // Headless runs are often several processes side by side, so nothing may write to files they would share
+    options.headless = true;
+    options.frame_locked_audio = true;
+    options.audio_dump_path = NULL;
+    options.record_replay_dir = NULL;
+    options.state_hash_log_path = NULL;
+    options.state_dump_path = NULL;
+
+    // Skip building sprites, effects and shadows unless the software renderer draws them
+    Force_No_Trans = !options.software_render;
+
+    // Only frames drawn by the software renderer can be captured
+    if (!options.software_render) {
+        options.capture_path = NULL;
+    }
+
+    if (SDLApp_Init() != 0) {
+        return false;
+    }
+
+    // There is no window to run the resource locating flow in
+    if (!Resources_CheckIfPresent()) {
+        SDL_Log("Headless runs need the game resources, start the game normally once to set them up");
+        SDLApp_Quit();
+        return false;
+    }
+
+    are_resources_checked = true;
+    return true;
+}
+
+void Headless_SetInputs(u16 p1_sw, u16 p2_sw) {
+    headless_sw[0] = p1_sw;
+    headless_sw[1] = p2_sw;
+}
+
+void Headless_Frame(bool with_audio) {
+    SDLApp_BeginHeadlessFrame();
+    step_0();
+    SDLApp_EndHeadlessFrame(with_audio);
+    step_1();
+}
+
+void Headless_Quit() {
+    if (is_game_initialized) {
+        afs_finish();
+    }
+
+    SDLApp_Quit();
+}
+
+#if !defined(AGENT_LIBRARY)
+
+/// @brief Runs a headless mode, such as `--batch`, and exits.
+static int run_headless(s32 (*run)()) {
+    int result;
+
+    // The replays and matches run in forked processes, which would all write to the same file
+    options.capture_path = NULL;
+
+    if (!Headless_Init()) {
+        return 1;
+    }
+
+    result = run();
+    Headless_Quit();
+    return result;
+}
+
+int main(int argc, char* argv[]) {
     bool is_running = true;
 
     init_windows_console();
+
+    if (!Options_Parse(argc, argv)) {
+        return 1;
+    }
+
+    if (options.batch_list_path != NULL) {
+        return run_headless(Run_Replay_Batch);
+    }
+
+    if (options.cpu_farm_path != NULL) {
+        return run_headless(Run_CPU_Farm);
+    }
+
     SDLApp_Init();
 
     while (is_running) {
@@ -143,9 +269,13 @@ int main() {
         step_0();
         SDLApp_EndFrame();
         step_1();
+        run_hidden_frames();
     }
 
-    AFS_Finish();
+    Close_Replay_Stream();
+    Close_State_Hash_Log();
+    Close_Sim_State_Dump();
+    afs_finish();
     SDLApp_Quit();
     return 0;
 }
@@ -163,6 +293,8 @@ static void init_windows_console() {
 #endif
 }
 
+#endif
+
 static void game_init() {
 #if defined(DEBUG)
     DebugConfig_Init();
@@ -193,6 +325,12 @@ static void game_step_0() {
     flPADGetALL();
     keyConvert();
 
+    if (options.headless) {
+        // There are no pads, the inputs come from the caller
+        p1sw_buff = headless_sw[0];
+        p2sw_buff = headless_sw[1];
+    }
+
     if (((Usage == 7) || (Usage == 2)) && !test_flag) {
         if (mpp_w.sysStop) {
             sysSLOW = 1;
@@ -266,7 +404,14 @@ static void game_step_0() {
 
     njUserMain();
     seqsBeforeProcess();
-    njdp2d_draw();
+
+    if (No_Trans) {
+        // Nothing is drawn on this frame, so drop the polygons that were queued
+        njdp2d_init();
+    } else {
+        njdp2d_draw();
+    }
+
     seqsAfterProcess();
     KnjFlush();
     disp_effect_work();
@@ -386,6 +531,7 @@ s32 njUserMain() {
     CPU_Rec[0] = 0;
     CPU_Rec[1] = 0;
 
+    Replay_Stream_Frame();
     Check_Replay_Status(0, Replay_Status[0]);
     Check_Replay_Status(1, Replay_Status[1]);
 
@@ -418,6 +564,9 @@ s32 njUserMain() {
                 }
             }
         }
+
+        Log_State_Hash();
+        Dump_Sim_State();
     } else {
         sys_w.disp.now = sys_w.disp.new;
     }
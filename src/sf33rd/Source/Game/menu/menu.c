@@ -58,6 +58,7 @@
 #include "sf33rd/Source/Game/stage/bg_sub.h"
 #include "sf33rd/Source/Game/system/pause.h"
 #include "sf33rd/Source/Game/system/ramcnt.h"
+#include "sf33rd/Source/Game/system/replay_stream.h"
 #include "sf33rd/Source/Game/system/reset.h"
 #include "sf33rd/Source/Game/system/saver.h"
 #include "sf33rd/Source/Game/system/sys_sub.h"
@@ -1415,10 +1416,24 @@ void Load_Replay(struct _TASK* task_ptr) {
         break;
 
     case 1:
-        if (Menu_Sub_case1(task_ptr) != 0) {
-            SaveInit(2, 0);
+        if (Menu_Sub_case1(task_ptr) == 0) {
+            break;
+        }
+
+        if (Load_Replay_Stream()) {
+            // Skip the memory card screens and start the replay file right away
+            Decide_ID = 0;
+
+            if (Interface_Type[0] == 0) {
+                Decide_ID = 1;
+            }
+
+            task_ptr->r_no[2] = 4;
+            task_ptr->r_no[3] = 0;
+            break;
         }
 
+        SaveInit(2, 0);
         break;
 
     case 2:
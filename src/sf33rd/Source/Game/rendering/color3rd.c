@@ -176,6 +176,10 @@ void load_any_color(u16 ix, u8 kokey) {
     }
 }
 
+u16 get_color_file_number(u16 ix) {
+    return color_file[ix].apfn;
+}
+
 void set_hitmark_color() {
     s16 i;
 
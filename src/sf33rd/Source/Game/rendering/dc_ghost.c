@@ -13,8 +13,15 @@
 #include "sf33rd/Source/PS2/ps2Quad.h"
 #include "structs.h"
 
+#include <SDL3/SDL.h>
+
 #include <string.h>
 
+#if defined(__SSE2__) || defined(_M_X64)
+#include <emmintrin.h>
+#define CALC_POINTS_SSE2
+#endif
+
 #define NTH_BYTE(value, n) ((((value >> n * 8) & 0xFF) << n * 8))
 
 typedef struct {
@@ -22,21 +29,27 @@ typedef struct {
     u32 col;
 } _Polygon;
 
+// Size of the request buffer in the original game
+#define NJDP2D_PRIM_BASE 100
+
 // `col` needs to be `uintptr_t` because it sometimes stores a pointer to `WORK`
 typedef struct {
     Vec3 v[4];
     uintptr_t col;
     u32 type;
-    s32 next;
 } NJDP2D_PRIM;
 
 typedef struct {
-    s16 ix1st;
-    s16 total;
-    NJDP2D_PRIM prim[100];
+    s32 total;
+    s32 capacity;
+    NJDP2D_PRIM* prim;
+
+    /// Draw order, then scratch space for sorting it. `capacity * 2` entries
+    s32* order;
 } NJDP2D_W;
 
 NJDP2D_W njdp2d_w;
+s32 njdp2d_overflow_count;
 MTX cmtx;
 
 static void matmul(MTX* dst, const MTX* a, const MTX* b) {
@@ -134,9 +147,30 @@ void njCalcPoints(MTX* mtx, Vec3* ps, Vec3* pd, s32 num) {
         mtx = &cmtx;
     }
 
+#if defined(CALC_POINTS_SSE2)
+    // Each lane does the same multiplies and adds as njCalcPoint, in the same order, so the results are identical
+    const __m128 row0 = _mm_loadu_ps(mtx->a[0]);
+    const __m128 row1 = _mm_loadu_ps(mtx->a[1]);
+    const __m128 row2 = _mm_loadu_ps(mtx->a[2]);
+    const __m128 row3 = _mm_loadu_ps(mtx->a[3]);
+    f32 out[4];
+
+    for (i = 0; i < num; i++, ps++, pd++) {
+        __m128 sum = _mm_mul_ps(_mm_set1_ps(ps->x), row0);
+
+        sum = _mm_add_ps(sum, _mm_mul_ps(_mm_set1_ps(ps->y), row1));
+        sum = _mm_add_ps(sum, _mm_mul_ps(_mm_set1_ps(ps->z), row2));
+        sum = _mm_add_ps(sum, row3);
+        _mm_storeu_ps(out, sum);
+        pd->x = out[0];
+        pd->y = out[1];
+        pd->z = out[2];
+    }
+#else
     for (i = 0; i < num; i++) {
         njCalcPoint(mtx, ps++, pd++);
     }
+#endif
 }
 
 void njDrawTexture(Polygon* polygon, s32 /* unused */, s32 tex, s32 /* unused */) {
@@ -164,27 +198,77 @@ void njDrawSprite(Polygon* polygon, s32 /* unused */, s32 tex, s32 /* unused */)
 }
 
 void njdp2d_init() {
-    njdp2d_w.ix1st = -1;
     njdp2d_w.total = 0;
 }
 
+/// @brief Sort the requests by priority, highest first. Requests with the same priority keep the order they were
+/// made in, as when the original game inserted each of them into a list.
+static void njdp2d_sort_order() {
+    s32* order = njdp2d_w.order;
+    s32* tmp = njdp2d_w.order + njdp2d_w.capacity;
+    s32* swap;
+    s32 width;
+    s32 lo;
+    s32 mid;
+    s32 hi;
+    s32 l;
+    s32 r;
+    s32 o;
+
+    for (o = 0; o < njdp2d_w.total; o++) {
+        order[o] = o;
+    }
+
+    for (width = 1; width < njdp2d_w.total; width *= 2) {
+        for (lo = 0; lo < njdp2d_w.total; lo += width * 2) {
+            mid = SDL_min(lo + width, njdp2d_w.total);
+            hi = SDL_min(lo + width * 2, njdp2d_w.total);
+            l = lo;
+            r = mid;
+
+            for (o = lo; o < hi; o++) {
+                // A later request only goes first if its priority is higher
+                if ((r < hi) &&
+                    ((l >= mid) || (njdp2d_w.prim[order[r]].v[0].z > njdp2d_w.prim[order[l]].v[0].z))) {
+                    tmp[o] = order[r++];
+                } else {
+                    tmp[o] = order[l++];
+                }
+            }
+        }
+
+        swap = order;
+        order = tmp;
+        tmp = swap;
+    }
+
+    if (order != njdp2d_w.order) {
+        SDL_memcpy(njdp2d_w.order, order, njdp2d_w.total * sizeof(s32));
+    }
+}
+
 void njdp2d_draw() {
+    NJDP2D_PRIM* prim;
     Quad prm;
     s32 i;
 
-    for (i = njdp2d_w.ix1st; i != -1; i = njdp2d_w.prim[i].next) {
-        switch (njdp2d_w.prim[i].type) {
+    njdp2d_sort_order();
+
+    for (i = 0; i < njdp2d_w.total; i++) {
+        prim = &njdp2d_w.prim[njdp2d_w.order[i]];
+
+        switch (prim->type) {
         case 0:
-            prm.v[0] = njdp2d_w.prim[i].v[0];
-            prm.v[1] = njdp2d_w.prim[i].v[1];
-            prm.v[2] = njdp2d_w.prim[i].v[2];
-            prm.v[3] = njdp2d_w.prim[i].v[3];
+            prm.v[0] = prim->v[0];
+            prm.v[1] = prim->v[1];
+            prm.v[2] = prim->v[2];
+            prm.v[3] = prim->v[3];
 
-            ps2SeqsRenderQuad_B(&prm, njdp2d_w.prim[i].col);
+            ps2SeqsRenderQuad_B(&prm, prim->col);
             break;
 
         case 1:
-            shadow_drawing((WORK*)njdp2d_w.prim[i].col, njdp2d_w.prim[i].v[0].y);
+            shadow_drawing((WORK*)prim->col, prim->v[0].y);
             break;
         }
     }
@@ -192,68 +276,65 @@ void njdp2d_draw() {
     njdp2d_init();
 }
 
+static bool njdp2d_grow() {
+    s32 capacity = SDL_max(njdp2d_w.capacity * 2, NJDP2D_PRIM_BASE);
+    NJDP2D_PRIM* prim;
+    s32* order;
+
+    prim = SDL_realloc(njdp2d_w.prim, capacity * sizeof(NJDP2D_PRIM));
+
+    if (prim == NULL) {
+        return false;
+    }
+
+    njdp2d_w.prim = prim;
+    order = SDL_realloc(njdp2d_w.order, capacity * 2 * sizeof(s32));
+
+    if (order == NULL) {
+        return false;
+    }
+
+    njdp2d_w.order = order;
+    njdp2d_w.capacity = capacity;
+    return true;
+}
+
 // `col` needs to be `uintptr_t` because it sometimes stores a pointer to `WORK`
 void njdp2d_sort(f32* pos, f32 pri, uintptr_t col, s32 flag) {
-    s32 i;
-    s32 ix = njdp2d_w.total;
-    s32 prev;
+    NJDP2D_PRIM* prim;
+
+    if (njdp2d_w.total == NJDP2D_PRIM_BASE) {
+        // The original buffer would have dropped this request
+        njdp2d_overflow_count += 1;
+    }
 
-    if (ix >= 100) {
+    if ((njdp2d_w.total >= njdp2d_w.capacity) && !njdp2d_grow()) {
         // The 2D polygon display request has exceeded the buffer\n
         flLogOut("２Ｄポリゴンの表示要求がバッファをオーバーしました\n");
         return;
     }
 
+    prim = &njdp2d_w.prim[njdp2d_w.total];
+
     if (flag == 0) {
-        njdp2d_w.prim[ix].v[0].z = njdp2d_w.prim[ix].v[1].z = njdp2d_w.prim[ix].v[2].z = njdp2d_w.prim[ix].v[3].z = pri;
-        njdp2d_w.prim[ix].v[0].x = pos[0];
-        njdp2d_w.prim[ix].v[0].y = pos[1];
-        njdp2d_w.prim[ix].v[1].x = pos[2];
-        njdp2d_w.prim[ix].v[1].y = pos[3];
-        njdp2d_w.prim[ix].v[2].x = pos[4];
-        njdp2d_w.prim[ix].v[2].y = pos[5];
-        njdp2d_w.prim[ix].v[3].x = pos[6];
-        njdp2d_w.prim[ix].v[3].y = pos[7];
-        njdp2d_w.prim[ix].type = 0;
-        njdp2d_w.prim[ix].col = col;
+        prim->v[0].z = prim->v[1].z = prim->v[2].z = prim->v[3].z = pri;
+        prim->v[0].x = pos[0];
+        prim->v[0].y = pos[1];
+        prim->v[1].x = pos[2];
+        prim->v[1].y = pos[3];
+        prim->v[2].x = pos[4];
+        prim->v[2].y = pos[5];
+        prim->v[3].x = pos[6];
+        prim->v[3].y = pos[7];
+        prim->type = 0;
+        prim->col = col;
     }
 
     if (flag == 1) {
-        njdp2d_w.prim[ix].v[0].z = pri;
-        njdp2d_w.prim[ix].v[0].y = pos[0];
-        njdp2d_w.prim[ix].type = 1;
-        njdp2d_w.prim[ix].col = col;
-    }
-
-    njdp2d_w.prim[ix].next = -1;
-
-    if (njdp2d_w.ix1st == -1) {
-        njdp2d_w.ix1st = njdp2d_w.total;
-    } else {
-        i = njdp2d_w.ix1st;
-        prev = -1;
-
-        while (1) {
-            if (pri > njdp2d_w.prim[i].v[0].z) {
-                if (prev == -1) {
-                    njdp2d_w.ix1st = ix;
-                    njdp2d_w.prim[ix].next = i;
-                } else {
-                    njdp2d_w.prim[prev].next = ix;
-                    njdp2d_w.prim[ix].next = i;
-                }
-
-                break;
-            }
-
-            if (njdp2d_w.prim[i].next == -1) {
-                njdp2d_w.prim[i].next = ix;
-                break;
-            }
-
-            prev = i;
-            i = njdp2d_w.prim[i].next;
-        }
+        prim->v[0].z = pri;
+        prim->v[0].y = pos[0];
+        prim->type = 1;
+        prim->col = col;
     }
 
     njdp2d_w.total += 1;
@@ -4,6 +4,9 @@
 #include "structs.h"
 #include "types.h"
 
+/// Frames in which more 2D polygons were requested than the 100 that the original game had room for
+extern s32 njdp2d_overflow_count;
+
 void njUnitMatrix(MTX* mtx);
 void njGetMatrix(MTX* m);
 void njSetMatrix(MTX* md, MTX* ms);
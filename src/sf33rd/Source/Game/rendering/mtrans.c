@@ -22,7 +22,28 @@
 
 #include <SDL3/SDL.h>
 
+#include <math.h>
+#include <string.h>
+
 #define PRIO_BASE_SIZE 128
+#define PENDING_CHIP_MAX 0x100
+
+/// Sprite chip of an object, waiting to be transformed together with the other chips of the object
+typedef struct {
+    s32 w;
+    s32 h;
+    s32 gix;
+    s32 code;
+    s32 attr;
+    s32 alpha;
+    s32 id;
+} PendingChip;
+
+/// What stepping the priority after a chip adds to the current matrix
+typedef struct {
+    f32 z;
+    f32 w;
+} ChipStep;
 
 // sbss
 s32 curr_bright;
@@ -31,6 +52,9 @@ SpriteChipSet seqs_w;
 // bss
 f32 PrioBase[PRIO_BASE_SIZE];
 f32 PrioBaseOriginal[PRIO_BASE_SIZE];
+static PendingChip pending_chips[PENDING_CHIP_MAX];
+static Vec3 pending_corners[PENDING_CHIP_MAX * 2];
+static s32 pending_chip_count;
 
 // rodata
 static const u16 flptbl[4] = { 0x0000, 0x8000, 0x4000, 0xC000 };
@@ -104,6 +128,7 @@ static const u32 bright_type[4][16] = { { 0x00FFFFFF,
 static void DebugLine(f32 x, f32 y, f32 w, f32 h);
 s32 seqsStoreChip(f32 x, f32 y, s32 w, s32 h, s32 gix, s32 code, s32 attr, s32 alpha, s32 id);
 void appRenewTempPriority(s32 z);
+static void flush_chips();
 static s16 check_patcash_ex_trans(PatternCollection* padr, u32 cg);
 static s32 get_free_patcash_index(PatternCollection* padr);
 static s32 get_mltbuf16(MultiTexture* mt, u32 code, u32 palt, s32* ret);
@@ -243,6 +268,7 @@ void mlt_obj_disp(MultiTexture* mt, WORK* wk, s32 base_y) {
         trsptr += 1;
     }
 
+    flush_chips();
     seqs_w.up[mt->id] = 1;
     appRenewTempPriority(wk->position_z);
 }
@@ -343,6 +369,7 @@ void mlt_obj_disp_rgb(MultiTexture* mt, WORK* wk, s32 base_y) {
         trsptr++;
     }
 
+    flush_chips();
     seqs_w.up[mt->id] = 1;
     appRenewTempPriority(wk->position_z);
 }
@@ -530,6 +557,7 @@ void mlt_obj_trans_ext(MultiTexture* mt, WORK* wk, s32 base_y) {
                 trsptr++;
             }
 
+            flush_chips();
             seqs_w.up[mt->id] = 1;
             appRenewTempPriority(wk->position_z);
             return;
@@ -617,6 +645,7 @@ void mlt_obj_trans_ext(MultiTexture* mt, WORK* wk, s32 base_y) {
             trsptr++;
         }
 
+        flush_chips();
         seqs_w.up[mt->id] = 1;
         appRenewTempPriority(wk->position_z);
     }
@@ -753,6 +782,7 @@ void mlt_obj_trans(MultiTexture* mt, WORK* wk, s32 base_y) {
         trsptr++;
     }
 
+    flush_chips();
     seqs_w.up[mt->id] = 1;
     appRenewTempPriority(wk->position_z);
 }
@@ -908,6 +938,7 @@ void mlt_obj_trans_cp3_ext(MultiTexture* mt, WORK* wk, s32 base_y) {
                 trsptr++;
             }
 
+            flush_chips();
             seqs_w.up[mt->id] = 1;
             appRenewTempPriority(wk->position_z);
         }
@@ -1000,6 +1031,7 @@ void mlt_obj_trans_cp3_ext(MultiTexture* mt, WORK* wk, s32 base_y) {
             trsptr++;
         }
 
+        flush_chips();
         seqs_w.up[mt->id] = 1;
         appRenewTempPriority(wk->position_z);
     }
@@ -1141,6 +1173,7 @@ void mlt_obj_trans_cp3(MultiTexture* mt, WORK* wk, s32 base_y) {
         trsptr++;
     }
 
+    flush_chips();
     seqs_w.up[mt->id] = 1;
     appRenewTempPriority(wk->position_z);
 }
@@ -1287,6 +1320,7 @@ void mlt_obj_trans_rgb_ext(MultiTexture* mt, WORK* wk, s32 base_y) {
                 trsptr++;
             }
 
+            flush_chips();
             seqs_w.up[mt->id] = 1;
             appRenewTempPriority(wk->position_z);
         }
@@ -1368,6 +1402,7 @@ void mlt_obj_trans_rgb_ext(MultiTexture* mt, WORK* wk, s32 base_y) {
             trsptr++;
         }
 
+        flush_chips();
         seqs_w.up[mt->id] = 1;
         appRenewTempPriority(wk->position_z);
     }
@@ -1501,6 +1536,7 @@ void mlt_obj_trans_rgb(MultiTexture* mt, WORK* wk, s32 base_y) {
         trsptr++;
     }
 
+    flush_chips();
     seqs_w.up[mt->id] = 1;
     appRenewTempPriority(wk->position_z);
 }
@@ -1563,6 +1599,7 @@ void seqsBeforeProcess() {
     s32 i;
 
     seqs_w.sprTotal = 0;
+    pending_chip_count = 0;
 
     // FIXME: Extract 24 into a define
     for (i = 0; i < 24; i++) {
@@ -1575,6 +1612,8 @@ void seqsAfterProcess() {
     u32 keep = 0;
     u32 val = 0;
 
+    flush_chips();
+
     if ((Debug_w[0x27] != 3) && (seqs_w.sprTotal != 0)) {
         for (i = 0; i < 24; i++) {
             if (seqs_w.up[i]) {
@@ -1608,38 +1647,98 @@ void seqsAfterProcess() {
 }
 
 s32 seqsStoreChip(f32 x, f32 y, s32 w, s32 h, s32 gix, s32 code, s32 attr, s32 alpha, s32 id) {
+    PendingChip* pending;
+    Vec3* corners;
+
+    if (pending_chip_count == PENDING_CHIP_MAX) {
+        flush_chips();
+    }
+
+    corners = &pending_corners[pending_chip_count * 2];
+    corners[0].x = x;
+    corners[0].y = y;
+    corners[1].x = x + w;
+    corners[1].y = y - h;
+    corners[0].z = corners[1].z = 0.0f;
+
+    pending = &pending_chips[pending_chip_count];
+    pending->w = w;
+    pending->h = h;
+    pending->gix = gix;
+    pending->code = code;
+    pending->attr = attr;
+    pending->alpha = alpha;
+    pending->id = id;
+    pending_chip_count += 1;
+    return 1;
+}
+
+static bool is_positive_sum(f32 value) {
+    return !signbit(value) && (value < 1.0e30f);
+}
+
+/// @brief Work out what stepping the priority after a chip adds to `a[3][2]` and `a[3][3]` of the current matrix.
+///
+/// The step is a whole matrix product, but it comes down to these two adds when it leaves every other element as it
+/// is and the sums stay positive, so that the zeros it multiplies them by keep their sign.
+/// @return `false` if the step does more than that, and has to be done chip by chip.
+static bool get_chip_step(ChipStep* step) {
+    MTX before;
+    MTX after;
+    MTX probe;
+
+    njGetMatrix(&before);
+    appRenewTempPriority_1_Chip();
+    njGetMatrix(&after);
+
+    // -0 in place of the sums leaves exactly what the step adds to them
+    probe = before;
+    probe.a[3][2] = probe.a[3][3] = -0.0f;
+    njSetMatrix(NULL, &probe);
+    appRenewTempPriority_1_Chip();
+    njGetMatrix(&probe);
+    njSetMatrix(NULL, &before);
+
+    step->z = probe.a[3][2];
+    step->w = probe.a[3][3];
+
+    // The first 14 elements are the rows 0 to 2 and the x and y of row 3
+    return (memcmp(before.a, after.a, sizeof(f32) * 14) == 0) && is_positive_sum(before.a[3][2]) &&
+           is_positive_sum(before.a[3][3]) && is_positive_sum(step->z) && is_positive_sum(step->w);
+}
+
+/// @brief Cull a chip by its corners on screen, and store it if it is kept.
+/// @return Whether the chip was stored, and the priority has to be stepped.
+static bool store_chip(const PendingChip* pending, const Vec3* corners) {
     Sprite2* chip;
     s32 u;
     s32 v;
 
     const f32 dx = 0;
     const f32 dy = 0;
+    const s32 w = pending->w;
+    const s32 h = pending->h;
+    const s32 code = pending->code;
+    const s32 attr = pending->attr;
 
-    chip = &seqs_w.chip[seqs_w.sprTotal];
-    chip->v[0].x = x;
-    chip->v[0].y = y;
-    chip->v[1].x = x + w;
-    chip->v[1].y = y - h;
-    chip->v[0].z = chip->v[1].z = 0.0f;
-    njCalcPoint(NULL, &chip->v[0], &chip->v[0]);
-    njCalcPoint(NULL, &chip->v[1], &chip->v[1]);
-
-    if ((chip->v[0].x >= 384.0f) || (chip->v[1].x < 0.0f) || (chip->v[0].y >= 224.0f) || (chip->v[1].y < 0.0f)) {
-        return 1;
+    if ((corners[0].x >= 384.0f) || (corners[1].x < 0.0f) || (corners[0].y >= 224.0f) || (corners[1].y < 0.0f)) {
+        return false;
     }
 
+    chip = &seqs_w.chip[seqs_w.sprTotal];
+    chip->v[0] = corners[0];
+    chip->v[1] = corners[1];
+
     if (!(attr & 0x2000)) {
         u = (code & 0xF) * 16;
         v = code & 0xF0;
-        chip->texCode = ppgGetUsingTextureHandle(NULL, gix + (code >> 8));
+        chip->texCode = ppgGetUsingTextureHandle(NULL, pending->gix + (code >> 8));
     } else {
         u = (code & 7) * 32;
         v = (code & 0x38) * 4;
-        chip->texCode = ppgGetUsingTextureHandle(NULL, gix + (code >> 6));
+        chip->texCode = ppgGetUsingTextureHandle(NULL, pending->gix + (code >> 6));
     }
 
-    appRenewTempPriority_1_Chip();
-
     if (attr & 0x8000) {
         chip->t[1].s = (u - dx) / 256.0f;
         chip->t[0].s = (u + w - dx) / 256.0f;
@@ -1657,8 +1756,8 @@ s32 seqsStoreChip(f32 x, f32 y, s32 w, s32 h, s32 gix, s32 code, s32 attr, s32 a
     }
 
     chip->texCode |= ppgGetUsingPaletteHandle(NULL, attr & 0x1FF) << 16;
-    chip->vtxColor = curr_bright | ((0xFF - alpha) << 24);
-    chip->id = id;
+    chip->vtxColor = curr_bright | ((0xFF - pending->alpha) << 24);
+    chip->id = pending->id;
     seqs_w.sprTotal += 1;
 
     if (seqs_w.sprTotal > 0x400) {
@@ -1667,7 +1766,58 @@ s32 seqsStoreChip(f32 x, f32 y, s32 w, s32 h, s32 gix, s32 code, s32 attr, s32 a
         while (1) {}
     }
 
-    return 1;
+    return true;
+}
+
+/// @brief Store the chips queued by `seqsStoreChip`, transforming the corners of all of them in one go.
+///
+/// Every stored chip steps the priority in the matrix, so this has to run before anything else uses it. The result
+/// is the same as storing the chips one by one, down to the bit.
+static void flush_chips() {
+    ChipStep step;
+    MTX mtx;
+    Vec3* corners = pending_corners;
+    f32 z;
+    f32 w;
+    s32 i;
+
+    if (pending_chip_count == 0) {
+        return;
+    }
+
+    if (get_chip_step(&step)) {
+        njGetMatrix(&mtx);
+        z = mtx.a[3][2];
+        w = mtx.a[3][3];
+
+        // Leave the priority out of z, with -0 so that every other bit stays the same, and add it back per chip
+        mtx.a[3][2] = -0.0f;
+        njCalcPoints(&mtx, pending_corners, pending_corners, pending_chip_count * 2);
+
+        for (i = 0; i < pending_chip_count; i++, corners += 2) {
+            corners[0].z += z;
+            corners[1].z += z;
+
+            if (store_chip(&pending_chips[i], corners)) {
+                z = step.z + z;
+                w = step.w + w;
+            }
+        }
+
+        mtx.a[3][2] = z;
+        mtx.a[3][3] = w;
+        njSetMatrix(NULL, &mtx);
+    } else {
+        for (i = 0; i < pending_chip_count; i++, corners += 2) {
+            njCalcPoints(NULL, corners, corners, 2);
+
+            if (store_chip(&pending_chips[i], corners)) {
+                appRenewTempPriority_1_Chip();
+            }
+        }
+    }
+
+    pending_chip_count = 0;
 }
 
 static s32 get_mltbuf16(MultiTexture* mt, u32 code, u32 palt, s32* ret) {
@@ -2152,6 +2302,9 @@ static void DebugLine(f32 x, f32 y, f32 w, f32 h) {
     PAL_CURSOR_P xy[4];
     PAL_CURSOR_COL cc[4];
 
+    // The outline goes through the matrix as stepped by the chips before it
+    flush_chips();
+
     line.p = &xy[0];
     line.col = &cc[0];
     line.tex = NULL;
@@ -27,19 +27,6 @@
 #define TO_UV_128(val) ((val) / 128.0f)
 #endif
 
-typedef struct {
-    s16 fade;
-    s16 fade_kind;
-    u8 fade_prio;
-} FadeData;
-
-typedef struct {
-    u8 atr;
-    u8 page;
-    u8 cx;
-    u8 cy;
-} SAFrame;
-
 // sdata
 u8 ascProData[128] = { 0, 18, 0, 0, 0,  0, 0,  0,  0,  0, 0,  0, 0, 0,  0,  0,  0, 0, 0,  0,  0,  0,  0, 0,  0, 0,
                        0, 0,  0, 0, 0,  0, 34, 19, 18, 0, 0,  0, 0, 34, 34, 34, 1, 1, 34, 1,  34, 0,  0, 18, 0, 0,
@@ -106,7 +106,7 @@ void Entry_Task(struct _TASK* /* unused */) {
 
     for (ix = 0; ix < ff; ix++) {
         if (ix == (ff - 1)) {
-            No_Trans = 0;
+            No_Trans = Force_No_Trans;
         } else {
             No_Trans = 1;
         }
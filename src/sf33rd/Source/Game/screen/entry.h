@@ -8,5 +8,6 @@ extern const u8 Coin_Message_Data[7][2];
 
 void Entry_Task(struct _TASK*);
 s32 Ck_Break_Into(u16 Sw_0, u16 Sw_1, s16 PL_id);
+void Entry_01_Sub(s16 PL_id);
 
 #endif // ENTRY_H
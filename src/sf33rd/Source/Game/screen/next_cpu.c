@@ -69,6 +69,7 @@ void Next_Q_3rd();
 void Sel_CPU_Sub(s16 PL_id, u16 sw, u16 /* unused */);
 void Setup_EM_List();
 void Setup_Next_Fighter();
+void Prefetch_Next_Fighter(s16 em_id);
 s8 Setup_Com_Arts();
 void Setup_Com_Color();
 void Setup_Regular_OBJ(s16 PL_id);
@@ -1102,6 +1103,8 @@ void Sel_CPU_Sub(s16 PL_id, u16 sw, u16 /* unused */) {
         Temporary_EM[Player_id] = 1;
     }
 
+    Prefetch_Next_Fighter(EM_List[Player_id][Temporary_EM[Player_id] - 1]);
+
     if (sw & SWK_ATTACKS) {
         Sel_EM_Complete[PL_id] = 1;
         EM_id = EM_List[Player_id][Temporary_EM[Player_id] - 1];
@@ -1130,28 +1133,32 @@ void Setup_EM_List() {
     EM_List[Player_id][1] = EM_Candidate[Player_id][1][VS_Index[Player_id]];
 }
 
-void Setup_Next_Fighter() {
-    paring_counter[COM_id] = 0;
-    paring_bonus_r[COM_id] = 0;
-    My_char[COM_id] = EM_id;
-
-    if (EM_id == 17) {
-        Battle_Country = Q_Country;
-        bg_w.stage = Q_Country;
-    } else {
-        Battle_Country = EM_id;
-
-        if (My_char[Player_id] == 0 && EM_id == 1) {
-            Battle_Country = 0;
-        }
+s16 Next_Fighter_Stage(s16 em_id, s16 player_char) {
+    if (Debug_w[31]) {
+        return Debug_w[31] - 1;
+    }
 
-        bg_w.stage = Battle_Country;
+    if (em_id == 17) {
+        return Q_Country;
     }
 
-    if (Debug_w[31]) {
-        Battle_Country = bg_w.stage = Debug_w[31] - 1;
+    if (player_char == 0 && em_id == 1) {
+        return 0;
     }
 
+    return em_id;
+}
+
+void Prefetch_Next_Fighter(s16 em_id) {
+    Prefetch_LDREQ_Player(2, em_id);
+    Prefetch_LDREQ_BG(Next_Fighter_Stage(em_id, My_char[Player_id]));
+}
+
+void Setup_Next_Fighter() {
+    paring_counter[COM_id] = 0;
+    paring_bonus_r[COM_id] = 0;
+    My_char[COM_id] = EM_id;
+    Battle_Country = bg_w.stage = Next_Fighter_Stage(EM_id, My_char[Player_id]);
     Push_LDREQ_Queue_BG(bg_w.stage + 0);
     bg_w.area = 0;
     Super_Arts[COM_id] = Stock_Com_Arts[Player_id] = Setup_Com_Arts();
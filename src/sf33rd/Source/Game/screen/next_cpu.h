@@ -11,4 +11,7 @@ s16 Select_CPU_First();
 void Setup_PL_Color(s16 PL_id, u16 sw);
 s32 Auto_Cut_Sub();
 
+/// @brief Stage of an arcade mode fight against `em_id`, with `player_char` as the player's character.
+s16 Next_Fighter_Stage(s16 em_id, s16 player_char);
+
 #endif
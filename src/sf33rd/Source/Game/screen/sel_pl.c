@@ -1148,6 +1148,8 @@ void Sel_PL_Sub(s16 PL_id, u16 sw) {
         Sound_SE(ID + 96);
     }
 
+    Prefetch_LDREQ_Player(PL_id, ID_of_Face[Cursor_Y[PL_id]][Cursor_X[PL_id]]);
+
     if (!(sw & SWK_ATTACKS)) {
         return;
     }
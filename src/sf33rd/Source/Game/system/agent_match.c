@@ -0,0 +1,185 @@
+/**
+ * @file agent_match.c
+ * Matches for the Agent API
+ *
+ * A match is started through the same screens as a replay loaded from the Replay menu, which load the characters
+ * and the stage given in `Replay_w` without going through the select screens. It is switched to a versus match
+ * before the battle starts, so that players read their inputs from the pads or the AI instead of the replay.
+ */
+
+#include "sf33rd/Source/Game/system/agent_match.h"
+#include "common.h"
+#include "sf33rd/Source/Game/Game.h"
+#include "sf33rd/Source/Game/engine/workuser.h"
+#include "sf33rd/Source/Game/main.h"
+#include "sf33rd/Source/Game/menu/menu.h"
+#include "sf33rd/Source/Game/stage/bg.h"
+#include "sf33rd/Source/Game/system/sys_sub.h"
+#include "sf33rd/Source/Game/system/work_sys.h"
+#include "structs.h"
+
+typedef enum AgentMatchState {
+    AGENT_MATCH_LOADING,
+    AGENT_MATCH_STARTING,
+    AGENT_MATCH_INTRO,
+    AGENT_MATCH_READY,
+} AgentMatchState;
+
+static AgentMatchState match_state = AGENT_MATCH_READY;
+static u32 match_seed;
+
+static void setup_replay_w(const AgentConfig* config) {
+    struct _REP_GAME_INFOR* rp = &Replay_w.game_infor;
+    struct _MINI_SAVE_W* msw = &Replay_w.mini_save_w;
+    const struct _SAVE_W* sw = &save_w[1];
+    s16 ix;
+
+    for (ix = 0; ix < 2; ix++) {
+        rp->player_infor[ix].my_char = config->character[ix];
+        rp->player_infor[ix].sa = config->super_art[ix];
+        rp->player_infor[ix].color = config->color[ix];
+        rp->player_infor[ix].player_type = !config->cpu[ix];
+        rp->Vital_Handicap[ix] = Vital_Handicap[1][ix];
+    }
+
+    rp->stage = config->stage;
+    rp->Direction_Working = Direction_Working[1];
+    msw->Pad_Infor[0] = sw->Pad_Infor[0];
+    msw->Pad_Infor[1] = sw->Pad_Infor[1];
+    msw->Time_Limit = sw->Time_Limit;
+    msw->Battle_Number[0] = sw->Battle_Number[0];
+    msw->Battle_Number[1] = sw->Battle_Number[1];
+    msw->Damage_Level = sw->Damage_Level;
+    msw->extra_option = sw->extra_option;
+    Replay_w.system_dir = system_dir[1];
+}
+
+void Agent_Match_Start(const AgentConfig* config) {
+    struct _TASK* menu = &task[TASK_MENU];
+
+    cpExitTask(TASK_PAUSE);
+    Next_Title_Sub();
+    setup_replay_w(config);
+
+    // Jump straight to the loading screen of the Replay menu, as if a replay file had been picked
+    G_No[1] = 0xC;
+    G_No[2] = 0;
+    G_No[3] = 0;
+    cpReadyTask(TASK_MENU, Menu_Task);
+    menu->r_no[0] = 0;
+    menu->r_no[1] = 6;
+    menu->r_no[2] = 4;
+    menu->r_no[3] = 0;
+    Decide_ID = 0;
+
+    // Load_Replay_Sub copies the other settings to save_w[3], but keeps the difficulty
+    save_w[3].Difficulty = config->difficulty;
+    match_seed = config->seed;
+    match_state = AGENT_MATCH_LOADING;
+}
+
+/// @brief Set the random number tables to where the seed points, wrapping each index at the size of its table.
+static void apply_seed() {
+    Random_ix16 = match_seed & 0x3F;
+    Random_ix32 = (match_seed >> 6) & 0x7F;
+    Random_ix16_ex = (match_seed >> 13) & 0xF;
+    Random_ix32_ex = (match_seed >> 17) & 0x1F;
+
+    // Refresh the copies taken when the match started
+    Setup_Replay_Header();
+}
+
+bool Agent_Match_Update() {
+    switch (match_state) {
+    case AGENT_MATCH_LOADING:
+        // Load_Replay_Sub has copied Replay_w into the game, the mode only matters from here on
+        if ((task[TASK_MENU].condition == 1) && (task[TASK_MENU].r_no[3] >= 2)) {
+            Mode_Type = MODE_VERSUS;
+            match_state = AGENT_MATCH_STARTING;
+        }
+
+        break;
+
+    case AGENT_MATCH_STARTING:
+        // Game2_0 has cleared the random number tables
+        if ((G_No[1] == 2) && (G_No[2] == 6)) {
+            apply_seed();
+            match_state = AGENT_MATCH_INTRO;
+        }
+
+        break;
+
+    case AGENT_MATCH_INTRO:
+        if (Allow_a_battle_f) {
+            match_state = AGENT_MATCH_READY;
+        }
+
+        break;
+
+    case AGENT_MATCH_READY:
+        break;
+    }
+
+    return match_state == AGENT_MATCH_READY;
+}
+
+static void observe_attack_boxes(const WORK* wk, AgentPlayer* out) {
+    const s16(*box)[4];
+    AgentBox* dst;
+    s16 ix;
+
+    out->attack_box_count = 0;
+
+    if ((wk->h_att == NULL) || (wk->cg_ja.atix == 0) || (wk->att_hit_ok == 0)) {
+        return;
+    }
+
+    box = wk->h_att->att_box;
+
+    for (ix = 0; ix < 4; ix++, box++) {
+        if ((*box)[1] == 0) {
+            continue;
+        }
+
+        // Same as hit_check_subroutine, boxes are mirrored around the player when facing right
+        dst = &out->attack_boxes[out->attack_box_count++];
+
+        if (wk->rl_flag) {
+            dst->x = wk->xyz[0].disp.pos - (*box)[0] - (*box)[1];
+        } else {
+            dst->x = wk->xyz[0].disp.pos + (*box)[0];
+        }
+
+        dst->y = wk->xyz[1].disp.pos + (*box)[2];
+        dst->width = (*box)[1];
+        dst->height = (*box)[3];
+    }
+}
+
+void Agent_Match_Observe(AgentObservation* obs) {
+    const PLW* plw;
+    AgentPlayer* out;
+    s16 ix;
+
+    obs->battle_active = Allow_a_battle_f != 0;
+    obs->match_over = (match_state == AGENT_MATCH_READY) && (G_No[1] != 2);
+    obs->round = Round_num;
+    obs->timer = Counter_hi;
+
+    for (ix = 0; ix < 2; ix++) {
+        plw = &gs.plw[ix];
+        out = &obs->player[ix];
+
+        out->x = plw->wu.xyz[0].disp.pos;
+        out->y = plw->wu.xyz[1].disp.pos;
+        out->vitality = plw->wu.vital_new;
+        out->stun = plw->py->now.quantity.h;
+        out->stun_limit = plw->py->genkai;
+        out->super_gauge = plw->sa->gauge.s.h;
+        out->super_stock = plw->sa->store;
+        out->pat_status = plw->wu.pat_status;
+        out->facing_right = plw->wu.rl_flag != 0;
+        out->wins = PL_Wins[ix];
+        observe_attack_boxes(&plw->wu, out);
+    }
+}
@@ -0,0 +1,18 @@
+#ifndef AGENT_MATCH_H
+#define AGENT_MATCH_H
+
+#include "port/agent.h"
+#include "types.h"
+
+/// @brief Leave whatever is running and start loading a versus match, with each player controlled by the pads or
+/// the AI.
+void Agent_Match_Start(const AgentConfig* config);
+
+/// @brief Advance the setup of the match started by `Agent_Match_Start`. Call after every frame.
+/// @return `true` once the players are in control for the first time.
+bool Agent_Match_Update();
+
+/// @brief Fill the players and round state of `obs` from the current frame.
+void Agent_Match_Observe(AgentObservation* obs);
+
+#endif
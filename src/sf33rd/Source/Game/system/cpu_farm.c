@@ -0,0 +1,353 @@
+/**
+ * @file cpu_farm.c
+ * Headless CPU vs CPU Matches
+ *
+ * The game boots once, up to the attract loop, and every match runs in a process forked from that state. A match
+ * is started the same way as with the Agent API, with both players given to the AI. Each process sends back what
+ * happened in its match, and the results are added up per character pairing and difficulty.
+ */
+
+#include "sf33rd/Source/Game/system/cpu_farm.h"
+#include "common.h"
+#include "port/agent.h"
+#include "port/batch_runner.h"
+#include "port/options.h"
+#include "sf33rd/Source/Game/engine/workuser.h"
+#include "sf33rd/Source/Game/main.h"
+#include "sf33rd/Source/Game/screen/next_cpu.h"
+#include "sf33rd/Source/Game/system/agent_match.h"
+#include "structs.h"
+
+#include <SDL3/SDL.h>
+
+#define BOOT_FRAME_LIMIT (60 * 60)
+#define MATCH_FRAME_LIMIT (60 * 60 * 15)
+#define GAME_FPS 59.59949
+#define PAIRING_COUNT (AGENT_CHARACTER_COUNT * AGENT_CHARACTER_COUNT)
+#define ROUTINE_COUNT 16
+
+typedef enum HitKind {
+    HIT_KIND_NORMAL,
+    HIT_KIND_SPECIAL,
+    HIT_KIND_SUPER,
+    HIT_KIND_COUNT,
+} HitKind;
+
+static const char* hit_kind_names[HIT_KIND_COUNT] = { "normal", "special", "super" };
+
+// Matches Com_Jmp_Tbl in Main_Program
+static const char* routine_names[ROUTINE_COUNT] = { "initialize", "free",           "active",   "before_follow",
+                                                    "follow",     "before_passive", "passive",  "guard",
+                                                    "vs_shell",   "guard_vs_shell", "damage",   "float",
+                                                    "flip",       "caught",         "wait_lie", "catch" };
+
+typedef struct FarmResult {
+    bool finished;
+    s32 wins[2];
+    s32 rounds;
+    s32 round_frames;
+    s32 frames;
+
+    /// Damage dealt by each player
+    s32 damage[2][HIT_KIND_COUNT];
+
+    /// Frames each player's AI spent in each routine, while the players were in control
+    s32 ai_frames[2][ROUTINE_COUNT];
+} FarmResult;
+
+typedef struct FarmStats {
+    s32 matches;
+    s32 failed;
+    s32 wins[2];
+    s32 rounds;
+    u64 round_frames;
+    u64 damage[2][HIT_KIND_COUNT];
+    u64 ai_frames[2][ROUTINE_COUNT];
+} FarmStats;
+
+typedef struct FarmTotals {
+    FarmStats* stats;
+    s32 finished;
+    s32 failed;
+    u64 frames;
+} FarmTotals;
+
+static s32 difficulty_count;
+
+/// @brief Pick the match of a job. Jobs go through every pairing and difficulty before moving to the next seed,
+/// so that all of them have results early in a long run.
+static void setup_job(int job, AgentConfig* config) {
+    SDL_zerop(config);
+    config->character[1] = job % AGENT_CHARACTER_COUNT;
+    job /= AGENT_CHARACTER_COUNT;
+    config->character[0] = job % AGENT_CHARACTER_COUNT;
+    job /= AGENT_CHARACTER_COUNT;
+    config->difficulty = options.farm_difficulty_first + (job % difficulty_count);
+    job /= difficulty_count;
+    config->seed = options.farm_seed_first + job;
+    config->cpu[0] = 1;
+    config->cpu[1] = 1;
+
+    // The stage arcade mode would pick. Q_Country, the stage Q was first met on, has its boot value in every job.
+    config->stage = Next_Fighter_Stage(config->character[1], config->character[0]);
+}
+
+/// @brief Sort an attack by its `kind_of_waza`, the same way as the cancel rules in hitcheck.c.
+static HitKind get_hit_kind(u8 kind_of_waza) {
+    if ((kind_of_waza & 0xF8) == 0) {
+        return HIT_KIND_NORMAL;
+    }
+
+    if (kind_of_waza & 0x60) {
+        return HIT_KIND_SUPER;
+    }
+
+    return HIT_KIND_SPECIAL;
+}
+
+static void record_frame(FarmResult* result, s16* vital, bool* was_active) {
+    const WORK* wk;
+    s16 now;
+    s16 pl;
+
+    for (pl = 0; pl < 2; pl++) {
+        wk = &gs.plw[pl].wu;
+        now = (wk->vital_new < 0) ? 0 : wk->vital_new;
+
+        // Vitality only goes up when a round starts
+        if (now < vital[pl]) {
+            result->damage[pl ^ 1][get_hit_kind(wk->dm_kind_of_waza)] += vital[pl] - now;
+        }
+
+        vital[pl] = now;
+    }
+
+    if (Allow_a_battle_f) {
+        result->round_frames += 1;
+
+        for (pl = 0; pl < 2; pl++) {
+            if (CP_No[pl][0] < ROUTINE_COUNT) {
+                result->ai_frames[pl][CP_No[pl][0]] += 1;
+            }
+        }
+    } else if (*was_active) {
+        result->rounds += 1;
+    }
+
+    *was_active = Allow_a_battle_f != 0;
+}
+
+static void run_job(int job, void* result_data) {
+    FarmResult result;
+    AgentConfig config;
+    s16 vital[2];
+    bool was_active = false;
+    s32 i;
+    s16 pl;
+
+    SDL_zero(result);
+    setup_job(job, &config);
+    Agent_Match_Start(&config);
+
+    // Screen transitions wait for voices and music to end, so these frames need audio
+    for (i = 0; (i < BOOT_FRAME_LIMIT) && !Agent_Match_Update(); i++) {
+        Headless_Frame(true);
+        result.frames += 1;
+    }
+
+    if (i < BOOT_FRAME_LIMIT) {
+        for (pl = 0; pl < 2; pl++) {
+            vital[pl] = gs.plw[pl].wu.vital_new;
+        }
+
+        // The battle ends when the match has been decided
+        for (i = 0; (i < MATCH_FRAME_LIMIT) && (G_No[1] == 2); i++) {
+            Headless_Frame(false);
+            result.frames += 1;
+            record_frame(&result, vital, &was_active);
+        }
+
+        result.finished = G_No[1] != 2;
+    }
+
+    for (pl = 0; pl < 2; pl++) {
+        result.wins[pl] = PL_Wins[pl];
+    }
+
+    SDL_memcpy(result_data, &result, sizeof(result));
+}
+
+static void on_result(int job, const void* result_data, void* user) {
+    FarmTotals* totals = user;
+    FarmStats* stats = &totals->stats[job % (PAIRING_COUNT * difficulty_count)];
+    FarmResult result;
+    s16 pl;
+    s16 ix;
+
+    totals->finished += 1;
+    stats->matches += 1;
+
+    if (result_data == NULL) {
+        totals->failed += 1;
+        stats->failed += 1;
+        return;
+    }
+
+    SDL_memcpy(&result, result_data, sizeof(result));
+    totals->frames += result.frames;
+
+    if (!result.finished) {
+        totals->failed += 1;
+        stats->failed += 1;
+        return;
+    }
+
+    if (result.wins[0] != result.wins[1]) {
+        stats->wins[result.wins[1] > result.wins[0]] += 1;
+    }
+
+    stats->rounds += result.rounds;
+    stats->round_frames += result.round_frames;
+
+    for (pl = 0; pl < 2; pl++) {
+        for (ix = 0; ix < HIT_KIND_COUNT; ix++) {
+            stats->damage[pl][ix] += result.damage[pl][ix];
+        }
+
+        for (ix = 0; ix < ROUTINE_COUNT; ix++) {
+            stats->ai_frames[pl][ix] += result.ai_frames[pl][ix];
+        }
+    }
+}
+
+static void write_stats(SDL_IOStream* output, const FarmStats* all_stats) {
+    const FarmStats* stats;
+    s32 played;
+    s32 group;
+    s16 pl;
+    s16 ix;
+
+    SDL_IOprintf(output, "p1_char,p2_char,difficulty,matches,failed,p1_win_rate,p2_win_rate,avg_round_frames");
+
+    for (pl = 1; pl <= 2; pl++) {
+        for (ix = 0; ix < HIT_KIND_COUNT; ix++) {
+            SDL_IOprintf(output, ",p%d_%s_damage", pl, hit_kind_names[ix]);
+        }
+    }
+
+    for (pl = 1; pl <= 2; pl++) {
+        for (ix = 0; ix < ROUTINE_COUNT; ix++) {
+            SDL_IOprintf(output, ",p%d_ai_%s_frames", pl, routine_names[ix]);
+        }
+    }
+
+    SDL_IOprintf(output, "\n");
+
+    for (group = 0; group < PAIRING_COUNT * difficulty_count; group++) {
+        stats = &all_stats[group];
+        played = stats->matches - stats->failed;
+
+        if (stats->matches == 0) {
+            continue;
+        }
+
+        SDL_IOprintf(output,
+                     "%d,%d,%d,%d,%d,%.4f,%.4f,%.1f",
+                     (group / AGENT_CHARACTER_COUNT) % AGENT_CHARACTER_COUNT,
+                     group % AGENT_CHARACTER_COUNT,
+                     options.farm_difficulty_first + (group / PAIRING_COUNT),
+                     stats->matches,
+                     stats->failed,
+                     (played > 0) ? (double)stats->wins[0] / played : 0.0,
+                     (played > 0) ? (double)stats->wins[1] / played : 0.0,
+                     (stats->rounds > 0) ? (double)stats->round_frames / stats->rounds : 0.0);
+
+        for (pl = 0; pl < 2; pl++) {
+            for (ix = 0; ix < HIT_KIND_COUNT; ix++) {
+                SDL_IOprintf(output, ",%" SDL_PRIu64, stats->damage[pl][ix]);
+            }
+        }
+
+        for (pl = 0; pl < 2; pl++) {
+            for (ix = 0; ix < ROUTINE_COUNT; ix++) {
+                SDL_IOprintf(output, ",%" SDL_PRIu64, stats->ai_frames[pl][ix]);
+            }
+        }
+
+        SDL_IOprintf(output, "\n");
+    }
+}
+
+s32 Run_CPU_Farm() {
+    FarmTotals totals;
+    SDL_IOStream* output;
+    s32 worker_count = options.batch_jobs;
+    s64 seed_count;
+    s64 job_count;
+    s32 i;
+    Uint64 start;
+    double seconds;
+
+    if ((options.farm_difficulty_first < 0) || (options.farm_difficulty_last >= AGENT_DIFFICULTY_COUNT)) {
+        SDL_Log("Farm difficulties must be within 0-%d", AGENT_DIFFICULTY_COUNT - 1);
+        return 1;
+    }
+
+    difficulty_count = options.farm_difficulty_last - options.farm_difficulty_first + 1;
+    seed_count = (s64)options.farm_seed_last - options.farm_seed_first + 1;
+    job_count = PAIRING_COUNT * difficulty_count * seed_count;
+
+    if (job_count > SDL_MAX_SINT32) {
+        SDL_Log("Farm runs are limited to %d matches, %" SDL_PRIs64 " seeds make %" SDL_PRIs64,
+                SDL_MAX_SINT32,
+                seed_count,
+                job_count);
+        return 1;
+    }
+
+    for (i = 0; (i < BOOT_FRAME_LIMIT) && (G_No[0] != 1); i++) {
+        Headless_Frame(true);
+    }
+
+    if (G_No[0] != 1) {
+        SDL_Log("The game didn't boot within %d frames", BOOT_FRAME_LIMIT);
+        return 1;
+    }
+
+    if (worker_count <= 0) {
+        worker_count = SDL_GetNumLogicalCPUCores();
+    }
+
+    output = SDL_IOFromFile(options.cpu_farm_path, "w");
+
+    if (output == NULL) {
+        SDL_Log("Failed to create %s: %s", options.cpu_farm_path, SDL_GetError());
+        return 1;
+    }
+
+    SDL_zero(totals);
+    totals.stats = SDL_calloc(PAIRING_COUNT * difficulty_count, sizeof(FarmStats));
+    start = SDL_GetPerformanceCounter();
+
+    if (!BatchRunner_Run(job_count, worker_count, sizeof(FarmResult), run_job, on_result, &totals)) {
+        SDL_free(totals.stats);
+        SDL_CloseIO(output);
+        return 1;
+    }
+
+    seconds = (double)(SDL_GetPerformanceCounter() - start) / SDL_GetPerformanceFrequency();
+    write_stats(output, totals.stats);
+
+    SDL_Log("CPU farm: %d matches (%d failed) with %d jobs in %.2f s, %.2f matches/s, %.0f frames/s (%.1fx real time)",
+            totals.finished,
+            totals.failed,
+            worker_count,
+            seconds,
+            totals.finished / seconds,
+            totals.frames / seconds,
+            totals.frames / seconds / GAME_FPS);
+
+    SDL_free(totals.stats);
+    SDL_CloseIO(output);
+    return 0;
+}
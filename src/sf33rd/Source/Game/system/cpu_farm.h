@@ -0,0 +1,14 @@
+#ifndef CPU_FARM_H
+#define CPU_FARM_H
+
+#include "types.h"
+
+/// @brief Play CPU vs CPU matches headless for every character pairing, at each difficulty and seed of
+/// `--farm-difficulty` and `--farm-seeds`, and write statistics for each pairing and difficulty to `--cpu-farm`.
+///
+/// Like `Run_Replay_Batch`, matches run in processes forked from the booted game, several at a time.
+/// `Headless_Init` must have been called.
+/// @return `0` if the matches were run, `1` if the farm couldn't start.
+s32 Run_CPU_Farm();
+
+#endif
@@ -0,0 +1,409 @@
+/**
+ * @file replay_batch.c
+ * Headless Replay Batches
+ *
+ * The game boots once, up to the attract loop. Each replay then runs in a process forked from that state: it goes
+ * through the title screen and the Replay menu like a player would, plays the replay file to its end and sends a
+ * summary of the match back. Forked processes share the memory of the booted game until they write to it, so
+ * starting one costs little more than the frames it runs.
+ *
+ * With --software-render, each replay can also write the image hash of every frame it ran to
+ * `<--batch-frames dir>/<replay file name>.frames`, one `frame,hash` line each, to be kept as golden values. It can
+ * also be captured to `<--batch-capture dir>/<replay file name>.mkv`, with the same frames as the hashes.
+ */
+
+#include "sf33rd/Source/Game/system/replay_batch.h"
+#include "common.h"
+#include "port/batch_runner.h"
+#include "port/io/afs.h"
+#include "port/options.h"
+#include "port/sdl/sdl_app.h"
+#include "port/sdl/sdl_soft_renderer.h"
+#include "sf33rd/Source/Game/Game.h"
+#include "sf33rd/Source/Game/engine/grade.h"
+#include "sf33rd/Source/Game/engine/workuser.h"
+#include "sf33rd/Source/Game/main.h"
+#include "sf33rd/Source/Game/screen/entry.h"
+#include "sf33rd/Source/Game/system/replay_stream.h"
+#include "sf33rd/Source/Game/system/state_hash.h"
+#include "sf33rd/Source/Game/system/work_sys.h"
+#include "structs.h"
+
+#include <SDL3/SDL.h>
+
+#define BOOT_FRAME_LIMIT (60 * 60)
+#define MATCH_FRAME_LIMIT (60 * 60 * 60)
+#define GAME_FPS 59.59949
+
+typedef enum BatchStatus {
+    BATCH_STATUS_OK,
+    BATCH_STATUS_LOAD_FAILED,
+    BATCH_STATUS_TIMED_OUT,
+    BATCH_STATUS_CRASHED,
+    BATCH_STATUS_FRAMES_FAILED,
+    BATCH_STATUS_CAPTURE_FAILED,
+} BatchStatus;
+
+static const char* status_names[] = { "ok", "load_failed", "timed_out", "crashed", "frames_failed", "capture_failed" };
+
+typedef struct BatchResult {
+    BatchStatus status;
+    s32 winner;
+    s32 wins[2];
+    s32 match_frames;
+    s32 frames;
+    u64 state_hash;
+    u64 image_hash; // Of the hashes of every frame the replay ran, with --software-render
+    GradeData grade[2];
+} BatchResult;
+
+typedef struct BatchTotals {
+    SDL_IOStream* output;
+    s32 finished;
+    s32 failed;
+    u64 frames;
+} BatchTotals;
+
+static char** paths;
+static s32 path_count;
+static SDL_IOStream* frame_hash_io = NULL;
+
+static s32 read_list(const char* list_path) {
+    char* list = SDL_LoadFile(list_path, NULL);
+    char* line;
+    char* next;
+
+    if (list == NULL) {
+        SDL_Log("Failed to read replay list %s: %s", list_path, SDL_GetError());
+        return 0;
+    }
+
+    path_count = 0;
+
+    for (line = list; line != NULL; line = next) {
+        next = SDL_strchr(line, '\n');
+
+        if (next != NULL) {
+            *next++ = '\0';
+        }
+
+        line[SDL_strcspn(line, "\r")] = '\0';
+
+        if (*line == '\0') {
+            continue;
+        }
+
+        paths = SDL_realloc(paths, sizeof(char*) * (path_count + 1));
+        paths[path_count++] = line;
+    }
+
+    return path_count;
+}
+
+/// @brief Run frames until `done` returns true.
+/// @return `true` if `done` returned true within `limit` frames.
+static bool run_until(bool (*done)(), s32 limit, s32* frames) {
+    for (s32 i = 0; i < limit; i++) {
+        if (done()) {
+            return true;
+        }
+
+        Headless_Frame(true);
+
+        if (frame_hash_io != NULL) {
+            SDL_IOprintf(frame_hash_io, "%d,%016" SDL_PRIx64 "\n", *frames, SDLSoftRenderer_GetFrameHash());
+        }
+
+        *frames += 1;
+    }
+
+    return false;
+}
+
+static bool is_attract_loop() {
+    return G_No[0] == 1;
+}
+
+/// Presses Start on the title screen, and picks Replay in the mode select menu once it takes input.
+static bool is_replay_menu() {
+    struct _TASK* menu = &task[TASK_MENU];
+
+    if ((G_No[0] == 2) && (G_No[1] == 0) && (G_No[2] == 1) && !Request_G_No) {
+        Entry_01_Sub(0);
+    }
+
+    if ((menu->condition == 1) && (menu->r_no[0] == 0) && (menu->r_no[1] == 1) && (menu->r_no[2] == 3)) {
+        Menu_Cursor_Y[0] = 4;
+        menu->r_no[2] += 1;
+        menu->free[0] = 0;
+        menu->free[1] = 6;
+    }
+
+    return (menu->r_no[0] == 0) && (menu->r_no[1] == 6);
+}
+
+static bool is_replay_over() {
+    return Replay_Status[0] == 2;
+}
+
+/// @brief Make the path of a file in `dir` named after the replay file of `job`. Free it with `SDL_free`.
+static char* make_job_path(int job, const char* dir, const char* extension) {
+    const char* name = paths[job];
+    const char* c;
+    char* path;
+
+    for (c = paths[job]; *c != '\0'; c++) {
+        if ((*c == '/') || (*c == '\\')) {
+            name = c + 1;
+        }
+    }
+
+    SDL_asprintf(&path, "%s/%s.%s", dir, name, extension);
+    return path;
+}
+
+static SDL_IOStream* create_frame_hashes(int job) {
+    char* path = make_job_path(job, options.batch_frame_hash_dir, "frames");
+    SDL_IOStream* io = SDL_IOFromFile(path, "w");
+
+    if (io == NULL) {
+        SDL_Log("Failed to create %s: %s", path, SDL_GetError());
+    }
+
+    SDL_free(path);
+    return io;
+}
+
+static void run_job(int job, void* result_data) {
+    BatchResult result;
+    StateHash hash;
+    s32 pl;
+
+    SDL_zero(result);
+    options.replay_path = paths[job];
+
+    // Fail early, the Replay menu would fall back to the memory card
+    if (!Load_Replay_Stream()) {
+        result.status = BATCH_STATUS_LOAD_FAILED;
+        SDL_memcpy(result_data, &result, sizeof(result));
+        return;
+    }
+
+    Next_Title_Sub();
+
+    if (options.software_render) {
+        SDLSoftRenderer_ResetHash();
+    }
+
+    if (options.batch_frame_hash_dir != NULL) {
+        frame_hash_io = create_frame_hashes(job);
+
+        if (frame_hash_io == NULL) {
+            result.status = BATCH_STATUS_FRAMES_FAILED;
+            SDL_memcpy(result_data, &result, sizeof(result));
+            return;
+        }
+    }
+
+    if (options.batch_capture_dir != NULL) {
+        char* path = make_job_path(job, options.batch_capture_dir, "mkv");
+        const bool is_capturing = SDLApp_StartCapture(path);
+
+        SDL_free(path);
+
+        if (!is_capturing) {
+            if (frame_hash_io != NULL) {
+                SDL_CloseIO(frame_hash_io);
+                frame_hash_io = NULL;
+            }
+
+            result.status = BATCH_STATUS_CAPTURE_FAILED;
+            SDL_memcpy(result_data, &result, sizeof(result));
+            return;
+        }
+    }
+
+    if (!run_until(is_replay_menu, BOOT_FRAME_LIMIT, &result.frames) ||
+        !run_until(is_replay_over, MATCH_FRAME_LIMIT, &result.frames)) {
+        result.status = BATCH_STATUS_TIMED_OUT;
+    }
+
+    result.winner = Winner_id;
+    result.match_frames = Get_Match_Frame() + 1;
+    Calc_State_Hash(&hash);
+    result.state_hash = Get_State_Hash_Total(&hash);
+
+    if (options.software_render) {
+        result.image_hash = SDLSoftRenderer_GetHash();
+    }
+
+    if ((frame_hash_io != NULL) && !SDL_CloseIO(frame_hash_io) && (result.status == BATCH_STATUS_OK)) {
+        result.status = BATCH_STATUS_FRAMES_FAILED;
+    }
+
+    frame_hash_io = NULL;
+
+    if (options.batch_capture_dir != NULL) {
+        SDLApp_StopCapture();
+    }
+
+    for (pl = 0; pl < 2; pl++) {
+        result.wins[pl] = PL_Wins[pl];
+        result.grade[pl] = judge_item[pl][Play_Type];
+    }
+
+    SDL_memcpy(result_data, &result, sizeof(result));
+}
+
+static void write_header(SDL_IOStream* output) {
+    SDL_IOprintf(output, "replay,status,winner,p1_wins,p2_wins,match_frames,state_hash,image_hash");
+
+    for (s32 pl = 1; pl <= 2; pl++) {
+        SDL_IOprintf(output,
+                     ",p%d_max_combo,p%d_clean_hits,p%d_parries,p%d_red_parries,p%d_guard_parries,p%d_super_arts"
+                     ",p%d_guards,p%d_offence,p%d_defence",
+                     pl,
+                     pl,
+                     pl,
+                     pl,
+                     pl,
+                     pl,
+                     pl,
+                     pl,
+                     pl);
+    }
+
+    SDL_IOprintf(output, "\n");
+}
+
+static void write_result(SDL_IOStream* output, int job, const BatchResult* result) {
+    SDL_IOprintf(output,
+                 "\"%s\",%s,%d,%d,%d,%d,%016" SDL_PRIx64 ",%016" SDL_PRIx64,
+                 paths[job],
+                 status_names[result->status],
+                 result->winner,
+                 result->wins[0],
+                 result->wins[1],
+                 result->match_frames,
+                 result->state_hash,
+                 result->image_hash);
+
+    for (s32 pl = 0; pl < 2; pl++) {
+        const GradeData* grade = &result->grade[pl];
+
+        SDL_IOprintf(output,
+                     ",%d,%d,%d,%d,%d,%d,%d,%d,%d",
+                     grade->max_combo,
+                     grade->clean_hits,
+                     grade->nml_blocking,
+                     grade->rpd_blocking,
+                     grade->grd_blocking,
+                     grade->sa_exec,
+                     grade->guard_succ,
+                     grade->offence_total,
+                     grade->defence_total);
+    }
+
+    SDL_IOprintf(output, "\n");
+}
+
+static void on_result(int job, const void* result_data, void* user) {
+    BatchTotals* totals = user;
+    BatchResult result;
+
+    if (result_data != NULL) {
+        SDL_memcpy(&result, result_data, sizeof(result));
+    } else {
+        SDL_zero(result);
+        result.status = BATCH_STATUS_CRASHED;
+    }
+
+    totals->finished += 1;
+    totals->frames += result.frames;
+
+    if (result.status != BATCH_STATUS_OK) {
+        totals->failed += 1;
+        SDL_Log("Batch replay %s: %s", paths[job], status_names[result.status]);
+    }
+
+    if (totals->output != NULL) {
+        write_result(totals->output, job, &result);
+    }
+}
+
+s32 Run_Replay_Batch() {
+    BatchTotals totals;
+    s32 worker_count = options.batch_jobs;
+    s32 boot_frames = 0;
+    Uint64 start;
+    double seconds;
+
+    SDL_zero(totals);
+
+    if ((options.batch_frame_hash_dir != NULL) && !options.software_render) {
+        SDL_Log("--batch-frames needs --software-render, frames aren't drawn otherwise");
+        return 1;
+    }
+
+    if ((options.batch_capture_dir != NULL) && !options.software_render) {
+        SDL_Log("--batch-capture needs --software-render, frames aren't drawn otherwise");
+        return 1;
+    }
+
+    if (read_list(options.batch_list_path) == 0) {
+        return 1;
+    }
+
+    if (!run_until(is_attract_loop, BOOT_FRAME_LIMIT, &boot_frames)) {
+        SDL_Log("The game didn't boot within %d frames", BOOT_FRAME_LIMIT);
+        return 1;
+    }
+
+    if (!AFS_IsMapped()) {
+        SDL_Log("Batch runs need the game archive to be memory mapped");
+        return 1;
+    }
+
+    if (worker_count <= 0) {
+        worker_count = SDL_GetNumLogicalCPUCores();
+    }
+
+    if (options.batch_output_path != NULL) {
+        totals.output = SDL_IOFromFile(options.batch_output_path, "w");
+
+        if (totals.output == NULL) {
+            SDL_Log("Failed to create %s: %s", options.batch_output_path, SDL_GetError());
+            return 1;
+        }
+
+        write_header(totals.output);
+    }
+
+    start = SDL_GetPerformanceCounter();
+
+    if (!BatchRunner_Run(path_count, worker_count, sizeof(BatchResult), run_job, on_result, &totals)) {
+        if (totals.output != NULL) {
+            SDL_CloseIO(totals.output);
+        }
+
+        return 1;
+    }
+
+    seconds = (double)(SDL_GetPerformanceCounter() - start) / SDL_GetPerformanceFrequency();
+
+    // Compare runs with different --batch-jobs to see how this scales with cores
+    SDL_Log("Batch: %d replays (%d failed) with %d jobs in %.2f s, %.2f replays/s, %.0f frames/s (%.1fx real time)",
+            totals.finished,
+            totals.failed,
+            worker_count,
+            seconds,
+            totals.finished / seconds,
+            totals.frames / seconds,
+            totals.frames / seconds / GAME_FPS);
+
+    if (totals.output != NULL) {
+        SDL_CloseIO(totals.output);
+    }
+
+    return 0;
+}
@@ -0,0 +1,13 @@
+#ifndef REPLAY_BATCH_H
+#define REPLAY_BATCH_H
+
+#include "types.h"
+
+/// @brief Play every replay file listed in `--batch` headless, and write what happened in each to `--batch-output`.
+///
+/// The game is booted once, then each replay runs in a process forked from that state, several at a time.
+/// `Headless_Init` must have been called.
+/// @return `0` if the replays were run, `1` if the batch couldn't start.
+s32 Run_Replay_Batch();
+
+#endif
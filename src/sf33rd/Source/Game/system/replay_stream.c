@@ -0,0 +1,658 @@
+/**
+ * @file replay_stream.c
+ * Replay Files
+ *
+ * `Replay_w` only holds a few minutes of inputs. While a recording is streamed, its input buffers are written
+ * to the file whenever they fill up, together with a keyframe of the simulation state every few seconds.
+ * Playback pages the inputs back into `Replay_w`, and seeks by loading the nearest keyframe and running
+ * the frames after it without presenting them.
+ */
+
+#include "sf33rd/Source/Game/system/replay_stream.h"
+#include "common.h"
+#include "port/io/replay_file.h"
+#include "port/options.h"
+#include "sf33rd/Source/Game/debug/Debug.h"
+#include "sf33rd/Source/Game/engine/workuser.h"
+#include "sf33rd/Source/Game/main.h"
+#include "sf33rd/Source/Game/system/sim_state.h"
+#include "sf33rd/Source/Game/system/work_sys.h"
+#include "structs.h"
+
+#include <SDL3/SDL.h>
+
+#define REPLAY_BUFF_SIZE 7198
+#define REPLAY_INFO_SIZE 180
+#define REPLAY_PAD_WORD 0xF000
+#define FRAMES_PER_SECOND 60
+
+typedef enum StreamMode {
+    STREAM_NONE,
+    STREAM_RECORD,
+    STREAM_PLAY,
+} StreamMode;
+
+typedef struct {
+    void* adrs;
+    size_t size;
+} SessionVar;
+
+// Globals that belong to the playback session rather than to the recorded match.
+// They keep their values when a keyframe is loaded.
+static const SessionVar session_vars[] = {
+    { &Play_Mode, sizeof(Play_Mode) },
+    { Replay_Status, sizeof(Replay_Status) },
+    { &Mode_Type, sizeof(Mode_Type) },
+    { &Present_Mode, sizeof(Present_Mode) },
+    { &Play_Type, sizeof(Play_Type) },
+    { &Demo_Flag, sizeof(Demo_Flag) },
+    { Direction_Working, sizeof(Direction_Working) },
+    { Vital_Handicap, sizeof(Vital_Handicap) },
+    { save_w, sizeof(save_w) },
+    { system_dir, sizeof(system_dir) },
+    { Debug_w, sizeof(Debug_w) },
+    { &p1sw_buff, sizeof(p1sw_buff) },
+    { &p2sw_buff, sizeof(p2sw_buff) },
+    { &p3sw_buff, sizeof(p3sw_buff) },
+    { &p4sw_buff, sizeof(p4sw_buff) },
+    { task, sizeof(struct _TASK) * TASK_GAME },
+    { &task[TASK_SAVER], sizeof(task) - (sizeof(struct _TASK) * TASK_SAVER) },
+};
+
+#define SESSION_VAR_COUNT (sizeof(session_vars) / sizeof(SessionVar))
+
+static StreamMode stream_mode = STREAM_NONE;
+static ReplayWriter* writer = NULL;
+static ReplayReader* reader = NULL;
+static u8* state_buff = NULL;
+static size_t state_size = 0;
+static u8* session_buff = NULL;
+
+static u32 next_frame;
+static u32 current_frame;
+static u32 keyframe_interval;
+
+// Recording
+static u32 words_written[2];
+static s32 buff_written[2];
+
+// Playback
+static const u16* play_words[2];
+static u32 play_word_count[2];
+static u32 buff_next_word[2];
+static u32 frame_count;
+static bool keyframes_usable;
+static s32 seek_target = -1;
+static bool seek_pending = false;
+
+static void put_u8(u8** dst, u32 value) {
+    **dst = value & 0xFF;
+    *dst += 1;
+}
+
+static void put_u16(u8** dst, u32 value) {
+    (*dst)[0] = value & 0xFF;
+    (*dst)[1] = (value >> 8) & 0xFF;
+    *dst += 2;
+}
+
+static void put_bytes(u8** dst, const void* src, size_t size) {
+    SDL_memcpy(*dst, src, size);
+    *dst += size;
+}
+
+static u8 get_u8(const u8** src) {
+    const u8 value = **src;
+
+    *src += 1;
+    return value;
+}
+
+static u16 get_u16(const u8** src) {
+    const u16 value = (*src)[0] | ((*src)[1] << 8);
+
+    *src += 2;
+    return value;
+}
+
+static void get_bytes(const u8** src, void* dst, size_t size) {
+    SDL_memcpy(dst, *src, size);
+    *src += size;
+}
+
+/// @brief Serialize the match setup, the same fields that the memory card keeps in `Replay_w`.
+static void pack_info(u8* info) {
+    const struct _REP_GAME_INFOR* rp = &Rep_Game_Infor[10];
+    const struct _SAVE_W* sw = &save_w[Present_Mode];
+    u8* ptr = info;
+    s16 ix;
+
+    for (ix = 0; ix < 2; ix++) {
+        put_u8(&ptr, rp->player_infor[ix].my_char);
+        put_u8(&ptr, rp->player_infor[ix].sa);
+        put_u8(&ptr, rp->player_infor[ix].color);
+        put_u8(&ptr, rp->player_infor[ix].player_type);
+    }
+
+    put_u8(&ptr, rp->stage);
+    put_u8(&ptr, rp->Direction_Working);
+    put_u8(&ptr, rp->Vital_Handicap[0]);
+    put_u8(&ptr, rp->Vital_Handicap[1]);
+    put_u16(&ptr, rp->Random_ix16);
+    put_u16(&ptr, rp->Random_ix32);
+    put_u16(&ptr, rp->Random_ix16_ex);
+    put_u16(&ptr, rp->Random_ix32_ex);
+    put_u16(&ptr, rp->players_timer);
+    put_u16(&ptr, rp->old_mes_no2);
+    put_u16(&ptr, rp->old_mes_no3);
+    put_u16(&ptr, rp->old_mes_no_pl);
+    put_u16(&ptr, rp->mes_already);
+    put_u8(&ptr, Champion);
+    put_u16(&ptr, Control_Time);
+    put_u8(&ptr, sw->Difficulty);
+    put_bytes(&ptr, Replay_w.lag, sizeof(Replay_w.lag));
+    put_bytes(&ptr, sw->Pad_Infor, sizeof(sw->Pad_Infor));
+    put_u8(&ptr, sw->Time_Limit);
+    put_u8(&ptr, sw->Battle_Number[0]);
+    put_u8(&ptr, sw->Battle_Number[1]);
+    put_u8(&ptr, sw->Damage_Level);
+    put_bytes(&ptr, &sw->extra_option, sizeof(sw->extra_option));
+    put_bytes(&ptr, system_dir[Present_Mode].contents, sizeof(system_dir[Present_Mode].contents));
+    put_u16(&ptr, system_dir[Present_Mode].sum);
+}
+
+static void unpack_info(const u8* info) {
+    struct _REP_GAME_INFOR* rp = &Replay_w.game_infor;
+    struct _MINI_SAVE_W* msw = &Replay_w.mini_save_w;
+    const u8* ptr = info;
+    s16 ix;
+
+    for (ix = 0; ix < 2; ix++) {
+        rp->player_infor[ix].my_char = get_u8(&ptr);
+        rp->player_infor[ix].sa = get_u8(&ptr);
+        rp->player_infor[ix].color = get_u8(&ptr);
+        rp->player_infor[ix].player_type = get_u8(&ptr);
+    }
+
+    rp->stage = get_u8(&ptr);
+    rp->Direction_Working = get_u8(&ptr);
+    rp->Vital_Handicap[0] = get_u8(&ptr);
+    rp->Vital_Handicap[1] = get_u8(&ptr);
+    rp->Random_ix16 = get_u16(&ptr);
+    rp->Random_ix32 = get_u16(&ptr);
+    rp->Random_ix16_ex = get_u16(&ptr);
+    rp->Random_ix32_ex = get_u16(&ptr);
+    rp->players_timer = get_u16(&ptr);
+    rp->old_mes_no2 = get_u16(&ptr);
+    rp->old_mes_no3 = get_u16(&ptr);
+    rp->old_mes_no_pl = get_u16(&ptr);
+    rp->mes_already = get_u16(&ptr);
+    Replay_w.champion = get_u8(&ptr);
+    Replay_w.Control_Time_Buff = get_u16(&ptr);
+    Replay_w.Difficulty = get_u8(&ptr);
+    get_bytes(&ptr, Replay_w.lag, sizeof(Replay_w.lag));
+    get_bytes(&ptr, msw->Pad_Infor, sizeof(msw->Pad_Infor));
+    msw->Time_Limit = get_u8(&ptr);
+    msw->Battle_Number[0] = get_u8(&ptr);
+    msw->Battle_Number[1] = get_u8(&ptr);
+    msw->Damage_Level = get_u8(&ptr);
+    get_bytes(&ptr, &msw->extra_option, sizeof(msw->extra_option));
+    get_bytes(&ptr, Replay_w.system_dir.contents, sizeof(Replay_w.system_dir.contents));
+    Replay_w.system_dir.sum = get_u16(&ptr);
+}
+
+static void alloc_state_buff() {
+    size_t session_size = 0;
+    s32 ix;
+
+    if (state_buff != NULL) {
+        return;
+    }
+
+    for (ix = 0; ix < SESSION_VAR_COUNT; ix++) {
+        session_size += session_vars[ix].size;
+    }
+
+    state_size = Get_Sim_State_Size();
+    state_buff = SDL_malloc(state_size);
+    session_buff = SDL_malloc(session_size);
+}
+
+// Recording
+
+/// @brief Name a new replay file after the current time. Matches started within the same millisecond, in this
+/// process or another one, get a counter added so that they don't overwrite each other.
+static void make_replay_path(char* path, size_t path_size) {
+    SDL_Time now;
+    SDL_DateTime date;
+    size_t len;
+    s32 ix;
+
+    SDL_GetCurrentTime(&now);
+    SDL_TimeToDateTime(now, &date, true);
+    len = SDL_snprintf(path,
+                       path_size,
+                       "%s/%04d%02d%02d-%02d%02d%02d-%03d",
+                       options.record_replay_dir,
+                       date.year,
+                       date.month,
+                       date.day,
+                       date.hour,
+                       date.minute,
+                       date.second,
+                       date.nanosecond / 1000000);
+
+    for (ix = 0; ix < 100; ix++) {
+        if (ix == 0) {
+            SDL_snprintf(path + len, path_size - len, ".3sxr");
+        } else {
+            SDL_snprintf(path + len, path_size - len, "-%d.3sxr", ix);
+        }
+
+        if (!SDL_GetPathInfo(path, NULL)) {
+            return;
+        }
+    }
+}
+
+static void start_recording() {
+    u8 info[REPLAY_INFO_SIZE];
+    char path[1024];
+
+    if ((options.record_replay_dir == NULL) || ((Mode_Type != MODE_VERSUS) && (Mode_Type != MODE_NETWORK))) {
+        return;
+    }
+
+    SDL_CreateDirectory(options.record_replay_dir);
+    make_replay_path(path, sizeof(path));
+    pack_info(info);
+    writer = ReplayWriter_Create(path, info, sizeof(info), Get_Sim_State_Layout());
+
+    if (writer == NULL) {
+        return;
+    }
+
+    alloc_state_buff();
+    stream_mode = STREAM_RECORD;
+    next_frame = 0;
+    keyframe_interval = SDL_max(options.replay_keyframe_seconds, 1) * FRAMES_PER_SECOND;
+    words_written[0] = words_written[1] = 0;
+    buff_written[0] = buff_written[1] = 0;
+}
+
+/// @brief Write the inputs that were added to `Replay_w` since the last write.
+static void write_inputs(s16 PL_id) {
+    const u16* buff = Replay_w.io_unit.key_buff[PL_id];
+    const s32 count = Demo_Ptr[PL_id] - &buff[buff_written[PL_id]];
+
+    ReplayWriter_WriteInputs(writer, PL_id, &buff[buff_written[PL_id]], count);
+    buff_written[PL_id] += count;
+    words_written[PL_id] += count;
+}
+
+static void write_keyframe() {
+    ReplayInputPos inputs[REPLAY_PLAYERS];
+    s16 PL_id;
+
+    for (PL_id = 0; PL_id < 2; PL_id++) {
+        write_inputs(PL_id);
+        inputs[PL_id].position = words_written[PL_id];
+
+        // The run that Get_Replay is still extending is only written once it ends
+        if (Condense_Buff[PL_id] == 0xFFFF) {
+            inputs[PL_id].timer = 0;
+            inputs[PL_id].value = 0;
+        } else {
+            inputs[PL_id].timer = Demo_Timer[PL_id];
+            inputs[PL_id].value = Condense_Buff[PL_id] & 0xFFF;
+        }
+    }
+
+    Save_Sim_State(state_buff);
+    ReplayWriter_WriteKeyframe(writer, next_frame, inputs, state_buff, state_size);
+}
+
+static void finish_recording() {
+    u16 word;
+    s16 PL_id;
+
+    for (PL_id = 0; PL_id < 2; PL_id++) {
+        write_inputs(PL_id);
+
+        if (Condense_Buff[PL_id] != 0xFFFF) {
+            word = ((Demo_Timer[PL_id] - 1) << 12) | (Condense_Buff[PL_id] & 0xFFF);
+            ReplayWriter_WriteInputs(writer, PL_id, &word, 1);
+        }
+    }
+
+    ReplayWriter_Close(writer, next_frame);
+    writer = NULL;
+    stream_mode = STREAM_NONE;
+}
+
+static void record_frame() {
+    if ((Play_Mode != 1) || !Demo_Flag) {
+        finish_recording();
+        return;
+    }
+
+    if (Game_pause == 0x81) {
+        return;
+    }
+
+    if ((next_frame % keyframe_interval) == 0) {
+        write_keyframe();
+    }
+
+    next_frame += 1;
+}
+
+s32 Flush_Replay_Buff(s16 PL_id) {
+    if (stream_mode != STREAM_RECORD) {
+        return 0;
+    }
+
+    write_inputs(PL_id);
+    Demo_Ptr[PL_id] = Replay_w.io_unit.key_buff[PL_id];
+    buff_written[PL_id] = 0;
+    return 1;
+}
+
+// Playback
+
+/// @brief Count the frames of a recording that was cut short before its index was written.
+static u32 count_frames() {
+    u32 frames = 0;
+    u32 player_frames;
+    u32 ix;
+    s16 PL_id;
+    bool found = false;
+
+    for (PL_id = 0; PL_id < 2; PL_id++) {
+        if (play_word_count[PL_id] == 0) {
+            continue;
+        }
+
+        player_frames = 0;
+
+        for (ix = 0; ix < play_word_count[PL_id]; ix++) {
+            player_frames += (play_words[PL_id][ix] >> 12) + 1;
+        }
+
+        frames = found ? SDL_min(frames, player_frames) : player_frames;
+        found = true;
+    }
+
+    return frames;
+}
+
+static void fill_replay_buff(s16 PL_id, u32 position) {
+    u16* buff = Replay_w.io_unit.key_buff[PL_id];
+    u32 ix;
+
+    for (ix = 0; ix < REPLAY_BUFF_SIZE; ix++) {
+        if ((position + ix) < play_word_count[PL_id]) {
+            buff[ix] = play_words[PL_id][position + ix];
+        } else {
+            buff[ix] = REPLAY_PAD_WORD;
+        }
+    }
+
+    buff_next_word[PL_id] = position + REPLAY_BUFF_SIZE;
+    Demo_Ptr[PL_id] = buff;
+}
+
+static void start_playback() {
+    const u32 layout = ReplayReader_GetStateLayout(reader);
+    s16 PL_id;
+
+    for (PL_id = 0; PL_id < 2; PL_id++) {
+        play_word_count[PL_id] = ReplayReader_GetInputs(reader, PL_id, &play_words[PL_id]);
+        fill_replay_buff(PL_id, 0);
+    }
+
+    frame_count = ReplayReader_GetFrameCount(reader);
+
+    if (frame_count == 0) {
+        frame_count = count_frames();
+    }
+
+    keyframes_usable = (layout == Get_Sim_State_Layout());
+
+    if (!keyframes_usable) {
+        SDL_Log("Replay keyframes were written by a different build, seeking back is disabled");
+    }
+
+    alloc_state_buff();
+    stream_mode = STREAM_PLAY;
+    next_frame = 0;
+    current_frame = 0;
+
+    if (options.replay_seek_seconds > 0) {
+        seek_target = options.replay_seek_seconds * FRAMES_PER_SECOND;
+        seek_pending = true;
+    }
+}
+
+static void seek_inputs(s16 PL_id, const ReplayInputPos* pos) {
+    u16 word;
+    s32 length;
+
+    if (pos->timer == 0) {
+        Demo_Timer[PL_id] = 0;
+        fill_replay_buff(PL_id, pos->position);
+        return;
+    }
+
+    // The keyframe was taken in the middle of a run, so only the rest of it is left to play
+    if (pos->position < play_word_count[PL_id]) {
+        word = play_words[PL_id][pos->position];
+    } else {
+        word = REPLAY_PAD_WORD;
+    }
+
+    length = (word >> 12) + 1;
+    Condense_Buff[PL_id] = pos->value;
+    Demo_Timer[PL_id] = SDL_max(length - pos->timer, 0);
+    fill_replay_buff(PL_id, pos->position + 1);
+}
+
+static bool load_keyframe(s32 index) {
+    ReplayInputPos inputs[REPLAY_PLAYERS];
+    u32 frame;
+    u8* ptr;
+    s32 ix;
+    s16 PL_id;
+
+    if (!ReplayReader_LoadKeyframe(reader, index, &frame, inputs, state_buff, state_size)) {
+        SDL_Log("Replay keyframe %d is damaged", index);
+        return false;
+    }
+
+    for (ptr = session_buff, ix = 0; ix < SESSION_VAR_COUNT; ix++) {
+        SDL_memcpy(ptr, session_vars[ix].adrs, session_vars[ix].size);
+        ptr += session_vars[ix].size;
+    }
+
+    Load_Sim_State(state_buff);
+
+    for (ptr = session_buff, ix = 0; ix < SESSION_VAR_COUNT; ix++) {
+        SDL_memcpy(session_vars[ix].adrs, ptr, session_vars[ix].size);
+        ptr += session_vars[ix].size;
+    }
+
+    for (PL_id = 0; PL_id < 2; PL_id++) {
+        seek_inputs(PL_id, &inputs[PL_id]);
+    }
+
+    next_frame = frame;
+    return true;
+}
+
+static void start_seek() {
+    s32 index = -1;
+
+    seek_pending = false;
+
+    if ((frame_count > 0) && ((u32)seek_target >= frame_count)) {
+        seek_target = frame_count - 1;
+    }
+
+    if (keyframes_usable) {
+        index = ReplayReader_FindKeyframe(reader, seek_target);
+    }
+
+    // Load a keyframe when it is closer to the target than the current frame
+    if ((index >= 0) &&
+        (((u32)seek_target < next_frame) || (ReplayReader_GetKeyframeFrame(reader, index) > next_frame))) {
+        if (load_keyframe(index)) {
+            return;
+        }
+    }
+
+    // Without a keyframe the only way is forward
+    if ((u32)seek_target < next_frame) {
+        seek_target = -1;
+    }
+}
+
+static void play_frame() {
+    if ((Play_Mode != 3) || !Demo_Flag) {
+        stream_mode = STREAM_NONE;
+        seek_target = -1;
+        seek_pending = false;
+        return;
+    }
+
+    if (Game_pause == 0x81) {
+        return;
+    }
+
+    if (seek_pending) {
+        start_seek();
+    }
+
+    current_frame = next_frame;
+    next_frame += 1;
+
+    if ((seek_target >= 0) && (next_frame >= (u32)seek_target)) {
+        seek_target = -1;
+    }
+}
+
+void Refill_Replay_Buff(s16 PL_id) {
+    if ((stream_mode != STREAM_PLAY) || (Demo_Timer[PL_id] != 0) ||
+        (Demo_Ptr[PL_id] < &Replay_w.io_unit.key_buff[PL_id][REPLAY_BUFF_SIZE])) {
+        return;
+    }
+
+    fill_replay_buff(PL_id, buff_next_word[PL_id]);
+}
+
+s32 Replay_Stream_Ended() {
+    return (stream_mode == STREAM_PLAY) && (current_frame >= frame_count);
+}
+
+s32 Load_Replay_Stream() {
+    const void* info;
+    size_t info_size;
+
+    if (options.replay_path == NULL) {
+        return 0;
+    }
+
+    if (reader == NULL) {
+        reader = ReplayReader_Open(options.replay_path);
+
+        if (reader == NULL) {
+            return 0;
+        }
+    }
+
+    info = ReplayReader_GetInfo(reader, &info_size);
+
+    if (info_size != REPLAY_INFO_SIZE) {
+        SDL_Log("Replay file %s has an unknown match setup", options.replay_path);
+        ReplayReader_Close(reader);
+        reader = NULL;
+        return 0;
+    }
+
+    SDL_zero(Replay_w);
+    unpack_info(info);
+    return 1;
+}
+
+void Seek_Replay_Stream(s32 frames) {
+    s32 target;
+
+    if ((stream_mode != STREAM_PLAY) || (Replay_Status[0] != 3) || (Game_pause == 0x81)) {
+        return;
+    }
+
+    target = ((seek_target >= 0) ? seek_target : (s32)next_frame) + frames;
+    seek_target = SDL_max(target, 0);
+    seek_pending = true;
+}
+
+s32 Is_Replay_Seeking() {
+    if ((stream_mode != STREAM_PLAY) || (seek_target < 0) || (Game_pause == 0x81)) {
+        return 0;
+    }
+
+    return seek_pending || ((next_frame < (u32)seek_target) && (next_frame < frame_count));
+}
+
+// Stream
+
+void Start_Replay_Stream() {
+    if (stream_mode == STREAM_RECORD) {
+        finish_recording();
+    }
+
+    stream_mode = STREAM_NONE;
+    seek_target = -1;
+    seek_pending = false;
+
+    switch (Play_Mode) {
+    case 1:
+        start_recording();
+        break;
+
+    case 3:
+        if ((reader != NULL) && (Mode_Type == MODE_REPLAY)) {
+            start_playback();
+        }
+
+        break;
+    }
+}
+
+void Replay_Stream_Frame() {
+    switch (stream_mode) {
+    case STREAM_RECORD:
+        record_frame();
+        break;
+
+    case STREAM_PLAY:
+        play_frame();
+        break;
+
+    default:
+        break;
+    }
+}
+
+void Close_Replay_Stream() {
+    if (stream_mode == STREAM_RECORD) {
+        finish_recording();
+    }
+
+    stream_mode = STREAM_NONE;
+    ReplayReader_Close(reader);
+    reader = NULL;
+    SDL_free(state_buff);
+    SDL_free(session_buff);
+    state_buff = NULL;
+    session_buff = NULL;
+}
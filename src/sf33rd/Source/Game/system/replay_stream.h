@@ -0,0 +1,39 @@
+#ifndef REPLAY_STREAM_H
+#define REPLAY_STREAM_H
+
+#include "types.h"
+
+/// @brief Start streaming the replay that `Check_Replay` just set up.
+/// Versus and network matches are recorded to `--record-replays`, and playback reads the file loaded by
+/// `Load_Replay_Stream`.
+void Start_Replay_Stream();
+
+/// @brief Advance the stream by one frame. Called before the replay inputs of a frame are recorded or played.
+void Replay_Stream_Frame();
+
+/// @brief Finish the recording in progress, if any.
+void Close_Replay_Stream();
+
+/// @brief Write a full replay input buffer to the recording.
+/// @return `1` if the buffer was written and can be reused, `0` if no recording is in progress.
+s32 Flush_Replay_Buff(s16 PL_id);
+
+/// @brief Load the next inputs of a player into the replay input buffer when playback reaches its end.
+void Refill_Replay_Buff(s16 PL_id);
+
+/// @brief Check if playback from a file has run out of recorded frames.
+s32 Replay_Stream_Ended();
+
+/// @brief Load `--replay` into `Replay_w` for the Replay menu.
+/// @return `1` if a replay file was loaded, `0` to use the memory card.
+s32 Load_Replay_Stream();
+
+/// @brief Jump forward or back during playback from a file.
+/// @param frames Offset from the current frame.
+void Seek_Replay_Stream(s32 frames);
+
+/// @brief Check if playback is running frames to reach a seek target.
+/// These frames are simulated but not presented.
+s32 Is_Replay_Seeking();
+
+#endif
@@ -0,0 +1,395 @@
+/**
+ * @file sim_state.c
+ * Snapshots of the Simulation State
+ */
+
+#include "sf33rd/Source/Game/system/sim_state.h"
+#include "common.h"
+#include "sf33rd/AcrSDK/ps2/foundaps2.h"
+#include "sf33rd/Source/Game/count.h"
+#include "sf33rd/Source/Game/debug/Debug.h"
+#include "sf33rd/Source/Game/effect/effect.h"
+#include "sf33rd/Source/Game/engine/cmb_win.h"
+#include "sf33rd/Source/Game/engine/cmd_data.h"
+#include "sf33rd/Source/Game/engine/grade.h"
+#include "sf33rd/Source/Game/engine/hitcheck.h"
+#include "sf33rd/Source/Game/engine/plcnt.h"
+#include "sf33rd/Source/Game/engine/spgauge.h"
+#include "sf33rd/Source/Game/engine/stun.h"
+#include "sf33rd/Source/Game/engine/vital.h"
+#include "sf33rd/Source/Game/engine/workuser.h"
+#include "sf33rd/Source/Game/io/ioconv.h"
+#include "sf33rd/Source/Game/sc_sub.h"
+#include "sf33rd/Source/Game/stage/bg.h"
+#include "sf33rd/Source/Game/system/sim_state_vars.h"
+#include "sf33rd/Source/Game/system/work_sys.h"
+#include "structs.h"
+
+#include <SDL3/SDL.h>
+#include <memory.h>
+#include <stddef.h>
+
+// The game's own statics, constant tables and code are well within this distance of each other
+#define IMAGE_SPAN ((uintptr_t)256 * 1024 * 1024)
+
+// Pointers in snapshots are tagged with the base they are an offset from. Untagged ones are stored as they are,
+// which user space addresses never clash with.
+#define POINTER_RELOCATED ((uintptr_t)1 << (sizeof(uintptr_t) * 8 - 1))
+#define POINTER_IN_IMAGE ((uintptr_t)1 << (sizeof(uintptr_t) * 8 - 2))
+
+// frw is stored as WORK_Other, with the rest of each slot as raw bytes. The effects that use a bigger struct have to
+// keep their pointers where WORK_Other has them, and tools/gen_sim_state.py checks that they have none past it.
+_Static_assert(offsetof(WORK_Other_CONN, my_master) == offsetof(WORK_Other, my_master), "frw pointer moved");
+_Static_assert(offsetof(WORK_Other_JUDGE, my_master) == offsetof(WORK_Other, my_master), "frw pointer moved");
+
+typedef struct {
+    const char* name;
+    size_t offset;
+    size_t size;
+    size_t elem_size;
+    SimStateKind kind;
+    s32 type;
+    s32 dims[2];
+} SimStateField;
+
+typedef struct {
+    const char* name;
+    size_t size;
+    const SimStateField* fields;
+    s32 field_count;
+} SimStateType;
+
+typedef struct {
+    const char* module;
+    const char* name;
+    void* adrs;
+    size_t size;
+    size_t elem_size;
+    SimStateKind kind;
+    s32 type;
+    s32 dims[2];
+} SimStateVar;
+
+enum {
+    SIM_STATE_TYPE_NONE = -1,
+#define SIM_STATE_TYPE(id, type) SIM_STATE_TYPE_##id,
+#define SIM_STATE_FIELD(id, type, name, elem, kind, sub, d1, d2)
+#define SIM_STATE_TYPE_END(id)
+#include "sf33rd/Source/Game/system/sim_state_types.inc"
+#undef SIM_STATE_TYPE
+#undef SIM_STATE_FIELD
+#undef SIM_STATE_TYPE_END
+};
+
+#define SIM_STATE_TYPE(id, type) static const SimStateField id##_fields[] = {
+#define SIM_STATE_FIELD(id, type, name, elem, kind, sub, d1, d2)                                                      \
+    { #name,                                                                                                           \
+      offsetof(type, name),                                                                                            \
+      sizeof(((type*)0)->name),                                                                                        \
+      sizeof(((type*)0)->elem),                                                                                        \
+      SIM_KIND_##kind,                                                                                                 \
+      SIM_STATE_TYPE_##sub,                                                                                            \
+      { d1, d2 } },
+#define SIM_STATE_TYPE_END(id) };
+#include "sf33rd/Source/Game/system/sim_state_types.inc"
+#undef SIM_STATE_TYPE
+#undef SIM_STATE_FIELD
+#undef SIM_STATE_TYPE_END
+
+static const SimStateType sim_state_types[] = {
+#define SIM_STATE_TYPE(id, type) { #id, sizeof(type), id##_fields, SDL_arraysize(id##_fields) },
+#define SIM_STATE_FIELD(id, type, name, elem, kind, sub, d1, d2)
+#define SIM_STATE_TYPE_END(id)
+#include "sf33rd/Source/Game/system/sim_state_types.inc"
+#undef SIM_STATE_TYPE
+#undef SIM_STATE_FIELD
+#undef SIM_STATE_TYPE_END
+};
+
+static const SimStateVar sim_state_vars[] = {
+#define SIM_STATE_VAR(module, name, elem, kind, type, d1, d2)                                                         \
+    { #module, #name, (void*)&name, sizeof(name), sizeof(elem), SIM_KIND_##kind, SIM_STATE_TYPE_##type, { d1, d2 } },
+#include "sf33rd/Source/Game/system/sim_state_vars.inc"
+#undef SIM_STATE_VAR
+};
+
+#define SIM_STATE_VAR_COUNT (sizeof(sim_state_vars) / sizeof(SimStateVar))
+
+typedef struct {
+    size_t offset; // Offset in a snapshot
+    void* adrs;
+} PointerSlot;
+
+static const s32 no_dims[2] = { 0, 0 };
+
+static SimStateLeaf* leaves = NULL;
+static s32 leaf_count = 0;
+static s32 leaf_capacity = 0;
+
+static PointerSlot* pointer_slots = NULL;
+static s32 pointer_slot_count = 0;
+
+void Get_Sim_State_Bases(SimStateBases* bases) {
+    // The arena is the only heap that game state points into
+    bases->arena_start = (uintptr_t)flFMS.baseandcap[0];
+    bases->arena_size = (uintptr_t)flFMS.baseandcap[1] - bases->arena_start;
+    bases->image_start = (uintptr_t)&gs - IMAGE_SPAN;
+    bases->image_size = IMAGE_SPAN * 2;
+}
+
+static uintptr_t pack_pointer(const SimStateBases* bases, uintptr_t value) {
+    if ((value - bases->arena_start) < bases->arena_size) {
+        return POINTER_RELOCATED | (value - bases->arena_start);
+    }
+
+    if ((value - bases->image_start) < bases->image_size) {
+        return POINTER_RELOCATED | POINTER_IN_IMAGE | (value - bases->image_start);
+    }
+
+    return value;
+}
+
+static uintptr_t unpack_pointer(const SimStateBases* bases, uintptr_t value) {
+    if (!(value & POINTER_RELOCATED)) {
+        return value;
+    }
+
+    if (value & POINTER_IN_IMAGE) {
+        return bases->image_start + (value & ~(POINTER_RELOCATED | POINTER_IN_IMAGE));
+    }
+
+    return bases->arena_start + (value & ~POINTER_RELOCATED);
+}
+
+/// @brief Find every pointer leaf in a snapshot. Leaves come in the order of the globals they belong to.
+static void find_pointer_slots() {
+    const SimStateLeaf* list;
+    const SimStateLeaf* leaf;
+    size_t var_offset = 0;
+    s32 capacity = 0;
+    s32 count;
+    s32 var = 0;
+    s32 i;
+    size_t j;
+
+    list = Get_Sim_State_Leaves(&count);
+
+    for (i = 0; i < count; i++) {
+        leaf = &list[i];
+
+        while ((u8*)leaf->adrs >= (u8*)sim_state_vars[var].adrs + sim_state_vars[var].size) {
+            var_offset += sim_state_vars[var].size;
+            var += 1;
+        }
+
+        if (leaf->kind != SIM_KIND_PTR) {
+            continue;
+        }
+
+        for (j = 0; j < leaf->size; j += leaf->elem_size) {
+            if (pointer_slot_count == capacity) {
+                capacity = (capacity == 0) ? 1024 : (capacity * 2);
+                pointer_slots = SDL_realloc(pointer_slots, sizeof(PointerSlot) * capacity);
+            }
+
+            pointer_slots[pointer_slot_count].offset =
+                var_offset + ((u8*)leaf->adrs - (u8*)sim_state_vars[var].adrs) + j;
+            pointer_slots[pointer_slot_count].adrs = (u8*)leaf->adrs + j;
+            pointer_slot_count += 1;
+        }
+    }
+}
+
+size_t Get_Sim_State_Size() {
+    size_t size = 0;
+    s32 i;
+
+    for (i = 0; i < SIM_STATE_VAR_COUNT; i++) {
+        size += sim_state_vars[i].size;
+    }
+
+    return size;
+}
+
+u32 Get_Sim_State_Layout() {
+    SimStateBases bases;
+    uintptr_t anchors[3];
+    u32 hash = 0x811C9DC5;
+    const char* c;
+    s32 i;
+
+    // FNV-1a over every name and size
+    for (i = 0; i < SIM_STATE_VAR_COUNT; i++) {
+        for (c = sim_state_vars[i].name; *c != '\0'; c++) {
+            hash = (hash ^ (u8)*c) * 0x01000193;
+        }
+
+        hash = (hash ^ (u32)sim_state_vars[i].size) * 0x01000193;
+    }
+
+    // Build id. Any change to the code, the constant tables or the statics moves at least one of them.
+    Get_Sim_State_Bases(&bases);
+    anchors[0] = (uintptr_t)&Get_Sim_State_Layout - bases.image_start;
+    anchors[1] = (uintptr_t)sim_state_types - bases.image_start;
+    anchors[2] = (uintptr_t)&leaf_count - bases.image_start;
+
+    for (i = 0; i < SDL_arraysize(anchors); i++) {
+        hash = (hash ^ (u32)anchors[i]) * 0x01000193;
+    }
+
+    return hash;
+}
+
+void Save_Sim_State(void* dst) {
+    SimStateBases bases;
+    uintptr_t value;
+    u8* ptr = dst;
+    s32 i;
+
+    if (pointer_slots == NULL) {
+        find_pointer_slots();
+    }
+
+    for (i = 0; i < SIM_STATE_VAR_COUNT; i++) {
+        memcpy(ptr, sim_state_vars[i].adrs, sim_state_vars[i].size);
+        ptr += sim_state_vars[i].size;
+    }
+
+    Get_Sim_State_Bases(&bases);
+
+    for (i = 0; i < pointer_slot_count; i++) {
+        memcpy(&value, (u8*)dst + pointer_slots[i].offset, sizeof(value));
+        value = pack_pointer(&bases, value);
+        memcpy((u8*)dst + pointer_slots[i].offset, &value, sizeof(value));
+    }
+}
+
+void Load_Sim_State(const void* src) {
+    SimStateBases bases;
+    uintptr_t value;
+    const u8* ptr = src;
+    s32 i;
+
+    if (pointer_slots == NULL) {
+        find_pointer_slots();
+    }
+
+    for (i = 0; i < SIM_STATE_VAR_COUNT; i++) {
+        memcpy(sim_state_vars[i].adrs, ptr, sim_state_vars[i].size);
+        ptr += sim_state_vars[i].size;
+    }
+
+    Get_Sim_State_Bases(&bases);
+
+    for (i = 0; i < pointer_slot_count; i++) {
+        memcpy(&value, (const u8*)src + pointer_slots[i].offset, sizeof(value));
+        value = unpack_pointer(&bases, value);
+        memcpy(pointer_slots[i].adrs, &value, sizeof(value));
+    }
+}
+
+static void add_leaf(const char* path, void* adrs, size_t size, size_t elem_size, SimStateKind kind, const s32* dims) {
+    SimStateLeaf* leaf;
+
+    if (leaf_count == leaf_capacity) {
+        leaf_capacity = (leaf_capacity == 0) ? 1024 : (leaf_capacity * 2);
+        leaves = SDL_realloc(leaves, sizeof(SimStateLeaf) * leaf_capacity);
+    }
+
+    leaf = &leaves[leaf_count];
+    leaf->path = SDL_strdup(path);
+    leaf->adrs = adrs;
+    leaf->size = size;
+    leaf->elem_size = elem_size;
+    leaf->kind = kind;
+    leaf->dims[0] = dims[0];
+    leaf->dims[1] = dims[1];
+    leaf_count += 1;
+}
+
+static size_t append_index(char* path, size_t len, size_t path_size, size_t index, const s32* dims) {
+    if (dims[1] != 0) {
+        return len + SDL_snprintf(path + len,
+                                  path_size - len,
+                                  "[%zu][%zu][%zu]",
+                                  index / (dims[0] * dims[1]),
+                                  (index / dims[1]) % dims[0],
+                                  index % dims[1]);
+    }
+
+    if (dims[0] != 0) {
+        return len + SDL_snprintf(path + len, path_size - len, "[%zu][%zu]", index / dims[0], index % dims[0]);
+    }
+
+    return len + SDL_snprintf(path + len, path_size - len, "[%zu]", index);
+}
+
+static void add_entry(char* path, size_t len, size_t path_size, u8* adrs, size_t size, size_t elem_size,
+                      SimStateKind kind, s32 type, const s32* dims) {
+    const SimStateType* st;
+    const SimStateField* field;
+    size_t rest_size;
+    size_t elem_len;
+    size_t field_len;
+    size_t i;
+    s32 j;
+
+    if (kind != SIM_KIND_STRUCT) {
+        add_leaf(path, adrs, size, elem_size, kind, dims);
+        return;
+    }
+
+    st = &sim_state_types[type];
+
+    for (i = 0; i < (size / elem_size); i++) {
+        elem_len = (size != elem_size) ? append_index(path, len, path_size, i, dims) : len;
+
+        for (j = 0; j < st->field_count; j++) {
+            field = &st->fields[j];
+            field_len = elem_len + SDL_snprintf(path + elem_len, path_size - elem_len, ".%s", field->name);
+            add_entry(path,
+                      field_len,
+                      path_size,
+                      adrs + (i * elem_size) + field->offset,
+                      field->size,
+                      field->elem_size,
+                      field->kind,
+                      field->type,
+                      field->dims);
+        }
+
+        // Storage that is viewed as a smaller struct, like frw
+        if (elem_size > st->size) {
+            rest_size = elem_size - st->size;
+            SDL_snprintf(path + elem_len, path_size - elem_len, ".(rest)");
+            add_leaf(path, adrs + (i * elem_size) + st->size, rest_size, rest_size, SIM_KIND_RAW, no_dims);
+        }
+
+        path[len] = '\0';
+    }
+}
+
+const SimStateLeaf* Get_Sim_State_Leaves(s32* count) {
+    char path[256];
+    const SimStateVar* var;
+    s32 i;
+
+    if (leaves == NULL) {
+        for (i = 0; i < SIM_STATE_VAR_COUNT; i++) {
+            var = &sim_state_vars[i];
+            SDL_strlcpy(path, var->name, sizeof(path));
+            add_entry(path,
+                      SDL_strlen(path),
+                      sizeof(path),
+                      var->adrs,
+                      var->size,
+                      var->elem_size,
+                      var->kind,
+                      var->type,
+                      var->dims);
+        }
+    }
+
+    *count = leaf_count;
+    return leaves;
+}
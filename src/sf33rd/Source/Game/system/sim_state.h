@@ -0,0 +1,69 @@
+#ifndef SIM_STATE_H
+#define SIM_STATE_H
+
+#include "types.h"
+
+#include <stddef.h>
+#include <stdint.h>
+
+typedef enum SimStateKind {
+    SIM_KIND_S8,
+    SIM_KIND_U8,
+    SIM_KIND_S16,
+    SIM_KIND_U16,
+    SIM_KIND_S32,
+    SIM_KIND_U32,
+    SIM_KIND_S64,
+    SIM_KIND_U64,
+    SIM_KIND_F32,
+    SIM_KIND_F64,
+    SIM_KIND_BOOL,
+    SIM_KIND_PTR,
+    SIM_KIND_RAW, // Unions, enums and anything else that is compared byte by byte
+    SIM_KIND_STRUCT,
+} SimStateKind;
+
+/// @brief A field of the simulation state that is not a struct, like `gs.plw[1].wu.routine_no`.
+typedef struct SimStateLeaf {
+    const char* path;
+    void* adrs;
+    size_t size;      // Size of the whole field
+    size_t elem_size; // Size of one element if the field is an array
+    SimStateKind kind;
+    s32 dims[2]; // Inner dimensions of a multidimensional array, `0` if unused
+} SimStateLeaf;
+
+/// @brief Where pointers of the simulation state point to in this process.
+///
+/// The memory arena is allocated and the executable is loaded at a different address in every run, so pointers
+/// into them are only comparable and restorable as offsets from these bases.
+typedef struct SimStateBases {
+    uintptr_t arena_start;
+    uintptr_t arena_size;
+    uintptr_t image_start; // The game's own statics, constant tables and code
+    uintptr_t image_size;
+} SimStateBases;
+
+void Get_Sim_State_Bases(SimStateBases* bases);
+
+/// @brief Get the size of a simulation state snapshot.
+size_t Get_Sim_State_Size();
+
+/// @brief Get a hash of the names and sizes of the globals in a snapshot, and of where the executable puts its
+/// code, constants and statics. Snapshots store pointers into the executable as offsets, so they can only be
+/// loaded by the same build.
+u32 Get_Sim_State_Layout();
+
+/// @brief Copy the globals listed in `sim_state_vars.inc` to `dst`, with pointers stored as offsets.
+void Save_Sim_State(void* dst);
+
+/// @brief Overwrite the globals listed in `sim_state_vars.inc` with a snapshot taken by `Save_Sim_State`, which may
+/// come from another run of the same build.
+void Load_Sim_State(const void* src);
+
+/// @brief Get every field of the globals in `sim_state_vars.inc`, with structs broken down using
+/// `sim_state_types.inc`. The list is built on the first call.
+/// @param count Receives the number of leaves.
+const SimStateLeaf* Get_Sim_State_Leaves(s32* count);
+
+#endif
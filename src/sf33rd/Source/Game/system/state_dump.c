@@ -0,0 +1,188 @@
+/**
+ * @file state_dump.c
+ * Simulation State Dumps
+ *
+ * A dump is a header followed by one record per frame, all little endian:
+ *
+ *   header  magic, version, leaf count, then for each leaf: path length, path, kind, element size, size, dimensions
+ *   frame   frame number, state size, deflated size, deflated state
+ *
+ * The state of a frame is every leaf of `Get_Sim_State_Leaves` in order, in the byte order of the machine (every
+ * target is little endian) and with pointers widened to 8 bytes. It is XORed with the state of the previous record
+ * before it is deflated. Most of the state stays the same from one frame to the next, so records are small.
+ *
+ * Since the header names every leaf, dumps from builds with different struct layouts can still be compared.
+ */
+
+#include "sf33rd/Source/Game/system/state_dump.h"
+#include "common.h"
+#include "port/options.h"
+#include "sf33rd/Source/Game/system/sim_state.h"
+#include "sf33rd/Source/Game/system/state_hash.h"
+#include "zlib.h"
+
+#include <SDL3/SDL.h>
+
+#define STATE_DUMP_MAGIC 0x50445333 // "3SDP"
+#define STATE_DUMP_VERSION 2
+
+// Pointers can't be compared by value between processes, so only where they point to is dumped
+#define POINTER_NULL 0
+#define POINTER_ARENA (1ULL << 63) // OR'd with the offset into the arena
+#define POINTER_IMAGE (1ULL << 62) // OR'd with the offset into the executable, see SimStateBases
+#define POINTER_OTHER (1ULL << 61)
+
+static SDL_IOStream* dump_io = NULL;
+static const SimStateLeaf* leaves;
+static s32 leaf_count;
+static u8* state;
+static u8* prev_state;
+static size_t state_size;
+static u8* deflate_buf;
+static size_t deflate_capacity;
+
+static size_t get_dump_size(const SimStateLeaf* leaf) {
+    if (leaf->kind == SIM_KIND_PTR) {
+        return (leaf->size / leaf->elem_size) * 8;
+    }
+
+    return leaf->size;
+}
+
+static u64 encode_pointer(const SimStateBases* bases, uintptr_t value) {
+    if (value == 0) {
+        return POINTER_NULL;
+    }
+
+    if ((value - bases->arena_start) < bases->arena_size) {
+        return POINTER_ARENA | (value - bases->arena_start);
+    }
+
+    if ((value - bases->image_start) < bases->image_size) {
+        return POINTER_IMAGE | (value - bases->image_start);
+    }
+
+    return POINTER_OTHER;
+}
+
+static bool open_dump() {
+    const SimStateLeaf* leaf;
+    size_t path_len;
+    s32 i;
+
+    dump_io = SDL_IOFromFile(options.state_dump_path, "wb");
+
+    if (dump_io == NULL) {
+        SDL_Log("Failed to create state dump %s: %s", options.state_dump_path, SDL_GetError());
+        return false;
+    }
+
+    leaves = Get_Sim_State_Leaves(&leaf_count);
+    state_size = 0;
+
+    SDL_WriteU32LE(dump_io, STATE_DUMP_MAGIC);
+    SDL_WriteU32LE(dump_io, STATE_DUMP_VERSION);
+    SDL_WriteU32LE(dump_io, leaf_count);
+
+    for (i = 0; i < leaf_count; i++) {
+        leaf = &leaves[i];
+        path_len = SDL_strlen(leaf->path);
+        SDL_WriteU16LE(dump_io, path_len);
+        SDL_WriteIO(dump_io, leaf->path, path_len);
+        SDL_WriteU8(dump_io, leaf->kind);
+        SDL_WriteU32LE(dump_io, (leaf->kind == SIM_KIND_PTR) ? 8 : leaf->elem_size);
+        SDL_WriteU32LE(dump_io, get_dump_size(leaf));
+        SDL_WriteU32LE(dump_io, leaf->dims[0]);
+        SDL_WriteU32LE(dump_io, leaf->dims[1]);
+        state_size += get_dump_size(leaf);
+    }
+
+    state = SDL_malloc(state_size);
+    prev_state = SDL_calloc(1, state_size);
+
+    // Worst case growth of deflate, as documented in zlib.h
+    deflate_capacity = state_size + state_size / 1000 + 12;
+    deflate_buf = SDL_malloc(deflate_capacity);
+    return true;
+}
+
+static void collect_state() {
+    const SimStateLeaf* leaf;
+    SimStateBases bases;
+    u8* dst = state;
+    uintptr_t value;
+    u64 encoded;
+    size_t j;
+    s32 i;
+
+    Get_Sim_State_Bases(&bases);
+
+    for (i = 0; i < leaf_count; i++) {
+        leaf = &leaves[i];
+
+        if (leaf->kind != SIM_KIND_PTR) {
+            SDL_memcpy(dst, leaf->adrs, leaf->size);
+            dst += leaf->size;
+            continue;
+        }
+
+        for (j = 0; j < leaf->size; j += leaf->elem_size) {
+            SDL_memcpy(&value, (u8*)leaf->adrs + j, sizeof(uintptr_t));
+            encoded = SDL_Swap64LE(encode_pointer(&bases, value));
+            SDL_memcpy(dst, &encoded, 8);
+            dst += 8;
+        }
+    }
+}
+
+void Dump_Sim_State() {
+    const s32 frame = Get_Match_Frame();
+    uLongf deflated_size;
+    u8 xored;
+    size_t i;
+
+    if ((options.state_dump_path == NULL) || (frame < 0)) {
+        return;
+    }
+
+    if ((dump_io == NULL) && !open_dump()) {
+        options.state_dump_path = NULL;
+        return;
+    }
+
+    collect_state();
+
+    // Keep the new state for the next frame and dump the difference
+    for (i = 0; i < state_size; i++) {
+        xored = state[i] ^ prev_state[i];
+        prev_state[i] = state[i];
+        state[i] = xored;
+    }
+
+    deflated_size = deflate_capacity;
+
+    if (compress2(deflate_buf, &deflated_size, state, state_size, Z_BEST_SPEED) != Z_OK) {
+        // Later records would be XORed with a state that isn't in the file
+        SDL_Log("Failed to compress the state of frame %d, stopping the dump", frame);
+        Close_Sim_State_Dump();
+        options.state_dump_path = NULL;
+        return;
+    }
+
+    SDL_WriteU32LE(dump_io, frame);
+    SDL_WriteU32LE(dump_io, state_size);
+    SDL_WriteU32LE(dump_io, deflated_size);
+    SDL_WriteIO(dump_io, deflate_buf, deflated_size);
+}
+
+void Close_Sim_State_Dump() {
+    if (dump_io == NULL) {
+        return;
+    }
+
+    SDL_CloseIO(dump_io);
+    dump_io = NULL;
+    SDL_free(state);
+    SDL_free(prev_state);
+    SDL_free(deflate_buf);
+}
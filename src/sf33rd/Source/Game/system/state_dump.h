@@ -0,0 +1,11 @@
+#ifndef STATE_DUMP_H
+#define STATE_DUMP_H
+
+/// @brief Write the full simulation state of the frame that just ran to `--state-dump`, if set.
+/// Frames are numbered like in the state hash log, so `Log_State_Hash` must run first.
+/// Dumps of two runs are compared with `tools/check_determinism.py`.
+void Dump_Sim_State();
+
+void Close_Sim_State_Dump();
+
+#endif
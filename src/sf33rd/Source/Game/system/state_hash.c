@@ -0,0 +1,312 @@
+/**
+ * @file state_hash.c
+ * Simulation State Hashing
+ *
+ * The hash runs four independent lanes over the state, in the style of xxHash64, so that the multiplies of
+ * consecutive words overlap. Every word is checked for being a pointer into the memory arena or the executable
+ * first, and such pointers are hashed as offsets. That check is done without branches, since state words are a mix
+ * of pointers and plain values that branches can't predict.
+ */
+
+#include "sf33rd/Source/Game/system/state_hash.h"
+#include "common.h"
+#include "port/options.h"
+#include "sf33rd/Source/Game/effect/effect.h"
+#include "sf33rd/Source/Game/engine/cmd_data.h"
+#include "sf33rd/Source/Game/engine/hitcheck.h"
+#include "sf33rd/Source/Game/engine/workuser.h"
+#include "sf33rd/Source/Game/stage/bg.h"
+#include "sf33rd/Source/Game/system/sim_state.h"
+#include "structs.h"
+
+#include <SDL3/SDL.h>
+
+#define PRIME64_1 0x9E3779B185EBCA87ULL
+#define PRIME64_2 0xC2B2AE3D27D4EB4FULL
+#define PRIME64_3 0x165667B19E3779F9ULL
+#define PRIME64_4 0x85EBCA77C2B2AE63ULL
+
+#define WORD_SIZE sizeof(uintptr_t)
+#define STRIPE_SIZE (WORD_SIZE * 4)
+
+typedef struct {
+    u64 lanes[4];
+    u64 length;
+} Hasher;
+
+static const char* region_names[STATE_HASH_REGION_COUNT] = {
+    "players", "effects", "stage", "random", "score", "hit_queue", "timers", "commands",
+};
+
+static SimStateBases bases;
+
+static SDL_IOStream* log_io = NULL;
+static u32 next_frame;
+static s32 match_frame = -1;
+
+static u64 rotl64(u64 value, s32 shift) {
+    return (value << shift) | (value >> (64 - shift));
+}
+
+static u64 hash_round(u64 acc, u64 input) {
+    acc += input * PRIME64_2;
+    acc = rotl64(acc, 31);
+    return acc * PRIME64_1;
+}
+
+static u64 merge_round(u64 acc, u64 lane) {
+    acc ^= hash_round(0, lane);
+    return acc * PRIME64_1 + PRIME64_4;
+}
+
+static uintptr_t relocate(uintptr_t word) {
+    const uintptr_t arena_offset = word - bases.arena_start;
+    const uintptr_t image_offset = word - bases.image_start;
+    uintptr_t result = word;
+
+    // Selects rather than early returns, so that they compile to conditional moves
+    result = (image_offset < bases.image_size) ? image_offset : result;
+    result = (arena_offset < bases.arena_size) ? arena_offset : result;
+    return result;
+}
+
+static void hasher_init(Hasher* hasher, u64 seed) {
+    hasher->lanes[0] = seed + PRIME64_1 + PRIME64_2;
+    hasher->lanes[1] = seed + PRIME64_2;
+    hasher->lanes[2] = seed;
+    hasher->lanes[3] = seed - PRIME64_1;
+    hasher->length = 0;
+}
+
+static void hasher_add(Hasher* hasher, const void* data, size_t size) {
+    const u8* ptr = data;
+    const u8* stripes_end = ptr + (size - (size % STRIPE_SIZE));
+    const u8* words_end = ptr + (size - (size % WORD_SIZE));
+    u64 lane0 = hasher->lanes[0];
+    u64 lane1 = hasher->lanes[1];
+    u64 lane2 = hasher->lanes[2];
+    u64 lane3 = hasher->lanes[3];
+    uintptr_t words[4];
+    u64 tail = 0;
+
+    for (; ptr < stripes_end; ptr += STRIPE_SIZE) {
+        SDL_memcpy(words, ptr, STRIPE_SIZE);
+        lane0 = hash_round(lane0, relocate(words[0]));
+        lane1 = hash_round(lane1, relocate(words[1]));
+        lane2 = hash_round(lane2, relocate(words[2]));
+        lane3 = hash_round(lane3, relocate(words[3]));
+    }
+
+    for (; ptr < words_end; ptr += WORD_SIZE) {
+        SDL_memcpy(words, ptr, WORD_SIZE);
+        lane0 = hash_round(lane0, relocate(words[0]));
+    }
+
+    if (ptr < (const u8*)data + size) {
+        SDL_memcpy(&tail, ptr, (const u8*)data + size - ptr);
+        lane1 = hash_round(lane1, tail);
+    }
+
+    hasher->lanes[0] = lane0;
+    hasher->lanes[1] = lane1;
+    hasher->lanes[2] = lane2;
+    hasher->lanes[3] = lane3;
+    hasher->length += size;
+}
+
+static u64 hasher_finish(const Hasher* hasher) {
+    u64 acc = rotl64(hasher->lanes[0], 1) + rotl64(hasher->lanes[1], 7) + rotl64(hasher->lanes[2], 12) +
+              rotl64(hasher->lanes[3], 18);
+    s32 i;
+
+    for (i = 0; i < 4; i++) {
+        acc = merge_round(acc, hasher->lanes[i]);
+    }
+
+    acc += hasher->length;
+    acc ^= acc >> 33;
+    acc *= PRIME64_2;
+    acc ^= acc >> 29;
+    acc *= PRIME64_3;
+    acc ^= acc >> 32;
+    return acc;
+}
+
+static void hash_effects(Hasher* hasher) {
+    s16 ix;
+
+    hasher_add(hasher, head_ix, sizeof(head_ix));
+    hasher_add(hasher, tail_ix, sizeof(tail_ix));
+    hasher_add(hasher, exec_tm, sizeof(exec_tm));
+    hasher_add(hasher, &frwctr, sizeof(frwctr));
+    hasher_add(hasher, frw_live, sizeof(frw_live));
+
+    // Only the slots in use, in slot order. Their order in the lists is in their before and behind links.
+    for (ix = next_effect_work(0); ix != -1; ix = next_effect_work(ix + 1)) {
+        hasher_add(hasher, frw[ix], sizeof(frw[ix]));
+    }
+}
+
+static void hash_random(Hasher* hasher) {
+    const s16 values[] = { Random_ix16,     Random_ix32,     Random_ix16_ex,     Random_ix32_ex,    Random_ix16_com,
+                           Random_ix32_com, Random_ix16_ex_com, Random_ix32_ex_com, Random_ix16_bg };
+
+    hasher_add(hasher, values, sizeof(values));
+}
+
+static void hash_hit_queue(Hasher* hasher) {
+    hasher_add(hasher, hs, sizeof(hs));
+    hasher_add(hasher, q_hit_push, sizeof(q_hit_push));
+    hasher_add(hasher, mkm_wk, sizeof(mkm_wk));
+    hasher_add(hasher, &hpq_in, sizeof(hpq_in));
+    hasher_add(hasher, &ca_check_flag, sizeof(ca_check_flag));
+}
+
+static void hash_timers(Hasher* hasher) {
+    const s32 values[] = { Game_timer, Counter_hi, Counter_low, Time_in_Time, Time_Stop, Demo_Time_Stop, Round_num };
+
+    hasher_add(hasher, values, sizeof(values));
+}
+
+static void hash_commands(Hasher* hasher) {
+    hasher_add(hasher, wcp, sizeof(wcp));
+    hasher_add(hasher, t_pl_lvr, sizeof(t_pl_lvr));
+    hasher_add(hasher, waza_work, sizeof(waza_work));
+    hasher_add(hasher, waza_type, sizeof(waza_type));
+}
+
+void Calc_State_Hash(StateHash* hash) {
+    Hasher hasher;
+    s32 region;
+
+    Get_Sim_State_Bases(&bases);
+
+    for (region = 0; region < STATE_HASH_REGION_COUNT; region++) {
+        hasher_init(&hasher, region);
+
+        switch (region) {
+        case STATE_HASH_PLAYERS:
+            hasher_add(&hasher, gs.plw, sizeof(gs.plw));
+            break;
+
+        case STATE_HASH_EFFECTS:
+            hash_effects(&hasher);
+            break;
+
+        case STATE_HASH_STAGE:
+            hasher_add(&hasher, &bg_w, sizeof(bg_w));
+            break;
+
+        case STATE_HASH_RANDOM:
+            hash_random(&hasher);
+            break;
+
+        case STATE_HASH_SCORE:
+            hasher_add(&hasher, Score, sizeof(Score));
+            break;
+
+        case STATE_HASH_HIT_QUEUE:
+            hash_hit_queue(&hasher);
+            break;
+
+        case STATE_HASH_TIMERS:
+            hash_timers(&hasher);
+            break;
+
+        case STATE_HASH_COMMANDS:
+            hash_commands(&hasher);
+            break;
+        }
+
+        hash->region[region] = hasher_finish(&hasher);
+    }
+}
+
+u64 Get_State_Hash_Total(const StateHash* hash) {
+    Hasher hasher;
+
+    hasher_init(&hasher, STATE_HASH_REGION_COUNT);
+    hasher_add(&hasher, hash->region, sizeof(hash->region));
+    return hasher_finish(&hasher);
+}
+
+s32 Compare_State_Hash(const StateHash* a, const StateHash* b) {
+    s32 region;
+
+    for (region = 0; region < STATE_HASH_REGION_COUNT; region++) {
+        if (a->region[region] != b->region[region]) {
+            return region;
+        }
+    }
+
+    return -1;
+}
+
+const char* Get_State_Hash_Region_Name(s32 region) {
+    return region_names[region];
+}
+
+static void count_match_frame() {
+    if ((Play_Mode != 1) && (Play_Mode != 3)) {
+        next_frame = 0;
+        match_frame = -1;
+        return;
+    }
+
+    if (Game_pause == 0x81) {
+        match_frame = -1;
+        return;
+    }
+
+    match_frame = next_frame;
+    next_frame += 1;
+}
+
+s32 Get_Match_Frame() {
+    return match_frame;
+}
+
+void Log_State_Hash() {
+    StateHash hash;
+    s32 region;
+
+    count_match_frame();
+
+    if ((options.state_hash_log_path == NULL) || (match_frame < 0)) {
+        return;
+    }
+
+    if (log_io == NULL) {
+        log_io = SDL_IOFromFile(options.state_hash_log_path, "w");
+
+        if (log_io == NULL) {
+            SDL_Log("Failed to create state hash log %s: %s", options.state_hash_log_path, SDL_GetError());
+            options.state_hash_log_path = NULL;
+            return;
+        }
+
+        SDL_IOprintf(log_io, "frame total");
+
+        for (region = 0; region < STATE_HASH_REGION_COUNT; region++) {
+            SDL_IOprintf(log_io, " %s", region_names[region]);
+        }
+
+        SDL_IOprintf(log_io, "\n");
+    }
+
+    Calc_State_Hash(&hash);
+    SDL_IOprintf(log_io, "%d %016llx", match_frame, (unsigned long long)Get_State_Hash_Total(&hash));
+
+    for (region = 0; region < STATE_HASH_REGION_COUNT; region++) {
+        SDL_IOprintf(log_io, " %016llx", (unsigned long long)hash.region[region]);
+    }
+
+    SDL_IOprintf(log_io, "\n");
+}
+
+void Close_State_Hash_Log() {
+    if (log_io != NULL) {
+        SDL_CloseIO(log_io);
+        log_io = NULL;
+    }
+}
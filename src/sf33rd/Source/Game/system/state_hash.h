@@ -0,0 +1,49 @@
+#ifndef STATE_HASH_H
+#define STATE_HASH_H
+
+#include "types.h"
+
+typedef enum StateHashRegion {
+    STATE_HASH_PLAYERS,   // gs.plw
+    STATE_HASH_EFFECTS,   // Live entries of frw and the effect lists
+    STATE_HASH_STAGE,     // bg_w
+    STATE_HASH_RANDOM,    // Random_ix* counters
+    STATE_HASH_SCORE,     // Score
+    STATE_HASH_HIT_QUEUE, // hs, q_hit_push and the rest of the hit queue
+    STATE_HASH_TIMERS,    // Game_timer, round timer and time stops
+    STATE_HASH_COMMANDS,  // Lever history, charge timers and move flags of the command parser
+    STATE_HASH_REGION_COUNT,
+} StateHashRegion;
+
+/// @brief Hash of the simulation state, one value per region so that a mismatch points at the subsystem that
+/// diverged.
+typedef struct StateHash {
+    u64 region[STATE_HASH_REGION_COUNT];
+} StateHash;
+
+/// @brief Hash the simulation state of the current frame.
+///
+/// Pointers into the game's memory arena and into the executable are hashed as offsets, so hashes of the
+/// same state match across processes and machines as long as the struct layouts are the same.
+void Calc_State_Hash(StateHash* hash);
+
+/// @brief Combine all regions of a hash into one value.
+u64 Get_State_Hash_Total(const StateHash* hash);
+
+/// @brief Find the first region where two hashes differ.
+/// @return Region index, or `-1` if the hashes are equal.
+s32 Compare_State_Hash(const StateHash* a, const StateHash* b);
+
+const char* Get_State_Hash_Region_Name(s32 region);
+
+/// @brief Write the hash of the frame that just ran to `--state-hash-log`, if set.
+/// Only frames of matches that are being recorded or replayed are logged, numbered from the start of the match.
+void Log_State_Hash();
+
+/// @brief Get the number that `Log_State_Hash` gave the frame that just ran.
+/// @return Frame number from the start of the match, or `-1` if the frame is not part of a recorded or replayed match.
+s32 Get_Match_Frame();
+
+void Close_State_Hash_Log();
+
+#endif
@@ -30,6 +30,7 @@
 #include "sf33rd/Source/Game/sound/sound3rd.h"
 #include "sf33rd/Source/Game/stage/bg.h"
 #include "sf33rd/Source/Game/stage/bg_sub.h"
+#include "sf33rd/Source/Game/system/replay_stream.h"
 #include "sf33rd/Source/Game/system/sys_sub2.h"
 #include "sf33rd/Source/Game/system/sysdir.h"
 #include "sf33rd/Source/Game/system/work_sys.h"
@@ -1098,6 +1099,7 @@ void Check_Replay() {
     Demo_Timer[1] = 0;
     Demo_Ptr[0] = Replay_w.io_unit.key_buff[0];
     Demo_Ptr[1] = Replay_w.io_unit.key_buff[1];
+    Start_Replay_Stream();
 }
 
 void Setup_Replay_Header() {
@@ -1238,7 +1240,7 @@ void Setup_Replay_Buff(s16 PL_id, u16 sw_buff) {
     *Demo_Ptr[PL_id] = buff;
     Demo_Ptr[PL_id]++;
 
-    if (&Replay_w.io_unit.key_buff[PL_id][7197] < Demo_Ptr[PL_id]) {
+    if ((&Replay_w.io_unit.key_buff[PL_id][7197] < Demo_Ptr[PL_id]) && !Flush_Replay_Buff(PL_id)) {
         Replay_Status[PL_id] = 99;
         Replay_w.full_data |= PL_id + 1;
         Rec_Time[PL_id] = Record_Timer;
@@ -1253,7 +1255,9 @@ void Replay(s16 PL_id) {
     u16 sw;
     u16 buff;
 
-    if (&Replay_w.io_unit.key_buff[PL_id][7198] < Demo_Ptr[PL_id]) {
+    Refill_Replay_Buff(PL_id);
+
+    if ((&Replay_w.io_unit.key_buff[PL_id][7198] < Demo_Ptr[PL_id]) || Replay_Stream_Ended()) {
         Replay_Status[0] = 2;
         Replay_Status[1] = 2;
 
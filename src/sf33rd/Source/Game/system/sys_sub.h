@@ -59,6 +59,7 @@ s32 Cut_Cut_Sub(s16 xx);
 bool Cut_Cut_Loser();
 void Soft_Reset_Sub();
 void Check_Replay();
+void Setup_Replay_Header();
 void Check_Replay_Status(s16 PL_id, u8 Status);
 s16 Check_SysDir_Page();
 void Clear_Flash_Init(s16 level);
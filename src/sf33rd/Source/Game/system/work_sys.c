@@ -31,6 +31,7 @@ s32 Y_Adjust_Buff[3];
 u8 Disp_Size_H;
 u8 Disp_Size_V;
 u8 No_Trans;
+u8 Force_No_Trans;
 u8 Turbo;
 u8 Turbo_Timer;
 s16 Correct_X[4];
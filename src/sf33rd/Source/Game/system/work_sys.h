@@ -43,6 +43,10 @@ extern s32 Y_Adjust_Buff[3];
 extern u8 Disp_Size_H;
 extern u8 Disp_Size_V;
 extern u8 No_Trans;
+
+/// Skip drawing on every frame, as if each one was fast-forwarded. Set by headless runs.
+extern u8 Force_No_Trans;
+
 extern u8 Turbo;
 extern u8 Turbo_Timer;
 extern s16 Correct_X[4];
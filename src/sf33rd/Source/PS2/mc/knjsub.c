@@ -74,18 +74,22 @@ typedef struct _kanji_tbl {
     u32 uni_ascii;
 } _kanji_tbl;
 
+// Atlas key of a glyph: font type, glyph source (0 = font file, 1 = built-in ASCII table) and index
+#define GLYPH_KEY(kw, source, index) (((kw)->type << 24) | ((source) << 16) | (index))
+
 // forward decls
 static u32 ascii2sjis(u8 data, u32 sort);
 static u32 ascii2sjis_sce(u8 data);
 static u32 ascii2sjis_nec(u8 data);
 static u32 sjis2index(u32 code, u32 sort);
 static void unicode_puts(_kanji_w* kw, const s8* str);
-static u32* make_fbg_pkt(_kanji_w* kw, u32* p, u32* /* unused */, u32 han_f);
-static u32* make_fnt_pkt(_kanji_w* kw, u32* p, u32* img, u32 han_f);
+static s32 get_glyph(_kanji_w* kw, u32 key, u32* (*get_img)(_kanji_w* kw, u32 index), u32 index);
+static u32* make_fbg_pkt(_kanji_w* kw, u32* p, s32 glyph, u32 han_f);
+static u32* make_fnt_pkt(_kanji_w* kw, u32* p, s32 glyph, u32 han_f);
 static u32* make_env_pkt(u32* p, u32 /* unused */, u32 /* unused */);
-static u32* make_pal_pkt(_kanji_w* kw, u32* p);
 static u32* get_img_adrs(_kanji_w* kw, u32 index);
 static u32* get_uni_adrs(_kanji_w* kw, u32 index);
+static u32* get_uni_adrs2(_kanji_w* kw, u32 code);
 
 // sdata
 
@@ -372,7 +376,6 @@ void KnjInit(u32 type, uintptr_t adrs, u32 disp_max, u32 top_dbp) {
         kw->pack_top[i] = pp;
         adrs += psize;
         pp = make_env_pkt(pp, kw->fontw, kw->fonth);
-        pp = make_pal_pkt(kw, pp);
         kw->pack_fnt[i] = pp;
     }
 
@@ -389,6 +392,7 @@ void KnjInit(u32 type, uintptr_t adrs, u32 disp_max, u32 top_dbp) {
     kw->color = 0x80808080;
     kw->bg_mode = 1;
     kw->bg_color = 0x80000000;
+    SDLMessageRenderer_ClearGlyphs();
     knj_use_flag = 1;
 }
 
@@ -447,7 +451,7 @@ void KnjPuts(const s8* str) {
     u32 c;
     u32 code;
     u32 index;
-    u32* img;
+    s32 glyph;
     u32* pp;
     u32 han_f;
     _kanji_w* kw = &kanji_w;
@@ -506,8 +510,8 @@ void KnjPuts(const s8* str) {
 
         if (index < kw->fmax) {
             if (kw->dcur < kw->dmax) {
-                img = get_img_adrs(kw, index);
-                pp = make_fnt_pkt(kw, pp, img, han_f);
+                glyph = get_glyph(kw, GLYPH_KEY(kw, 0, index), get_img_adrs, index);
+                pp = make_fnt_pkt(kw, pp, glyph, han_f);
                 kw->dcur += 1;
             } else {
                 break;
@@ -911,7 +915,7 @@ static void unicode_puts(_kanji_w* kw, const s8* str) {
     const u8* str_buf;
     u32 code;
     u32 index;
-    u32* img;
+    s32 glyph;
     u32* pp;
     u32 han_f;
 
@@ -931,13 +935,13 @@ static void unicode_puts(_kanji_w* kw, const s8* str) {
             if (kw->uni_ascii == 0) {
                 if (code < 0x10) {
                     han_f = 0;
-                    img = get_uni_adrs2(kw, code);
+                    glyph = get_glyph(kw, GLYPH_KEY(kw, 1, code), get_uni_adrs2, code);
                     goto block_14;
                 }
 
                 if (code < 0x80) {
                     han_f = 1;
-                    img = get_uni_adrs2(kw, code);
+                    glyph = get_glyph(kw, GLYPH_KEY(kw, 1, code), get_uni_adrs2, code);
                     goto block_14;
                 }
             }
@@ -947,9 +951,9 @@ static void unicode_puts(_kanji_w* kw, const s8* str) {
 
             if (index < kw->fmax) {
                 if (kw->dcur < kw->dmax) {
-                    img = get_uni_adrs(kw, index);
+                    glyph = get_glyph(kw, GLYPH_KEY(kw, 0, index), get_uni_adrs, index);
                 block_14:
-                    pp = make_fnt_pkt(kw, pp, img, han_f);
+                    pp = make_fnt_pkt(kw, pp, glyph, han_f);
                     kw->dcur += 1;
                 } else {
                     break;
@@ -1060,25 +1064,17 @@ static u32* make_env_pkt(u32* p, u32 /* unused */, u32 /* unused */) {
     return p;
 }
 
-static u32* make_img_pkt(u32* p, u32* img, u32 dbp, u32 dbw, u32 dbsm, u32 dsax, u32 dsay, u32 rrw, u32 rrh) {
-    SDLMessageRenderer_CreateTexture(rrw, rrh, img, dbsm);
-
-    return p;
-}
-
-static u32* make_pal_pkt(_kanji_w* kw, u32* p) {
-    s32 i;
-    u32* img;
+static s32 get_glyph(_kanji_w* kw, u32 key, u32* (*get_img)(_kanji_w* kw, u32 index), u32 index) {
+    s32 glyph = SDLMessageRenderer_FindGlyph(key);
 
-    for (i = 0; i < kw->pmax; i++) {
-        img = (u32*)(kw->rgba_adrs + (i * 16));
-        p = make_img_pkt(p, img, kw->pdbp + i, 1, SCE_GS_PSMCT32, 0, 0, 8, 2);
+    if (glyph < 0) {
+        glyph = SDLMessageRenderer_AddGlyph(key, kw->fontw, kw->fonth, get_img(kw, index));
     }
 
-    return p;
+    return glyph;
 }
 
-static u32* make_fnt_pkt(_kanji_w* kw, u32* p, u32* img, u32 han_f) {
+static u32* make_fnt_pkt(_kanji_w* kw, u32* p, s32 glyph, u32 han_f) {
     s32 x;
     s32 y;
     s32 x0;
@@ -1092,8 +1088,7 @@ static u32* make_fnt_pkt(_kanji_w* kw, u32* p, u32* img, u32 han_f) {
     u32 xs;
     u32 ys;
 
-    p = make_img_pkt(p, img, kw->fdbp, 1, SCE_GS_PSMT4, 0, 0, kw->fontw, kw->fonth);
-    p = make_fbg_pkt(kw, p, img, han_f);
+    p = make_fbg_pkt(kw, p, glyph, han_f);
     x = kw->x * 16;
     y = kw->y * 16;
     ox = ((4096 - flPs2State.DispWidth) / 2) * 0x10;
@@ -1112,12 +1107,12 @@ static u32* make_fnt_pkt(_kanji_w* kw, u32* p, u32* img, u32 han_f) {
     u1 = ((kw->fontw * 16) >> han_f);
     v1 = kw->fonth * 16;
 
-    SDLMessageRenderer_DrawTexture(x0, y0, x1, y1, 0, 0, u1, v1, kw->color);
+    SDLMessageRenderer_DrawGlyph(glyph, x0, y0, x1, y1, 0, 0, u1, v1, kw->color);
 
     return p;
 }
 
-static u32* make_fbg_pkt(_kanji_w* kw, u32* p, u32* /* unused */, u32 han_f) {
+static u32* make_fbg_pkt(_kanji_w* kw, u32* p, s32 glyph, u32 han_f) {
     s32 x;
     s32 y;
     s32 x0;
@@ -1153,7 +1148,7 @@ static u32* make_fbg_pkt(_kanji_w* kw, u32* p, u32* /* unused */, u32 han_f) {
     u1 = ((kw->fontw * 16) >> han_f);
     v1 = kw->fonth * 16;
 
-    SDLMessageRenderer_DrawTexture(x0, y0, x1, y1, 8, 8, u1 + 8, v1 + 8, kw->bg_color);
+    SDLMessageRenderer_DrawGlyph(glyph, x0, y0, x1, y1, 8, 8, u1 + 8, v1 + 8, kw->bg_color);
 
     return p;
 }
@@ -0,0 +1,442 @@
+/**
+ * @file calc_points_check.c
+ * Checks that sprite chips are transformed the same when all chips of an object go through one njCalcPoints call
+ *
+ * First, njCalcPoints has to give the same bits as njCalcPoint, whichever kernel it was built with. Then objects
+ * with the matrices that the stage and object code set up are stored both through seqsStoreChip, which queues
+ * them until the object is done, and through the chip by chip path it replaced. The stored chips and the matrix
+ * that they step have to match. Last, both paths are timed.
+ */
+
+#include "common.h"
+#include "sf33rd/AcrSDK/ps2/flps2render.h"
+#include "sf33rd/AcrSDK/ps2/foundaps2.h"
+#include "sf33rd/Source/Common/PPGFile.h"
+#include "sf33rd/Source/Game/debug/Debug.h"
+#include "sf33rd/Source/Game/rendering/aboutspr.h"
+#include "sf33rd/Source/Game/rendering/chren3rd.h"
+#include "sf33rd/Source/Game/rendering/color3rd.h"
+#include "sf33rd/Source/Game/rendering/dc_ghost.h"
+#include "sf33rd/Source/Game/rendering/mtrans.h"
+#include "sf33rd/Source/Game/rendering/texcash.h"
+#include "sf33rd/Source/Game/rendering/texgroup.h"
+#include "sf33rd/Source/Game/system/work_sys.h"
+#include "sf33rd/Source/PS2/ps2Quad.h"
+#include "structs.h"
+
+#include <SDL3/SDL.h>
+
+#include <stdio.h>
+#include <string.h>
+
+#define POINT_COUNT 1000000
+#define OBJECT_COUNT 200000
+#define BENCHMARK_OBJECTS 20000
+#define BENCHMARK_CHIPS 48
+#define BENCHMARK_MATRICES 64
+#define BENCHMARK_RUNS 7
+#define CHIP_MAX 0x400
+
+extern MTX cmtx;
+extern s32 curr_bright;
+extern SpriteChipSet seqs_w;
+
+s32 seqsStoreChip(f32 x, f32 y, s32 w, s32 h, s32 gix, s32 code, s32 attr, s32 alpha, s32 id);
+void appRenewTempPriority_1_Chip();
+
+typedef struct Chip {
+    f32 x;
+    f32 y;
+    s32 w;
+    s32 h;
+    s32 gix;
+    s32 code;
+    s32 attr;
+} Chip;
+
+// Stand-ins for the parts of the game that storing and drawing chips call out to
+u16 ColorRAM[512][64];
+s8 Debug_w[72];
+MultiTexture mts[MULTITEXTURE_MAX];
+const u8 obj_group_table[37664];
+const TexGroupData texgrpdat[100];
+TEX_GRP_LD texgrplds[100];
+TexturePoolUsed* tpu_free;
+MTX BgMATRIX[9];
+
+s32 flLogOut(s8* /* unused */, ...) {
+    return 0;
+}
+
+s32 flSetRenderState(enum _FLSETRENDERSTATE /* unused */, u32 /* unused */) {
+    return 1;
+}
+
+Palette* palGetChunkGhostCP3() {
+    return NULL;
+}
+
+Palette* palGetChunkGhostDC() {
+    return NULL;
+}
+
+void palCopyGhostDC(s32 /* unused */, s32 /* unused */, void* /* unused */) {}
+
+void palUpdateGhostDC() {}
+
+s32 ppgCheckTextureDataBe(Texture* /* unused */) {
+    return 1;
+}
+
+// Handles only have to tell the chips apart. They stay calls, like in the game, so that both paths are timed fairly.
+__attribute__((noinline)) s32 ppgGetUsingTextureHandle(Texture* /* unused */, s32 ixNums) {
+    return (ixNums * 7 + 1) & 0xFFFF;
+}
+
+__attribute__((noinline)) s32 ppgGetUsingPaletteHandle(Palette* /* unused */, s32 ixNums) {
+    return ixNums + 3;
+}
+
+s32 ppgRenewTexChunkSeqs(Texture* /* unused */) {
+    return 1;
+}
+
+void ppgSetupCurrentDataList(PPGDataList* /* unused */) {}
+
+s32 ppgSetupTexChunkSeqs(Texture* /* unused */, PPGFileHeader* /* unused */, u8* /* unused */, s32 /* unused */,
+                         s32 /* unused */, u32 /* unused */) {
+    return 0;
+}
+
+void ppgRenewDotDataSeqs(Texture* /* unused */, u32 /* unused */, u32* /* unused */, u32 /* unused */,
+                         u32 /* unused */) {}
+
+void ppgSetupCurrentPaletteNumber(Palette* /* unused */, s32 /* unused */) {}
+
+s32 ppgWriteQuadWithST_B(Vertex* /* unused */, u32 /* unused */, PPGDataList* /* unused */, s32 /* unused */,
+                         s32 /* unused */) {
+    return 0;
+}
+
+s32 ppgWriteQuadWithST_B2(Vertex* /* unused */, u32 /* unused */, PPGDataList* /* unused */, s32 /* unused */,
+                          s32 /* unused */) {
+    return 0;
+}
+
+void ps2SeqsRenderQuad_Ax(Sprite2* /* unused */) {}
+
+void ps2SeqsRenderQuad_B(Quad* /* unused */, u32 /* unused */) {}
+
+void shadow_drawing(WORK* /* unused */, s16 /* unused */) {}
+
+static u32 random_state = 1;
+static Sprite2 chips[CHIP_MAX + 1];
+static Sprite2 reference_chips[CHIP_MAX + 1];
+static Chip object[CHIP_MAX];
+
+static u32 next_random() {
+    random_state ^= random_state << 13;
+    random_state ^= random_state >> 17;
+    random_state ^= random_state << 5;
+    return random_state;
+}
+
+static f32 random_float(f32 min, f32 max) {
+    return min + (max - min) * (next_random() & 0xFFFFFF) / (f32)0x1000000;
+}
+
+/// @brief The chip by chip store that seqsStoreChip used to do.
+__attribute__((noinline)) static s32 reference_store_chip(Sprite2* chip, const Chip* c, s32 alpha, s32 id) {
+    s32 u;
+    s32 v;
+
+    const f32 dx = 0;
+    const f32 dy = 0;
+
+    chip->v[0].x = c->x;
+    chip->v[0].y = c->y;
+    chip->v[1].x = c->x + c->w;
+    chip->v[1].y = c->y - c->h;
+    chip->v[0].z = chip->v[1].z = 0.0f;
+    njCalcPoints(NULL, chip->v, chip->v, 2);
+
+    if ((chip->v[0].x >= 384.0f) || (chip->v[1].x < 0.0f) || (chip->v[0].y >= 224.0f) || (chip->v[1].y < 0.0f)) {
+        return 0;
+    }
+
+    if (!(c->attr & 0x2000)) {
+        u = (c->code & 0xF) * 16;
+        v = c->code & 0xF0;
+        chip->texCode = ppgGetUsingTextureHandle(NULL, c->gix + (c->code >> 8));
+    } else {
+        u = (c->code & 7) * 32;
+        v = (c->code & 0x38) * 4;
+        chip->texCode = ppgGetUsingTextureHandle(NULL, c->gix + (c->code >> 6));
+    }
+
+    appRenewTempPriority_1_Chip();
+
+    if (c->attr & 0x8000) {
+        chip->t[1].s = (u - dx) / 256.0f;
+        chip->t[0].s = (u + c->w - dx) / 256.0f;
+    } else {
+        chip->t[0].s = (u + dx) / 256.0f;
+        chip->t[1].s = (u + c->w + dx) / 256.0f;
+    }
+
+    if (c->attr & 0x4000) {
+        chip->t[1].t = (v - dy) / 256.0f;
+        chip->t[0].t = (v + c->h - dy) / 256.0f;
+    } else {
+        chip->t[0].t = (v + dy) / 256.0f;
+        chip->t[1].t = (v + c->h + dy) / 256.0f;
+    }
+
+    chip->texCode |= ppgGetUsingPaletteHandle(NULL, c->attr & 0x1FF) << 16;
+    chip->vtxColor = curr_bright | ((0xFF - alpha) << 24);
+    chip->id = id;
+    return 1;
+}
+
+/// @brief Set up the matrix of an object on a stage layer, the way `scr_calc` and `mlt_obj_matrix` do.
+static void random_object_matrix() {
+    const f32 zoom = random_float(0.75f, 1.5f);
+    const f32 scroll_scale = (next_random() % 4 == 0) ? random_float(0.5f, 1.0f) : 1.0f;
+    const s16 h_shift = next_random() % 1024;
+    const s16 v_shift = next_random() % 256;
+    s16 position_x = h_shift + next_random() % 384;
+    s16 position_y = v_shift + next_random() % 200;
+
+    // Most objects stand on screen, some are off to a side
+    if (next_random() % 8 == 0) {
+        position_x += (next_random() & 1) ? 512 : -512;
+    }
+
+    njUnitMatrix(NULL);
+    njScale(NULL, zoom, zoom, 1.0f);
+    njScale(NULL, scroll_scale, scroll_scale, 1.0f);
+    njTranslate(NULL, 0.0f, 224.0f, 0.0f);
+    njScale(NULL, 1.0f, -1.0f, 1.0f);
+    njTranslate(NULL, -h_shift, -v_shift, 0.0f);
+    njTranslate(NULL, position_x, position_y, (next_random() % 64 * 512 + 1) / 65535.0f);
+
+    if (next_random() % 4 == 0) {
+        njScale(NULL, (1.0f / 64.0f) * (next_random() % 128 + 1), (1.0f / 64.0f) * (next_random() % 128 + 1), 1.0f);
+    }
+}
+
+/// @brief Set up a matrix with everything mixed, that the chips of an object can't be transformed together with.
+static void random_mixed_matrix() {
+    MTX mtx;
+    s32 i;
+
+    for (i = 0; i < 16; i++) {
+        mtx.a[i / 4][i % 4] = random_float(-2.0f, 2.0f);
+    }
+
+    mtx.a[3][0] = random_float(-200.0f, 500.0f);
+    mtx.a[3][1] = random_float(-200.0f, 400.0f);
+    njSetMatrix(NULL, &mtx);
+}
+
+/// @brief Lay out the chips of an object the way the trans tables do, around the feet of a character.
+static void random_object(s32 count) {
+    const s32 flip = (next_random() & 3) << 14;
+    s32 i;
+
+    for (i = 0; i < count; i++) {
+        const s32 attr = next_random() & 0x2F0F;
+        const s32 w = ((attr & 0xC00) >> 7) + 8;
+        const s32 h = ((attr & 0x300) >> 5) + 8;
+        const f32 x = (s32)(next_random() % 192) - 96;
+        const f32 y = (s32)(next_random() % 176) - 16;
+
+        object[i].x = x - (w * BOOL(flip & 0x8000));
+        object[i].y = y + (h * BOOL(flip & 0x4000));
+        object[i].w = w;
+        object[i].h = h;
+        object[i].gix = next_random() % 64;
+        object[i].code = next_random() & 0x3FFF;
+        object[i].attr = (attr ^ flip) & 0xE00F;
+    }
+}
+
+static s32 store_reference(s32 count, s32 alpha, s32 id) {
+    s32 total = 0;
+    s32 i;
+
+    for (i = 0; i < count; i++) {
+        total += reference_store_chip(&reference_chips[total], &object[i], alpha, id);
+    }
+
+    return total;
+}
+
+static void store_batched(s32 count, s32 alpha, s32 id) {
+    s32 i;
+
+    seqsBeforeProcess();
+
+    for (i = 0; i < count; i++) {
+        seqsStoreChip(object[i].x,
+                      object[i].y,
+                      object[i].w,
+                      object[i].h,
+                      object[i].gix,
+                      object[i].code,
+                      object[i].attr,
+                      alpha,
+                      id);
+    }
+
+    seqsAfterProcess();
+}
+
+static bool check_points() {
+    MTX mtx;
+    Vec3 in[4];
+    Vec3 batch[4];
+    Vec3 single[4];
+    s32 i;
+    s32 j;
+
+    for (i = 0; i < POINT_COUNT; i++) {
+        for (j = 0; j < 16; j++) {
+            mtx.a[j / 4][j % 4] = random_float(-1024.0f, 1024.0f);
+        }
+
+        for (j = 0; j < 4; j++) {
+            in[j].x = random_float(-4096.0f, 4096.0f);
+            in[j].y = random_float(-4096.0f, 4096.0f);
+            in[j].z = (j < 2) ? 0.0f : random_float(-1.0f, 1.0f);
+        }
+
+        njCalcPoints(&mtx, in, batch, 4);
+
+        for (j = 0; j < 4; j++) {
+            njCalcPoint(&mtx, &in[j], &single[j]);
+        }
+
+        if (memcmp(batch, single, sizeof(batch)) != 0) {
+            printf("njCalcPoints differs from njCalcPoint at point %d\n", i);
+            return false;
+        }
+    }
+
+    return true;
+}
+
+static bool check_objects(s32* stored_count) {
+    MTX start;
+    MTX after;
+    s32 count;
+    s32 total;
+    s32 i;
+
+    for (i = 0; i < OBJECT_COUNT; i++) {
+        // Every so often an object has more chips than the queue holds
+        count = (next_random() % 16 == 0) ? 0x100 + next_random() % 0x180 : 1 + next_random() % 64;
+        curr_bright = next_random() & 0xFFFFFF;
+        random_object(count);
+
+        // Now and then check the chip by chip fallback too
+        if (next_random() % 16 == 0) {
+            random_mixed_matrix();
+        } else {
+            random_object_matrix();
+        }
+
+        njGetMatrix(&start);
+
+        store_batched(count, i & 0xFF, i % 24);
+        njGetMatrix(&after);
+
+        njSetMatrix(NULL, &start);
+        total = store_reference(count, i & 0xFF, i % 24);
+
+        if (total != seqs_w.sprTotal) {
+            printf("Object %d: %d chips stored instead of %d\n", i, seqs_w.sprTotal, total);
+            return false;
+        }
+
+        if (memcmp(chips, reference_chips, sizeof(Sprite2) * total) != 0) {
+            printf("Object %d: stored chips differ\n", i);
+            return false;
+        }
+
+        if (memcmp(&after, &cmtx, sizeof(MTX)) != 0) {
+            printf("Object %d: the matrix differs afterwards\n", i);
+            return false;
+        }
+
+        *stored_count += total;
+    }
+
+    return true;
+}
+
+/// @brief Time storing the same objects chip by chip or batched, in nanoseconds per chip.
+static f64 time_objects(MTX* matrices, bool batched) {
+    const Uint64 start = SDL_GetTicksNS();
+    s32 i;
+
+    for (i = 0; i < BENCHMARK_OBJECTS; i++) {
+        njSetMatrix(NULL, &matrices[i % BENCHMARK_MATRICES]);
+
+        if (batched) {
+            store_batched(BENCHMARK_CHIPS, 0, 0);
+        } else {
+            store_reference(BENCHMARK_CHIPS, 0, 0);
+        }
+    }
+
+    return (SDL_GetTicksNS() - start) / (f64)(BENCHMARK_OBJECTS * BENCHMARK_CHIPS);
+}
+
+static void benchmark() {
+    static MTX matrices[BENCHMARK_MATRICES];
+    f64 reference_ns = 1e9;
+    f64 batched_ns = 1e9;
+    s32 i;
+
+    for (i = 0; i < BENCHMARK_MATRICES; i++) {
+        random_object_matrix();
+        njGetMatrix(&matrices[i]);
+    }
+
+    random_object(BENCHMARK_CHIPS);
+
+    // Take the best of a few alternating runs, to leave out what else the machine is doing
+    for (i = 0; i < BENCHMARK_RUNS; i++) {
+        reference_ns = SDL_min(reference_ns, time_objects(matrices, false));
+        batched_ns = SDL_min(batched_ns, time_objects(matrices, true));
+    }
+
+    printf("%d objects of %d chips: chip by chip %.1f ns per chip, batched %.1f ns per chip\n",
+           BENCHMARK_OBJECTS,
+           BENCHMARK_CHIPS,
+           reference_ns,
+           batched_ns);
+}
+
+int main() {
+    s32 stored_count = 0;
+
+    // Skip drawing, only the stored chips matter
+    Debug_w[0x27] = 3;
+    seqsInitialize(chips);
+
+    if (!check_points()) {
+        return 1;
+    }
+
+    printf("njCalcPoints: %d random points match njCalcPoint\n", POINT_COUNT * 4);
+
+    if (!check_objects(&stored_count)) {
+        return 1;
+    }
+
+    printf("seqsStoreChip: %d objects match, %d chips stored\n", OBJECT_COUNT, stored_count);
+    benchmark();
+    return 0;
+}
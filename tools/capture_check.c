@@ -0,0 +1,306 @@
+/**
+ * @file capture_check.c
+ * Checks that a capture has every frame and all the audio it was given, and times the copies it adds to a frame
+ *
+ * A few hundred frames drawn by the software renderer are captured together with a changing number of audio
+ * samples per frame, many more frames than the ring has slots, so the main thread also waits for the worker. The
+ * file is then read back: it has to have as many video frames as were captured, each with the checksum that the
+ * software renderer gave it, and the audio samples have to be the ones that were captured, in order.
+ *
+ * The frames are the same kind of frames that `--batch-capture` records from a replay, whose checksums
+ * `--batch-frames` writes, but drawn from quads here since replays need the game data.
+ */
+
+#include "common.h"
+#include "port/options.h"
+#include "port/sdl/sdl_capture.h"
+#include "port/sdl/sdl_soft_renderer.h"
+#include "port/sound/mixer.h"
+
+#include <SDL3/SDL.h>
+
+#include <libavcodec/avcodec.h>
+#include <libavformat/avformat.h>
+
+#include <stdio.h>
+
+#define CANVAS_WIDTH 384
+#define CANVAS_HEIGHT 224
+#define FRAME_COUNT 300
+#define QUAD_COUNT 12
+#define FNV_OFFSET_BASIS 0xCBF29CE484222325ULL
+#define FNV_PRIME 0x100000001B3ULL
+
+// Stand-ins for the parts of the game that sdl_capture.c reads the frame and its audio from
+Options options = { .software_render = true };
+
+static s16 samples[MIXER_MAX_GAME_FRAME_FRAMES * MIXER_CHANNELS];
+static int sample_count;
+
+int OfflineAudio_GetLastFrame(const s16** last_samples) {
+    *last_samples = samples;
+    return sample_count;
+}
+
+static u32 random_state = 1;
+static SDLSoftRenderer_Quad quads[QUAD_COUNT];
+static u64 frame_hashes[FRAME_COUNT];
+static u64 audio_hash = FNV_OFFSET_BASIS;
+static s64 audio_sample_count = 0;
+
+static u32 next_random() {
+    random_state ^= random_state << 13;
+    random_state ^= random_state >> 17;
+    random_state ^= random_state << 5;
+    return random_state;
+}
+
+static u64 hash_byte(u64 value, u32 byte) {
+    return (value ^ byte) * FNV_PRIME;
+}
+
+static void set_vertex(SDL_Vertex* vertex, float x, float y, u32 rgba) {
+    vertex->position.x = x;
+    vertex->position.y = y;
+    vertex->tex_coord.x = 0;
+    vertex->tex_coord.y = 0;
+    vertex->color.r = (rgba >> 24) / 255.0f;
+    vertex->color.g = ((rgba >> 16) & 0xFF) / 255.0f;
+    vertex->color.b = ((rgba >> 8) & 0xFF) / 255.0f;
+    vertex->color.a = (rgba & 0xFF) / 255.0f;
+}
+
+/// @brief Draw frame `frame`: an opaque background whose colours change every frame, under half transparent quads
+/// that move. The frame stays opaque, so the checksum of its red, green and blue is enough to tell it apart.
+static void draw_frame(s32 frame) {
+    SDLSoftRenderer_Quad* quad = &quads[0];
+    const u32 shade = (u32)(frame & 0xFF) << 8;
+    s32 i;
+
+    quad->image = NULL;
+    set_vertex(&quad->vertices[0], 0, 0, 0x204000FF | shade);
+    set_vertex(&quad->vertices[1], CANVAS_WIDTH, 0, 0x402000FF | shade);
+    set_vertex(&quad->vertices[2], 0, CANVAS_HEIGHT, 0x600000FF | shade);
+    set_vertex(&quad->vertices[3], CANVAS_WIDTH, CANVAS_HEIGHT, 0x101000FF | shade);
+
+    for (i = 1; i < QUAD_COUNT; i++) {
+        const float x = (float)((i * 41 + frame * 3) % CANVAS_WIDTH);
+        const float y = (float)((i * 29 + frame * 2) % CANVAS_HEIGHT);
+        const u32 rgba = (next_random() & 0xFFFFFF00) | 0x80;
+
+        quad = &quads[i];
+        quad->image = NULL;
+        set_vertex(&quad->vertices[0], x, y, rgba);
+        set_vertex(&quad->vertices[1], x + 40, y, rgba);
+        set_vertex(&quad->vertices[2], x, y + 30, rgba);
+        set_vertex(&quad->vertices[3], x + 40, y + 30, rgba);
+    }
+
+    SDLSoftRenderer_Render(0x000000FF, quads, QUAD_COUNT);
+}
+
+/// @brief Make the audio of a frame, 805 or 806 sample frames like the mixer makes at the game's frame rate.
+static void make_audio() {
+    s32 i;
+
+    sample_count = MIXER_MAX_GAME_FRAME_FRAMES - (next_random() & 1);
+
+    for (i = 0; i < sample_count * MIXER_CHANNELS; i++) {
+        const u16 sample = (u16)next_random();
+
+        samples[i] = sample;
+        audio_hash = hash_byte(audio_hash, sample & 0xFF);
+        audio_hash = hash_byte(audio_hash, sample >> 8);
+    }
+
+    audio_sample_count += sample_count;
+}
+
+static bool capture(const char* path) {
+    Uint64 copy_ns = 0;
+    Uint64 start;
+    s32 frame;
+
+    SDLSoftRenderer_Init(CANVAS_WIDTH, CANVAS_HEIGHT, 2);
+
+    if (!SDLCapture_Init(path, CANVAS_WIDTH, CANVAS_HEIGHT)) {
+        printf("Failed to start capturing to %s\n", path);
+        return false;
+    }
+
+    for (frame = 0; frame < FRAME_COUNT; frame++) {
+        draw_frame(frame);
+        frame_hashes[frame] = SDLSoftRenderer_GetFrameHash();
+        make_audio();
+
+        start = SDL_GetTicksNS();
+        SDLCapture_Frame(NULL, NULL);
+        copy_ns += SDL_GetTicksNS() - start;
+    }
+
+    SDLCapture_Quit();
+    SDLSoftRenderer_Quit();
+    printf("SDLCapture: %.3f ms per frame on the main thread, waits for the worker included\n",
+           copy_ns / 1e6 / FRAME_COUNT);
+    return true;
+}
+
+/// @brief Check the checksum of the `index`th frame read back, as the software renderer computes it.
+static bool check_frame(const AVFrame* frame, s32 index) {
+    u64 hash = FNV_OFFSET_BASIS;
+    s32 x;
+    s32 y;
+
+    if (index >= FRAME_COUNT) {
+        printf("More than the %d frames that were captured\n", FRAME_COUNT);
+        return false;
+    }
+
+    if ((frame->format != AV_PIX_FMT_0RGB32) || (frame->width != CANVAS_WIDTH) || (frame->height != CANVAS_HEIGHT)) {
+        printf("Frame %d isn't a %dx%d 0RGB frame\n", index, CANVAS_WIDTH, CANVAS_HEIGHT);
+        return false;
+    }
+
+    for (y = 0; y < CANVAS_HEIGHT; y++) {
+        const Uint32* row = (const Uint32*)(frame->data[0] + y * frame->linesize[0]);
+
+        for (x = 0; x < CANVAS_WIDTH; x++) {
+            hash = hash_byte(hash, (row[x] >> 16) & 0xFF);
+            hash = hash_byte(hash, (row[x] >> 8) & 0xFF);
+            hash = hash_byte(hash, row[x] & 0xFF);
+            hash = hash_byte(hash, 0xFF);
+        }
+    }
+
+    if (hash != frame_hashes[index]) {
+        printf("Frame %d: checksum %016" SDL_PRIx64 " instead of %016" SDL_PRIx64 "\n",
+               index,
+               hash,
+               frame_hashes[index]);
+        return false;
+    }
+
+    return true;
+}
+
+/// @brief Decode the frames that `context` has ready and check them.
+static bool receive_frames(AVCodecContext* context, AVFrame* frame, s32* frame_count) {
+    int ret;
+
+    while ((ret = avcodec_receive_frame(context, frame)) >= 0) {
+        if (!check_frame(frame, *frame_count)) {
+            return false;
+        }
+
+        *frame_count += 1;
+    }
+
+    if ((ret != AVERROR(EAGAIN)) && (ret != AVERROR_EOF)) {
+        printf("Failed to decode frame %d\n", *frame_count);
+        return false;
+    }
+
+    return true;
+}
+
+/// @brief Read every packet of the file, decode and check the video frames and hash the audio.
+static bool read_packets(AVFormatContext* format, AVCodecContext* context, int video_index, int audio_index) {
+    AVPacket* packet = av_packet_alloc();
+    AVFrame* frame = av_frame_alloc();
+    u64 hash = FNV_OFFSET_BASIS;
+    s64 sample_total = 0;
+    s32 frame_count = 0;
+    bool is_ok = (packet != NULL) && (frame != NULL);
+    int i;
+
+    while (is_ok && (av_read_frame(format, packet) >= 0)) {
+        if (packet->stream_index == video_index) {
+            is_ok = (avcodec_send_packet(context, packet) >= 0) && receive_frames(context, frame, &frame_count);
+        } else if (packet->stream_index == audio_index) {
+            // Interleaved 16-bit little endian PCM, hashed the way it was made
+            for (i = 0; i < packet->size; i++) {
+                hash = hash_byte(hash, packet->data[i]);
+            }
+
+            sample_total += packet->size / (MIXER_CHANNELS * sizeof(s16));
+        }
+
+        av_packet_unref(packet);
+    }
+
+    // Drain the frames the decoder still holds
+    is_ok = is_ok && (avcodec_send_packet(context, NULL) >= 0) && receive_frames(context, frame, &frame_count);
+    av_frame_free(&frame);
+    av_packet_free(&packet);
+
+    if (!is_ok) {
+        return false;
+    }
+
+    if (frame_count != FRAME_COUNT) {
+        printf("%d frames read back instead of %d\n", frame_count, FRAME_COUNT);
+        return false;
+    }
+
+    if ((sample_total != audio_sample_count) || (hash != audio_hash)) {
+        printf("%" SDL_PRIs64 " audio samples read back instead of %" SDL_PRIs64 ", or they differ\n",
+               sample_total,
+               audio_sample_count);
+        return false;
+    }
+
+    return true;
+}
+
+static bool read_back(const char* path) {
+    AVFormatContext* format = NULL;
+    AVCodecContext* context = NULL;
+    const AVCodec* codec = NULL;
+    int video_index;
+    int audio_index;
+    bool is_ok;
+
+    if ((avformat_open_input(&format, path, NULL, NULL) < 0) || (avformat_find_stream_info(format, NULL) < 0)) {
+        printf("Failed to open %s\n", path);
+        avformat_close_input(&format);
+        return false;
+    }
+
+    video_index = av_find_best_stream(format, AVMEDIA_TYPE_VIDEO, -1, -1, &codec, 0);
+    audio_index = av_find_best_stream(format, AVMEDIA_TYPE_AUDIO, -1, -1, NULL, 0);
+
+    if ((video_index < 0) || (audio_index < 0)) {
+        printf("%s is missing its video or its audio\n", path);
+        avformat_close_input(&format);
+        return false;
+    }
+
+    context = avcodec_alloc_context3(codec);
+    is_ok = (context != NULL) &&
+            (avcodec_parameters_to_context(context, format->streams[video_index]->codecpar) >= 0) &&
+            (avcodec_open2(context, codec, NULL) >= 0);
+
+    if (!is_ok) {
+        printf("Failed to open the video decoder\n");
+    } else {
+        is_ok = read_packets(format, context, video_index, audio_index);
+    }
+
+    avcodec_free_context(&context);
+    avformat_close_input(&format);
+    return is_ok;
+}
+
+int main(int argc, char* argv[]) {
+    const char* path = (argc > 1) ? argv[1] : "capture_check.mkv";
+
+    if (!capture(path) || !read_back(path)) {
+        return 1;
+    }
+
+    printf("SDLCapture: %d frames and %" SDL_PRIs64 " audio samples read back from %s with their checksums\n",
+           FRAME_COUNT,
+           audio_sample_count,
+           path);
+    return 0;
+}
@@ -0,0 +1,301 @@
+import argparse
+import bisect
+import struct
+import sys
+import zlib
+from pathlib import Path
+
+# Finds the first frame where two runs of the same inputs diverge, and the fields that differ.
+#
+# Record a match with --record-replays, then play it back in both configurations (two builds, two compilers,
+# two machines...) with the Replay menu and either of:
+#
+#   --state-hash-log <file>  one line of hashes per frame, cheap enough to leave on
+#   --state-dump <file>      the full state of every frame
+#
+# Usage:
+#   python3 tools/check_determinism.py a.log b.log    first frame and region where the hashes differ
+#   python3 tools/check_determinism.py a.dump b.dump  first frame and the exact fields that differ
+#
+# Dumps name every field, so they can be compared across builds with different struct layouts.
+
+dump_magic = 0x50445333
+dump_version = 2
+
+# Matches SimStateKind
+kinds = ("s8", "u8", "s16", "u16", "s32", "u32", "s64", "u64", "f32", "f64", "bool", "ptr", "raw")
+kind_formats = {
+    "s8": "<b",
+    "u8": "<B",
+    "s16": "<h",
+    "u16": "<H",
+    "s32": "<i",
+    "u32": "<I",
+    "s64": "<q",
+    "u64": "<Q",
+    "f32": "<f",
+    "f64": "<d",
+    "bool": "<B",
+    "ptr": "<Q",
+}
+float_bits_formats = {"f32": "<I", "f64": "<Q"}
+
+pointer_arena = 1 << 63
+pointer_image = 1 << 62
+
+
+class Leaf:
+    def __init__(self, path, kind, elem_size, size, dims, offset):
+        self.path = path
+        self.kind = kind
+        self.elem_size = elem_size
+        self.size = size
+        self.dims = dims
+        self.offset = offset
+
+    def element_path(self, index):
+        if self.size == self.elem_size:
+            return self.path
+
+        d1, d2 = self.dims
+
+        if d2:
+            return f"{self.path}[{index // (d1 * d2)}][{index // d2 % d1}][{index % d2}]"
+
+        if d1:
+            return f"{self.path}[{index // d1}][{index % d1}]"
+
+        return f"{self.path}[{index}]"
+
+    def format_value(self, data):
+        if self.kind not in kind_formats:
+            return data.hex()
+
+        value = struct.unpack(kind_formats[self.kind], data)[0]
+
+        if self.kind == "ptr":
+            if value == 0:
+                return "NULL"
+
+            if value & pointer_arena:
+                return f"arena+0x{value & ~pointer_arena:x}"
+
+            if value & pointer_image:
+                return f"image+0x{value & ~pointer_image:x}"
+
+            return "(outside the arena and the image)"
+
+        if self.kind in float_bits_formats:
+            bits = struct.unpack(float_bits_formats[self.kind], data)[0]
+            return f"{value!r} (0x{bits:0{self.elem_size * 2}x})"
+
+        return str(value)
+
+
+class Dump:
+    def __init__(self, path):
+        self.data = Path(path).read_bytes()
+        magic, version, leaf_count = struct.unpack_from("<III", self.data, 0)
+
+        if magic != dump_magic or version != dump_version:
+            raise ValueError(f"{path} is not a state dump of version {dump_version}")
+
+        self.leaves = []
+        pos = 12
+        offset = 0
+
+        for _ in range(leaf_count):
+            (path_len,) = struct.unpack_from("<H", self.data, pos)
+            leaf_path = self.data[pos + 2 : pos + 2 + path_len].decode()
+            pos += 2 + path_len
+            kind, elem_size, size, d1, d2 = struct.unpack_from("<BIIII", self.data, pos)
+            pos += 17
+            self.leaves.append(Leaf(leaf_path, kinds[kind], elem_size, size, (d1, d2), offset))
+            offset += size
+
+        self.offsets = [leaf.offset for leaf in self.leaves]
+        self.by_path = {leaf.path: leaf for leaf in self.leaves}
+        self.layout = [(leaf.path, leaf.kind, leaf.size) for leaf in self.leaves]
+        self.frames_pos = pos
+
+    def frames(self):
+        """Yields (frame, state) for every record."""
+        pos = self.frames_pos
+        state = None
+
+        while pos + 12 <= len(self.data):
+            frame, size, deflated_size = struct.unpack_from("<III", self.data, pos)
+            pos += 12
+
+            if pos + deflated_size > len(self.data):
+                break
+
+            delta = zlib.decompress(self.data[pos : pos + deflated_size])
+            pos += deflated_size
+
+            if state is None:
+                state = delta
+            else:
+                state = (int.from_bytes(state, "little") ^ int.from_bytes(delta, "little")).to_bytes(size, "little")
+
+            yield frame, state
+
+    def find_leaf(self, offset):
+        return self.leaves[bisect.bisect_right(self.offsets, offset) - 1]
+
+
+def diff_same_layout(dump, state_a, state_b):
+    """Yields (leaf, leaf, element index) for each differing element, for dumps with the same layout."""
+    diff = int.from_bytes(state_a, "little") ^ int.from_bytes(state_b, "little")
+
+    while diff:
+        offset = (diff & -diff).bit_length() // 8
+        leaf = dump.find_leaf(offset)
+        index = (offset - leaf.offset) // leaf.elem_size
+        yield leaf, leaf, index
+
+        # Continue after this element
+        end = leaf.offset + (index + 1) * leaf.elem_size
+        diff &= ~((1 << (end * 8)) - 1)
+
+
+def diff_by_path(dump_a, dump_b, state_a, state_b):
+    """Yields (leaf a, leaf b, element index) for each differing element of the fields that both dumps have."""
+    for leaf_a in dump_a.leaves:
+        leaf_b = dump_b.by_path.get(leaf_a.path)
+
+        if leaf_b is None or leaf_b.size != leaf_a.size or leaf_b.elem_size != leaf_a.elem_size:
+            continue
+
+        data_a = state_a[leaf_a.offset : leaf_a.offset + leaf_a.size]
+        data_b = state_b[leaf_b.offset : leaf_b.offset + leaf_b.size]
+
+        if data_a == data_b:
+            continue
+
+        for index in range(leaf_a.size // leaf_a.elem_size):
+            start = index * leaf_a.elem_size
+            end = start + leaf_a.elem_size
+
+            if data_a[start:end] != data_b[start:end]:
+                yield leaf_a, leaf_b, index
+
+
+def compare_dumps(path_a, path_b, max_fields):
+    dump_a = Dump(path_a)
+    dump_b = Dump(path_b)
+    same_layout = dump_a.layout == dump_b.layout
+
+    if not same_layout:
+        only_a = set(dump_a.by_path) - set(dump_b.by_path)
+        only_b = set(dump_b.by_path) - set(dump_a.by_path)
+        print(f"The dumps have different layouts: {len(only_a)} fields only in A, {len(only_b)} only in B")
+
+        for leaf_path in sorted(only_a)[:max_fields]:
+            print(f"  only in A: {leaf_path}")
+
+        for leaf_path in sorted(only_b)[:max_fields]:
+            print(f"  only in B: {leaf_path}")
+
+    frames_b = dump_b.frames()
+    frame_count = 0
+
+    for frame_a, state_a in dump_a.frames():
+        frame_b, state_b = next(frames_b, (None, None))
+
+        if frame_b is None:
+            print(f"B ends before frame {frame_a}, after {frame_count} matching frames")
+            return 0
+
+        if frame_b != frame_a:
+            print(f"The dumps cover different frames: {frame_a} in A, {frame_b} in B")
+            return 1
+
+        if same_layout:
+            differences = diff_same_layout(dump_a, state_a, state_b) if state_a != state_b else iter(())
+        else:
+            differences = diff_by_path(dump_a, dump_b, state_a, state_b)
+
+        differences = list(differences)
+
+        if differences:
+            print(f"First difference at frame {frame_a}, {len(differences)} fields differ:")
+
+            for leaf_a, leaf_b, index in differences[:max_fields]:
+                start_a = leaf_a.offset + index * leaf_a.elem_size
+                start_b = leaf_b.offset + index * leaf_b.elem_size
+                value_a = leaf_a.format_value(state_a[start_a : start_a + leaf_a.elem_size])
+                value_b = leaf_b.format_value(state_b[start_b : start_b + leaf_b.elem_size])
+                print(f"  {leaf_a.element_path(index)} ({leaf_a.kind}): {value_a} != {value_b}")
+
+            if len(differences) > max_fields:
+                print(f"  ... and {len(differences) - max_fields} more")
+
+            return 1
+
+        frame_count += 1
+
+    if next(frames_b, None) is not None:
+        print(f"A ends before B, after {frame_count} matching frames")
+    else:
+        print(f"No differences in {frame_count} frames")
+
+    return 0
+
+
+def read_hash_log(path):
+    lines = Path(path).read_text().splitlines()
+    regions = lines[0].split()[2:]
+    frames = {}
+
+    for line in lines[1:]:
+        values = line.split()
+
+        if len(values) == len(regions) + 2:
+            frames[int(values[0])] = values[1:]
+
+    return regions, frames
+
+
+def compare_hash_logs(path_a, path_b):
+    regions_a, frames_a = read_hash_log(path_a)
+    regions_b, frames_b = read_hash_log(path_b)
+
+    if regions_a != regions_b:
+        print("The logs hash different regions")
+        return 1
+
+    common = sorted(set(frames_a) & set(frames_b))
+
+    for frame in common:
+        hashes_a = frames_a[frame]
+        hashes_b = frames_b[frame]
+
+        if hashes_a != hashes_b:
+            differing = [regions_a[i] for i in range(len(regions_a)) if hashes_a[i + 1] != hashes_b[i + 1]]
+            print(f"First difference at frame {frame}, in: {', '.join(differing)}")
+            print("Dump both runs with --state-dump to find the fields that differ")
+            return 1
+
+    print(f"No differences in {len(common)} frames")
+    return 0
+
+
+def main():
+    parser = argparse.ArgumentParser(description="Compare state hash logs or state dumps of two runs")
+    parser.add_argument("a")
+    parser.add_argument("b")
+    parser.add_argument("--max-fields", type=int, default=20, help="Number of differing fields to print")
+    args = parser.parse_args()
+
+    with open(args.a, "rb") as f:
+        is_dump = f.read(4) == struct.pack("<I", dump_magic)
+
+    if is_dump:
+        return compare_dumps(args.a, args.b, args.max_fields)
+
+    return compare_hash_logs(args.a, args.b)
+
+
+if __name__ == "__main__":
+    sys.exit(main())
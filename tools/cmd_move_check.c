@@ -0,0 +1,311 @@
+/**
+ * @file cmd_move_check.c
+ * Checks that cmd_move recognizes the same moves as the walk over all 56 move slots it replaced
+ *
+ * Every character is driven with random motions and buttons, on both command sets. Each frame, the input is
+ * picked up once, then the old walk and cmd_move both run from that same state, and everything they can touch
+ * has to match afterwards. Special moves are turned off and back on now and then, like the game can.
+ *
+ * The inputs are random, not recorded from matches, since there are no recordings here.
+ */
+
+#include "common.h"
+#include "sf33rd/Source/Game/engine/cmd_data.h"
+#include "sf33rd/Source/Game/engine/cmd_main.h"
+#include "sf33rd/Source/Game/engine/hitcheck.h"
+#include "sf33rd/Source/Game/engine/plcnt.h"
+#include "sf33rd/Source/Game/engine/pls01.h"
+#include "sf33rd/Source/Game/engine/workuser.h"
+#include "sf33rd/Source/Game/system/sysdir.h"
+
+#include <SDL3/SDL.h>
+
+#include <stdio.h>
+#include <string.h>
+
+#define CHARACTER_COUNT 20
+#define ROUNDS 8
+#define FRAMES_PER_ROUND 20000
+
+// Lever directions by numpad notation, 5 is neutral
+static const u16 lever_bits[10] = { 0, 0x6, 0x2, 0xA, 0x4, 0, 0x8, 0x5, 0x1, 0x9 };
+
+// Motions that the move tables are made of, as numpad digits for a player facing right
+static const char* motions[] = {
+    "236", "214", "623", "421", "41236", "63214", "236236", "214214", "2369", "2147", "22", "66", "44", "28",
+    "46", "5",   "8",   "2",   "6",     "4",     "3",      "1",      "9",    "7",    "6321478", "2684",
+};
+
+typedef struct Snapshot {
+    WORK_CP wcp[2];
+    T_PL_LVR t_pl_lvr[2];
+    WAZA_WORK waza_work[2][56];
+    PLW plw[2];
+    s16 cmd_id;
+    s16* cmd_tbl_ptr;
+    u16 sw_work;
+    T_PL_LVR* chk_pl;
+    s16 waza_type[2];
+    WAZA_WORK* waza_ptr;
+    PLW* cmd_pl;
+} Snapshot;
+
+extern void (*chk_move_jp[28])();
+
+// Stand-ins for the parts of the game that the move checks call out to
+GameState gs;
+char cmd_sel[2];
+s16 omop_b_block_ix[2];
+const s16 blok_b_omake[4] = { 0, 0, 0, 0 };
+
+s16 check_rl_on_car(PLW* wk) {
+    return wk->wu.rl_waza;
+}
+
+void make_red_blocking_time(s16 /* unused */, s16 /* unused */, s16 /* unused */) {}
+
+static u32 random_state = 1;
+static s32 recognized_count = 0;
+static s32 live_count = 0;
+
+static u32 next_random() {
+    random_state ^= random_state << 13;
+    random_state ^= random_state >> 17;
+    random_state ^= random_state << 5;
+    return random_state;
+}
+
+/// @brief The walk over all 56 slots that cmd_move used to do.
+static void cmd_move_reference() {
+    s16 j;
+    intptr_t* adrs;
+
+    cmd_id = cmd_pl->wu.id;
+
+    if (cmd_sel[cmd_id]) {
+        adrs = pl_CMD[cmd_pl->player_number];
+    } else {
+        adrs = pl_cmd[cmd_pl->player_number];
+    }
+
+    for (j = 0; j < 56; j++) {
+        if (wcp[cmd_id].waza_flag[j] != -1) {
+            waza_type[cmd_id] = j;
+            cmd_tbl_ptr = (s16*)adrs[j];
+            waza_ptr = &waza_work[cmd_id][j];
+            chk_move_jp[waza_ptr->w_type]();
+        }
+    }
+
+    for (j = 0; j < 56; j++) {
+        if ((wcp[cmd_id].waza_flag[j] != -1) && (wcp[cmd_id].waza_flag[j] != 0)) {
+            waza_ptr = &waza_work[cmd_id][j];
+            command_ok_move(j);
+        }
+    }
+}
+
+static void save(Snapshot* snapshot) {
+    memcpy(snapshot->wcp, wcp, sizeof(wcp));
+    memcpy(snapshot->t_pl_lvr, t_pl_lvr, sizeof(t_pl_lvr));
+    memcpy(snapshot->waza_work, waza_work, sizeof(waza_work));
+    memcpy(snapshot->plw, gs.plw, sizeof(gs.plw));
+    memcpy(snapshot->waza_type, waza_type, sizeof(waza_type));
+    snapshot->cmd_id = cmd_id;
+    snapshot->cmd_tbl_ptr = cmd_tbl_ptr;
+    snapshot->sw_work = sw_work;
+    snapshot->chk_pl = chk_pl;
+    snapshot->waza_ptr = waza_ptr;
+    snapshot->cmd_pl = cmd_pl;
+}
+
+static void load(const Snapshot* snapshot) {
+    memcpy(wcp, snapshot->wcp, sizeof(wcp));
+    memcpy(t_pl_lvr, snapshot->t_pl_lvr, sizeof(t_pl_lvr));
+    memcpy(waza_work, snapshot->waza_work, sizeof(waza_work));
+    memcpy(gs.plw, snapshot->plw, sizeof(gs.plw));
+    memcpy(waza_type, snapshot->waza_type, sizeof(waza_type));
+    cmd_id = snapshot->cmd_id;
+    cmd_tbl_ptr = snapshot->cmd_tbl_ptr;
+    sw_work = snapshot->sw_work;
+    chk_pl = snapshot->chk_pl;
+    waza_ptr = snapshot->waza_ptr;
+    cmd_pl = snapshot->cmd_pl;
+}
+
+/// @brief Find the first field that differs, `NULL` if there is none.
+static const char* compare(const Snapshot* a, const Snapshot* b) {
+#define COMPARE(field)                                                                                                 \
+    if (memcmp(&a->field, &b->field, sizeof(a->field)) != 0) {                                                         \
+        return #field;                                                                                                 \
+    }
+
+    COMPARE(wcp);
+    COMPARE(t_pl_lvr);
+    COMPARE(waza_work);
+    COMPARE(plw);
+    COMPARE(waza_type);
+    COMPARE(cmd_id);
+    COMPARE(cmd_tbl_ptr);
+    COMPARE(sw_work);
+    COMPARE(chk_pl);
+    COMPARE(waza_ptr);
+    COMPARE(cmd_pl);
+    return NULL;
+#undef COMPARE
+}
+
+/// @brief Pick the lever and buttons of the next frame, mostly by playing motions with random timing.
+static u16 next_input(const char** motion, s16* hold) {
+    u16 buttons = 0;
+    s32 digit;
+
+    if (*hold > 0) {
+        *hold -= 1;
+    } else if ((*motion)[0] != '\0' && (*motion)[1] != '\0') {
+        *motion += 1;
+        *hold = next_random() % 4;
+    } else {
+        *motion = motions[next_random() % SDL_arraysize(motions)];
+        *hold = (next_random() % 8 == 0) ? 40 + next_random() % 30 : next_random() % 4;
+    }
+
+    digit = (*motion)[0] - '0';
+
+    // Buttons mostly come at the end of a motion, sometimes pressed together or mashed
+    if (((*motion)[1] == '\0') || (next_random() % 16 == 0)) {
+        switch (next_random() % 4) {
+        case 0:
+            buttons = 0x10 << (next_random() % 3);
+            break;
+
+        case 1:
+            buttons = 0x100 << (next_random() % 3);
+            break;
+
+        case 2:
+            buttons = next_random() & 0x770;
+            break;
+        }
+    }
+
+    return lever_bits[digit] | buttons;
+}
+
+/// @brief Count the moves of `id` that were just recognized, to show that the input reaches the checks.
+static void count_recognized(const Snapshot* before, const Snapshot* after, s16 id, bool* seen) {
+    s16 j;
+
+    for (j = 0; j < 56; j++) {
+        if ((before->wcp[id].waza_flag[j] == 0) && (after->wcp[id].waza_flag[j] > 0)) {
+            recognized_count += 1;
+            seen[j] = true;
+        }
+    }
+}
+
+static bool run_character(s16 character) {
+    static Snapshot start;
+    static Snapshot reference;
+    static Snapshot result;
+    const char* motion[2] = { motions[0], motions[0] };
+    s16 hold[2] = { 0, 0 };
+    s16 dead[2];
+    bool seen[56] = { false };
+    s32 round;
+    s32 frame;
+    s16 id;
+
+    for (round = 0; round < ROUNDS; round++) {
+        memset(&gs, 0, sizeof(gs));
+        memset(t_pl_lvr, 0, sizeof(t_pl_lvr));
+        cmd_sel[0] = round & 1;
+        cmd_sel[1] = (round >> 1) & 1;
+
+        for (id = 0; id < 2; id++) {
+            gs.plw[id].wu.id = id;
+            gs.plw[id].player_number = character;
+            omop_b_block_ix[id] = 0;
+            cmd_init(&gs.plw[id]);
+            dead[id] = -1;
+        }
+
+        for (frame = 0; frame < FRAMES_PER_ROUND; frame++) {
+            for (id = 0; id < 2; id++) {
+                PLW* pl = &gs.plw[id];
+
+                if (next_random() % 600 == 0) {
+                    pl->wu.rl_flag ^= 1;
+                    pl->wu.rl_waza = pl->wu.rl_flag;
+                }
+
+                // The game resets single moves now and then
+                if (next_random() % 2000 == 0) {
+                    waza_flag_clear_only_1(id, waza_live[id][next_random() % waza_live_num[id]]);
+                }
+
+                // A special move is turned off, and back on with a flag set like the debug menu and the training
+                // dummy do. The first 16 moves are always listed, and the parry checks write to some of them.
+                if (next_random() % 3000 == 0) {
+                    if (dead[id] == -1) {
+                        dead[id] = waza_live[id][16 + next_random() % (waza_live_num[id] - 16)];
+                        waza_flag_set(id, dead[id], -1);
+                    } else {
+                        waza_flag_set(id, dead[id], 9);
+                        dead[id] = -1;
+                    }
+                }
+
+                wcp[id].sw_lvbt = next_input(&motion[id], &hold[id]);
+                key_thru(pl);
+                save(&start);
+
+                cmd_move_reference();
+                save(&reference);
+
+                load(&start);
+                cmd_move();
+                save(&result);
+
+                const char* field = compare(&reference, &result);
+
+                if (field != NULL) {
+                    printf("Character %d, round %d, frame %d, player %d: %s differs\n",
+                           character,
+                           round,
+                           frame,
+                           id,
+                           field);
+                    return false;
+                }
+
+                count_recognized(&start, &result, id, seen);
+            }
+        }
+    }
+
+    for (id = 0; id < 56; id++) {
+        live_count += seen[id];
+    }
+
+    return true;
+}
+
+int main() {
+    s16 character;
+    s32 failures = 0;
+
+    for (character = 0; character < CHARACTER_COUNT; character++) {
+        if (!run_character(character)) {
+            failures += 1;
+        }
+    }
+
+    printf("cmd_move: %d of %d characters match over %d frames each, %d moves recognized, %d different ones\n",
+           CHARACTER_COUNT - failures,
+           CHARACTER_COUNT,
+           ROUNDS * FRAMES_PER_ROUND * 2,
+           recognized_count,
+           live_count);
+    return (failures == 0) ? 0 : 1;
+}
@@ -0,0 +1,235 @@
+/**
+ * @file effect_pool_check.c
+ * Checks that the occupancy bitmap of the effect pool finds the same slots as walking the effect lists, and times both
+ *
+ * Effects are pulled into random lists and pushed back at random, and lists are cleared now and then, like a match
+ * does. After every change, the slots that next_effect_work visits have to be exactly the ones in the 8 lists, and
+ * the free stack has to hold the rest.
+ */
+
+#include "common.h"
+#include "sf33rd/Source/Game/debug/Debug.h"
+#include "sf33rd/Source/Game/effect/effect.h"
+#include "sf33rd/Source/Game/engine/workuser.h"
+#include "sf33rd/Source/Game/stage/bg.h"
+
+#include <SDL3/SDL.h>
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#define STEP_COUNT 2000000
+#define HOT_RUNS 200000
+#define COLD_RUNS 200
+
+// Bigger than the caches, to evict the effect slots from them
+#define EVICTION_SIZE (32 * 1024 * 1024)
+
+// Stand-ins for the parts of the game that the rest of effect.c calls out to
+GameState gs;
+s8 Debug_w[72];
+u8 Country;
+s8 another_bg[2];
+BG bg_w;
+const void (*effmovejptbl[1])();
+
+void fatal_error(const s8* fmt, ...) {
+    printf("%s\n", fmt);
+    exit(1);
+}
+
+s32 flPrintL(s32 /* unused */, s32 /* unused */, const s8* /* unused */, ...) {
+    return 0;
+}
+
+void pp_screen_quake(s16 /* unused */) {}
+
+static u32 random_state = 1;
+
+static u32 next_random() {
+    random_state ^= random_state << 13;
+    random_state ^= random_state >> 17;
+    random_state ^= random_state << 5;
+    return random_state;
+}
+
+/// @brief Mark the slots in the lists, the way the pool was walked before it had a bitmap.
+/// @return Number of slots in the lists.
+static s32 walk_lists(bool* is_listed) {
+    const WORK* wk;
+    s32 count = 0;
+    s16 index;
+    s16 ix;
+
+    SDL_memset(is_listed, 0, sizeof(bool) * EFFECT_MAX);
+
+    for (index = 0; index < 8; index++) {
+        for (ix = head_ix[index]; ix != -1; ix = wk->behind) {
+            wk = (const WORK*)frw[ix];
+            is_listed[ix] = true;
+            count += 1;
+        }
+    }
+
+    return count;
+}
+
+static bool check_pool(s32 step) {
+    bool is_listed[EFFECT_MAX];
+    bool is_free[EFFECT_MAX];
+    const s32 listed_count = walk_lists(is_listed);
+    s32 visited_count = 0;
+    s16 ix;
+    s16 i;
+
+    for (ix = next_effect_work(0); ix != -1; ix = next_effect_work(ix + 1)) {
+        if (!is_listed[ix]) {
+            printf("Step %d: slot %d is marked in use but isn't in a list\n", step, ix);
+            return false;
+        }
+
+        visited_count += 1;
+    }
+
+    if (visited_count != listed_count) {
+        printf("Step %d: %d slots are marked in use, %d are in the lists\n", step, visited_count, listed_count);
+        return false;
+    }
+
+    SDL_memset(is_free, 0, sizeof(is_free));
+
+    for (i = 0; i < frwctr; i++) {
+        is_free[frwque[i]] = true;
+    }
+
+    for (ix = 0; ix < EFFECT_MAX; ix++) {
+        if (is_free[ix] == is_listed[ix]) {
+            printf("Step %d: slot %d is %s\n",
+                   step,
+                   ix,
+                   is_free[ix] ? "free and in a list" : "neither free nor listed");
+            return false;
+        }
+    }
+
+    return true;
+}
+
+/// @brief Pick a random slot in use, found the way the effects find each other.
+static s16 pick_live_slot() {
+    const s16 ix = next_effect_work(next_random() % EFFECT_MAX);
+
+    return (ix != -1) ? ix : next_effect_work(0);
+}
+
+/// @brief Make one random change to the pool, mostly pulls and pushes.
+static void change_pool() {
+    const u32 action = next_random() % 1000;
+
+    if (action == 0) {
+        effect_work_init();
+    } else if (action < 4) {
+        effect_work_quick_init();
+    } else if (action < 10) {
+        effect_work_list_init(next_random() % 8, -1);
+    } else if ((action < 500) || (frwctr == EFFECT_MAX)) {
+        pull_effect_work(next_random() % 8);
+    } else {
+        push_effect_work((WORK*)frw[pick_live_slot()]);
+    }
+}
+
+static u32 walk_by_lists() {
+    const WORK* wk;
+    u32 sum = 0;
+    s16 index;
+    s16 ix;
+
+    for (index = 0; index < 8; index++) {
+        for (ix = head_ix[index]; ix != -1; ix = wk->behind) {
+            wk = (const WORK*)frw[ix];
+            sum += wk->id;
+        }
+    }
+
+    return sum;
+}
+
+static u32 walk_by_bitmap() {
+    u32 sum = 0;
+    s16 ix;
+
+    for (ix = next_effect_work(0); ix != -1; ix = next_effect_work(ix + 1)) {
+        sum += ((const WORK*)frw[ix])->id;
+    }
+
+    return sum;
+}
+
+/// @brief Time a walk over the slots in use, with the slots in the cache or evicted from it before each walk.
+static double time_walk(u32 (*walk)(), bool is_cold, s32 runs, u32* sum) {
+    static u8 eviction[EVICTION_SIZE];
+    Uint64 total_ns = 0;
+    Uint64 start;
+    s32 i;
+    s32 j;
+
+    for (i = 0; i < runs; i++) {
+        if (is_cold) {
+            for (j = 0; j < EVICTION_SIZE; j += 64) {
+                eviction[j] += 1;
+            }
+        }
+
+        start = SDL_GetTicksNS();
+        *sum += walk();
+        total_ns += SDL_GetTicksNS() - start;
+    }
+
+    return (double)total_ns / runs;
+}
+
+static void benchmark() {
+    u32 sum = 0;
+    s32 i;
+
+    effect_work_init();
+
+    // A busy match: a few dozen effects spread over the lists, with holes from the ones that ended
+    for (i = 0; i < 60; i++) {
+        pull_effect_work(next_random() % 8);
+    }
+
+    for (i = 0; i < 20; i++) {
+        push_effect_work((WORK*)frw[pick_live_slot()]);
+    }
+
+    printf("%d effects in use, cached: lists %.1f ns per walk, bitmap %.1f ns per walk\n",
+           EFFECT_MAX - frwctr,
+           time_walk(walk_by_lists, false, HOT_RUNS, &sum),
+           time_walk(walk_by_bitmap, false, HOT_RUNS, &sum));
+    printf("%d effects in use, not cached: lists %.1f ns per walk, bitmap %.1f ns per walk (%u)\n",
+           EFFECT_MAX - frwctr,
+           time_walk(walk_by_lists, true, COLD_RUNS, &sum),
+           time_walk(walk_by_bitmap, true, COLD_RUNS, &sum),
+           sum & 1);
+}
+
+int main() {
+    s32 step;
+
+    effect_work_init();
+
+    for (step = 0; step < STEP_COUNT; step++) {
+        change_pool();
+
+        if (!check_pool(step)) {
+            return 1;
+        }
+    }
+
+    printf("frw_live: %d random pool changes, the marked slots match the effect lists\n", STEP_COUNT);
+    benchmark();
+    return 0;
+}
@@ -0,0 +1,442 @@
+import re
+from pathlib import Path
+
+# Generates the list of globals that make up the simulation state (used by replay keyframes and state dumps):
+#   src/sf33rd/Source/Game/system/sim_state_vars.h    extern declarations of the globals
+#   src/sf33rd/Source/Game/system/sim_state_vars.inc  SIM_STATE_VAR(...) for each global
+#   src/sf33rd/Source/Game/system/sim_state_types.inc SIM_STATE_FIELD(...) for each field of the structs they use
+#
+# Usage: python3 tools/gen_sim_state.py
+#
+# Every non-static variable defined at file scope in one of the files below is listed.
+# Re-run the script after adding or removing globals in these files, or fields in the structs they use.
+#
+# Each variable and field gets a kind, so that state dumps can name the exact field that differs and print its value.
+# Unions, enums and types that can't be resolved are compared as raw bytes.
+
+repo_root = Path(__file__).resolve().parent.parent
+game_src = repo_root / "src/sf33rd/Source/Game"
+header_path = game_src / "system/sim_state_vars.h"
+list_path = game_src / "system/sim_state_vars.inc"
+types_path = game_src / "system/sim_state_types.inc"
+
+state_files = (
+    "engine/workuser.c",
+    "engine/cmd_data.c",
+    "system/work_sys.c",
+    "system/sys_sub.c",
+    "effect/effect.c",
+    "stage/bg.c",
+    "engine/hitcheck.c",
+    "engine/plcnt.c",
+    "engine/cmb_win.c",
+    "engine/grade.c",
+    "engine/spgauge.c",
+    "engine/slowf.c",
+    "engine/stun.c",
+    "engine/vital.c",
+    "engine/plpat14.c",
+    "count.c",
+    "sc_sub.c",
+    "com/com_sub.c",
+    "com/ck_pass.c",
+    "debug/Debug.c",
+    "io/ioconv.c",
+)
+
+# Headers that struct definitions are read from
+type_dirs = (
+    repo_root / "include/sf33rd",
+    repo_root / "src/sf33rd",
+)
+type_files = (repo_root / "include/structs.h",)
+
+# Globals in the files above that are not simulation state.
+excluded_vars = {
+    "Replay_w",  # Recorded inputs, streamed separately
+    "Force_No_Trans",  # Set by headless runs, not by the game
+}
+
+# Globals that are declared as raw storage but hold structs. Each element is dumped as the given struct, followed by
+# the rest of the element as raw bytes.
+var_views = {
+    "frw": "WORK_Other",  # Effects. Every effect starts with WORK_Other or a struct with the same head
+}
+
+# Other structs that the storage above is used as. Past the head they share with the view, they must not hold
+# pointers, since the rest of each element is stored as raw bytes and can't be relocated when a keyframe is loaded.
+var_view_variants = {
+    "frw": ("WORK_Other_CONN", "WORK_Other_JUDGE"),
+}
+
+scalar_kinds = {
+    "s8": "S8",
+    "char": "S8",
+    "signed char": "S8",
+    "u8": "U8",
+    "unsigned char": "U8",
+    "u_char": "U8",
+    "s16": "S16",
+    "short": "S16",
+    "u16": "U16",
+    "unsigned short": "U16",
+    "u_short": "U16",
+    "s32": "S32",
+    "int": "S32",
+    "u32": "U32",
+    "unsigned int": "U32",
+    "u_int": "U32",
+    "s64": "S64",
+    "u64": "U64",
+    "u_long": "U64",
+    "f32": "F32",
+    "float": "F32",
+    "f64": "F64",
+    "double": "F64",
+    "bool": "BOOL",
+    "intptr_t": "PTR",
+    "uintptr_t": "PTR",
+}
+
+definition_re = re.compile(
+    r"^(?:volatile\s+)?(?:struct\s+)?[A-Za-z_]\w*(?:\s+[A-Za-z_]\w*)*[\s*]+([A-Za-z_]\w*)\s*(?:\[[^\]]*\])*\s*(?:=.*)?;\s*$"
+)
+type_re = re.compile(r"^((?:(?:const|volatile|struct|union|enum|unsigned|signed)\s+)*[A-Za-z_]\w*)(.*)$")
+skipped_prefixes = ("static", "extern", "typedef", "#", "return", "//")
+qualifiers = {"const", "volatile", "static", "register"}
+
+
+def read_definitions(path):
+    """Returns (name, declaration) for each global defined in the file."""
+    definitions = []
+
+    for line in path.read_text().splitlines():
+        if line.startswith(skipped_prefixes) or line.startswith((" ", "\t")):
+            continue
+
+        # Constant tables aren't state, but pointers to constant data are
+        if line.startswith("const ") and "*" not in line.split("=")[0]:
+            continue
+
+        match = definition_re.match(line)
+
+        if match:
+            declaration = line.split("=")[0].rstrip().rstrip(";").rstrip()
+            definitions.append((match.group(1), declaration))
+
+    return definitions
+
+
+def strip_comments(text):
+    text = re.sub(r"/\*.*?\*/", " ", text, flags=re.S)
+    text = re.sub(r"//[^\n]*", "", text)
+    return re.sub(r"^\s*#[^\n]*", "", text, flags=re.M)
+
+
+def find_closing_brace(text, start):
+    """Returns the index of the brace that closes the one at `start`."""
+    depth = 0
+
+    for i in range(start, len(text)):
+        if text[i] == "{":
+            depth += 1
+        elif text[i] == "}":
+            depth -= 1
+
+            if depth == 0:
+                return i
+
+    raise ValueError("Unbalanced braces")
+
+
+def split_top_level(text, separator):
+    parts = []
+    depth = 0
+    current = ""
+
+    for c in text:
+        if c in "{(":
+            depth += 1
+        elif c in "})":
+            depth -= 1
+
+        if c == separator and depth == 0:
+            parts.append(current.strip())
+            current = ""
+        else:
+            current += c
+
+    if current.strip():
+        parts.append(current.strip())
+
+    return parts
+
+
+class TypeTable:
+    def __init__(self):
+        self.structs = {}  # name -> (spelling, body)
+        self.unions = set()
+        self.enums = set()
+        self.aliases = {}  # name -> type text
+
+    def read_header(self, path):
+        text = strip_comments(path.read_text(errors="replace"))
+        record_re = re.compile(r"\b(typedef\s+)?(struct|union|enum)\s*([A-Za-z_]\w*)?\s*\{")
+        pos = 0
+
+        while True:
+            match = record_re.search(text, pos)
+
+            if match is None:
+                break
+
+            end = find_closing_brace(text, match.end() - 1)
+            body = text[match.end() : end]
+            is_typedef, kind, tag = match.group(1), match.group(2), match.group(3)
+            names = []
+
+            if tag:
+                names.append((tag, f"{kind} {tag}"))
+
+            if is_typedef:
+                declarators = text[end + 1 : text.index(";", end)]
+
+                for declarator in split_top_level(declarators, ","):
+                    if declarator and "*" not in declarator:
+                        names.append((declarator, declarator))
+
+            for name, spelling in names:
+                if kind == "struct":
+                    self.structs.setdefault(name, (spelling, body))
+                elif kind == "union":
+                    self.unions.add(name)
+                else:
+                    self.enums.add(name)
+
+            # Nested definitions are members of the outer record, not types of their own
+            pos = end + 1
+
+        for match in re.finditer(r"\btypedef\s+([^;{}()]+?)\s*([A-Za-z_]\w*)\s*;", text):
+            type_text, name = match.group(1), match.group(2)
+
+            if not re.match(r"(union|enum)\b", type_text):
+                self.aliases.setdefault(name, type_text)
+
+    def resolve(self, type_text):
+        """Returns (kind, struct name) for a base type, following typedefs."""
+        words = [w for w in type_text.replace("*", " * ").split() if w not in qualifiers]
+
+        if "*" in words:
+            return "PTR", None
+
+        base = " ".join(words)
+
+        if base in scalar_kinds:
+            return scalar_kinds[base], None
+
+        if base.startswith(("union ", "enum ")):
+            return "RAW", None
+
+        name = base.split()[-1] if base else ""
+
+        if name in self.structs:
+            return "STRUCT", name
+
+        if name in self.unions or name in self.enums:
+            return "RAW", None
+
+        if name in self.aliases and self.aliases[name] != base:
+            return self.resolve(self.aliases[name])
+
+        return "RAW", None
+
+
+def parse_declarator(declarator):
+    """Returns (name, dims, is_pointer) for a declarator like `*name[2][3]` or `(*name)()`."""
+    function_match = re.match(r"\(\s*\*\s*([A-Za-z_]\w*)\s*((?:\[[^\]]*\])*)\s*\)\s*\(.*\)$", declarator)
+
+    if function_match:
+        return function_match.group(1), re.findall(r"\[([^\]]*)\]", function_match.group(2)), True
+
+    match = re.match(r"^(\**)\s*([A-Za-z_]\w*)\s*((?:\[[^\]]*\])*)$", declarator)
+
+    if match is None:
+        return None
+
+    return match.group(2), re.findall(r"\[([^\]]*)\]", match.group(3)), match.group(1) != ""
+
+
+def describe(types, type_text, declarator):
+    """Returns (name, elem, kind, struct name, d1, d2) for a declaration, or None if it can't be described."""
+    parsed = parse_declarator(declarator.strip())
+
+    if parsed is None:
+        return None
+
+    name, dims, is_pointer = parsed
+    kind, struct_name = ("PTR", None) if is_pointer else types.resolve(type_text)
+
+    if any(d.strip() == "" for d in dims):
+        return None
+
+    if len(dims) > 3:
+        # Deeper arrays are compared as one raw block
+        return name, name, "RAW", None, "0", "0"
+
+    inner = [d.strip() for d in dims[1:]] + ["0", "0"]
+    return name, name + "[0]" * len(dims), kind, struct_name, inner[0], inner[1]
+
+
+def parse_members(types, body):
+    """Returns the describable members of a struct body and the ones that were skipped."""
+    members = []
+    skipped = []
+
+    for statement in split_top_level(body, ";"):
+        if not statement:
+            continue
+
+        nested = re.match(r"^(struct|union)\s*([A-Za-z_]\w*)?\s*\{", statement)
+
+        if nested:
+            # Anonymous struct or union member: compared as raw bytes under the member name
+            declarators = statement[find_closing_brace(statement, nested.end() - 1) + 1 :]
+
+            for declarator in split_top_level(declarators, ","):
+                described = describe(types, "union", declarator)
+
+                if described is None:
+                    skipped.append(statement)
+                else:
+                    members.append(described)
+
+            if not declarators.strip():
+                skipped.append(statement)
+
+            continue
+
+        if ":" in statement:
+            skipped.append(statement)
+            continue
+
+        function_match = re.match(r"^(.+?)\s*(\(\s*\*.*)$", statement)
+
+        if function_match:
+            type_text, declarators = function_match.group(1), [function_match.group(2)]
+        else:
+            match = type_re.match(statement)
+
+            if match is None:
+                skipped.append(statement)
+                continue
+
+            type_text, declarators = match.group(1), split_top_level(match.group(2), ",")
+
+        for declarator in declarators:
+            described = describe(types, type_text, declarator)
+
+            if described is None:
+                skipped.append(statement)
+            else:
+                members.append(described)
+
+    return members, skipped
+
+
+def has_pointer(types, struct_name):
+    members, _ = parse_members(types, types.structs[struct_name][1])
+    return any(kind == "PTR" or (kind == "STRUCT" and has_pointer(types, sub)) for _, _, kind, sub, _, _ in members)
+
+
+def check_view_variants(types):
+    """Fails if a struct that storage is used as has pointers in the part that is stored as raw bytes."""
+    for var, variants in var_view_variants.items():
+        view_members, _ = parse_members(types, types.structs[var_views[var]][1])
+
+        for variant in variants:
+            members, _ = parse_members(types, types.structs[variant][1])
+            shared = 0
+
+            while shared < min(len(members), len(view_members)) and members[shared] == view_members[shared]:
+                shared += 1
+
+            for name, _, kind, sub, _, _ in members[shared:]:
+                if kind == "PTR" or (kind == "STRUCT" and has_pointer(types, sub)):
+                    raise SystemExit(f"{variant}.{name} is a pointer past the head of {var_views[var]}, {var} can't hold it")
+
+
+def main():
+    notice = "// This file is generated by tools/gen_sim_state.py. Do not edit it by hand."
+    header_lines = [notice, "", "#ifndef SIM_STATE_VARS_H", "#define SIM_STATE_VARS_H", ""]
+    list_lines = [notice, ""]
+    types_lines = [notice, ""]
+
+    types = TypeTable()
+
+    for path in type_files:
+        types.read_header(path)
+
+    for directory in type_dirs:
+        for path in sorted(directory.rglob("*.h")):
+            types.read_header(path)
+
+    check_view_variants(types)
+    used_structs = []
+
+    def use_struct(name):
+        if name is not None and name not in used_structs:
+            used_structs.append(name)
+
+    for source in state_files:
+        module = Path(source).stem
+        header_lines.append(f"// {source}")
+
+        for name, declaration in read_definitions(game_src / source):
+            if name in excluded_vars:
+                continue
+
+            header_lines.append(f"extern {declaration};")
+
+            if name in var_views:
+                var = (name, name + "[0]", "STRUCT", var_views[name], "0", "0")
+            else:
+                match = re.match(r"^(.*?)\b(\**\s*" + name + r"\s*(?:\[[^\]]*\]\s*)*)$", declaration)
+                var = describe(types, match.group(1), match.group(2)) if match else None
+
+            if var is None:
+                var = (name, name, "RAW", None, "0", "0")
+
+            _, elem, kind, struct_name, d1, d2 = var
+            use_struct(struct_name)
+            list_lines.append(f"SIM_STATE_VAR({module}, {name}, {elem}, {kind}, {struct_name or 'NONE'}, {d1}, {d2})")
+
+        header_lines.append("")
+
+    # Structs used by other structs are appended while the list is walked
+    skipped_members = []
+
+    for struct_name in used_structs:
+        spelling, body = types.structs[struct_name]
+        members, skipped = parse_members(types, body)
+        skipped_members += [f"{struct_name}: {s}" for s in skipped]
+        types_lines.append(f"SIM_STATE_TYPE({struct_name}, {spelling})")
+
+        for name, elem, kind, member_struct, d1, d2 in members:
+            use_struct(member_struct)
+            sub = member_struct or "NONE"
+            types_lines.append(f"SIM_STATE_FIELD({struct_name}, {spelling}, {name}, {elem}, {kind}, {sub}, {d1}, {d2})")
+
+        types_lines.append(f"SIM_STATE_TYPE_END({struct_name})")
+        types_lines.append("")
+
+    for member in skipped_members:
+        print(f"Skipped member {member}")
+
+    header_lines.append("#endif")
+    header_path.write_text("\n".join(header_lines) + "\n")
+    list_path.write_text("\n".join(list_lines) + "\n")
+    types_path.write_text("\n".join(types_lines).rstrip("\n") + "\n")
+
+
+if __name__ == "__main__":
+    main()
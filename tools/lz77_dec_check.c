@@ -0,0 +1,445 @@
+/**
+ * @file lz77_dec_check.c
+ * Checks that decLZ77withSizeCheck decodes every stream like the byte by byte decoder it replaced, and times both
+ *
+ * Streams are made of random tokens of every kind, with short and long runs and references that overlap what they
+ * write. Some are plain random bytes, and some are decoded in place, with the stream at the end of the output. The
+ * output and whatever the decoders wrote around it have to match, as well as the result.
+ */
+
+#include "common.h"
+#include "sf33rd/Source/Compress/Lz77/Lz77Dec.h"
+
+#include <SDL3/SDL.h>
+
+#include <stdio.h>
+#include <string.h>
+
+#define STREAM_COUNT 40000
+#define OUTPUT_MAX 0x20000
+
+// Room before the output for references from before its start, and after it for runs past its end
+#define MARGIN 0x10000
+#define STREAM_MAX (OUTPUT_MAX * 2 + MARGIN * 2)
+#define BUFFER_SIZE (MARGIN + OUTPUT_MAX + MARGIN + STREAM_MAX)
+
+#define BENCHMARK_SIZE 0x400000
+#define BENCHMARK_RUNS 16
+
+static u32 random_state = 1;
+static u8 stream[STREAM_MAX];
+static u8 noise[BUFFER_SIZE];
+static u8 buffer[BUFFER_SIZE];
+static u8 reference_buffer[BUFFER_SIZE];
+
+static u32 next_random() {
+    random_state ^= random_state << 13;
+    random_state ^= random_state >> 17;
+    random_state ^= random_state << 5;
+    return random_state;
+}
+
+/// @brief The byte by byte decoder that decLZ77withSizeCheck used to be.
+static s32 reference_decode(u8* src, u8* dst, s32 size) {
+    s32 j;
+    s32 loop;
+    u8* dic;
+    u8 num;
+    u8 step;
+    u16 offset;
+
+    while (size > 0) {
+        offset = *src++;
+
+        if (offset & 0x80) {
+            if (offset & 0x40) {
+                offset = ((offset << 8) | *src++) & 0x3FFF;
+
+                if (offset == 0) {
+                    offset = 0x4000;
+                }
+
+                loop = *src++;
+
+                if (loop & 0x80) {
+                    step = *src++;
+                } else {
+                    step = 0;
+                }
+
+                loop &= 0x7F;
+
+                if (loop == 0) {
+                    loop = 0x80;
+                }
+
+                dic = dst - offset;
+
+                if (step) {
+                    for (j = 0; j < loop; j++) {
+                        *dst++ = *dic + step;
+                        dic++;
+                    }
+                } else {
+                    for (j = 0; j < loop; j++) {
+                        *dst++ = *dic++;
+                    }
+                }
+
+                size -= loop;
+            } else {
+                switch (offset & 0x3F) {
+                case 1:
+                    loop = *src++;
+
+                    if (loop == 0) {
+                        loop = 0x100;
+                    }
+
+                    for (j = 0; j < loop; j++) {
+                        *dst++ = *src++;
+                    }
+
+                    size -= loop;
+                    break;
+
+                case 2:
+                    loop = (src[0] << 8) | src[1];
+                    src += 2;
+
+                    if (loop == 0) {
+                        loop = 0x10000;
+                    }
+
+                    for (j = 0; j < loop; j++) {
+                        *dst++ = *src++;
+                    }
+
+                    size -= loop;
+                    break;
+
+                case 3:
+                    num = *src++;
+                    loop = *src++;
+
+                    if (loop == 0) {
+                        loop = 0x100;
+                    }
+
+                    for (j = 0; j < loop; j++) {
+                        *dst++ = num;
+                    }
+
+                    size -= loop;
+                    break;
+
+                case 4:
+                    num = *src++;
+                    loop = (src[0] << 8) | src[1];
+                    src += 2;
+
+                    if (loop == 0) {
+                        loop = 0x10000;
+                    }
+
+                    for (j = 0; j < loop; j++) {
+                        *dst++ = num;
+                    }
+
+                    size -= loop;
+                    break;
+
+                case 5:
+                    num = *src++;
+                    step = *src++;
+                    loop = *src++;
+
+                    if (loop == 0) {
+                        loop = 0x100;
+                    }
+
+                    for (j = 0; j < loop; j++) {
+                        *dst++ = num;
+                        num += step;
+                    }
+
+                    size -= loop;
+                    break;
+
+                case 6:
+                    num = *src++;
+                    step = *src++;
+                    loop = (src[0] << 8) | src[1];
+                    src += 2;
+
+                    if (loop == 0) {
+                        loop = 0x10000;
+                    }
+
+                    for (j = 0; j < loop; j++) {
+                        *dst++ = num;
+                        num += step;
+                    }
+
+                    size -= loop;
+                    break;
+                }
+            }
+        } else {
+            offset = (offset << 8) | *src++;
+            loop = offset & 0xF;
+
+            if (loop == 0) {
+                loop = 0x10;
+            }
+
+            offset = (offset >> 4) & 0x7FF;
+
+            if (offset == 0) {
+                offset = 0x800;
+            }
+
+            dic = dst - offset;
+
+            for (j = 0; j < loop; j++) {
+                *dst++ = *dic++;
+            }
+
+            size -= loop;
+        }
+    }
+
+    return size == 0;
+}
+
+/// @brief Pick a length that is mostly short, sometimes up to `max`, and now and then 0, which stands for `max`.
+static u32 random_length(u32 max) {
+    switch (next_random() % 8) {
+    case 0:
+        return next_random() % max;
+
+    case 1:
+        return 0;
+
+    default:
+        return next_random() % 24;
+    }
+}
+
+/// @brief Write one random token, and return how many bytes it decodes to.
+static s32 write_token(u8** p, s32 written, bool compressible) {
+    u8* s = *p;
+    u32 loop;
+    u32 offset;
+    s32 j;
+
+    // Most of a compressed image is short references back into what was decoded, after some literals to start from
+    u32 kind = compressible ? ((next_random() % 4 != 0) ? 0 : 1 + next_random() % 8) : next_random() % 9;
+
+    if (compressible && (written == 0)) {
+        kind = 2;
+    }
+
+    switch (kind) {
+    case 0:
+        // Short reference, a distance of 1 to 2048 and 1 to 16 bytes
+        offset = compressible ? 1 + next_random() % SDL_min(written, 0x800) : next_random() % 0x800;
+        loop = next_random() % 16;
+        *s++ = (offset >> 4) & 0x7F;
+        *s++ = ((offset & 0xF) << 4) | loop;
+        *p = s;
+        return (loop == 0) ? 0x10 : loop;
+
+    case 1:
+        // Long reference, a distance of 1 to 16384, maybe with a step
+        offset = compressible ? 1 + next_random() % SDL_min(written, 0x4000) : next_random() % 0x4000;
+        loop = next_random() % 0x80;
+        *s++ = 0xC0 | ((offset >> 8) & 0x3F);
+        *s++ = offset & 0xFF;
+
+        if (next_random() % 4 == 0) {
+            *s++ = 0x80 | loop;
+            *s++ = next_random();
+        } else {
+            *s++ = loop;
+        }
+
+        *p = s;
+        return (loop == 0) ? 0x80 : loop;
+
+    case 2:
+    case 3:
+        // Literals
+        loop = random_length((kind == 2) ? 0x100 : 0x10000);
+        *s++ = 0x80 | (kind - 1);
+
+        if (kind == 2) {
+            *s++ = loop;
+            loop = (loop == 0) ? 0x100 : loop;
+        } else {
+            *s++ = loop >> 8;
+            *s++ = loop;
+            loop = (loop == 0) ? 0x10000 : loop;
+        }
+
+        for (j = 0; j < loop; j++) {
+            *s++ = next_random();
+        }
+
+        *p = s;
+        return loop;
+
+    case 4:
+    case 5:
+    case 6:
+    case 7:
+        // Fills, and runs that count up by a step
+        loop = random_length(((kind & 1) == 0) ? 0x100 : 0x10000);
+        *s++ = 0x80 | (kind - 1);
+        *s++ = next_random();
+
+        if (kind >= 6) {
+            *s++ = next_random();
+        }
+
+        if ((kind & 1) == 0) {
+            *s++ = loop;
+            loop = (loop == 0) ? 0x100 : loop;
+        } else {
+            *s++ = loop >> 8;
+            *s++ = loop;
+            loop = (loop == 0) ? 0x10000 : loop;
+        }
+
+        *p = s;
+        return loop;
+
+    default:
+        // A command that doesn't exist, the decoders skip it
+        *s++ = 0x80 | (7 + next_random() % 57);
+        *p = s;
+        return 0;
+    }
+}
+
+/// @brief Make a stream that decodes to about `size` bytes, and return its length.
+static s32 make_stream(u8* s, s32 size, bool compressible) {
+    u8* p = s;
+    s32 written = 0;
+    s32 j;
+
+    if (!compressible && (next_random() % 8 == 0)) {
+        // Plain random bytes
+        for (j = 0; j < size; j++) {
+            *p++ = next_random();
+        }
+    } else {
+        while ((written < size) && (p - s < OUTPUT_MAX * 2)) {
+            written += write_token(&p, written, compressible);
+        }
+    }
+
+    // Whatever a broken stream reads past its end
+    for (j = 0; j < MARGIN; j++) {
+        *p++ = next_random();
+    }
+
+    return p - s;
+}
+
+static bool check_stream(s32 index) {
+    const s32 size = (next_random() % 16 == 0) ? next_random() % OUTPUT_MAX : next_random() % 0x1000;
+    const s32 length = make_stream(stream, size, false);
+    const bool in_place = next_random() % 8 == 0;
+    u8* src = stream;
+    u8* reference_src = stream;
+    s32 used = MARGIN + size + MARGIN;
+    s32 result;
+    s32 reference_result;
+    s32 j;
+
+    if (in_place) {
+        // The stream sits at the end of the output, as when a file is decompressed where it was loaded
+        j = MARGIN + SDL_max(size - length, 0) + next_random() % 64;
+        used = SDL_max(used, j + length);
+        src = &buffer[j];
+        reference_src = &reference_buffer[j];
+    }
+
+    memcpy(buffer, noise, used);
+
+    if (in_place) {
+        memcpy(src, stream, length);
+    }
+
+    memcpy(reference_buffer, buffer, used);
+    result = decLZ77withSizeCheck(src, &buffer[MARGIN], size);
+    reference_result = reference_decode(reference_src, &reference_buffer[MARGIN], size);
+
+    if (result != reference_result) {
+        printf("Stream %d: decoded with result %d instead of %d\n", index, result, reference_result);
+        return false;
+    }
+
+    if (memcmp(buffer, reference_buffer, used) != 0) {
+        for (j = 0; buffer[j] == reference_buffer[j]; j++) {}
+
+        printf("Stream %d of %d bytes: byte %d differs\n", index, size, j - MARGIN);
+        return false;
+    }
+
+    return true;
+}
+
+static void benchmark() {
+    static u8 benchmark_stream[BENCHMARK_SIZE * 2 + MARGIN];
+    static u8 output[BENCHMARK_SIZE + 0x10000];
+    Uint64 reference_ns = ~0ULL;
+    Uint64 batched_ns = ~0ULL;
+    Uint64 start;
+    s32 size = 0;
+    s32 i;
+
+    // Decode to exactly the size of the tokens, so that the stream is valid
+    {
+        u8* p = benchmark_stream;
+
+        while (size < BENCHMARK_SIZE - 0x10000) {
+            size += write_token(&p, size, true);
+        }
+    }
+
+    for (i = 0; i < BENCHMARK_RUNS; i++) {
+        start = SDL_GetTicksNS();
+        reference_decode(benchmark_stream, output, size);
+        reference_ns = SDL_min(reference_ns, SDL_GetTicksNS() - start);
+
+        start = SDL_GetTicksNS();
+        decLZ77withSizeCheck(benchmark_stream, output, size);
+        batched_ns = SDL_min(batched_ns, SDL_GetTicksNS() - start);
+    }
+
+    printf("%d bytes decoded: byte by byte %.0f MB/s, in blocks %.0f MB/s\n",
+           size,
+           size * 1e3 / reference_ns,
+           size * 1e3 / batched_ns);
+}
+
+int main() {
+    s32 i;
+
+    // What the output is written over
+    for (i = 0; i < BUFFER_SIZE; i++) {
+        noise[i] = next_random();
+    }
+
+    for (i = 0; i < STREAM_COUNT; i++) {
+        if (!check_stream(i)) {
+            return 1;
+        }
+    }
+
+    printf("decLZ77withSizeCheck: %d random streams decode like the byte by byte decoder\n", STREAM_COUNT);
+    benchmark();
+    return 0;
+}
@@ -0,0 +1,204 @@
+/**
+ * @file njdp2d_sort_check.c
+ * Checks that 2D polygon requests are drawn in the order that the old list insertion gave them
+ *
+ * Random frames of requests, with few distinct priorities so that there are many ties, are made through
+ * njdp2d_sort and drawn with njdp2d_draw. The order in which quads and shadows come out has to be the order that
+ * inserting each request into the list, as the game used to, would have drawn them in. Frames go past the 100
+ * requests that the old buffer held, which the list is not capped at here.
+ */
+
+#include "common.h"
+#include "sf33rd/AcrSDK/ps2/flps2render.h"
+#include "sf33rd/AcrSDK/ps2/foundaps2.h"
+#include "sf33rd/Source/Common/PPGFile.h"
+#include "sf33rd/Source/Game/rendering/aboutspr.h"
+#include "sf33rd/Source/Game/rendering/color3rd.h"
+#include "sf33rd/Source/Game/rendering/dc_ghost.h"
+#include "sf33rd/Source/PS2/ps2Quad.h"
+#include "structs.h"
+
+#include <SDL3/SDL.h>
+
+#include <stdio.h>
+#include <string.h>
+
+#define FRAME_COUNT 200000
+#define REQUEST_MAX 400
+
+typedef struct Request {
+    f32 pri;
+    s32 next;
+} Request;
+
+static WORK shadows[REQUEST_MAX];
+static s32 drawn[REQUEST_MAX];
+static s32 drawn_count;
+
+// Stand-ins for the parts of the game that drawing requests calls out to
+s32 flLogOut(s8* /* unused */, ...) {
+    return 0;
+}
+
+s32 flSetRenderState(enum _FLSETRENDERSTATE /* unused */, u32 /* unused */) {
+    return 1;
+}
+
+void palCopyGhostDC(s32 /* unused */, s32 /* unused */, void* /* unused */) {}
+
+void palUpdateGhostDC() {}
+
+void ppgRenewDotDataSeqs(Texture* /* unused */, u32 /* unused */, u32* /* unused */, u32 /* unused */,
+                         u32 /* unused */) {}
+
+void ppgSetupCurrentPaletteNumber(Palette* /* unused */, s32 /* unused */) {}
+
+s32 ppgWriteQuadWithST_B(Vertex* /* unused */, u32 /* unused */, PPGDataList* /* unused */, s32 /* unused */,
+                         s32 /* unused */) {
+    return 0;
+}
+
+s32 ppgWriteQuadWithST_B2(Vertex* /* unused */, u32 /* unused */, PPGDataList* /* unused */, s32 /* unused */,
+                          s32 /* unused */) {
+    return 0;
+}
+
+// Quads carry the number of their request as their color, shadows as the work they are drawn for
+void ps2SeqsRenderQuad_B(Quad* /* unused */, u32 col) {
+    drawn[drawn_count++] = col;
+}
+
+void shadow_drawing(WORK* wk, s16 /* unused */) {
+    drawn[drawn_count++] = wk - shadows;
+}
+
+static u32 random_state = 1;
+static Request requests[REQUEST_MAX];
+static s32 reference_order[REQUEST_MAX];
+
+static u32 next_random() {
+    random_state ^= random_state << 13;
+    random_state ^= random_state >> 17;
+    random_state ^= random_state << 5;
+    return random_state;
+}
+
+/// @brief Insert the next request into the list the way njdp2d_sort used to, behind every request that has at least
+/// its priority.
+static void reference_insert(s32* first, s32 ix) {
+    s32 i;
+    s32 prev;
+
+    requests[ix].next = -1;
+
+    if (*first == -1) {
+        *first = ix;
+        return;
+    }
+
+    i = *first;
+    prev = -1;
+
+    while (1) {
+        if (requests[ix].pri > requests[i].pri) {
+            if (prev == -1) {
+                *first = ix;
+                requests[ix].next = i;
+            } else {
+                requests[prev].next = ix;
+                requests[ix].next = i;
+            }
+
+            break;
+        }
+
+        if (requests[i].next == -1) {
+            requests[i].next = ix;
+            break;
+        }
+
+        prev = i;
+        i = requests[i].next;
+    }
+}
+
+static bool run_frame(s32 frame) {
+    f32 priorities[8];
+    f32 pos[8] = { 0 };
+    s32 priority_count = 1 + next_random() % 8;
+    s32 count;
+    s32 first = -1;
+    s32 overflow_count = njdp2d_overflow_count;
+    s32 i;
+
+    // Mostly frames that fit the old buffer, some that go past it
+    count = (next_random() % 8 == 0) ? next_random() % (REQUEST_MAX + 1) : next_random() % 101;
+
+    // A frame only uses a few priorities, from the table that the game sets up
+    for (i = 0; i < priority_count; i++) {
+        priorities[i] = ((next_random() % 128) * 512 + 1) / 65535.0f;
+    }
+
+    drawn_count = 0;
+
+    for (i = 0; i < count; i++) {
+        requests[i].pri = priorities[next_random() % priority_count];
+        reference_insert(&first, i);
+
+        if (next_random() % 4 == 0) {
+            njdp2d_sort(pos, requests[i].pri, (uintptr_t)&shadows[i], 1);
+        } else {
+            njdp2d_sort(pos, requests[i].pri, i, 0);
+        }
+    }
+
+    for (i = 0; first != -1; i++, first = requests[first].next) {
+        reference_order[i] = first;
+    }
+
+    njdp2d_draw();
+
+    if (njdp2d_overflow_count - overflow_count != (count > 100)) {
+        printf("Frame %d: %d requests, but the overflow count went up by %d\n",
+               frame,
+               count,
+               njdp2d_overflow_count - overflow_count);
+        return false;
+    }
+
+    if (drawn_count != count) {
+        printf("Frame %d: %d of %d requests drawn\n", frame, drawn_count, count);
+        return false;
+    }
+
+    if (memcmp(drawn, reference_order, count * sizeof(s32)) != 0) {
+        for (i = 0; drawn[i] == reference_order[i]; i++) {}
+
+        printf("Frame %d: request %d drawn at %d instead of %d\n", frame, drawn[i], i, reference_order[i]);
+        return false;
+    }
+
+    return true;
+}
+
+int main() {
+    s32 overflow_frames = 0;
+    s32 frame;
+
+    njdp2d_init();
+
+    for (frame = 0; frame < FRAME_COUNT; frame++) {
+        const s32 before = njdp2d_overflow_count;
+
+        if (!run_frame(frame)) {
+            return 1;
+        }
+
+        overflow_frames += njdp2d_overflow_count - before;
+    }
+
+    printf("njdp2d_sort: %d frames drawn in the order of the list, %d of them past the old buffer\n",
+           FRAME_COUNT,
+           overflow_frames);
+    return 0;
+}
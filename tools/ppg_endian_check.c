@@ -0,0 +1,250 @@
+/**
+ * @file ppg_endian_check.c
+ * Checks that ppgChangeDataEndian converts pixels and palettes like the scalar loops it replaced, and times both
+ *
+ * Random buffers of every length up to a few hundred bytes, and some longer ones, start at every offset from a
+ * 16-byte boundary that their element size allows. They are converted as 32-bit colours, 16-bit colours and 4-bit
+ * pixels, and with the flags that leave them alone. The buffer and the bytes around it have to match.
+ */
+
+#include "common.h"
+#include "sf33rd/AcrSDK/ps2/flps2render.h"
+#include "sf33rd/AcrSDK/ps2/flps2vram.h"
+#include "sf33rd/AcrSDK/ps2/foundaps2.h"
+#include "sf33rd/Source/Common/MemMan.h"
+#include "sf33rd/Source/Compress/zlibApp.h"
+#include "sf33rd/Source/PS2/ps2Quad.h"
+#include "structs.h"
+
+#include <SDL3/SDL.h>
+
+#include <stdio.h>
+#include <string.h>
+
+#define BUFFER_COUNT 200000
+#define SIZE_MAX_SHORT 300
+#define SIZE_MAX_LONG 0x4000
+
+// Bytes on both sides of the data that nothing may write to
+#define MARGIN 32
+
+#define BENCHMARK_SIZE 0x100000
+#define BENCHMARK_RUNS 16
+
+#define REVERT_U32(val)                                                                                                \
+    (((val & 0xFF) << 0x18) | ((val & 0xFF00) << 8) | ((val >> 8) & 0xFF00) | ((val >> 0x18) & 0xFF))
+#define REVERT_U16(val) (((val >> 8) & 0xFF) | ((val & 0xFF) << 8))
+#define REVERT_U8(val) (((val << 4) & 0xF0) | ((val >> 4) & 0xF))
+
+typedef struct Conversion {
+    const char* name;
+    s32 dendL;
+    s32 col4;
+    s32 depth;
+    s32 excdot;
+} Conversion;
+
+static const Conversion conversions[] = {
+    { "32-bit colours", 0, 1, 2, 0 },        { "16-bit colours", 0, 0, 2, 0 },
+    { "4-bit pixels", 0, 0, 0, 1 },          { "little endian colours", 4, 1, 2, 1 },
+    { "8-bit pixels", 0, 1, 1, 1 },          { "pixels without a swap", 0, 0, 0, 0 },
+};
+
+void ppgChangeDataEndian(u8* adrs, s32 size, s32 dendL, s32 col4, s32 depth, s32 excdot);
+
+// Stand-ins for the parts of the game that the rest of PPGFile.c calls out to
+s32 flLogOut(s8* /* unused */, ...) {
+    return 0;
+}
+
+s32 flSetRenderState(enum _FLSETRENDERSTATE /* unused */, u32 /* unused */) {
+    return 1;
+}
+
+u32 flCreatePaletteHandle(plContext* /* unused */, u32 /* unused */) {
+    return 0;
+}
+
+s32 flReleasePaletteHandle(u32 /* unused */) {
+    return 1;
+}
+
+u32 flCreateTextureHandle(plContext* /* unused */, u32 /* unused */) {
+    return 0;
+}
+
+s32 flReleaseTextureHandle(u32 /* unused */) {
+    return 1;
+}
+
+s32 flLockTexture(Rect* /* unused */, u32 /* unused */, plContext* /* unused */, u32 /* unused */) {
+    return 0;
+}
+
+s32 flUnlockTexture(u32 /* unused */) {
+    return 1;
+}
+
+void mmHeapInitialize(_MEMMAN_OBJ* /* unused */, u8* /* unused */, s32 /* unused */, s32 /* unused */,
+                      s8* /* unused */) {}
+
+u8* mmAlloc(_MEMMAN_OBJ* /* unused */, ssize_t /* unused */, s32 /* unused */) {
+    return NULL;
+}
+
+void mmFree(_MEMMAN_OBJ* /* unused */, u8* /* unused */) {}
+
+void ps2SeqsRenderQuad_A(Sprite* /* unused */, u32 /* unused */) {}
+
+void ps2SeqsRenderQuad_A2(Sprite* /* unused */, u32 /* unused */) {}
+
+ssize_t zlib_Decompress(void* /* unused */, s32 /* unused */, void* /* unused */, s32 /* unused */) {
+    return 0;
+}
+
+static u32 random_state = 1;
+static u8 noise[MARGIN + SIZE_MAX_LONG + 16 + MARGIN + 64] __attribute__((aligned(16)));
+static u8 buffer[MARGIN + SIZE_MAX_LONG + 16 + MARGIN] __attribute__((aligned(16)));
+static u8 reference_buffer[MARGIN + SIZE_MAX_LONG + 16 + MARGIN] __attribute__((aligned(16)));
+
+static u32 next_random() {
+    random_state ^= random_state << 13;
+    random_state ^= random_state >> 17;
+    random_state ^= random_state << 5;
+    return random_state;
+}
+
+/// @brief The scalar loops that ppgChangeDataEndian used to be.
+__attribute__((noinline)) static void reference_change_data_endian(u8* adrs, s32 size, s32 dendL, s32 col4, s32 depth,
+                                                                   s32 excdot) {
+    s32 i;
+    u32* c4;
+    u16* c2;
+
+    if (depth == 1) {
+        return;
+    }
+
+    if (depth != 0) {
+        if (dendL == 0) {
+            if (col4 != 0) {
+                c4 = (u32*)adrs;
+
+                for (i = 0; i < size / 4; i++) {
+                    c4[i] = REVERT_U32(c4[i]);
+                }
+            } else {
+                c2 = (u16*)adrs;
+
+                for (i = 0; i < size / 2; i++) {
+                    c2[i] = REVERT_U16(c2[i]);
+                }
+            }
+        }
+
+        return;
+    }
+
+    if (excdot != 0) {
+        for (i = 0; i < size; i++) {
+            adrs[i] = REVERT_U8(adrs[i]);
+        }
+    }
+}
+
+static bool check_buffer(s32 index) {
+    const Conversion* conversion = &conversions[next_random() % SDL_arraysize(conversions)];
+    const s32 size = (next_random() % 16 == 0) ? next_random() % SIZE_MAX_LONG : next_random() % SIZE_MAX_SHORT;
+    const s32 used = MARGIN + size + 16 + MARGIN;
+    s32 offset = next_random() % 16;
+    s32 j;
+
+    // Colours are only ever read from where their size lines them up
+    if (conversion->depth != 0) {
+        offset &= conversion->col4 ? ~3 : ~1;
+    }
+
+    memcpy(buffer, &noise[next_random() % 64], used);
+    memcpy(reference_buffer, buffer, used);
+
+    ppgChangeDataEndian(&buffer[MARGIN + offset],
+                        size,
+                        conversion->dendL,
+                        conversion->col4,
+                        conversion->depth,
+                        conversion->excdot);
+    reference_change_data_endian(&reference_buffer[MARGIN + offset],
+                                 size,
+                                 conversion->dendL,
+                                 conversion->col4,
+                                 conversion->depth,
+                                 conversion->excdot);
+
+    if (memcmp(buffer, reference_buffer, used) != 0) {
+        for (j = 0; buffer[j] == reference_buffer[j]; j++) {}
+
+        printf("Buffer %d, %s of %d bytes at offset %d: byte %d differs\n",
+               index,
+               conversion->name,
+               size,
+               offset,
+               j - MARGIN - offset);
+        return false;
+    }
+
+    return true;
+}
+
+static void benchmark(const Conversion* conversion) {
+    static u8 data[BENCHMARK_SIZE] __attribute__((aligned(16)));
+    Uint64 reference_ns = ~0ULL;
+    Uint64 simd_ns = ~0ULL;
+    Uint64 start;
+    s32 i;
+
+    for (i = 0; i < BENCHMARK_SIZE; i++) {
+        data[i] = next_random();
+    }
+
+    // Each run swaps the data back, which doesn't matter to the timing
+    for (i = 0; i < BENCHMARK_RUNS; i++) {
+        start = SDL_GetTicksNS();
+        reference_change_data_endian(
+            data, BENCHMARK_SIZE, conversion->dendL, conversion->col4, conversion->depth, conversion->excdot);
+        reference_ns = SDL_min(reference_ns, SDL_GetTicksNS() - start);
+
+        start = SDL_GetTicksNS();
+        ppgChangeDataEndian(
+            data, BENCHMARK_SIZE, conversion->dendL, conversion->col4, conversion->depth, conversion->excdot);
+        simd_ns = SDL_min(simd_ns, SDL_GetTicksNS() - start);
+    }
+
+    printf("%s, %d bytes: scalar %.0f MB/s, ppgChangeDataEndian %.0f MB/s\n",
+           conversion->name,
+           BENCHMARK_SIZE,
+           BENCHMARK_SIZE * 1e3 / reference_ns,
+           BENCHMARK_SIZE * 1e3 / simd_ns);
+}
+
+int main() {
+    s32 i;
+
+    // What the data is surrounded by
+    for (i = 0; i < (s32)sizeof(noise); i++) {
+        noise[i] = next_random();
+    }
+
+    for (i = 0; i < BUFFER_COUNT; i++) {
+        if (!check_buffer(i)) {
+            return 1;
+        }
+    }
+
+    printf("ppgChangeDataEndian: %d random buffers converted like the scalar loops\n", BUFFER_COUNT);
+
+    for (i = 0; i < 3; i++) {
+        benchmark(&conversions[i]);
+    }
+
+    return 0;
+}
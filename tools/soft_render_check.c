@@ -0,0 +1,172 @@
+/**
+ * @file soft_render_check.c
+ * Checks that the software renderer draws the frames that its golden hashes were taken from
+ *
+ * A short animation of textured, tinted and half transparent sprites over a shaded background is rendered with 1 to
+ * 8 threads. The hash of each frame has to match the golden value below with every number of threads. The same
+ * frames without their sprites have to hash differently, so that a run that drops sprites can't pass.
+ *
+ * Run with `--print` to print the hashes, after a change that is meant to alter the output.
+ */
+
+#include "common.h"
+#include "port/sdl/sdl_soft_renderer.h"
+
+#include <SDL3/SDL.h>
+
+#include <stdio.h>
+#include <string.h>
+
+#define CANVAS_WIDTH 384
+#define CANVAS_HEIGHT 224
+#define FRAME_COUNT 8
+#define SPRITE_COUNT 40
+#define QUAD_MAX (SPRITE_COUNT + 1)
+#define TEXTURE_SIZE 16
+#define CLEAR_COLOR 0x102030FF
+
+static const u64 golden[FRAME_COUNT] = {
+    0x571C74A46B1A48F5ULL, 0xA23309F2BC63540EULL, 0xAF4FF96A29275C3EULL, 0xF13BA9E883DF0332ULL,
+    0xD93E8A7C0FB22E27ULL, 0x4191991DB229F4BDULL, 0xD1A1D2D282CF41B3ULL, 0x9ACF4B0C9B697900ULL,
+};
+
+static SDL_Surface* texture;
+static SDLSoftRenderer_Quad quads[QUAD_MAX];
+
+/// @brief Make a checkerboard whose alpha fades across it, with a fully transparent border like sprite cells have.
+static bool make_texture() {
+    Uint32* texels;
+    s32 x;
+    s32 y;
+
+    texture = SDL_CreateSurface(TEXTURE_SIZE, TEXTURE_SIZE, SDL_PIXELFORMAT_RGBA8888);
+
+    if (texture == NULL) {
+        printf("Failed to create the texture: %s\n", SDL_GetError());
+        return false;
+    }
+
+    for (y = 0; y < TEXTURE_SIZE; y++) {
+        texels = (Uint32*)((u8*)texture->pixels + y * texture->pitch);
+
+        for (x = 0; x < TEXTURE_SIZE; x++) {
+            const bool is_border = (x == 0) || (y == 0) || (x == TEXTURE_SIZE - 1) || (y == TEXTURE_SIZE - 1);
+            const Uint32 rgb = (((x / 4) + (y / 4)) & 1) ? 0xF0C03000 : 0x3080F000;
+
+            texels[x] = is_border ? 0 : (rgb | (0x40 + x * 10));
+        }
+    }
+
+    return true;
+}
+
+static void set_vertex(SDL_Vertex* vertex, float x, float y, float u, float v, u32 rgba) {
+    vertex->position.x = x;
+    vertex->position.y = y;
+    vertex->tex_coord.x = u;
+    vertex->tex_coord.y = v;
+    vertex->color.r = (rgba >> 24) / 255.0f;
+    vertex->color.g = ((rgba >> 16) & 0xFF) / 255.0f;
+    vertex->color.b = ((rgba >> 8) & 0xFF) / 255.0f;
+    vertex->color.a = (rgba & 0xFF) / 255.0f;
+}
+
+/// @brief Lay out frame `frame`, with or without its sprites.
+/// @return Number of quads.
+static s32 make_frame(s32 frame, bool with_sprites) {
+    SDLSoftRenderer_Quad* quad = &quads[0];
+    s32 count = 1;
+    s32 i;
+
+    // Background with a color per corner
+    quad->image = NULL;
+    set_vertex(&quad->vertices[0], 0, 0, 0, 0, 0x204060FF);
+    set_vertex(&quad->vertices[1], CANVAS_WIDTH, 0, 0, 0, 0x406020FF);
+    set_vertex(&quad->vertices[2], 0, CANVAS_HEIGHT, 0, 0, 0x602040FF);
+    set_vertex(&quad->vertices[3], CANVAS_WIDTH, CANVAS_HEIGHT, 0, 0, 0x101010FF);
+
+    if (!with_sprites) {
+        return count;
+    }
+
+    // Sprites move, grow and skew by whole and quarter pixels, and some of them are flipped or only tinted quads
+    for (i = 0; i < SPRITE_COUNT; i++) {
+        const float x = (float)((i * 37 + frame * 11) % (CANVAS_WIDTH + 32) - 16) + (i % 4) * 0.25f;
+        const float y = (float)((i * 53 + frame * 7) % (CANVAS_HEIGHT + 32) - 16) + (frame % 4) * 0.25f;
+        const float size = (float)(8 + (i % 5) * 12);
+        const float skew = (float)((i % 3) - 1) * 0.5f * size;
+        const float u0 = (i % 7 == 0) ? 1.0f : 0.0f;
+        const u32 tint = (i % 3 == 0) ? 0xFFFFFFFF : (0x80FF80FF - ((u32)(i * 5) & 0x7F));
+
+        quad = &quads[count++];
+        quad->image = (i % 6 == 5) ? NULL : texture;
+        set_vertex(&quad->vertices[0], x + skew, y, u0, 0, tint);
+        set_vertex(&quad->vertices[1], x + skew + size, y, 1 - u0, 0, tint);
+        set_vertex(&quad->vertices[2], x, y + size, u0, 1, (i % 2) ? tint : 0xFFFFFF80);
+        set_vertex(&quad->vertices[3], x + size, y + size, 1 - u0, 1, tint);
+    }
+
+    return count;
+}
+
+/// @brief Render every frame with `thread_count` threads and collect their hashes.
+static void render_frames(s32 thread_count, bool with_sprites, u64* hashes) {
+    s32 frame;
+
+    SDLSoftRenderer_Init(CANVAS_WIDTH, CANVAS_HEIGHT, thread_count);
+
+    for (frame = 0; frame < FRAME_COUNT; frame++) {
+        SDLSoftRenderer_Render(CLEAR_COLOR, quads, make_frame(frame, with_sprites));
+        hashes[frame] = SDLSoftRenderer_GetFrameHash();
+    }
+
+    SDLSoftRenderer_Quit();
+}
+
+int main(int argc, char* argv[]) {
+    u64 hashes[FRAME_COUNT];
+    u64 background[FRAME_COUNT];
+    s32 thread_count;
+    s32 frame;
+
+    if (!make_texture()) {
+        return 1;
+    }
+
+    if ((argc > 1) && (strcmp(argv[1], "--print") == 0)) {
+        render_frames(1, true, hashes);
+
+        for (frame = 0; frame < FRAME_COUNT; frame++) {
+            printf("0x%016" SDL_PRIx64 "ULL,\n", hashes[frame]);
+        }
+
+        return 0;
+    }
+
+    render_frames(1, false, background);
+
+    for (thread_count = 1; thread_count <= 8; thread_count++) {
+        render_frames(thread_count, true, hashes);
+
+        for (frame = 0; frame < FRAME_COUNT; frame++) {
+            if (hashes[frame] != golden[frame]) {
+                printf("Frame %d with %d threads: hash %016" SDL_PRIx64 " instead of %016" SDL_PRIx64 "\n",
+                       frame,
+                       thread_count,
+                       hashes[frame],
+                       golden[frame]);
+                return 1;
+            }
+
+            if (hashes[frame] == background[frame]) {
+                printf("Frame %d hashes the same without its sprites\n", frame);
+                return 1;
+            }
+        }
+    }
+
+    printf("SDLSoftRenderer: %d frames match their golden hashes with 1 to 8 threads, and differ without sprites\n",
+           FRAME_COUNT);
+    SDL_DestroySurface(texture);
+    return 0;
+}
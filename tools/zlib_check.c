@@ -0,0 +1,331 @@
+/**
+ * @file zlib_check.c
+ * Checks that zlib_Decompress inflates every block like the version that set up a new context per call, and times both
+ *
+ * The blocks are laid out like the ones a stage and character load decompresses: the textures of each background
+ * layer, the textures that get rewritten during the match, the stage palette and the palettes of both characters.
+ * Their pixels are runs of a few colours with some noise, compressed at the best level. Each one has to inflate to
+ * its pixels with both versions. Truncated and corrupted blocks, and outputs that are too small, have to fail the
+ * same way, and the blocks after them still have to inflate.
+ *
+ * The game data isn't available here, so the blocks are made up with the sizes that the loader asks for.
+ */
+
+#include "common.h"
+#include "sf33rd/Source/Common/MemMan.h"
+#include "sf33rd/Source/Compress/zlibApp.h"
+
+#include <SDL3/SDL.h>
+
+#include "zlib.h"
+
+#include <stdio.h>
+#include <string.h>
+
+// The same size as the heap the game gives zlib
+#define HEAP_SIZE 0x10000
+
+#define BENCHMARK_RUNS 16
+#define BROKEN_COUNT 5000
+
+typedef struct LoadStep {
+    const char* name;
+    s32 size;
+    s32 count;
+} LoadStep;
+
+// Background layers of 32 textures each, as bg.c sets them up, then the rest of the stage and the characters
+static const LoadStep load_steps[] = {
+    { "layer 1 textures", 0x10000, 32 },   { "layer 2 textures", 0x10000, 32 },   { "layer 3 textures", 0x8000, 32 },
+    { "rewritten textures", 0x10000, 4 },  { "stage palette", 0x200, 1 },         { "player 1 palettes", 0x2000, 1 },
+    { "player 2 palettes", 0x2000, 1 },
+};
+
+typedef struct Block {
+    u8* data;
+    s32 size;
+    u8* packed;
+    s32 packed_size;
+} Block;
+
+static u32 random_state = 1;
+static Block* blocks;
+static s32 block_count;
+static u8* output;
+static u8* reference_output;
+static s32 output_max;
+
+static u8 heap[HEAP_SIZE];
+static u8 reference_heap[HEAP_SIZE];
+static _MEMMAN_OBJ reference_mobj;
+static z_stream reference_stream;
+
+static u32 next_random() {
+    random_state ^= random_state << 13;
+    random_state ^= random_state >> 17;
+    random_state ^= random_state << 5;
+    return random_state;
+}
+
+static void* reference_malloc(void* /* unused */, u32 items, u32 size) {
+    return mmAlloc(&reference_mobj, size * items, 0);
+}
+
+static void reference_free(void* /* unused */, void* adrs) {
+    mmFree(&reference_mobj, (u8*)adrs);
+}
+
+static void reference_initialize() {
+    mmHeapInitialize(
+        &reference_mobj, reference_heap, HEAP_SIZE, ALIGN_UP(sizeof(_MEMMAN_CELL), 16), "- for the reference -");
+    reference_stream.zalloc = reference_malloc;
+    reference_stream.zfree = reference_free;
+    reference_stream.opaque = NULL;
+}
+
+/// @brief The zlib_Decompress that set up and tore down an inflate context on every call.
+__attribute__((noinline)) static ssize_t reference_decompress(void* srcBuff, s32 srcSize, void* dstBuff,
+                                                              s32 dstSize) {
+    s32 state;
+
+    reference_stream.next_in = srcBuff;
+    reference_stream.avail_in = srcSize;
+    reference_stream.next_out = dstBuff;
+    reference_stream.avail_out = dstSize;
+    state = 0;
+
+    if (inflateInit_(&reference_stream, ZLIB_VERSION, sizeof(z_stream)) != 0) {
+        return 0;
+    }
+
+    while (1) {
+        state = inflate(&reference_stream, 0);
+
+        if (state == 1) {
+            break;
+        }
+
+        if (state == 0) {
+            continue;
+        } else {
+            return 0;
+        }
+    }
+
+    if (inflateEnd(&reference_stream) != 0) {
+        return 0;
+    }
+
+    return reference_stream.total_out;
+}
+
+/// @brief Fill `data` with runs of a few colours, and a random pixel now and then, like sprite and background art.
+static void make_pixels(u8* data, s32 size) {
+    u8 colors[8];
+    s32 run;
+    s32 i;
+
+    for (i = 0; i < 8; i++) {
+        colors[i] = next_random();
+    }
+
+    for (i = 0; i < size; i += run) {
+        const u8 color = (next_random() % 16 == 0) ? next_random() : colors[next_random() % 8];
+
+        run = SDL_min(1 + (s32)(next_random() % 24), size - i);
+        SDL_memset(&data[i], color, run);
+    }
+}
+
+static bool make_blocks() {
+    uLongf packed_size;
+    s32 i;
+    s32 j;
+
+    for (i = 0; i < (s32)SDL_arraysize(load_steps); i++) {
+        block_count += load_steps[i].count;
+        output_max = SDL_max(output_max, load_steps[i].size);
+    }
+
+    blocks = SDL_calloc(block_count, sizeof(Block));
+    output = SDL_malloc(output_max);
+    reference_output = SDL_malloc(output_max);
+
+    if ((blocks == NULL) || (output == NULL) || (reference_output == NULL)) {
+        return false;
+    }
+
+    block_count = 0;
+
+    for (i = 0; i < (s32)SDL_arraysize(load_steps); i++) {
+        for (j = 0; j < load_steps[i].count; j++) {
+            Block* block = &blocks[block_count++];
+
+            block->size = load_steps[i].size;
+            block->data = SDL_malloc(block->size);
+            packed_size = block->size + block->size / 1000 + 12;
+            block->packed = SDL_malloc(packed_size);
+
+            if ((block->data == NULL) || (block->packed == NULL)) {
+                return false;
+            }
+
+            make_pixels(block->data, block->size);
+
+            if (compress2(block->packed, &packed_size, block->data, block->size, 9) != Z_OK) {
+                printf("Failed to compress block %d of the %s\n", j, load_steps[i].name);
+                return false;
+            }
+
+            block->packed_size = packed_size;
+        }
+    }
+
+    return true;
+}
+
+/// @brief Inflate `block` with both versions, with `packed_size` bytes of its stream into `dst_size` bytes.
+static bool check_block(s32 index, const Block* block, s32 packed_size, s32 dst_size) {
+    const ssize_t result = zlib_Decompress(block->packed, packed_size, output, dst_size);
+    const ssize_t reference_result = reference_decompress(block->packed, packed_size, reference_output, dst_size);
+
+    if (result != reference_result) {
+        printf("Block %d, %d of %d bytes into %d: %zd instead of %zd\n",
+               index,
+               packed_size,
+               block->packed_size,
+               dst_size,
+               result,
+               reference_result);
+        return false;
+    }
+
+    if ((result != 0) && (memcmp(output, reference_output, result) != 0)) {
+        printf("Block %d, %d of %d bytes into %d: the output differs\n",
+               index,
+               packed_size,
+               block->packed_size,
+               dst_size);
+        return false;
+    }
+
+    // The version per call left its context in its heap when it failed
+    if (reference_result == 0) {
+        reference_initialize();
+    }
+
+    return true;
+}
+
+static bool check_load() {
+    s32 i;
+
+    for (i = 0; i < block_count; i++) {
+        if (!check_block(i, &blocks[i], blocks[i].packed_size, blocks[i].size)) {
+            return false;
+        }
+
+        if (memcmp(output, blocks[i].data, blocks[i].size) != 0) {
+            printf("Block %d doesn't inflate to its pixels\n", i);
+            return false;
+        }
+    }
+
+    return true;
+}
+
+/// @brief Inflate a block that is cut short, too big for its output or has a byte changed, then an intact one.
+static bool check_broken(s32 index) {
+    Block* block = &blocks[next_random() % block_count];
+    const s32 offset = next_random() % block->packed_size;
+    const u8 byte = block->packed[offset];
+    bool is_ok;
+
+    switch (next_random() % 3) {
+    case 0:
+        is_ok = check_block(index, block, offset, block->size);
+        break;
+
+    case 1:
+        is_ok = check_block(index, block, block->packed_size, next_random() % block->size);
+        break;
+
+    default:
+        block->packed[offset] ^= 1 + next_random() % 255;
+        is_ok = check_block(index, block, block->packed_size, block->size);
+        block->packed[offset] = byte;
+        break;
+    }
+
+    block = &blocks[next_random() % block_count];
+    return is_ok && check_block(index, block, block->packed_size, block->size);
+}
+
+static Uint64 time_load(ssize_t (*decompress)(void*, s32, void*, s32)) {
+    Uint64 best_ns = ~0ULL;
+    Uint64 start;
+    s32 run;
+    s32 i;
+
+    for (run = 0; run < BENCHMARK_RUNS; run++) {
+        start = SDL_GetTicksNS();
+
+        for (i = 0; i < block_count; i++) {
+            decompress(blocks[i].packed, blocks[i].packed_size, output, blocks[i].size);
+        }
+
+        best_ns = SDL_min(best_ns, SDL_GetTicksNS() - start);
+    }
+
+    return best_ns;
+}
+
+static void benchmark() {
+    const Uint64 reference_ns = time_load(reference_decompress);
+    const Uint64 reset_ns = time_load(zlib_Decompress);
+    s64 total = 0;
+    s32 i;
+
+    for (i = 0; i < block_count; i++) {
+        total += blocks[i].size;
+    }
+
+    printf("Load of %d blocks, %" SDL_PRIs64 " bytes: context per call %.2f ms, inflateReset %.2f ms\n",
+           block_count,
+           total,
+           reference_ns / 1e6,
+           reset_ns / 1e6);
+}
+
+int main() {
+    s32 i;
+
+    zlib_Initialize(heap, HEAP_SIZE);
+    reference_initialize();
+
+    if (!make_blocks()) {
+        printf("Failed to make the blocks\n");
+        return 1;
+    }
+
+    if (!check_load()) {
+        return 1;
+    }
+
+    for (i = 0; i < BROKEN_COUNT; i++) {
+        if (!check_broken(i)) {
+            return 1;
+        }
+    }
+
+    // The blocks still inflate after all the failures
+    if (!check_load()) {
+        return 1;
+    }
+
+    printf("zlib_Decompress: %d blocks and %d broken ones inflate like with a context per call\n",
+           block_count,
+           BROKEN_COUNT);
+    benchmark();
+    return 0;
+}